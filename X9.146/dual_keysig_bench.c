@@ -0,0 +1,1087 @@
+/* dual_keysig_bench.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Throughput of making and verifying X9.146 dual key and signature
+ * certificates, ECDSA with ML-DSA, and the cost of them in TLS 1.3.
+ *
+ * A root CA with an ECDSA key and an ML-DSA key is made in memory. Certificates
+ * are then made on all threads the way gen_ecdsa_mldsa_dual_keysig_cert does:
+ * the ML-DSA signature over the pre-TBS goes in the altSignatureValue
+ * extension and the ECDSA signature over the whole certificate. Then they are
+ * all verified on all threads, each signature on its own and then both by a
+ * certificate manager. The time spent encoding, in ECDSA and in ML-DSA is
+ * reported for both.
+ *
+ * Last, TLS 1.3 handshakes are done in memory with a root and server chain of
+ * ECDSA only certificates, and of dual certificates with the CKS extension
+ * asking for the native, alternative or both signatures in the
+ * CertificateVerify message.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/dilithium.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#if defined(WOLFSSL_DUAL_ALG_CERTS) && defined(HAVE_DILITHIUM)
+
+#define LARGE_TEMP_SZ 9216
+
+#define DEF_NUM_CERTS       1000
+#define DEF_HANDSHAKES      200
+#define MAX_THREADS         256
+/* Subject keys each thread makes before timing and uses in turn. */
+#define KEYS_PER_THREAD     4
+/* Most bytes of an ML-DSA SubjectPublicKeyInfo. */
+#define MAX_SAPKI_SZ        4096
+/* Size of the buffer for each direction of a connection. */
+#define MEM_BUF_SZ          (64 * 1024)
+/* Most times a certificate is made when the clock keeps moving on. */
+#define MAX_TRIES           3
+/* Most calls to connect and accept for a handshake. */
+#define MAX_HS_STEPS        64
+
+#define SUBJECT_COUNTRY "US"
+#define SUBJECT_STATE "MT"
+#define SUBJECT_LOCALITY "YourCity"
+#define SUBJECT_ORG "YourOrgName"
+#define SUBJECT_UNIT "YourUnitName"
+
+/* ECDSA curve and ML-DSA parameters of a security level. */
+typedef struct DualLevel {
+    int              level;
+    const char*      name;
+    int              curveId;
+    int              curveSz;
+    int              sigType;
+    enum wc_HashType hashType;
+    int              altSigType;
+    int              mlDsaType;
+} DualLevel;
+
+/* The keys of the CA. Each thread has its own copy as signing caches values
+ * in the keys. */
+typedef struct CaKeys {
+    ecc_key       ecc;
+    dilithium_key mlDsa;
+} CaKeys;
+
+/* Seconds a thread spent in each part of making or verifying certificates. */
+typedef struct PartTimes {
+    double encode;
+    double ecdsa;
+    double mlDsa;
+    double cm;
+    /* Certificates made again as the validity changed in the middle. */
+    int    retries;
+} PartTimes;
+
+typedef struct Worker {
+    pthread_t tid;
+    int       id;
+    int       ret;
+    PartTimes times;
+} Worker;
+
+static const DualLevel gLevels[] = {
+    { 2, "P-256 and ML-DSA-44", ECC_SECP256R1, 32, CTC_SHA256wECDSA,
+      WC_HASH_TYPE_SHA256, CTC_ML_DSA_LEVEL2, ML_DSA_LEVEL2_TYPE },
+    { 3, "P-384 and ML-DSA-65", ECC_SECP384R1, 48, CTC_SHA384wECDSA,
+      WC_HASH_TYPE_SHA384, CTC_ML_DSA_LEVEL3, ML_DSA_LEVEL3_TYPE },
+    { 5, "P-521 and ML-DSA-87", ECC_SECP521R1, 66, CTC_SHA512wECDSA,
+      WC_HASH_TYPE_SHA512, CTC_ML_DSA_LEVEL5, ML_DSA_LEVEL5_TYPE },
+};
+#define NUM_LEVELS ((int)(sizeof(gLevels) / sizeof(gLevels[0])))
+
+static const DualLevel* gLvl;
+static int               gNumThreads;
+static int               gNumCerts;
+static pthread_barrier_t gStart;
+/* altSignatureAlgorithm extension value */
+static byte              gAltSigAlg[MAX_ALGO_SZ];
+static int               gAltSigAlgSz;
+/* CA keys, private with public and public only */
+static byte              gCaEcc[LARGE_TEMP_SZ];
+static word32            gCaEccSz;
+static byte              gCaEccPub[LARGE_TEMP_SZ];
+static word32            gCaEccPubSz;
+static byte              gCaMlDsa[LARGE_TEMP_SZ];
+static word32            gCaMlDsaSz;
+static byte              gCaMlDsaPub[MAX_SAPKI_SZ];
+static word32            gCaMlDsaPubSz;
+static byte              gRoot[LARGE_TEMP_SZ];
+static int               gRootSz;
+static byte**            gCerts;
+static int*              gCertSz;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Decode the CA keys, with the private parts to sign or without to verify. */
+static int ca_keys_load(CaKeys* ca, int priv)
+{
+    int    ret;
+    word32 idx = 0;
+
+    ret = wc_ecc_init(&ca->ecc);
+    if (ret == 0) {
+        ret = wc_dilithium_init(&ca->mlDsa);
+        if (ret != 0)
+            wc_ecc_free(&ca->ecc);
+    }
+    if (ret != 0)
+        return ret;
+
+    if (priv)
+        ret = wc_EccPrivateKeyDecode(gCaEcc, &idx, &ca->ecc, gCaEccSz);
+    else
+        ret = wc_EccPublicKeyDecode(gCaEccPub, &idx, &ca->ecc, gCaEccPubSz);
+    if (ret == 0) {
+        ret = wc_dilithium_set_level(&ca->mlDsa, gLvl->level);
+    }
+    if (ret == 0) {
+        idx = 0;
+        if (priv)
+            ret = wc_Dilithium_PrivateKeyDecode(gCaMlDsa, &idx, &ca->mlDsa,
+                                                gCaMlDsaSz);
+        else
+            ret = wc_Dilithium_PublicKeyDecode(gCaMlDsaPub, &idx, &ca->mlDsa,
+                                               gCaMlDsaPubSz);
+    }
+    if (ret != 0) {
+        wc_dilithium_free(&ca->mlDsa);
+        wc_ecc_free(&ca->ecc);
+    }
+
+    return ret;
+}
+
+static void ca_keys_free(CaKeys* ca)
+{
+    wc_dilithium_free(&ca->mlDsa);
+    wc_ecc_free(&ca->ecc);
+}
+
+/* Make an ML-DSA key and get its SubjectPublicKeyInfo and, when priv is not
+ * NULL, its private key. Returns the size of the public key or an error. */
+static int make_ml_dsa_key(WC_RNG* rng, byte* pub, word32 pubSz, byte* priv,
+                           word32* privSz)
+{
+    int           ret;
+    dilithium_key key;
+
+    ret = wc_dilithium_init(&key);
+    if (ret != 0)
+        return ret;
+    ret = wc_dilithium_set_level(&key, gLvl->level);
+    if (ret == 0) {
+        ret = wc_dilithium_make_key(&key, rng);
+    }
+    if (ret == 0 && priv != NULL) {
+        ret = wc_Dilithium_KeyToDer(&key, priv, *privSz);
+        if (ret > 0) {
+            *privSz = (word32)ret;
+            ret = 0;
+        }
+    }
+    if (ret == 0) {
+        ret = wc_Dilithium_PublicKeyToDer(&key, pub, pubSz, 1);
+    }
+    wc_dilithium_free(&key);
+
+    return ret;
+}
+
+/* Sign the certificate body made by wc_MakeCert with the CA's ECDSA key.
+ * Returns the size of the certificate or a negative error. */
+static int sign_ecdsa(Cert* cert, byte* der, int derSz, CaKeys* ca,
+                      WC_RNG* rng, PartTimes* times)
+{
+    int    ret;
+    double start = now();
+
+    ret = wc_SignCert(cert->bodySz, cert->sigType, der, derSz, NULL, &ca->ecc,
+                      rng);
+    times->ecdsa += now() - start;
+
+    return ret;
+}
+
+/* Make a certificate signed by the CA. With a SubjectPublicKeyInfo of an
+ * ML-DSA key it is a dual key and signature certificate, otherwise an ECDSA
+ * only one. With no issuer it is self-signed.
+ * Returns the size of the certificate or a negative error. */
+static int make_cert(const char* commonName, int isCA, const byte* issuer,
+                     int issuerSz, ecc_key* subjKey, const byte* sapki,
+                     int sapkiSz, CaKeys* ca, WC_RNG* rng, byte* der,
+                     int derSz, PartTimes* times)
+{
+    int         ret;
+    int         preTbsSz = 0;
+    int         altSigValSz = 0;
+    int         initPreTbs;
+    int         tries = 0;
+    time_t      t0;
+    double      start;
+    Cert        cert;
+    DecodedCert preTbs;
+    byte        preTbsBuf[LARGE_TEMP_SZ];
+    byte        altSigValBuf[LARGE_TEMP_SZ];
+
+again:
+    initPreTbs = 0;
+    t0 = time(NULL);
+    start = now();
+    ret = wc_InitCert(&cert);
+    if (ret == 0) {
+        strncpy(cert.subject.country, SUBJECT_COUNTRY, CTC_NAME_SIZE);
+        strncpy(cert.subject.state, SUBJECT_STATE, CTC_NAME_SIZE);
+        strncpy(cert.subject.locality, SUBJECT_LOCALITY, CTC_NAME_SIZE);
+        strncpy(cert.subject.org, SUBJECT_ORG, CTC_NAME_SIZE);
+        strncpy(cert.subject.unit, SUBJECT_UNIT, CTC_NAME_SIZE);
+        strncpy(cert.subject.commonName, commonName, CTC_NAME_SIZE - 1);
+        cert.sigType = gLvl->sigType;
+        cert.isCA = isCA;
+        if (issuer != NULL)
+            ret = wc_SetIssuerBuffer(&cert, issuer, issuerSz);
+    }
+    if (ret == 0 && sapki != NULL) {
+        ret = wc_SetCustomExtension(&cert, 0, "2.5.29.72", sapki, sapkiSz);
+        if (ret >= 0) {
+            ret = wc_SetCustomExtension(&cert, 0, "2.5.29.73", gAltSigAlg,
+                                        gAltSigAlgSz);
+        }
+    }
+    if (ret >= 0) {
+        ret = wc_MakeCert(&cert, der, derSz, NULL, subjKey, rng);
+    }
+    times->encode += now() - start;
+    /* wc_ParseCert needs a signature on the certificate the pre-TBS is made
+     * from. */
+    if (ret >= 0) {
+        ret = sign_ecdsa(&cert, der, derSz, ca, rng, times);
+    }
+    if (ret < 0 || sapki == NULL)
+        return ret;
+
+    start = now();
+    wc_InitDecodedCert(&preTbs, der, ret, NULL);
+    initPreTbs = 1;
+    ret = wc_ParseCert(&preTbs, CERT_TYPE, NO_VERIFY, NULL);
+    if (ret == 0) {
+        ret = wc_GeneratePreTBS(&preTbs, preTbsBuf, sizeof(preTbsBuf));
+        preTbsSz = ret;
+    }
+    times->encode += now() - start;
+
+    if (ret >= 0) {
+        start = now();
+        ret = wc_MakeSigWithBitStr(altSigValBuf, sizeof(altSigValBuf),
+                                   gLvl->altSigType, preTbsBuf, preTbsSz,
+                                   gLvl->mlDsaType, &ca->mlDsa, rng);
+        times->mlDsa += now() - start;
+        altSigValSz = ret;
+    }
+
+    if (ret >= 0) {
+        start = now();
+        ret = wc_SetCustomExtension(&cert, 0, "2.5.29.74", altSigValBuf,
+                                    altSigValSz);
+        if (ret >= 0) {
+            ret = wc_MakeCert(&cert, der, derSz, NULL, subjKey, rng);
+        }
+        times->encode += now() - start;
+    }
+    if (ret >= 0) {
+        ret = sign_ecdsa(&cert, der, derSz, ca, rng, times);
+    }
+    if (initPreTbs)
+        wc_FreeDecodedCert(&preTbs);
+
+    /* The validity is encoded from the clock at each wc_MakeCert. The ML-DSA
+     * signature only matches when both got the same second. */
+    if (ret >= 0 && time(NULL) != t0 && ++tries < MAX_TRIES) {
+        times->retries++;
+        goto again;
+    }
+
+    return ret;
+}
+
+/* Verify the ECDSA and ML-DSA signatures of a certificate on their own.
+ * Returns 0 when both verify. */
+static int verify_parts(const byte* der, int derSz, CaKeys* ca, int mlDsaSigSz,
+                        PartTimes* times)
+{
+    int         ret;
+    int         res = 0;
+    int         preTbsSz = 0;
+    int         hashSz;
+    int         sigSz;
+    const byte* sig;
+    double      start;
+    DecodedCert cert;
+    byte        hash[WC_MAX_DIGEST_SIZE];
+    byte        preTbs[LARGE_TEMP_SZ];
+
+    start = now();
+    wc_InitDecodedCert(&cert, der, derSz, NULL);
+    ret = wc_ParseCert(&cert, CERT_TYPE, NO_VERIFY, NULL);
+    if (ret == 0) {
+        ret = wc_GeneratePreTBS(&cert, preTbs, sizeof(preTbs));
+        preTbsSz = ret;
+    }
+    times->encode += now() - start;
+
+    if (ret >= 0) {
+        start = now();
+        hashSz = wc_HashGetDigestSize(gLvl->hashType);
+        ret = wc_Hash(gLvl->hashType, cert.source + cert.certBegin,
+                      cert.sigIndex - cert.certBegin, hash, hashSz);
+        if (ret == 0) {
+            ret = wc_ecc_verify_hash(cert.signature, cert.sigLength, hash,
+                                     hashSz, &res, &ca->ecc);
+        }
+        if (ret == 0 && res != 1)
+            ret = SIG_VERIFY_E;
+        times->ecdsa += now() - start;
+    }
+
+    if (ret == 0) {
+        /* The signature is at the end of the altSignatureValue whether the
+         * BIT STRING header is kept or not. */
+        sig = cert.altSigValDer;
+        sigSz = cert.altSigValLen;
+        if (sig == NULL || sigSz < mlDsaSigSz) {
+            ret = ASN_PARSE_E;
+        }
+        else {
+            sig += sigSz - mlDsaSigSz;
+            sigSz = mlDsaSigSz;
+        }
+    }
+    if (ret == 0) {
+        start = now();
+        res = 0;
+        ret = wc_dilithium_verify_ctx_msg(sig, sigSz, NULL, 0, preTbs,
+                                          preTbsSz, &res, &ca->mlDsa);
+        if (ret == 0 && res != 1)
+            ret = SIG_VERIFY_E;
+        times->mlDsa += now() - start;
+    }
+    wc_FreeDecodedCert(&cert);
+
+    return ret;
+}
+
+static void* gen_thread(void* arg)
+{
+    Worker*  w = (Worker*)arg;
+    int      ret;
+    int      i;
+    int      numKeys = 0;
+    int      initCa = 0;
+    int      initRng = 0;
+    WC_RNG   rng;
+    CaKeys   ca;
+    ecc_key  keys[KEYS_PER_THREAD];
+    byte     sapki[KEYS_PER_THREAD][MAX_SAPKI_SZ];
+    int      sapkiSz[KEYS_PER_THREAD];
+    char     commonName[CTC_NAME_SIZE];
+    byte*    der;
+
+    der = (byte*)malloc(LARGE_TEMP_SZ);
+    ret = (der == NULL) ? MEMORY_E : wc_InitRng(&rng);
+    if (ret == 0) {
+        initRng = 1;
+        ret = ca_keys_load(&ca, 1);
+        initCa = (ret == 0);
+    }
+    for (; ret == 0 && numKeys < KEYS_PER_THREAD; numKeys++) {
+        ret = wc_ecc_init(&keys[numKeys]);
+        if (ret != 0)
+            break;
+        ret = wc_ecc_make_key_ex(&rng, gLvl->curveSz, &keys[numKeys],
+                                 gLvl->curveId);
+        if (ret == 0) {
+            sapkiSz[numKeys] = make_ml_dsa_key(&rng, sapki[numKeys],
+                                               MAX_SAPKI_SZ, NULL, NULL);
+            if (sapkiSz[numKeys] < 0)
+                ret = sapkiSz[numKeys];
+        }
+        if (ret != 0)
+            wc_ecc_free(&keys[numKeys]);
+    }
+
+    /* Keys are made, start timing. */
+    pthread_barrier_wait(&gStart);
+
+    for (i = w->id; ret == 0 && i < gNumCerts; i += gNumThreads) {
+        snprintf(commonName, sizeof(commonName), "device-%d.YourDomain.com",
+                 i);
+        ret = make_cert(commonName, 0, gRoot, gRootSz,
+                        &keys[i % KEYS_PER_THREAD],
+                        sapki[i % KEYS_PER_THREAD], sapkiSz[i % KEYS_PER_THREAD],
+                        &ca, &rng, der, LARGE_TEMP_SZ, &w->times);
+        if (ret > 0) {
+            gCerts[i] = (byte*)malloc(ret);
+            if (gCerts[i] == NULL) {
+                ret = MEMORY_E;
+                break;
+            }
+            memcpy(gCerts[i], der, ret);
+            gCertSz[i] = ret;
+            ret = 0;
+        }
+    }
+
+    for (i = 0; i < numKeys; i++)
+        wc_ecc_free(&keys[i]);
+    if (initCa)
+        ca_keys_free(&ca);
+    if (initRng)
+        wc_FreeRng(&rng);
+    free(der);
+    w->ret = ret;
+
+    return NULL;
+}
+
+static void* verify_thread(void* arg)
+{
+    Worker*               w = (Worker*)arg;
+    int                   ret;
+    int                   i;
+    int                   initCa = 0;
+    int                   mlDsaSigSz = 0;
+    double                start;
+    CaKeys                ca;
+    WOLFSSL_CERT_MANAGER* cm;
+
+    ret = ca_keys_load(&ca, 0);
+    if (ret == 0) {
+        initCa = 1;
+        mlDsaSigSz = wc_dilithium_sig_size(&ca.mlDsa);
+        if (mlDsaSigSz <= 0)
+            ret = mlDsaSigSz;
+    }
+    cm = wolfSSL_CertManagerNew();
+    if (cm == NULL) {
+        ret = MEMORY_E;
+    }
+    else if (wolfSSL_CertManagerLoadCABuffer(cm, gRoot, gRootSz,
+                 WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
+        ret = -1;
+    }
+
+    pthread_barrier_wait(&gStart);
+
+    for (i = w->id; ret == 0 && i < gNumCerts; i += gNumThreads) {
+        ret = verify_parts(gCerts[i], gCertSz[i], &ca, mlDsaSigSz, &w->times);
+        if (ret == 0) {
+            /* As a TLS peer does: both signatures in one call. */
+            start = now();
+            ret = wolfSSL_CertManagerVerifyBuffer(cm, gCerts[i], gCertSz[i],
+                                                  WOLFSSL_FILETYPE_ASN1);
+            w->times.cm += now() - start;
+            ret = (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+        }
+        if (ret != 0)
+            fprintf(stderr, "Certificate %d failed to verify: %d\n", i, ret);
+    }
+
+    wolfSSL_CertManagerFree(cm);
+    if (initCa)
+        ca_keys_free(&ca);
+    w->ret = ret;
+
+    return NULL;
+}
+
+/* Run a thread function on all threads. Returns the wall clock seconds from
+ * when all threads are ready to when the last is done. */
+static int run_threads(void* (*fn)(void*), Worker* workers, PartTimes* sum,
+                       double* wall)
+{
+    int    ret = 0;
+    int    i;
+    double start;
+
+    memset(sum, 0, sizeof(*sum));
+    memset(workers, 0, sizeof(Worker) * gNumThreads);
+    pthread_barrier_init(&gStart, NULL, gNumThreads + 1);
+    for (i = 0; i < gNumThreads; i++) {
+        workers[i].id = i;
+        if (pthread_create(&workers[i].tid, NULL, fn, &workers[i]) != 0) {
+            fprintf(stderr, "Failed to start thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    pthread_barrier_wait(&gStart);
+    start = now();
+    for (i = 0; i < gNumThreads; i++) {
+        pthread_join(workers[i].tid, NULL);
+        if (workers[i].ret != 0 && ret == 0)
+            ret = workers[i].ret;
+        sum->encode += workers[i].times.encode;
+        sum->ecdsa += workers[i].times.ecdsa;
+        sum->mlDsa += workers[i].times.mlDsa;
+        sum->cm += workers[i].times.cm;
+        sum->retries += workers[i].times.retries;
+    }
+    *wall = now() - start;
+    pthread_barrier_destroy(&gStart);
+
+    return ret;
+}
+
+/* Make the CA's keys and self-signed dual root certificate. */
+static int make_root(WC_RNG* rng)
+{
+    int       ret;
+    int       derSz;
+    ecc_key   key;
+    CaKeys    ca;
+    PartTimes times;
+
+    ret = wc_ecc_init(&key);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_make_key_ex(rng, gLvl->curveSz, &key, gLvl->curveId);
+    if (ret == 0) {
+        derSz = wc_EccKeyToDer(&key, gCaEcc, sizeof(gCaEcc));
+        ret = (derSz < 0) ? derSz : 0;
+        gCaEccSz = (word32)derSz;
+    }
+    if (ret == 0) {
+        derSz = wc_EccPublicKeyToDer(&key, gCaEccPub, sizeof(gCaEccPub), 1);
+        ret = (derSz < 0) ? derSz : 0;
+        gCaEccPubSz = (word32)derSz;
+    }
+    wc_ecc_free(&key);
+
+    if (ret == 0) {
+        gCaMlDsaSz = sizeof(gCaMlDsa);
+        derSz = make_ml_dsa_key(rng, gCaMlDsaPub, sizeof(gCaMlDsaPub),
+                                gCaMlDsa, &gCaMlDsaSz);
+        ret = (derSz < 0) ? derSz : 0;
+        gCaMlDsaPubSz = (word32)derSz;
+    }
+    if (ret == 0) {
+        gAltSigAlgSz = SetAlgoID(gLvl->altSigType, gAltSigAlg, oidSigType, 0);
+        if (gAltSigAlgSz <= 0)
+            ret = ALGO_ID_E;
+    }
+    if (ret == 0) {
+        ret = ca_keys_load(&ca, 1);
+    }
+    if (ret == 0) {
+        memset(&times, 0, sizeof(times));
+        gRootSz = make_cert("root.YourDomain.com", 1, NULL, 0, &ca.ecc,
+                            gCaMlDsaPub, gCaMlDsaPubSz, &ca, rng, gRoot,
+                            sizeof(gRoot), &times);
+        ret = (gRootSz < 0) ? gRootSz : 0;
+        ca_keys_free(&ca);
+    }
+
+    return ret;
+}
+
+static void print_parts(const char* what, const char* prep, int n,
+                        PartTimes* t, double wall)
+{
+    double total = t->encode + t->ecdsa + t->mlDsa;
+
+    printf("%-8s %d certificates on %d threads in %.2f s: %.0f certs/s\n",
+           what, n, gNumThreads, wall, n / wall);
+    printf("  per certificate: %s %.3f ms, ECDSA %.3f ms, ML-DSA %.3f ms "
+           "(%.0f%% of the time is ML-DSA)\n", prep, t->encode * 1000 / n,
+           t->ecdsa * 1000 / n, t->mlDsa * 1000 / n,
+           (total > 0) ? t->mlDsa * 100 / total : 0);
+}
+
+#ifdef WOLFSSL_TLS13
+
+/* Data in flight in one direction. */
+typedef struct MemBuf {
+    byte buf[MEM_BUF_SZ];
+    int  len;
+} MemBuf;
+
+/* Certificate chain and signatures asked for in CertificateVerify. */
+typedef struct HsMode {
+    const char* name;
+    int         dual;
+    byte        cks;
+} HsMode;
+
+static const HsMode gHsModes[] = {
+    { "ECDSA chain",       0, 0                               },
+    { "dual, native",      1, WOLFSSL_CKS_SIGSPEC_NATIVE      },
+    { "dual, alternative", 1, WOLFSSL_CKS_SIGSPEC_ALTERNATIVE },
+    { "dual, both",        1, WOLFSSL_CKS_SIGSPEC_BOTH        },
+};
+#define NUM_HS_MODES ((int)(sizeof(gHsModes) / sizeof(gHsModes[0])))
+
+static int mem_send(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemBuf* mem = (MemBuf*)ctx;
+
+    (void)ssl;
+
+    if (sz > MEM_BUF_SZ - mem->len)
+        sz = MEM_BUF_SZ - mem->len;
+    if (sz == 0)
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    memcpy(mem->buf + mem->len, buf, sz);
+    mem->len += sz;
+
+    return sz;
+}
+
+static int mem_recv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemBuf* mem = (MemBuf*)ctx;
+
+    (void)ssl;
+
+    if (mem->len == 0)
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    if (sz > mem->len)
+        sz = mem->len;
+    memcpy(buf, mem->buf, sz);
+    mem->len -= sz;
+    memmove(mem->buf, mem->buf + sz, mem->len);
+
+    return sz;
+}
+
+/* Whether the handshake can continue after a call to connect or accept. */
+static int handshake_step(WOLFSSL* ssl, int ret, int* done)
+{
+    int err;
+
+    if (ret == WOLFSSL_SUCCESS) {
+        *done = 1;
+        return 0;
+    }
+    err = wolfSSL_get_error(ssl, ret);
+    if (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE)
+        return 0;
+    return err;
+}
+
+/* Do a handshake in memory. The client's time includes verifying the chain
+ * and the CertificateVerify signatures. */
+static int handshake(WOLFSSL_CTX* cctx, WOLFSSL_CTX* sctx, double* total,
+                     double* client)
+{
+    int      ret = 0;
+    int      i;
+    int      cliDone = 0;
+    int      srvDone = 0;
+    double   start;
+    double   t;
+    WOLFSSL* cli;
+    WOLFSSL* srv;
+    static MemBuf toSrv;
+    static MemBuf toCli;
+
+    toSrv.len = 0;
+    toCli.len = 0;
+    *client = 0;
+    start = now();
+    cli = wolfSSL_new(cctx);
+    srv = wolfSSL_new(sctx);
+    if (cli == NULL || srv == NULL)
+        ret = MEMORY_E;
+    if (ret == 0) {
+        wolfSSL_SetIOWriteCtx(cli, &toSrv);
+        wolfSSL_SetIOReadCtx(cli, &toCli);
+        wolfSSL_SetIOWriteCtx(srv, &toCli);
+        wolfSSL_SetIOReadCtx(srv, &toSrv);
+    }
+
+    for (i = 0; ret == 0 && (!cliDone || !srvDone); i++) {
+        if (i == MAX_HS_STEPS) {
+            ret = -1;
+            break;
+        }
+        if (!cliDone) {
+            t = now();
+            ret = handshake_step(cli, wolfSSL_connect(cli), &cliDone);
+            *client += now() - t;
+        }
+        if (ret == 0 && !srvDone)
+            ret = handshake_step(srv, wolfSSL_accept(srv), &srvDone);
+    }
+
+    wolfSSL_free(srv);
+    wolfSSL_free(cli);
+    *total = now() - start;
+
+    return ret;
+}
+
+static int compare_double(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return (da > db) - (da < db);
+}
+
+/* Set up a client and server for a chain and time handshakes. */
+static int run_mode(const HsMode* mode, const byte* root, int rootSz,
+                    const byte* cert, int certSz, const byte* key, int keySz,
+                    const byte* altKey, int altKeySz, int num)
+{
+    int          ret = 0;
+    int          i;
+    double       sum = 0;
+    double       cliSum = 0;
+    double       client;
+    double*      lat;
+    WOLFSSL_CTX* cctx;
+    WOLFSSL_CTX* sctx;
+    byte         cks = mode->cks;
+
+    lat = (double*)malloc(sizeof(double) * num);
+    cctx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    sctx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    if (lat == NULL || cctx == NULL || sctx == NULL)
+        ret = MEMORY_E;
+
+    if (ret == 0 && (wolfSSL_CTX_load_verify_buffer(cctx, root, rootSz,
+                         WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+                     wolfSSL_CTX_use_certificate_buffer(sctx, cert, certSz,
+                         WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+                     wolfSSL_CTX_use_PrivateKey_buffer(sctx, key, keySz,
+                         WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)) {
+        fprintf(stderr, "Failed to load the chain for %s\n", mode->name);
+        ret = -1;
+    }
+    if (ret == 0 && mode->dual) {
+        if (wolfSSL_CTX_use_AltPrivateKey_buffer(sctx, altKey, altKeySz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+                wolfSSL_CTX_UseCKS(cctx, &cks, 1) != WOLFSSL_SUCCESS ||
+                wolfSSL_CTX_UseCKS(sctx, &cks, 1) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "Failed to set up %s\n", mode->name);
+            ret = -1;
+        }
+    }
+    if (ret == 0) {
+        wolfSSL_CTX_SetIOSend(cctx, mem_send);
+        wolfSSL_CTX_SetIORecv(cctx, mem_recv);
+        wolfSSL_CTX_SetIOSend(sctx, mem_send);
+        wolfSSL_CTX_SetIORecv(sctx, mem_recv);
+
+        /* Not timed: loads tables. */
+        ret = handshake(cctx, sctx, &lat[0], &client);
+    }
+    for (i = 0; ret == 0 && i < num; i++) {
+        ret = handshake(cctx, sctx, &lat[i], &client);
+        sum += lat[i];
+        cliSum += client;
+    }
+
+    if (ret == 0) {
+        qsort(lat, num, sizeof(double), compare_double);
+        printf("%-18s %8d %9.2f %9.2f %9.2f %10.2f\n", mode->name, certSz,
+               sum * 1000 / num, lat[num / 2] * 1000,
+               lat[(num * 99) / 100] * 1000, cliSum * 1000 / num);
+    }
+    else {
+        fprintf(stderr, "%s handshake failed: %d\n", mode->name, ret);
+    }
+
+    wolfSSL_CTX_free(sctx);
+    wolfSSL_CTX_free(cctx);
+    free(lat);
+
+    return ret;
+}
+
+/* Make ECDSA only and dual server chains from the same keys and time TLS 1.3
+ * handshakes with each. */
+static int run_handshakes(WC_RNG* rng, int num)
+{
+    int       ret;
+    int       i;
+    int       initKey = 0;
+    int       initCa = 0;
+    int       keySz = 0;
+    int       sapkiSz = 0;
+    int       certSz = 0;
+    int       ecdsaRootSz = 0;
+    int       ecdsaCertSz = 0;
+    word32    altKeySz = LARGE_TEMP_SZ;
+    ecc_key   key;
+    CaKeys    ca;
+    PartTimes times;
+    byte*     bufs;
+    byte*     keyDer;
+    byte*     altKey;
+    byte*     sapki;
+    byte*     cert;
+    byte*     ecdsaRoot;
+    byte*     ecdsaCert;
+
+    bufs = (byte*)malloc(LARGE_TEMP_SZ * 6);
+    if (bufs == NULL)
+        return MEMORY_E;
+    keyDer = bufs;
+    altKey = bufs + LARGE_TEMP_SZ;
+    sapki = bufs + LARGE_TEMP_SZ * 2;
+    cert = bufs + LARGE_TEMP_SZ * 3;
+    ecdsaRoot = bufs + LARGE_TEMP_SZ * 4;
+    ecdsaCert = bufs + LARGE_TEMP_SZ * 5;
+    memset(&times, 0, sizeof(times));
+
+    ret = ca_keys_load(&ca, 1);
+    if (ret == 0) {
+        initCa = 1;
+        ret = wc_ecc_init(&key);
+    }
+    if (ret == 0) {
+        initKey = 1;
+        ret = wc_ecc_make_key_ex(rng, gLvl->curveSz, &key, gLvl->curveId);
+    }
+    if (ret == 0) {
+        keySz = wc_EccKeyToDer(&key, keyDer, LARGE_TEMP_SZ);
+        sapkiSz = make_ml_dsa_key(rng, sapki, LARGE_TEMP_SZ, altKey,
+                                  &altKeySz);
+        if (keySz < 0 || sapkiSz < 0)
+            ret = (keySz < 0) ? keySz : sapkiSz;
+    }
+    if (ret == 0) {
+        certSz = make_cert("server.YourDomain.com", 0, gRoot, gRootSz, &key,
+                           sapki, sapkiSz, &ca, rng, cert, LARGE_TEMP_SZ,
+                           &times);
+        ecdsaRootSz = make_cert("root.YourDomain.com", 1, NULL, 0, &ca.ecc,
+                                NULL, 0, &ca, rng, ecdsaRoot, LARGE_TEMP_SZ,
+                                &times);
+        ecdsaCertSz = make_cert("server.YourDomain.com", 0, ecdsaRoot,
+                                ecdsaRootSz, &key, NULL, 0, &ca, rng,
+                                ecdsaCert, LARGE_TEMP_SZ, &times);
+        if (certSz < 0 || ecdsaRootSz < 0 || ecdsaCertSz < 0) {
+            fprintf(stderr, "Failed to make the server chains\n");
+            ret = -1;
+        }
+    }
+
+    if (ret == 0) {
+        printf("\nTLS 1.3 handshakes in memory, %d of each:\n", num);
+        printf("%-18s %8s %9s %9s %9s %10s\n", "Chain, CKS", "Cert B",
+               "Mean ms", "p50 ms", "p99 ms", "Client ms");
+    }
+    for (i = 0; ret == 0 && i < NUM_HS_MODES; i++) {
+        if (gHsModes[i].dual) {
+            ret = run_mode(&gHsModes[i], gRoot, gRootSz, cert, certSz, keyDer,
+                           keySz, altKey, (int)altKeySz, num);
+        }
+        else {
+            ret = run_mode(&gHsModes[i], ecdsaRoot, ecdsaRootSz, ecdsaCert,
+                           ecdsaCertSz, keyDer, keySz, NULL, 0, num);
+        }
+    }
+
+    if (initKey)
+        wc_ecc_free(&key);
+    if (initCa)
+        ca_keys_free(&ca);
+    free(bufs);
+
+    return ret;
+}
+
+#endif /* WOLFSSL_TLS13 */
+
+static void usage(void)
+{
+    fprintf(stderr, "dual_keysig_bench <options>:\n");
+    fprintf(stderr, "  -level <num>      2, 3 or 5, default 2\n");
+    fprintf(stderr, "  -n <num>          Certificates to make and verify, "
+                    "default %d\n", DEF_NUM_CERTS);
+    fprintf(stderr, "  -threads <num>    Number of threads, default: number "
+                    "of cores\n");
+    fprintf(stderr, "  -hs <num>         TLS 1.3 handshakes of each kind, "
+                    "0 for none, default %d\n", DEF_HANDSHAKES);
+}
+
+int main(int argc, char** argv)
+{
+    int       ret;
+    int       i;
+    int       level = 2;
+    int       numHs = DEF_HANDSHAKES;
+    double    wall;
+    WC_RNG    rng;
+    PartTimes sum;
+    Worker*   workers;
+
+    gNumThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    gNumCerts = DEF_NUM_CERTS;
+    if (gNumThreads < 1)
+        gNumThreads = 1;
+    if (gNumThreads > MAX_THREADS)
+        gNumThreads = MAX_THREADS;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-level", 7) == 0) {
+            level = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-n", 3) == 0) {
+            gNumCerts = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-threads", 9) == 0) {
+            gNumThreads = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-hs", 4) == 0) {
+            numHs = atoi(*++argv);
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    for (i = 0; i < NUM_LEVELS; i++) {
+        if (gLevels[i].level == level)
+            gLvl = &gLevels[i];
+    }
+    if (gLvl == NULL || gNumCerts < 1 || gNumThreads < 1 ||
+            gNumThreads > MAX_THREADS || numHs < 0) {
+        usage();
+        return 1;
+    }
+
+    gCerts = (byte**)calloc(gNumCerts, sizeof(byte*));
+    gCertSz = (int*)calloc(gNumCerts, sizeof(int));
+    workers = (Worker*)calloc(gNumThreads, sizeof(Worker));
+    if (gCerts == NULL || gCertSz == NULL || workers == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    wolfSSL_Init();
+    ret = wc_InitRng(&rng);
+    if (ret == 0) {
+        ret = make_root(&rng);
+        if (ret != 0)
+            fprintf(stderr, "Failed to make the root CA: %d\n", ret);
+    }
+
+    if (ret == 0) {
+        printf("%s, root certificate %d bytes\n\n", gLvl->name, gRootSz);
+        ret = run_threads(gen_thread, workers, &sum, &wall);
+        if (ret != 0)
+            fprintf(stderr, "Failed to make certificates: %d\n", ret);
+    }
+    if (ret == 0) {
+        print_parts("Made", "encode", gNumCerts, &sum, wall);
+        printf("  ECDSA signs twice: wc_ParseCert needs a signed certificate "
+               "to make the pre-TBS from\n");
+        if (sum.retries > 0)
+            printf("  %d made again as the clock moved on a second\n",
+                   sum.retries);
+        printf("  first certificate %d bytes\n", gCertSz[0]);
+
+        ret = run_threads(verify_thread, workers, &sum, &wall);
+        if (ret != 0)
+            fprintf(stderr, "Failed to verify certificates: %d\n", ret);
+    }
+    if (ret == 0) {
+        /* The wall time includes both ways of verifying. */
+        print_parts("Verified", "parse", gNumCerts, &sum, wall);
+        printf("  certificate manager, both signatures: %.3f ms, %.0f "
+               "certs/s on %d threads\n", sum.cm * 1000 / gNumCerts,
+               gNumCerts * gNumThreads / sum.cm, gNumThreads);
+    }
+
+#ifdef WOLFSSL_TLS13
+    if (ret == 0 && numHs > 0) {
+        ret = run_handshakes(&rng, numHs);
+    }
+#else
+    if (ret == 0 && numHs > 0)
+        printf("\nTLS 1.3 not compiled in, no handshakes\n");
+#endif
+
+    wc_FreeRng(&rng);
+    wolfSSL_Cleanup();
+    for (i = 0; i < gNumCerts; i++)
+        free(gCerts[i]);
+    free(gCerts);
+    free(gCertSz);
+    free(workers);
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    printf("Please compile wolfSSL with --enable-dual-alg-certs "
+           "--enable-dilithium\n");
+    return 0;
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -37,6 +38,7 @@
 
 //#define DEBUG_BTLE_IO
 #define BTLE_VER 1
+#define BTLE_RX_BUF_SIZE 4096
 
 typedef struct {
     unsigned char  ver;
@@ -56,6 +58,13 @@ typedef struct {
     int fdmosi;
     BtlePkt_t recv;
     BtlePkt_t send;
+    int mtu;
+    int coalesce;
+    BtleStats_t stats;
+    /* Data read from the pipe and not yet returned */
+    unsigned char rxBuf[BTLE_RX_BUF_SIZE];
+    int rxPos;
+    int rxLen;
 } BtleDev_t;
 
 static BtleDev_t gBtleDev;
@@ -73,29 +82,86 @@ static int btle_get_read(BtleDev_t* dev)
     return (dev->role == BTLE_ROLE_SERVER) ? dev->fdmiso : dev->fdmosi;
 }
 
-static int btle_send_block(BtleDev_t* dev, const unsigned char* buf,int len)
+/* Count the link packets needed to carry one write */
+static void btle_count_packets(BtleDev_t* dev, int len)
 {
-    int ret;
+    int payload = dev->mtu - BTLE_ATT_HDR_SIZE;
+    int packets = (len + payload - 1) / payload;
+
+    dev->stats.writes++;
+    dev->stats.packets += packets;
+    dev->stats.bytes += len + packets * BTLE_PKT_OVERHEAD;
+}
+
+/* Write all of the iovecs, adjusting them as parts are written. Returns the
+ * number of bytes written or -1 on error. */
+static int btle_writev_all(BtleDev_t* dev, struct iovec* iov, int cnt)
+{
+    ssize_t ret;
+    int total = 0;
     int fd = btle_get_write(dev);
-    ret = write(fd, buf, len);
+
+    for (;;) {
+        while (cnt > 0 && iov->iov_len == 0) {
+            iov++;
+            cnt--;
+        }
+        if (cnt == 0)
+            break;
+        ret = writev(fd, iov, cnt);
 #ifdef DEBUG_BTLE_IO
-    printf("Write: %d\n", ret);
+        printf("Write: %d\n", (int)ret);
 #endif
-    (void)dev;
-    return ret;
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return -1;
+        total += (int)ret;
+        while (cnt > 0 && (size_t)ret >= iov->iov_len) {
+            ret -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (unsigned char*)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+    if (total > 0)
+        btle_count_packets(dev, total);
+    return total;
+}
+
+static int btle_send_block(BtleDev_t* dev, const unsigned char* buf,int len)
+{
+    struct iovec iov;
+
+    iov.iov_base = (void*)buf;
+    iov.iov_len = len;
+    return btle_writev_all(dev, &iov, 1);
 }
 
 static int btle_recv_block(BtleDev_t* dev, unsigned char* buf, int len,
     int non_block)
 {
     fd_set set;
-    int ret, pos = 0;
+    int ret, pos = 0, avail;
     int fd = btle_get_read(dev);
 
-    FD_ZERO(&set);
-    FD_SET(fd, &set);
-
     while (pos < len) {
+        /* Return data already read first */
+        avail = dev->rxLen - dev->rxPos;
+        if (avail > 0) {
+            if (avail > len - pos)
+                avail = len - pos;
+            memcpy(&buf[pos], &dev->rxBuf[dev->rxPos], avail);
+            dev->rxPos += avail;
+            pos += avail;
+            continue;
+        }
+
+        FD_ZERO(&set);
+        FD_SET(fd, &set);
         ret = select(fd+1, &set, NULL, NULL, NULL);
         if (ret == 0) {
             if (non_block)
@@ -106,12 +172,16 @@ static int btle_recv_block(BtleDev_t* dev, unsigned char* buf, int len,
             return ret;
 
         if (FD_ISSET(fd, &set)) {
-            ret = read(fd, &buf[pos], len - pos);
+            /* Read all that is waiting so that a header and its data take
+             * one read */
+            ret = read(fd, dev->rxBuf, sizeof(dev->rxBuf));
         #ifdef DEBUG_BTLE_IO
             printf("Read: %d\n", ret);
         #endif
             if (ret > 0) {
-                pos += ret;
+                dev->stats.reads++;
+                dev->rxPos = 0;
+                dev->rxLen = ret;
             }
             else {
                 if (errno == EWOULDBLOCK) {
@@ -125,7 +195,6 @@ static int btle_recv_block(BtleDev_t* dev, unsigned char* buf, int len,
             }
         }
     }
-    (void)dev;
 
     return pos;
 }
@@ -160,6 +229,8 @@ int btle_open(void** dev, int role)
     gBtleDev.role = role;
     gBtleDev.fdmiso = fdmiso;
     gBtleDev.fdmosi = fdmosi;
+    gBtleDev.mtu = BTLE_MTU_DEFAULT;
+    gBtleDev.coalesce = 1;
 
     if (dev) {
         *dev = &gBtleDev;
@@ -171,6 +242,7 @@ int btle_open(void** dev, int role)
 int btle_send(const unsigned char* buf, int len, int type, void* context)
 {
     int ret;
+    struct iovec iov[2];
     BtleDev_t* dev = (BtleDev_t*)context;
     if (dev == NULL)
         return -1;
@@ -179,12 +251,27 @@ int btle_send(const unsigned char* buf, int len, int type, void* context)
     dev->send.header.ver = BTLE_VER;
     dev->send.header.type = type;
     dev->send.header.len = len;
-    ret = btle_send_block(dev, (unsigned char*)&dev->send.header,
-        sizeof(dev->send.header));
-    if (ret > 0) {
-        ret = btle_send_block(dev, buf, len);
+    dev->stats.msgs++;
+
+    if (!dev->coalesce) {
+        /* Header and data in separate writes and packets */
+        ret = btle_send_block(dev, (unsigned char*)&dev->send.header,
+            sizeof(dev->send.header));
+        if (ret > 0) {
+            ret = btle_send_block(dev, buf, len);
+        }
+        return ret;
     }
-    return ret;
+
+    /* Header and data in one write so they share packets */
+    iov[0].iov_base = &dev->send.header;
+    iov[0].iov_len = sizeof(dev->send.header);
+    iov[1].iov_base = (void*)buf;
+    iov[1].iov_len = len;
+    ret = btle_writev_all(dev, iov, 2);
+    if (ret < 0)
+        return ret;
+    return len;
 }
 
 int btle_recv_ex(unsigned char* buf, int len, int* type, void* context,
@@ -267,3 +354,34 @@ int btle_msg_pad(unsigned char* buf, int* len, void* context)
     (void)dev;
     return 0;
 }
+
+void btle_set_mtu(void* context, int mtu)
+{
+    BtleDev_t* dev = (BtleDev_t*)context;
+    if (dev == NULL)
+        return;
+
+    if (mtu < BTLE_MTU_MIN)
+        mtu = BTLE_MTU_MIN;
+    dev->mtu = mtu;
+}
+
+void btle_set_coalesce(void* context, int coalesce)
+{
+    BtleDev_t* dev = (BtleDev_t*)context;
+    if (dev == NULL)
+        return;
+
+    dev->coalesce = coalesce;
+}
+
+void btle_get_stats(void* context, BtleStats_t* stats)
+{
+    BtleDev_t* dev = (BtleDev_t*)context;
+    if (dev == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    *stats = dev->stats;
+}
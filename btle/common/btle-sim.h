@@ -23,6 +23,15 @@
 #define BTLE_MSG_MAX_SIZE   1024
 #define BTLE_BLOCK_SIZE     16
 
+/* Default ATT MTU: BLE 4.2 and later with data length extension */
+#define BTLE_MTU_DEFAULT    247
+/* Smallest ATT MTU: BLE 4.0 / 4.1 */
+#define BTLE_MTU_MIN        23
+/* ATT header in each packet, the rest of the MTU carries data */
+#define BTLE_ATT_HDR_SIZE   3
+/* L2CAP and ATT headers on the wire for each packet */
+#define BTLE_PKT_OVERHEAD   7
+
 #define _GNU_SOURCE
 #include <string.h> /* for strnstr */
 
@@ -37,6 +46,16 @@ typedef enum {
     BTLE_PKT_TYPE_MAX,
 } BtlePacket_t;
 
+/* Traffic sent by a device. Packets and wire bytes are what the messages
+ * would take on a BTLE link with the device's MTU. */
+typedef struct {
+    unsigned long msgs;     /* calls to btle_send */
+    unsigned long writes;   /* write system calls */
+    unsigned long reads;    /* read system calls */
+    unsigned long packets;  /* link packets */
+    unsigned long bytes;    /* bytes on the wire, including headers */
+} BtleStats_t;
+
 typedef enum {
     BTLE_ROLE_CLIENT,
     BTLE_ROLE_SERVER,
@@ -49,3 +68,6 @@ int  btle_recv(unsigned char* buf, int len, int* type, void* context);
 int  btle_recv_ex(unsigned char* buf, int len, int* type, void* context, int non_block);
 void btle_close(void* context);
 int  btle_msg_pad(unsigned char* buf, int* len, void* context);
+void btle_set_mtu(void* context, int mtu);
+void btle_set_coalesce(void* context, int coalesce);
+void btle_get_stats(void* context, BtleStats_t* stats);
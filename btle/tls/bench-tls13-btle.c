@@ -0,0 +1,451 @@
+/* bench-tls13-btle.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ *=============================================================================
+ *
+ * Benchmark of TLS v1.3 over the BTLE simulator: packets and bytes on the
+ * wire per handshake and per KB of application data.
+ *
+ * The client and server run in two processes over the simulator's pipes. Each
+ * is run with the header and data of a message in separate writes (and link
+ * packets), with them coalesced into one write, and coalesced with a maximum
+ * fragment length chosen for the link MTU.
+ */
+
+#include "btle-sim.h"
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define CERT_FILE "../../certs/server-cert.pem"
+#define KEY_FILE  "../../certs/server-key.pem"
+#define CA_FILE   "../../certs/ca-cert.pem"
+
+/* TLS v1.3 record header, inner content type and AEAD tag */
+#define TLS13_RECORD_OVERHEAD  (5 + 1 + 16)
+/* Header added to each message by the simulator */
+#define BTLE_MSG_HDR_SIZE      4
+
+#define DEF_DATA_KB     16
+#define DEF_WRITE_SZ    1024
+#define DEF_MAX_RECORD  1024
+#define MAX_WRITE_SZ    16384
+
+typedef struct CbCtx {
+    void* devCtx;
+} CbCtx_t;
+
+typedef struct BenchCfg {
+    const char* name;
+    int coalesce;
+    int mfl;        /* WOLFSSL_MFL_* or 0 for none */
+    int mtu;
+    int dataSz;
+    int writeSz;
+} BenchCfg_t;
+
+/* Traffic sent by one side */
+typedef struct BenchResult {
+    int ok;
+    BtleStats_t hs;
+    BtleStats_t data;
+} BenchResult_t;
+
+#ifdef HAVE_MAX_FRAGMENT
+/* Maximum fragment lengths that can be requested */
+static const struct {
+    int code;
+    int size;
+} kMfl[] = {
+    { WOLFSSL_MFL_2_8,  256 },
+    { WOLFSSL_MFL_2_9,  512 },
+    { WOLFSSL_MFL_2_10, 1024 },
+    { WOLFSSL_MFL_2_11, 2048 },
+    { WOLFSSL_MFL_2_12, 4096 },
+};
+#endif
+
+
+static int btleIORx(WOLFSSL *ssl, char *buf, int sz, void *ctx)
+{
+    int recvd;
+    CbCtx_t* cbCtx = (CbCtx_t*)ctx;
+
+    recvd = btle_recv((unsigned char*)buf, sz, NULL, cbCtx->devCtx);
+    if (recvd == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    }
+    return recvd;
+}
+
+static int btleIOTx(WOLFSSL *ssl, char *buf, int sz, void *ctx)
+{
+    int sent;
+    CbCtx_t* cbCtx = (CbCtx_t*)ctx;
+
+    sent = btle_send((unsigned char*)buf, sz, BTLE_PKT_TYPE_TLS, cbCtx->devCtx);
+    if (sent == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    }
+    return sent;
+}
+
+#ifdef HAVE_MAX_FRAGMENT
+/* Find the maximum fragment length, up to maxRecord, whose full records waste
+ * the least of their last link packet. */
+static int btle_mfl_for_mtu(int mtu, int maxRecord, int* fragSz)
+{
+    int i, wire, packets;
+    int payload = mtu - BTLE_ATT_HDR_SIZE;
+    int best = -1;
+    double eff, bestEff = 0;
+
+    for (i = 0; i < (int)(sizeof(kMfl) / sizeof(kMfl[0])); i++) {
+        if (kMfl[i].size > maxRecord)
+            continue;
+        wire = kMfl[i].size + TLS13_RECORD_OVERHEAD + BTLE_MSG_HDR_SIZE;
+        packets = (wire + payload - 1) / payload;
+        eff = (double)kMfl[i].size / (packets * payload);
+        if (eff >= bestEff) {
+            bestEff = eff;
+            best = i;
+        }
+    }
+    if (best < 0)
+        return 0;
+
+    *fragSz = kMfl[best].size;
+    return kMfl[best].code;
+}
+#endif
+
+static void stats_sub(BtleStats_t* r, const BtleStats_t* a,
+    const BtleStats_t* b)
+{
+    r->msgs = a->msgs - b->msgs;
+    r->writes = a->writes - b->writes;
+    r->reads = a->reads - b->reads;
+    r->packets = a->packets - b->packets;
+    r->bytes = a->bytes - b->bytes;
+}
+
+static void stats_add(BtleStats_t* r, const BtleStats_t* a)
+{
+    r->msgs += a->msgs;
+    r->writes += a->writes;
+    r->reads += a->reads;
+    r->packets += a->packets;
+    r->bytes += a->bytes;
+}
+
+/* Run one side: handshake, then the client sends the data and the server
+ * replies with one byte once it has all of it. */
+static int run_side(int role, const BenchCfg_t* cfg, BenchResult_t* res)
+{
+    int ret = -1, err, done = 0;
+    WOLFSSL_CTX* ctx = NULL;
+    WOLFSSL* ssl = NULL;
+    CbCtx_t cBctx;
+    BtleStats_t start;
+    static byte buf[MAX_WRITE_SZ];
+
+    memset(&cBctx, 0, sizeof(cBctx));
+    memset(res, 0, sizeof(*res));
+
+    ret = btle_open(&cBctx.devCtx, role);
+    if (ret != 0) {
+        printf("btle_open failed %d! errno %d\n", ret, errno);
+        goto done;
+    }
+    btle_set_mtu(cBctx.devCtx, cfg->mtu);
+    btle_set_coalesce(cBctx.devCtx, cfg->coalesce);
+    ret = -1;
+
+    if (role == BTLE_ROLE_CLIENT)
+        ctx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    else
+        ctx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    if (ctx == NULL) {
+        printf("Error creating WOLFSSL_CTX\n");
+        goto done;
+    }
+    wolfSSL_CTX_SetIOSend(ctx, btleIOTx);
+    wolfSSL_CTX_SetIORecv(ctx, btleIORx);
+
+    if (role == BTLE_ROLE_CLIENT) {
+        if (wolfSSL_CTX_load_verify_locations(ctx, CA_FILE, NULL)
+                != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "ERROR: failed to load %s, please check the "
+                "file.\n", CA_FILE);
+            goto done;
+        }
+    }
+    else {
+        if (wolfSSL_CTX_use_certificate_file(ctx, CERT_FILE,
+                WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_use_PrivateKey_file(ctx, KEY_FILE,
+                WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "ERROR: failed to load %s or %s, please check "
+                "the files.\n", CERT_FILE, KEY_FILE);
+            goto done;
+        }
+    }
+
+    ssl = wolfSSL_new(ctx);
+    if (ssl == NULL) {
+        printf("Error creating WOLFSSL\n");
+        goto done;
+    }
+    wolfSSL_SetIOReadCtx(ssl, &cBctx);
+    wolfSSL_SetIOWriteCtx(ssl, &cBctx);
+
+#ifdef HAVE_MAX_FRAGMENT
+    /* The client asks, then records both ways are limited */
+    if (cfg->mfl != 0 && role == BTLE_ROLE_CLIENT &&
+            wolfSSL_UseMaxFragment(ssl, (unsigned char)cfg->mfl)
+                != WOLFSSL_SUCCESS) {
+        printf("Max fragment length not supported\n");
+        goto done;
+    }
+#endif
+
+    do {
+        if (role == BTLE_ROLE_CLIENT)
+            ret = wolfSSL_connect(ssl);
+        else
+            ret = wolfSSL_accept(ssl);
+        err = wolfSSL_get_error(ssl, ret);
+    } while (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE);
+    if (ret != WOLFSSL_SUCCESS) {
+        printf("TLS handshake error %d\n", err);
+        goto done;
+    }
+    btle_get_stats(cBctx.devCtx, &res->hs);
+    start = res->hs;
+
+    memset(buf, 0x5a, sizeof(buf));
+    while (done < cfg->dataSz) {
+        int sz = cfg->dataSz - done;
+        if (sz > cfg->writeSz)
+            sz = cfg->writeSz;
+        do {
+            if (role == BTLE_ROLE_CLIENT)
+                ret = wolfSSL_write(ssl, buf, sz);
+            else
+                ret = wolfSSL_read(ssl, buf, sz);
+            err = wolfSSL_get_error(ssl, ret);
+        } while (err == WOLFSSL_ERROR_WANT_READ ||
+                 err == WOLFSSL_ERROR_WANT_WRITE);
+        if (ret <= 0) {
+            printf("TLS data error %d\n", err);
+            goto done;
+        }
+        done += ret;
+    }
+
+    do {
+        if (role == BTLE_ROLE_CLIENT)
+            ret = wolfSSL_read(ssl, buf, 1);
+        else
+            ret = wolfSSL_write(ssl, buf, 1);
+        err = wolfSSL_get_error(ssl, ret);
+    } while (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE);
+    if (ret != 1) {
+        printf("TLS data error %d\n", err);
+        goto done;
+    }
+
+    btle_get_stats(cBctx.devCtx, &res->data);
+    stats_sub(&res->data, &res->data, &start);
+    res->ok = 1;
+    ret = 0;
+
+done:
+    if (ssl) {
+        wolfSSL_free(ssl);
+    }
+    if (ctx) {
+        wolfSSL_CTX_free(ctx);
+    }
+    if (cBctx.devCtx != NULL) {
+        btle_close(cBctx.devCtx);
+    }
+
+    return ret;
+}
+
+/* Run the server in a child process and the client in this one */
+static int run_config(const BenchCfg_t* cfg)
+{
+    int fds[2];
+    int ret;
+    int status;
+    pid_t pid;
+    BenchResult_t cli, srv;
+    BtleStats_t hs, data;
+    double kb = cfg->dataSz / 1024.0;
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return -1;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        run_side(BTLE_ROLE_SERVER, cfg, &srv);
+        if (write(fds[1], &srv, sizeof(srv)) != (ssize_t)sizeof(srv))
+            _exit(1);
+        _exit(0);
+    }
+    close(fds[1]);
+
+    ret = run_side(BTLE_ROLE_CLIENT, cfg, &cli);
+    if (read(fds[0], &srv, sizeof(srv)) != (ssize_t)sizeof(srv))
+        srv.ok = 0;
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    if (ret != 0 || !cli.ok || !srv.ok) {
+        printf("%-24s failed\n", cfg->name);
+        return -1;
+    }
+
+    hs = cli.hs;
+    stats_add(&hs, &srv.hs);
+    data = cli.data;
+    stats_add(&data, &srv.data);
+    printf("%-24s %7lu %8lu %9lu %8.1f %9.1f %8.1f\n", cfg->name,
+        hs.packets, hs.bytes, hs.writes, data.packets / kb, data.bytes / kb,
+        data.writes / kb);
+
+    return 0;
+}
+
+static void Usage(void)
+{
+    printf("bench-tls13-btle " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-m <num>    Link ATT MTU, default %d\n", BTLE_MTU_DEFAULT);
+    printf("-d <num>    KB of application data, default %d\n", DEF_DATA_KB);
+    printf("-w <num>    Bytes per application write, default %d\n",
+        DEF_WRITE_SZ);
+    printf("-r <num>    Largest record fragment to negotiate, default %d\n",
+        DEF_MAX_RECORD);
+}
+
+int main(int argc, char** argv)
+{
+    int ch;
+    int ret = 0;
+    int mtu = BTLE_MTU_DEFAULT;
+    int dataKb = DEF_DATA_KB;
+    int writeSz = DEF_WRITE_SZ;
+    int maxRecord = DEF_MAX_RECORD;
+    int fragSz = 0;
+    char mflName[32];
+    BenchCfg_t cfg;
+
+    while ((ch = getopt(argc, argv, "?m:d:w:r:")) != -1) {
+        switch (ch) {
+            case 'm':
+                mtu = atoi(optarg);
+                break;
+            case 'd':
+                dataKb = atoi(optarg);
+                break;
+            case 'w':
+                writeSz = atoi(optarg);
+                break;
+            case 'r':
+                maxRecord = atoi(optarg);
+                break;
+            case '?':
+            default:
+                Usage();
+                return 0;
+        }
+    }
+    if (mtu < BTLE_MTU_MIN || dataKb < 1 || writeSz < 1 ||
+            writeSz > MAX_WRITE_SZ) {
+        Usage();
+        return 1;
+    }
+
+    wolfSSL_Init();
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mtu = mtu;
+    cfg.dataSz = dataKb * 1024;
+    cfg.writeSz = writeSz;
+
+    printf("ATT MTU %d, %d KB of data in %d byte writes\n", mtu, dataKb,
+        writeSz);
+    printf("%-24s %7s %8s %9s %8s %9s %8s\n", "", "hs pkts", "hs bytes",
+        "hs writes", "pkts/KB", "bytes/KB", "writes/KB");
+
+    cfg.name = "separate header";
+    cfg.coalesce = 0;
+    ret = run_config(&cfg);
+
+    if (ret == 0) {
+        cfg.name = "coalesced";
+        cfg.coalesce = 1;
+        ret = run_config(&cfg);
+    }
+
+#ifdef HAVE_MAX_FRAGMENT
+    if (ret == 0) {
+        cfg.mfl = btle_mfl_for_mtu(mtu, maxRecord, &fragSz);
+        if (cfg.mfl == 0) {
+            printf("No max fragment length up to %d\n", maxRecord);
+        }
+        else {
+            snprintf(mflName, sizeof(mflName), "coalesced, MFL %d", fragSz);
+            cfg.name = mflName;
+            ret = run_config(&cfg);
+        }
+    }
+#else
+    printf("Build wolfSSL with --enable-maxfragment for the max fragment "
+           "length run\n");
+    (void)maxRecord;
+    (void)fragSz;
+    (void)mflName;
+#endif
+
+    wolfSSL_Cleanup();
+
+    return ret;
+}
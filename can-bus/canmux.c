@@ -0,0 +1,412 @@
+/* canmux.c
+ *
+ * Copyright (C) 2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include "canmux.h"
+
+/* Approximate bits on the wire for a frame, ignoring bit stuffing. CAN FD
+ * frames are counted without bit rate switching. */
+#define CLASSIC_FRAME_BITS 47
+#define FD_FRAME_BITS      67
+
+struct sim_entry {
+    struct canfd_frame frame;
+    double deliver;
+};
+
+/* Frames on their way to one side of the bus */
+struct sim_queue {
+    struct sim_entry entry[CANMUX_SIM_QUEUE];
+    int head;
+    int count;
+};
+
+struct canmux_sim_bus {
+    struct sim_queue queue[2];
+    long bitrate;
+    /* Time at which the bus is next idle */
+    double bus_free;
+    int refs;
+};
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+int canmux_open(struct canmux_port *port, const char *interface,
+        const canid_t *rx_ids, int num_ids, int fd_frames)
+{
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+    struct can_filter *rfilter;
+    int sock;
+    int i;
+
+    memset(port, 0, sizeof(*port));
+    port->fd = -1;
+
+    rfilter = calloc((size_t)num_ids, sizeof(*rfilter));
+    if (rfilter == NULL) {
+        return -1;
+    }
+    for (i = 0; i < num_ids; i++) {
+        rfilter[i].can_id = rx_ids[i];
+        rfilter[i].can_mask = CAN_SFF_MASK;
+    }
+
+    if ((sock = socket(PF_CAN, SOCK_RAW, CAN_RAW)) < 0) {
+        perror("Socket open error\n");
+        free(rfilter);
+        return -1;
+    }
+    /* Let the kernel drop frames of other sessions and nodes */
+    setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, rfilter,
+            (socklen_t)(sizeof(*rfilter) * (size_t)num_ids));
+    free(rfilter);
+
+    if (fd_frames && setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FD_FRAMES,
+                &fd_frames, sizeof(fd_frames)) < 0) {
+        perror("CAN FD frames not supported\n");
+        close(sock);
+        return -1;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface, IFNAMSIZ - 1);
+    if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0) {
+        perror("Interface not found\n");
+        close(sock);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Bind error\n");
+        close(sock);
+        return -1;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+    port->fd = sock;
+    port->fd_frames = fd_frames;
+    return 0;
+}
+
+int canmux_sim_open(struct canmux_port *a, struct canmux_port *b,
+        int fd_frames, long bitrate)
+{
+    struct canmux_sim_bus *bus = calloc(1, sizeof(*bus));
+
+    if (bus == NULL) {
+        return -1;
+    }
+    bus->bitrate = bitrate;
+    bus->refs = 2;
+
+    memset(a, 0, sizeof(*a));
+    memset(b, 0, sizeof(*b));
+    a->fd = -1;
+    a->fd_frames = fd_frames;
+    a->sim = bus;
+    a->sim_side = 0;
+    b->fd = -1;
+    b->fd_frames = fd_frames;
+    b->sim = bus;
+    b->sim_side = 1;
+
+    return 0;
+}
+
+void canmux_close(struct canmux_port *port)
+{
+    if (port->sim != NULL) {
+        if (--port->sim->refs == 0) {
+            free(port->sim);
+        }
+        port->sim = NULL;
+    }
+    if (port->fd >= 0) {
+        close(port->fd);
+        port->fd = -1;
+    }
+}
+
+int canmux_frame_payload(const struct canmux_port *port)
+{
+    /* CAN FD frames give up a byte to hold the length as the frame length
+     * is rounded up to a valid data length code. */
+    return port->fd_frames ? CANFD_MAX_DLEN - 1 : CAN_MAX_DLEN;
+}
+
+/* Round up to a length that has a CAN FD data length code */
+static int fd_frame_len(int len)
+{
+    static const int valid[] = { 8, 12, 16, 20, 24, 32, 48, 64 };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(valid) / sizeof(valid[0])); i++) {
+        if (len <= valid[i]) {
+            return valid[i];
+        }
+    }
+    return CANFD_MAX_DLEN;
+}
+
+void canmux_frame_set(const struct canmux_port *port, struct canfd_frame *frame,
+        canid_t id, const uint8_t *data, int len)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->can_id = id;
+    if (port->fd_frames) {
+        frame->data[0] = (uint8_t)len;
+        memcpy(frame->data + 1, data, (size_t)len);
+        frame->len = (uint8_t)fd_frame_len(len + 1);
+    }
+    else {
+        memcpy(frame->data, data, (size_t)len);
+        frame->len = (uint8_t)len;
+    }
+}
+
+int canmux_frame_get(const struct canmux_port *port,
+        const struct canfd_frame *frame, const uint8_t **data)
+{
+    int len;
+
+    if (port->fd_frames) {
+        len = frame->len > 0 ? frame->data[0] : 0;
+        if (len >= frame->len) {
+            return -1;
+        }
+        *data = frame->data + 1;
+    }
+    else {
+        len = frame->len;
+        *data = frame->data;
+    }
+
+    return len;
+}
+
+struct canfd_frame *canmux_tx_frame(struct canmux_port *port)
+{
+    if (port->tx_count == CANMUX_BATCH && canmux_flush(port) == CANMUX_BATCH) {
+        return NULL;
+    }
+    return &port->tx[port->tx_count++];
+}
+
+static double sim_frame_time(const struct canmux_sim_bus *bus,
+        const struct canfd_frame *frame, int fd_frames)
+{
+    int bits;
+
+    if (bus->bitrate == 0) {
+        return 0;
+    }
+    bits = (fd_frames ? FD_FRAME_BITS : CLASSIC_FRAME_BITS) + 8 * frame->len;
+    return (double)bits / (double)bus->bitrate;
+}
+
+static int sim_flush(struct canmux_port *port)
+{
+    struct canmux_sim_bus *bus = port->sim;
+    struct sim_queue *q = &bus->queue[!port->sim_side];
+    struct sim_entry *e;
+    double t = now();
+    int i;
+
+    for (i = 0; i < port->tx_count && q->count < CANMUX_SIM_QUEUE; i++) {
+        /* Frames from both sides share the bus one at a time */
+        if (bus->bus_free < t) {
+            bus->bus_free = t;
+        }
+        bus->bus_free += sim_frame_time(bus, &port->tx[i], port->fd_frames);
+
+        e = &q->entry[(q->head + q->count) % CANMUX_SIM_QUEUE];
+        e->frame = port->tx[i];
+        e->deliver = bus->bus_free;
+        q->count++;
+    }
+
+    return i;
+}
+
+static int sock_flush(struct canmux_port *port)
+{
+    struct mmsghdr msgs[CANMUX_BATCH];
+    struct iovec iov[CANMUX_BATCH];
+    int i;
+    int sent;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < port->tx_count; i++) {
+        iov[i].iov_base = &port->tx[i];
+        /* A classic frame has the same layout as the start of a CAN FD
+         * frame */
+        iov[i].iov_len = port->fd_frames ? CANFD_MTU : CAN_MTU;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    sent = sendmmsg(port->fd, msgs, (unsigned int)port->tx_count, 0);
+    /* Transmit queue full: try again later */
+    if (sent < 0) {
+        sent = 0;
+    }
+    return sent;
+}
+
+int canmux_flush(struct canmux_port *port)
+{
+    int sent;
+
+    if (port->tx_count == 0) {
+        return 0;
+    }
+
+    if (port->sim != NULL) {
+        sent = sim_flush(port);
+    }
+    else {
+        sent = sock_flush(port);
+    }
+    port->calls_tx++;
+    port->frames_tx += (uint64_t)sent;
+
+    port->tx_count -= sent;
+    memmove(port->tx, port->tx + sent,
+            (size_t)port->tx_count * sizeof(port->tx[0]));
+
+    return port->tx_count;
+}
+
+static int sim_recv(struct canmux_port *port)
+{
+    struct sim_queue *q = &port->sim->queue[port->sim_side];
+    double t = now();
+    int n = 0;
+
+    while (n < CANMUX_BATCH && q->count > 0 &&
+            q->entry[q->head].deliver <= t) {
+        port->rx[n++] = q->entry[q->head].frame;
+        q->head = (q->head + 1) % CANMUX_SIM_QUEUE;
+        q->count--;
+    }
+
+    return n;
+}
+
+static int sock_recv(struct canmux_port *port)
+{
+    struct mmsghdr msgs[CANMUX_BATCH];
+    struct iovec iov[CANMUX_BATCH];
+    int i;
+    int n;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < CANMUX_BATCH; i++) {
+        iov[i].iov_base = &port->rx[i];
+        iov[i].iov_len = port->fd_frames ? CANFD_MTU : CAN_MTU;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    n = recvmmsg(port->fd, msgs, CANMUX_BATCH, MSG_DONTWAIT, NULL);
+    if (n <= 0) {
+        return 0;
+    }
+    for (i = 0; i < n; i++) {
+        /* Classic frames are not from a peer using CAN FD: drop them */
+        if (msgs[i].msg_len == CAN_MTU && port->fd_frames) {
+            port->rx[i].len = 0;
+        }
+    }
+
+    return n;
+}
+
+int canmux_recv(struct canmux_port *port)
+{
+    int n;
+
+    if (port->sim != NULL) {
+        n = sim_recv(port);
+    }
+    else {
+        n = sock_recv(port);
+    }
+    if (n > 0) {
+        port->calls_rx++;
+        port->frames_rx += (uint64_t)n;
+    }
+
+    return n;
+}
+
+void canmux_wait(struct canmux_port *port, int timeout)
+{
+    struct pollfd p[1];
+    struct sim_queue *q;
+    double wait;
+    struct timespec ts;
+    int i;
+
+    if (port->sim == NULL) {
+        p[0].fd = port->fd;
+        p[0].events = POLLIN;
+        poll(p, 1, timeout);
+        return;
+    }
+
+    /* Both ends of a simulated bus are in this process: sleep until the next
+     * frame for either has crossed the bus */
+    wait = timeout / 1000.0;
+    for (i = 0; i < 2; i++) {
+        q = &port->sim->queue[i];
+        if (q->count > 0 && q->entry[q->head].deliver - now() < wait) {
+            wait = q->entry[q->head].deliver - now();
+        }
+    }
+    if (wait > 0) {
+        ts.tv_sec = (time_t)wait;
+        ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1000000000);
+        nanosleep(&ts, NULL);
+    }
+}
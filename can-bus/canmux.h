@@ -0,0 +1,86 @@
+/* canmux.h
+ *
+ * Copyright (C) 2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef  __CANMUX_H__
+#define __CANMUX_H__
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <inttypes.h>
+
+/* Frames read or written with one system call */
+#define CANMUX_BATCH 64
+/* Frames that can be in flight in each direction of the simulated bus */
+#define CANMUX_SIM_QUEUE 4096
+
+/* A simulated bus between two ports in the same process */
+struct canmux_sim_bus;
+
+/* One node on a bus: a CAN_RAW socket or one end of a simulated bus. Frames
+ * are always held as CAN FD frames, classic frames have a length of at most
+ * CAN_MAX_DLEN. */
+struct canmux_port {
+    int fd;
+    int fd_frames;
+    struct canmux_sim_bus *sim;
+    int sim_side;
+
+    struct canfd_frame tx[CANMUX_BATCH];
+    int tx_count;
+    struct canfd_frame rx[CANMUX_BATCH];
+
+    uint64_t frames_rx;
+    uint64_t frames_tx;
+    uint64_t calls_rx;
+    uint64_t calls_tx;
+};
+
+/* Open a CAN_RAW socket on the interface that only receives frames with the
+ * identifiers given. */
+int canmux_open(struct canmux_port *port, const char *interface,
+        const canid_t *rx_ids, int num_ids, int fd_frames);
+/* Create a simulated bus and the ports on both ends. A bitrate of 0 delivers
+ * frames immediately. */
+int canmux_sim_open(struct canmux_port *a, struct canmux_port *b,
+        int fd_frames, long bitrate);
+void canmux_close(struct canmux_port *port);
+
+/* Payload bytes carried by each frame on the port */
+int canmux_frame_payload(const struct canmux_port *port);
+/* Get a frame to fill in from the transmit batch, flushing it if full.
+ * Returns NULL when the bus can take no more frames for now. */
+struct canfd_frame *canmux_tx_frame(struct canmux_port *port);
+/* Send the transmit batch. Returns the number of frames still waiting. */
+int canmux_flush(struct canmux_port *port);
+/* Read a batch of frames into port->rx without waiting. Returns the number of
+ * frames read. */
+int canmux_recv(struct canmux_port *port);
+/* Wait up to timeout milliseconds for frames to be readable. For a simulated
+ * bus, waits for frames to either end. */
+void canmux_wait(struct canmux_port *port, int timeout);
+
+/* Put stream data into a frame and get it back out */
+void canmux_frame_set(const struct canmux_port *port, struct canfd_frame *frame,
+        canid_t id, const uint8_t *data, int len);
+int canmux_frame_get(const struct canmux_port *port,
+        const struct canfd_frame *frame, const uint8_t **data);
+
+#endif /* __CANMUX_H__ */
@@ -0,0 +1,630 @@
+/* gateway.c
+ *
+ * Copyright (C) 2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* A gateway terminating many TLS sessions over one CAN bus socket.
+ *
+ * Each session uses a pair of arbitration IDs: the ECU sends on
+ * base + 2 * session and the gateway on base + 2 * session + 1. All sessions
+ * share one socket, frames are read and written in batches and handed to the
+ * session by arbitration ID. TLS records are carried as a stream of frame
+ * payloads, in order, which CAN guarantees for frames of one ID.
+ *
+ * With -i the gateway, or with -c the ECUs, run on a CAN interface. Without
+ * -i both run in this process over a simulated bus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "canmux.h"
+
+#define ERR_MSG_LEN 80
+
+/* Default first arbitration ID */
+#define DEF_BASE_ID 0x100
+#define DEF_SESSIONS 16
+/* Default application data the ECU sends in each session */
+#define DEF_DATA_LEN 4096
+/* Default simulated bus bitrate */
+#define DEF_BITRATE 500000
+/* Default seconds to wait for all sessions to complete */
+#define DEF_TIMEOUT 60
+#define MAX_SESSIONS 128
+/* Stream data received and not yet read by TLS */
+#define RX_BUF_LEN (16 * 1024)
+/* Most application data written by an ECU at a time */
+#define WRITE_CHUNK 1024
+
+enum session_state {
+    SESSION_HANDSHAKE,
+    SESSION_DATA,
+    SESSION_ACK,
+    SESSION_DONE,
+    SESSION_FAILED
+};
+
+struct session {
+    int index;
+    int is_client;
+    canid_t rx_id;
+    canid_t tx_id;
+    struct canmux_port *port;
+    WOLFSSL *ssl;
+    enum session_state state;
+
+    uint8_t rx[RX_BUF_LEN];
+    int rx_len;
+
+    int data_len;
+    int data_done;
+    double start;
+    double hs_time;
+    double data_time;
+};
+
+/* The sessions of one side of the bus */
+struct side {
+    int is_client;
+    struct canmux_port *port;
+    WOLFSSL_CTX *ctx;
+    struct session *sessions;
+    int num;
+    uint64_t dropped;
+    /* Sessions failed because a frame didn't fit in the receive buffer */
+    int overflowed;
+};
+
+static volatile int keep_running = 1;
+
+
+static void sig_handle(int dummy)
+{
+    (void) dummy;
+    keep_running = 0;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Function callback for wolfSSL to read stream data received for the
+ * session */
+static int session_recv(WOLFSSL *ssl, char *buf, int sz, void *ctx)
+{
+    struct session *s = (struct session*)ctx;
+
+    (void) ssl;
+
+    if (s->rx_len == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    }
+    if (sz > s->rx_len) {
+        sz = s->rx_len;
+    }
+    memcpy(buf, s->rx, (size_t)sz);
+    s->rx_len -= sz;
+    memmove(s->rx, s->rx + sz, (size_t)s->rx_len);
+
+    return sz;
+}
+
+/* Function callback for wolfSSL to send stream data as frames in the port's
+ * transmit batch */
+static int session_send(WOLFSSL *ssl, char *buf, int sz, void *ctx)
+{
+    struct session *s = (struct session*)ctx;
+    int payload = canmux_frame_payload(s->port);
+    int sent = 0;
+    int len;
+    struct canfd_frame *frame;
+
+    (void) ssl;
+
+    while (sent < sz) {
+        frame = canmux_tx_frame(s->port);
+        if (frame == NULL) {
+            break;
+        }
+        len = sz - sent;
+        if (len > payload) {
+            len = payload;
+        }
+        canmux_frame_set(s->port, frame, s->tx_id, (uint8_t*)buf + sent,
+                len);
+        sent += len;
+    }
+    if (sent == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    }
+
+    return sent;
+}
+
+static WOLFSSL_CTX *new_ctx(int is_client)
+{
+    int ret;
+    WOLFSSL_CTX *ctx;
+
+    if (is_client) {
+        ctx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    } else {
+        ctx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    }
+    if (!ctx) {
+        fprintf(stderr, "Could not init wolfSSL context\n");
+        return NULL;
+    }
+
+    if (is_client) {
+        ret = wolfSSL_CTX_load_verify_locations(ctx, "ca.crt", NULL);
+    } else {
+        ret = wolfSSL_CTX_use_certificate_file(ctx, "server.pem",
+                WOLFSSL_FILETYPE_PEM);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CTX_use_PrivateKey_file(ctx, "server.key",
+                    WOLFSSL_FILETYPE_PEM);
+        }
+    }
+    if (ret != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load cert or key, "
+                "please run generate_ssl.sh.\n");
+        wolfSSL_CTX_free(ctx);
+        return NULL;
+    }
+
+    wolfSSL_CTX_SetIORecv(ctx, session_recv);
+    wolfSSL_CTX_SetIOSend(ctx, session_send);
+
+    return ctx;
+}
+
+static int side_init(struct side *side, int is_client, struct canmux_port *port,
+        int num, canid_t base, int data_len)
+{
+    int i;
+    struct session *s;
+
+    memset(side, 0, sizeof(*side));
+    side->is_client = is_client;
+    side->port = port;
+    side->num = num;
+    side->ctx = new_ctx(is_client);
+    if (side->ctx == NULL) {
+        return -1;
+    }
+    side->sessions = calloc((size_t)num, sizeof(*side->sessions));
+    if (side->sessions == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < num; i++) {
+        s = &side->sessions[i];
+        s->index = i;
+        s->is_client = is_client;
+        s->rx_id = base + 2 * (canid_t)i + (is_client ? 1 : 0);
+        s->tx_id = base + 2 * (canid_t)i + (is_client ? 0 : 1);
+        s->port = port;
+        s->data_len = data_len;
+        s->ssl = wolfSSL_new(side->ctx);
+        if (!s->ssl) {
+            fprintf(stderr, "Could not init wolfSSL\n");
+            return -1;
+        }
+        wolfSSL_SetIOReadCtx(s->ssl, s);
+        wolfSSL_SetIOWriteCtx(s->ssl, s);
+    }
+
+    return 0;
+}
+
+static void side_free(struct side *side)
+{
+    int i;
+
+    for (i = 0; side->sessions != NULL && i < side->num; i++) {
+        wolfSSL_free(side->sessions[i].ssl);
+    }
+    free(side->sessions);
+    wolfSSL_CTX_free(side->ctx);
+}
+
+/* Whether a batch of frames can be read without any session's receive
+ * buffer overflowing. Reading stops until the sessions have drained their
+ * buffers - unread frames wait in the socket or the simulated bus. */
+static int side_can_recv(const struct side *side)
+{
+    int i;
+    int room = CANMUX_BATCH * canmux_frame_payload(side->port);
+    const struct session *s;
+
+    for (i = 0; i < side->num; i++) {
+        s = &side->sessions[i];
+        if (s->state != SESSION_DONE && s->state != SESSION_FAILED &&
+                RX_BUF_LEN - s->rx_len < room) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Hand each received frame to the session it is addressed to */
+static void side_demux(struct side *side, canid_t base, int n)
+{
+    int i;
+    int len;
+    canid_t id;
+    canid_t idx;
+    const uint8_t *data;
+    struct session *s;
+
+    for (i = 0; i < n; i++) {
+        id = side->port->rx[i].can_id & CAN_SFF_MASK;
+        idx = (id - base) / 2;
+        if (id < base || idx >= (canid_t)side->num ||
+                (id - base) % 2 != (side->is_client ? 1u : 0u)) {
+            side->dropped++;
+            continue;
+        }
+        s = &side->sessions[idx];
+
+        len = canmux_frame_get(side->port, &side->port->rx[i], &data);
+        if (len < 0 || s->state == SESSION_DONE ||
+                s->state == SESSION_FAILED) {
+            side->dropped++;
+            continue;
+        }
+        /* Stream data can't be lost - the session can't go on without it */
+        if (s->rx_len + len > RX_BUF_LEN) {
+            fprintf(stderr, "Session %d: receive buffer overflow\n",
+                    s->index);
+            s->state = SESSION_FAILED;
+            side->overflowed++;
+            side->dropped++;
+            continue;
+        }
+        /* The gateway's session starts with its first frame */
+        if (s->start == 0) {
+            s->start = now();
+        }
+        memcpy(s->rx + s->rx_len, data, (size_t)len);
+        s->rx_len += len;
+    }
+}
+
+static int session_fail(struct session *s, int ret, const char *op)
+{
+    char buffer[ERR_MSG_LEN];
+    int err = wolfSSL_get_error(s->ssl, ret);
+
+    if (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE) {
+        return 0;
+    }
+    fprintf(stderr, "Session %d: %s failed: %d, %s\n", s->index, op, err,
+            wolfSSL_ERR_error_string((unsigned long)err, buffer));
+    s->state = SESSION_FAILED;
+    return -1;
+}
+
+/* Move a session on as far as it can go without waiting for frames */
+static void session_step(struct session *s)
+{
+    int ret;
+    int len;
+    uint8_t buf[WRITE_CHUNK];
+
+    if (s->state == SESSION_HANDSHAKE) {
+        if (s->is_client && s->start == 0) {
+            s->start = now();
+        }
+        if (s->is_client) {
+            ret = wolfSSL_connect(s->ssl);
+        } else {
+            ret = wolfSSL_accept(s->ssl);
+        }
+        if (ret != WOLFSSL_SUCCESS) {
+            session_fail(s, ret, "handshake");
+            return;
+        }
+        s->hs_time = now() - s->start;
+        s->state = SESSION_DATA;
+    }
+
+    /* The ECU sends its data and the gateway replies with one byte once all
+     * has been received */
+    while (s->state == SESSION_DATA) {
+        len = s->data_len - s->data_done;
+        if (len > WRITE_CHUNK) {
+            len = WRITE_CHUNK;
+        }
+        if (len == 0) {
+            s->state = SESSION_ACK;
+            break;
+        }
+        if (s->is_client) {
+            memset(buf, (int)s->index, (size_t)len);
+            ret = wolfSSL_write(s->ssl, buf, len);
+            /* One chunk at a time so that no session hogs the bus */
+            if (ret > 0) {
+                s->data_done += ret;
+                break;
+            }
+        } else {
+            ret = wolfSSL_read(s->ssl, buf, len);
+            if (ret > 0) {
+                s->data_done += ret;
+                continue;
+            }
+        }
+        if (session_fail(s, ret, s->is_client ? "write" : "read") == 0) {
+            return;
+        }
+    }
+
+    if (s->state == SESSION_ACK) {
+        if (s->is_client) {
+            ret = wolfSSL_read(s->ssl, buf, 1);
+        } else {
+            buf[0] = 1;
+            ret = wolfSSL_write(s->ssl, buf, 1);
+        }
+        if (ret != 1) {
+            session_fail(s, ret, "ack");
+            return;
+        }
+        s->data_time = now() - s->start - s->hs_time;
+        s->state = SESSION_DONE;
+    }
+}
+
+static int side_active(const struct side *side)
+{
+    int i;
+    int active = 0;
+
+    for (i = 0; i < side->num; i++) {
+        if (side->sessions[i].state != SESSION_DONE &&
+                side->sessions[i].state != SESSION_FAILED) {
+            active++;
+        }
+    }
+    return active;
+}
+
+static void side_report(const struct side *side)
+{
+    int i;
+    int done = 0;
+    double hs = 0;
+    double bytes = 0;
+    double data_time = 0;
+    const struct session *s;
+
+    printf("\n%s sessions:\n", side->is_client ? "ECU" : "Gateway");
+    printf("session  rx id  tx id  handshake ms  data bytes  goodput B/s\n");
+    for (i = 0; i < side->num; i++) {
+        s = &side->sessions[i];
+        if (s->state != SESSION_DONE) {
+            printf("%7d  0x%03x  0x%03x  %s\n", s->index, s->rx_id, s->tx_id,
+                    s->state == SESSION_FAILED ? "failed" : "not complete");
+            continue;
+        }
+        if (s->data_done > 0 && s->data_time > 0) {
+            printf("%7d  0x%03x  0x%03x  %12.1f  %10d  %11.0f\n", s->index,
+                    s->rx_id, s->tx_id, s->hs_time * 1000, s->data_done,
+                    s->data_done / s->data_time);
+        } else {
+            printf("%7d  0x%03x  0x%03x  %12.1f  %10d  %11s\n", s->index,
+                    s->rx_id, s->tx_id, s->hs_time * 1000, s->data_done, "-");
+        }
+        done++;
+        hs += s->hs_time;
+        bytes += s->data_done;
+        data_time += s->data_time;
+    }
+    if (done > 0 && bytes > 0 && data_time > 0) {
+        printf("%d of %d complete, mean handshake %.1f ms, mean goodput "
+                "%.0f B/s\n", done, side->num, hs * 1000 / done,
+                bytes / data_time);
+    } else if (done > 0) {
+        printf("%d of %d complete, mean handshake %.1f ms\n", done,
+                side->num, hs * 1000 / done);
+    }
+    if (side->dropped > 0) {
+        printf("%" PRIu64 " frames dropped\n", side->dropped);
+    }
+    if (side->overflowed > 0) {
+        printf("%d sessions failed on receive buffer overflow\n",
+                side->overflowed);
+    }
+}
+
+static void port_report(const char *name, const struct canmux_port *port)
+{
+    printf("%s port: %" PRIu64 " frames in %" PRIu64 " reads, %" PRIu64
+            " frames in %" PRIu64 " writes\n", name, port->frames_rx,
+            port->calls_rx, port->frames_tx, port->calls_tx);
+}
+
+static void usage(void)
+{
+    printf("Usage: ./gateway [options]\n");
+    printf("  -i <interface>  CAN interface, default: simulated bus\n");
+    printf("  -c              Run the ECUs rather than the gateway on the "
+            "interface\n");
+    printf("  -n <num>        Sessions, default %d, max %d\n", DEF_SESSIONS,
+            MAX_SESSIONS);
+    printf("  -a <id>         First arbitration ID, default 0x%x\n",
+            DEF_BASE_ID);
+    printf("  -d <bytes>      Data sent by each ECU, default %d\n",
+            DEF_DATA_LEN);
+    printf("  -f              Use CAN FD frames\n");
+    printf("  -b <bitrate>    Simulated bus bitrate, 0 for unlimited, "
+            "default %d\n", DEF_BITRATE);
+    printf("  -t <sec>        Time to wait for sessions, default %d\n",
+            DEF_TIMEOUT);
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+    int opt;
+    int i;
+    int n;
+    int num_ports;
+    int num_sides = 0;
+    int active;
+    uint64_t moved;
+    const char *interface = NULL;
+    int ecu = 0;
+    int num = DEF_SESSIONS;
+    canid_t base = DEF_BASE_ID;
+    int data_len = DEF_DATA_LEN;
+    int fd_frames = 0;
+    long bitrate = DEF_BITRATE;
+    int timeout = DEF_TIMEOUT;
+    double deadline;
+    canid_t rx_ids[MAX_SESSIONS];
+    struct canmux_port ports[2];
+    struct side sides[2];
+    struct sigaction sa;
+
+    while ((opt = getopt(argc, argv, "i:cn:a:d:fb:t:h")) != -1) {
+        switch (opt) {
+            case 'i': interface = optarg; break;
+            case 'c': ecu = 1; break;
+            case 'n': num = atoi(optarg); break;
+            case 'a': base = (canid_t)strtoul(optarg, NULL, 0); break;
+            case 'd': data_len = atoi(optarg); break;
+            case 'f': fd_frames = 1; break;
+            case 'b': bitrate = atol(optarg); break;
+            case 't': timeout = atoi(optarg); break;
+            default: usage(); return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num < 1 || num > MAX_SESSIONS || data_len < 0 || bitrate < 0 ||
+            base + 2 * (canid_t)num > CAN_SFF_MASK + 1) {
+        usage();
+        return -1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sig_handle;
+    sigaction(SIGINT, &sa, 0);
+
+    wolfSSL_Init();
+    memset(ports, 0, sizeof(ports));
+    memset(sides, 0, sizeof(sides));
+    ports[0].fd = -1;
+    ports[1].fd = -1;
+
+    if (interface != NULL) {
+        for (i = 0; i < num; i++) {
+            rx_ids[i] = base + 2 * (canid_t)i + (ecu ? 1 : 0);
+        }
+        num_ports = 1;
+        ret = canmux_open(&ports[0], interface, rx_ids, num, fd_frames);
+        if (ret == 0) {
+            num_sides = 1;
+            ret = side_init(&sides[0], ecu, &ports[0], num, base, data_len);
+        }
+    } else {
+        num_ports = 2;
+        ret = canmux_sim_open(&ports[0], &ports[1], fd_frames, bitrate);
+        if (ret == 0) {
+            num_sides = 2;
+            ret = side_init(&sides[0], 0, &ports[0], num, base, data_len);
+        }
+        if (ret == 0) {
+            ret = side_init(&sides[1], 1, &ports[1], num, base, data_len);
+        }
+    }
+    if (ret != 0) {
+        goto exit;
+    }
+
+    printf("%d sessions, %d bytes each, %s frames, %s\n", num, data_len,
+            fd_frames ? "CAN FD" : "classic", interface != NULL ? interface :
+            "simulated bus");
+
+    deadline = now() + timeout;
+    active = num;
+    while (active > 0 && keep_running && now() < deadline) {
+        moved = 0;
+        for (i = 0; i < num_sides; i++) {
+            moved -= ports[i].frames_rx + ports[i].frames_tx;
+        }
+
+        for (i = 0; i < num_sides; i++) {
+            while (side_can_recv(&sides[i]) &&
+                    (n = canmux_recv(sides[i].port)) > 0) {
+                side_demux(&sides[i], base, n);
+            }
+        }
+        active = 0;
+        for (i = 0; i < num_sides; i++) {
+            for (n = 0; n < sides[i].num; n++) {
+                session_step(&sides[i].sessions[n]);
+            }
+            canmux_flush(sides[i].port);
+            active += side_active(&sides[i]);
+        }
+
+        for (i = 0; i < num_sides; i++) {
+            moved += ports[i].frames_rx + ports[i].frames_tx;
+        }
+        if (moved == 0) {
+            canmux_wait(&ports[0], 1);
+        }
+    }
+
+    for (i = 0; i < num_sides; i++) {
+        side_report(&sides[i]);
+    }
+    printf("\n");
+    for (i = 0; i < num_ports; i++) {
+        port_report(sides[i].is_client ? "ECU" : "Gateway", &ports[i]);
+    }
+    if (active > 0) {
+        ret = -1;
+    }
+
+exit:
+    for (i = 0; i < num_sides; i++) {
+        side_free(&sides[i]);
+    }
+    canmux_close(&ports[0]);
+    canmux_close(&ports[1]);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
@@ -0,0 +1,803 @@
+/* certgen_template.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Template based certificate generation.
+ *
+ * The other examples fill in a Cert for each certificate and have
+ * wc_SetIssuerBuffer() and wc_MakeCert_ex() encode all of it every time. Most
+ * of a device certificate is the same for every device though: version,
+ * signature algorithm, issuer, most of the subject, authority key id, key
+ * usage, policy and two custom extensions like those of custom_ext.c. Both
+ * extensions are non-critical here so that any verifier accepts the
+ * certificates.
+ *
+ * Here one reference certificate is made the usual way and its
+ * TBSCertificate is cut into pieces of DER. For each certificate only the
+ * serial number, validity, common name, public key and subject key id are
+ * encoded and spliced in between the pieces, then wc_SignCert_ex() signs it.
+ *
+ * Both ways are timed making certificates for the same keys, with encoding
+ * timed apart from signing. The last template certificate is written to
+ * ./newCert.der.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/sha.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/ssl.h>
+
+#define HEAP_HINT NULL
+#define LARGE_TEMP_SZ 4096
+
+#define DEF_NUM_CERTS   1000
+#define DEF_DAYS_VALID  365
+/* Validity must end before the year 10000 - GeneralizedTime has 4 digits. */
+#define MAX_DAYS_VALID  1000000
+/* Keys made before timing and used in turn. */
+#define NUM_KEYS        32
+#define SERIAL_SZ       16
+/* Most bytes the parts made for each certificate add to the pieces. */
+#define MAX_PER_CERT_SZ 512
+
+static const char kCaCert[] = "./ca-ecc-cert.der";
+static const char kCaKey[] = "./ca-ecc-key.der";
+static const char kNewCert[] = "./newCert.der";
+
+#if defined(WOLFSSL_ASN_TEMPLATE) && defined(WOLFSSL_CERT_GEN) && \
+    defined(WOLFSSL_CUSTOM_OID) && defined(HAVE_OID_ENCODING) && \
+    defined(WOLFSSL_CERT_EXT) && defined(HAVE_ECC)
+
+#define TAG_INTEGER     0x02
+#define TAG_OCTET_STR   0x04
+#define TAG_OID         0x06
+#define TAG_UTC_TIME    0x17
+#define TAG_GEN_TIME    0x18
+#define TAG_SEQ         0x30
+#define TAG_SET         0x31
+#define TAG_EXTENSIONS  0xa3
+
+/* Object ids of the parts that change: common name and subject key id. */
+static const byte kOidCommonName[] = { 0x55, 0x04, 0x03 };
+static const byte kOidSubjKeyId[] = { 0x55, 0x1d, 0x0e };
+
+/* Offset and size of a piece of the reference TBSCertificate. */
+typedef struct Piece {
+    word32 off;
+    word32 sz;
+} Piece;
+
+typedef struct CertTemplate {
+    byte   der[LARGE_TEMP_SZ];
+    word32 derSz;
+    Piece  version;
+    Piece  sigAlgo;
+    Piece  issuer;
+    /* Names of the subject before and after the common name. */
+    Piece  subjPre;
+    Piece  subjPost;
+    /* String type the common name is encoded with. */
+    byte   cnTag;
+    /* Extensions before and after the subject key id. */
+    Piece  extPre;
+    Piece  extPost;
+    int    daysValid;
+} CertTemplate;
+
+/* Seconds spent over all the certificates of a run. */
+typedef struct BenchResult {
+    double encode;
+    double sign;
+} BenchResult;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static int read_file(const char* fileName, byte* buf, int bufSz)
+{
+    int   sz;
+    FILE* file;
+
+    file = fopen(fileName, "rb");
+    if (!file) {
+        printf("failed to open file: %s\n", fileName);
+        return -1;
+    }
+    sz = (int)fread(buf, 1, bufSz, file);
+    fclose(file);
+
+    return sz;
+}
+
+/* Get the tag and length of the DER item at in.
+ * Returns the size of the header or -1 when the item doesn't fit. */
+static int der_get(const byte* in, word32 inSz, byte* tag, word32* len)
+{
+    word32 i = 2;
+    word32 n;
+
+    if (inSz < 2)
+        return -1;
+    *tag = in[0];
+    *len = in[1];
+    if (in[1] & 0x80) {
+        n = in[1] & 0x7f;
+        if (n == 0 || n > 3 || inSz < 2 + n)
+            return -1;
+        for (*len = 0; n > 0; n--)
+            *len = (*len << 8) | in[i++];
+    }
+    if (*len > inSz - i)
+        return -1;
+
+    return (int)i;
+}
+
+/* Write a DER item. The data may already be at out, to wrap it in place.
+ * Returns the size written. */
+static word32 der_item(byte* out, byte tag, const byte* data, word32 len)
+{
+    word32 hdrSz = (len >= 0x100) ? 4 : ((len >= 0x80) ? 3 : 2);
+    word32 i = 0;
+
+    memmove(out + hdrSz, data, len);
+    out[i++] = tag;
+    if (len >= 0x100) {
+        out[i++] = 0x82;
+        out[i++] = (byte)(len >> 8);
+    }
+    else if (len >= 0x80) {
+        out[i++] = 0x81;
+    }
+    out[i++] = (byte)len;
+
+    return hdrSz + len;
+}
+
+/* Check whether an RDN (SET) or Extension (SEQUENCE) item holds the object
+ * id. Returns the offset of what follows the object id or 0 when it doesn't.
+ */
+static word32 der_after_oid(const byte* in, word32 inSz, const byte* oid,
+                            word32 oidSz)
+{
+    int    h;
+    byte   tag;
+    word32 len;
+    word32 i;
+
+    h = der_get(in, inSz, &tag, &len);
+    if (h < 0)
+        return 0;
+    i = (word32)h;
+    /* An RDN is a SET holding an AttributeTypeAndValue SEQUENCE. */
+    if (tag == TAG_SET) {
+        h = der_get(in + i, len, &tag, &len);
+        if (h < 0 || tag != TAG_SEQ)
+            return 0;
+        i += (word32)h;
+    }
+    else if (tag != TAG_SEQ) {
+        return 0;
+    }
+    h = der_get(in + i, len, &tag, &len);
+    if (h < 0 || tag != TAG_OID || len != oidSz ||
+            memcmp(in + i + h, oid, oidSz) != 0)
+        return 0;
+
+    return i + (word32)h + len;
+}
+
+/* Split the items in der[off, off + sz) into those before and those after
+ * the one holding the object id. */
+static int template_split(CertTemplate* t, word32 off, word32 sz,
+                          const byte* oid, word32 oidSz, Piece* pre,
+                          Piece* post, word32* after)
+{
+    int    h;
+    byte   tag;
+    word32 len;
+    word32 i;
+
+    for (i = off; i < off + sz; i += (word32)h + len) {
+        h = der_get(t->der + i, off + sz - i, &tag, &len);
+        if (h < 0)
+            return ASN_PARSE_E;
+        *after = der_after_oid(t->der + i, (word32)h + len, oid, oidSz);
+        if (*after != 0) {
+            *after += i;
+            pre->off = off;
+            pre->sz = i - off;
+            post->off = i + (word32)h + len;
+            post->sz = off + sz - post->off;
+            return 0;
+        }
+    }
+
+    return ASN_PARSE_E;
+}
+
+/* Fill in the Cert and encode the TBSCertificate the way the other examples
+ * do. Returns the size of the TBSCertificate or a negative error. */
+static int make_tbs_per_cert(Cert* cert, const byte* caCert, int caCertSz,
+                             ecc_key* key, const char* commonName,
+                             int daysValid, WC_RNG* rng, byte* out,
+                             word32 outSz)
+{
+    int ret;
+
+    ret = wc_InitCert(cert);
+    if (ret != 0)
+        return ret;
+
+    strncpy(cert->subject.country, "US", CTC_NAME_SIZE);
+    strncpy(cert->subject.state, "MT", CTC_NAME_SIZE);
+    strncpy(cert->subject.locality, "Bozeman", CTC_NAME_SIZE);
+    strncpy(cert->subject.org, "yourOrgNameHere", CTC_NAME_SIZE);
+    strncpy(cert->subject.unit, "yourUnitNameHere", CTC_NAME_SIZE);
+    strncpy(cert->subject.commonName, commonName, CTC_NAME_SIZE - 1);
+    strncpy(cert->subject.email, "yourEmail@yourDomain.com", CTC_NAME_SIZE);
+
+    cert->isCA      = 0;
+    cert->sigType   = CTC_SHA256wECDSA;
+    cert->daysValid = daysValid;
+    /* anyPolicy */
+    strncpy(cert->certPolicies[0], "2.5.29.32.0", CTC_MAX_CERTPOL_SZ);
+    cert->certPoliciesNb = 1;
+
+    ret = wc_SetIssuerBuffer(cert, caCert, caCertSz);
+    if (ret == 0) {
+        ret = wc_SetAuthKeyIdFromCert(cert, caCert, caCertSz);
+    }
+    if (ret == 0) {
+        ret = wc_SetSubjectKeyIdFromPublicKey_ex(cert, ECC_TYPE, key);
+    }
+    if (ret == 0) {
+        ret = wc_SetKeyUsage(cert, "digitalSignature,keyAgreement");
+    }
+    if (ret == 0) {
+        ret = wc_SetCustomExtension(cert, 0, "1.2.3.4.5",
+                (const byte *)"This is a device extension", 26);
+    }
+    if (ret == 0) {
+        ret = wc_SetCustomExtension(cert, 0, "1.2.3.4.6",
+                (const byte *)"This is NOT a critical extension", 32);
+    }
+    if (ret == 0) {
+        ret = wc_MakeCert_ex(cert, out, outSz, ECC_TYPE, key, rng);
+    }
+
+    return ret;
+}
+
+/* Make a reference TBSCertificate and cut it into pieces. */
+static int template_init(CertTemplate* t, const byte* caCert, int caCertSz,
+                         ecc_key* key, int daysValid, WC_RNG* rng)
+{
+    int    ret;
+    int    h;
+    int    eh;
+    int    item;
+    byte   tag;
+    word32 len;
+    word32 extsLen;
+    word32 idx;
+    word32 end;
+    word32 after;
+    Cert   cert;
+
+    memset(t, 0, sizeof(*t));
+    t->daysValid = daysValid;
+
+    ret = make_tbs_per_cert(&cert, caCert, caCertSz, key, "template",
+                            daysValid, rng, t->der, sizeof(t->der));
+    if (ret < 0)
+        return ret;
+    t->derSz = (word32)ret;
+
+    h = der_get(t->der, t->derSz, &tag, &len);
+    if (h < 0 || tag != TAG_SEQ)
+        return ASN_PARSE_E;
+    idx = (word32)h;
+    end = idx + len;
+
+    /* version, serialNumber, signature, issuer, validity, subject,
+     * subjectPublicKeyInfo, then the optional items and extensions */
+    ret = ASN_PARSE_E;
+    for (item = 0; idx < end; item++, idx += (word32)h + len) {
+        h = der_get(t->der + idx, end - idx, &tag, &len);
+        if (h < 0)
+            return ASN_PARSE_E;
+
+        if (item == 0) {
+            t->version.off = idx;
+            t->version.sz = (word32)h + len;
+        }
+        else if (item == 2) {
+            t->sigAlgo.off = idx;
+            t->sigAlgo.sz = (word32)h + len;
+        }
+        else if (item == 3) {
+            t->issuer.off = idx;
+            t->issuer.sz = (word32)h + len;
+        }
+        else if (item == 5) {
+            if (template_split(t, idx + h, len, kOidCommonName,
+                    sizeof(kOidCommonName), &t->subjPre, &t->subjPost,
+                    &after) != 0)
+                return ASN_PARSE_E;
+            t->cnTag = t->der[after];
+        }
+        else if (item > 6 && tag == TAG_EXTENSIONS) {
+            eh = der_get(t->der + idx + h, len, &tag, &extsLen);
+            if (eh < 0 || tag != TAG_SEQ)
+                return ASN_PARSE_E;
+            ret = template_split(t, idx + h + eh, extsLen, kOidSubjKeyId,
+                    sizeof(kOidSubjKeyId), &t->extPre, &t->extPost, &after);
+        }
+    }
+
+    return ret;
+}
+
+/* Encode a time as UTCTime up to 2049 and as GeneralizedTime after, as
+ * RFC 5280 asks. Returns the size written. */
+static word32 set_time(byte* out, time_t t)
+{
+    struct tm tm;
+    char      str[16];
+
+    gmtime_r(&t, &tm);
+    if (tm.tm_year + 1900 > 9999) {
+        /* RFC 5280 value for no well-defined expiration date. */
+        return der_item(out, TAG_GEN_TIME, (byte*)"99991231235959Z", 15);
+    }
+    if (tm.tm_year + 1900 < 2050) {
+        strftime(str, sizeof(str), "%y%m%d%H%M%SZ", &tm);
+        return der_item(out, TAG_UTC_TIME, (byte*)str, 13);
+    }
+    strftime(str, sizeof(str), "%Y%m%d%H%M%SZ", &tm);
+    return der_item(out, TAG_GEN_TIME, (byte*)str, 15);
+}
+
+/* Encode the subject key id extension. The key id is the hash of the public
+ * key point, as wc_SetSubjectKeyIdFromPublicKey_ex() makes it.
+ * Returns the size written or a negative error. */
+static int set_skid(byte* out, ecc_key* key)
+{
+    int    ret;
+    byte   point[MAX_ECC_BYTES * 2 + 1];
+    word32 pointSz = sizeof(point);
+    byte   keyId[KEYID_SIZE];
+    byte   value[KEYID_SIZE + 2];
+    byte   ext[KEYID_SIZE + 16];
+    word32 i;
+
+    ret = wc_ecc_export_x963(key, point, &pointSz);
+    if (ret == 0) {
+    #ifndef NO_SHA
+        ret = wc_ShaHash(point, pointSz, keyId);
+    #else
+        ret = wc_Sha256Hash(point, pointSz, keyId);
+    #endif
+    }
+    if (ret != 0)
+        return ret;
+
+    i = der_item(ext, TAG_OID, kOidSubjKeyId, sizeof(kOidSubjKeyId));
+    der_item(value, TAG_OCTET_STR, keyId, sizeof(keyId));
+    i += der_item(ext + i, TAG_OCTET_STR, value, sizeof(value));
+
+    return (int)der_item(out, TAG_SEQ, ext, i);
+}
+
+/* Encode a TBSCertificate from the pieces and the parts that change.
+ * Returns the size of the TBSCertificate or a negative error. */
+static int make_tbs_template(const CertTemplate* t, ecc_key* key,
+                             const char* commonName, WC_RNG* rng, byte* out,
+                             word32 outSz)
+{
+    int    ret;
+    byte   body[LARGE_TEMP_SZ];
+    byte   part[LARGE_TEMP_SZ / 2];
+    byte   rdn[CTC_NAME_SIZE + 16];
+    byte   serial[SERIAL_SZ];
+    word32 cnSz = (word32)strlen(commonName);
+    word32 i = 0;
+    word32 p;
+    word32 n;
+    time_t t0 = time(NULL);
+
+    if (cnSz >= CTC_NAME_SIZE || t->derSz + MAX_PER_CERT_SZ > sizeof(body) ||
+            t->derSz + MAX_PER_CERT_SZ > outSz)
+        return BUFFER_E;
+
+    memcpy(body + i, t->der + t->version.off, t->version.sz);
+    i += t->version.sz;
+
+    /* Random and positive, like the serial number wolfSSL makes. */
+    ret = wc_RNG_GenerateBlock(rng, serial, sizeof(serial));
+    if (ret != 0)
+        return ret;
+    serial[0] &= 0x7f;
+    if (serial[0] == 0)
+        serial[0] = 0x01;
+    i += der_item(body + i, TAG_INTEGER, serial, sizeof(serial));
+
+    memcpy(body + i, t->der + t->sigAlgo.off, t->sigAlgo.sz);
+    i += t->sigAlgo.sz;
+    memcpy(body + i, t->der + t->issuer.off, t->issuer.sz);
+    i += t->issuer.sz;
+
+    /* Valid from a day ago in case clocks differ, as wolfSSL does. */
+    p = set_time(part, t0 - 86400);
+    p += set_time(part + p, t0 + (time_t)t->daysValid * 86400);
+    i += der_item(body + i, TAG_SEQ, part, p);
+
+    /* subject: SET { SEQUENCE { commonName, value } } between the names */
+    p = 0;
+    memcpy(part + p, t->der + t->subjPre.off, t->subjPre.sz);
+    p += t->subjPre.sz;
+    n = der_item(rdn, TAG_OID, kOidCommonName, sizeof(kOidCommonName));
+    n += der_item(rdn + n, t->cnTag, (const byte*)commonName, cnSz);
+    n = der_item(rdn, TAG_SEQ, rdn, n);
+    p += der_item(part + p, TAG_SET, rdn, n);
+    memcpy(part + p, t->der + t->subjPost.off, t->subjPost.sz);
+    p += t->subjPost.sz;
+    i += der_item(body + i, TAG_SEQ, part, p);
+
+    ret = wc_EccPublicKeyToDer(key, body + i, sizeof(body) - i, 1);
+    if (ret < 0)
+        return ret;
+    i += (word32)ret;
+
+    /* extensions: subject key id between the others */
+    p = 0;
+    memcpy(part + p, t->der + t->extPre.off, t->extPre.sz);
+    p += t->extPre.sz;
+    ret = set_skid(part + p, key);
+    if (ret < 0)
+        return ret;
+    p += (word32)ret;
+    memcpy(part + p, t->der + t->extPost.off, t->extPost.sz);
+    p += t->extPost.sz;
+    p = der_item(part, TAG_SEQ, part, p);
+    i += der_item(body + i, TAG_EXTENSIONS, part, p);
+
+    return (int)der_item(out, TAG_SEQ, body, i);
+}
+
+static int bench_per_cert(int numCerts, const byte* caCert, int caCertSz,
+                          ecc_key* caKey, ecc_key* keys, int daysValid,
+                          WC_RNG* rng, BenchResult* res)
+{
+    int    ret = 0;
+    int    i;
+    double start;
+    double mid;
+    char   commonName[CTC_NAME_SIZE];
+    byte   der[LARGE_TEMP_SZ];
+    Cert   cert;
+
+    for (i = 0; i < numCerts && ret >= 0; i++) {
+        snprintf(commonName, sizeof(commonName), "device-%d", i);
+
+        start = now();
+        ret = make_tbs_per_cert(&cert, caCert, caCertSz, &keys[i % NUM_KEYS],
+                                commonName, daysValid, rng, der, sizeof(der));
+        mid = now();
+        if (ret >= 0) {
+            ret = wc_SignCert_ex(ret, cert.sigType, der, sizeof(der),
+                                 ECC_TYPE, caKey, rng);
+        }
+        res->encode += mid - start;
+        res->sign += now() - mid;
+    }
+
+    return (ret < 0) ? ret : 0;
+}
+
+/* Make one certificate from the template and check that it parses and
+ * verifies against the CA before any timing. Returns 0 when it does. */
+static int check_template(const CertTemplate* t, const byte* caCert,
+                          int caCertSz, ecc_key* caKey, ecc_key* key,
+                          WC_RNG* rng)
+{
+    int                   ret;
+    int                   derSz;
+    byte                  der[LARGE_TEMP_SZ];
+    DecodedCert           decoded;
+    WOLFSSL_CERT_MANAGER* cm;
+
+    ret = make_tbs_template(t, key, "device-check", rng, der, sizeof(der));
+    if (ret >= 0) {
+        ret = wc_SignCert_ex(ret, CTC_SHA256wECDSA, der, sizeof(der),
+                             ECC_TYPE, caKey, rng);
+    }
+    if (ret < 0)
+        return ret;
+    derSz = ret;
+
+    wc_InitDecodedCert(&decoded, der, derSz, HEAP_HINT);
+    ret = wc_ParseCert(&decoded, CERT_TYPE, NO_VERIFY, NULL);
+    if (ret == 0 && (decoded.subjectCN == NULL ||
+            decoded.subjectCNLen != (int)strlen("device-check") ||
+            memcmp(decoded.subjectCN, "device-check",
+                    decoded.subjectCNLen) != 0)) {
+        ret = ASN_PARSE_E;
+    }
+    wc_FreeDecodedCert(&decoded);
+    if (ret != 0) {
+        printf("Template certificate doesn't parse: %d\n", ret);
+        return ret;
+    }
+
+    cm = wolfSSL_CertManagerNew();
+    if (cm == NULL)
+        return MEMORY_E;
+    ret = wolfSSL_CertManagerLoadCABuffer(cm, caCert, caCertSz,
+                                          WOLFSSL_FILETYPE_ASN1);
+    if (ret == WOLFSSL_SUCCESS) {
+        ret = wolfSSL_CertManagerVerifyBuffer(cm, der, derSz,
+                                              WOLFSSL_FILETYPE_ASN1);
+    }
+    wolfSSL_CertManagerFree(cm);
+    if (ret != WOLFSSL_SUCCESS) {
+        printf("Template certificate doesn't verify: %d\n", ret);
+        return (ret < 0) ? ret : -1;
+    }
+
+    return 0;
+}
+
+static int bench_template(int numCerts, const CertTemplate* t, ecc_key* caKey,
+                          ecc_key* keys, WC_RNG* rng, BenchResult* res)
+{
+    int    ret = 0;
+    int    i;
+    double start;
+    double mid;
+    char   commonName[CTC_NAME_SIZE];
+    byte   der[LARGE_TEMP_SZ];
+    FILE*  file;
+
+    for (i = 0; i < numCerts && ret >= 0; i++) {
+        snprintf(commonName, sizeof(commonName), "device-%d", i);
+
+        start = now();
+        ret = make_tbs_template(t, &keys[i % NUM_KEYS], commonName, rng, der,
+                                sizeof(der));
+        mid = now();
+        if (ret >= 0) {
+            ret = wc_SignCert_ex(ret, CTC_SHA256wECDSA, der, sizeof(der),
+                                 ECC_TYPE, caKey, rng);
+        }
+        res->encode += mid - start;
+        res->sign += now() - mid;
+    }
+    if (ret < 0)
+        return ret;
+
+    file = fopen(kNewCert, "wb");
+    if (!file) {
+        printf("failed to open file: %s\n", kNewCert);
+        return -1;
+    }
+    fwrite(der, 1, ret, file);
+    fclose(file);
+    printf("Wrote the last template certificate (%d bytes) to %s\n", ret,
+           kNewCert);
+
+    return 0;
+}
+
+static void print_result(const char* name, int numCerts, BenchResult* res)
+{
+    double total = res->encode + res->sign;
+
+    printf("%-10s %7d %11.1f %9.1f %10.1f %9.0f\n", name, numCerts,
+           res->encode * 1000000 / numCerts, res->sign * 1000000 / numCerts,
+           total * 1000000 / numCerts, numCerts / total);
+}
+
+static int do_bench(int numCerts, int daysValid)
+{
+    int          ret;
+    int          i;
+    int          numKeys = 0;
+    int          caCertSz;
+    int          caKeySz;
+    word32       idx = 0;
+    byte         caCert[LARGE_TEMP_SZ];
+    byte         caKeyBuf[LARGE_TEMP_SZ];
+    WC_RNG       rng;
+    ecc_key      caKey;
+    ecc_key      keys[NUM_KEYS];
+    BenchResult  perCert;
+    BenchResult  tmpl;
+    CertTemplate* t;
+
+    memset(&perCert, 0, sizeof(perCert));
+    memset(&tmpl, 0, sizeof(tmpl));
+
+    caCertSz = read_file(kCaCert, caCert, sizeof(caCert));
+    caKeySz = read_file(kCaKey, caKeyBuf, sizeof(caKeyBuf));
+    if (caCertSz <= 0 || caKeySz <= 0)
+        return -1;
+
+    t = (CertTemplate*)malloc(sizeof(CertTemplate));
+    if (t == NULL)
+        return MEMORY_E;
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        free(t);
+        return ret;
+    }
+
+    ret = wc_ecc_init(&caKey);
+    if (ret == 0) {
+        ret = wc_EccPrivateKeyDecode(caKeyBuf, &idx, &caKey, caKeySz);
+    }
+
+    printf("Making %d keys\n", NUM_KEYS);
+    for (; ret == 0 && numKeys < NUM_KEYS; numKeys++) {
+        ret = wc_ecc_init(&keys[numKeys]);
+        if (ret == 0) {
+            ret = wc_ecc_make_key(&rng, 32, &keys[numKeys]);
+            if (ret != 0)
+                wc_ecc_free(&keys[numKeys]);
+        }
+        if (ret != 0)
+            break;
+    }
+
+    if (ret == 0) {
+        ret = template_init(t, caCert, caCertSz, &keys[0], daysValid, &rng);
+        if (ret != 0)
+            printf("Failed to make the template: %d\n", ret);
+    }
+    if (ret == 0) {
+        ret = check_template(t, caCert, caCertSz, &caKey, &keys[1], &rng);
+    }
+    if (ret == 0) {
+        printf("Template: %u bytes reused, %u of them extensions\n",
+               t->version.sz + t->sigAlgo.sz + t->issuer.sz + t->subjPre.sz +
+               t->subjPost.sz + t->extPre.sz + t->extPost.sz,
+               t->extPre.sz + t->extPost.sz);
+        printf("Making %d certificates each way\n\n", numCerts);
+        ret = bench_per_cert(numCerts, caCert, caCertSz, &caKey, keys,
+                             daysValid, &rng, &perCert);
+        if (ret != 0)
+            printf("Per certificate path failed: %d\n", ret);
+    }
+    if (ret == 0) {
+        ret = bench_template(numCerts, t, &caKey, keys, &rng, &tmpl);
+        if (ret != 0)
+            printf("Template path failed: %d\n", ret);
+    }
+
+    if (ret == 0) {
+        printf("\n%-10s %7s %11s %9s %10s %9s\n", "Path", "Certs",
+               "Encode us", "Sign us", "Total us", "Certs/s");
+        print_result("per-cert", numCerts, &perCert);
+        print_result("template", numCerts, &tmpl);
+        printf("\nEncoding is %.1fx faster, certificates %.2fx faster\n",
+               perCert.encode / tmpl.encode,
+               (perCert.encode + perCert.sign) / (tmpl.encode + tmpl.sign));
+    }
+
+    for (i = 0; i < numKeys; i++)
+        wc_ecc_free(&keys[i]);
+    wc_ecc_free(&caKey);
+    wc_FreeRng(&rng);
+    free(t);
+
+    return ret;
+}
+
+/* Shows usage information */
+static void usage(void)
+{
+    fprintf(stderr, "certgen_template <options>:\n");
+    fprintf(stderr, "  -n <num>       Certificates to make each way, default "
+                    "%d\n", DEF_NUM_CERTS);
+    fprintf(stderr, "  -days <num>    Days the certificates are valid, "
+                    "default %d, max %d\n", DEF_DAYS_VALID, MAX_DAYS_VALID);
+}
+
+int main(int argc, char** argv)
+{
+    int ret;
+    int numCerts = DEF_NUM_CERTS;
+    int daysValid = DEF_DAYS_VALID;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-n", 3) == 0) {
+            numCerts = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-days", 6) == 0) {
+            daysValid = atoi(*++argv);
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if (numCerts < 1 || daysValid < 1 || daysValid > MAX_DAYS_VALID) {
+        usage();
+        return 1;
+    }
+
+    wolfSSL_Init();
+    ret = do_bench(numCerts, daysValid);
+    wolfSSL_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+    (void)kCaCert;
+    (void)kCaKey;
+    (void)kNewCert;
+
+    printf("Please configure wolfSSL with --enable-certgen --enable-certext "
+           "--enable-ecc CFLAGS=\"-DWOLFSSL_CUSTOM_OID "
+           "-DHAVE_OID_ENCODING\"\n");
+    return 0;
+}
+
+#endif
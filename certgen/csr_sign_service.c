@@ -0,0 +1,1088 @@
+/* csr_sign_service.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/*
+ * CSR signing service.
+ *
+ * A long running version of csr_sign. The CA certificate and key are loaded
+ * once. The issuer name, authority key id and extensions are set once in a
+ * template certificate that is copied for each request. Each worker thread
+ * decodes its own copy of the CA key and has its own RNG.
+ *
+ * Clients send CSRs in batches over a Unix socket. The CSRs of a batch are
+ * parsed, checked and signed in parallel by the workers, and the certificates
+ * are returned in the order of the requests:
+ *   request:  u32 count, then count times: u32 length, CSR (PEM or DER)
+ *   response: count times: u32 length, DER encoded certificate
+ *             - a length of 0 means the CSR was rejected.
+ * Integers are in network byte order.
+ *
+ * A CSR is rejected when it doesn't parse, its signature doesn't verify
+ * with its own public key, the key isn't ECC or there is no common name.
+ *
+ * Usage:
+./csr_sign_service -serve [-ca-cert <file>] [-ca-key <file>] [-threads <num>]
+./csr_sign_service -bench [-n <num>] [-batch <num>] [-conns <num>]
+./csr_sign_service -sign <csr file>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+/* Check if the internal asn API's are available */
+#if defined(WOLFSSL_TEST_CERT) || defined(OPENSSL_EXTRA) || \
+    defined(OPENSSL_EXTRA_X509_SMALL)
+    #define HAVE_DECODEDCERT
+#endif
+
+#define HEAP_HINT       NULL
+#define LARGE_TEMP_SZ   4096
+/* Most CSRs in a batch. */
+#define MAX_BATCH       1024
+#define MAX_THREADS     256
+#define DEF_NUM_CERTS   10000
+#define DEF_BATCH       64
+#define DEF_CONNS       4
+/* Different keys the benchmark makes CSRs for. */
+#define BENCH_KEYS      16
+
+static const char* kSockPath = "/tmp/csr_sign_service.sock";
+static const char* kCaCert = "./ca-ecc-cert.der";
+static const char* kCaKey = "./ca-ecc-key.der";
+static const char* kNewCert = "./newCert.der";
+
+#if defined(WOLFSSL_CERT_REQ) && defined(WOLFSSL_CERT_GEN) && \
+    defined(HAVE_ECC) && defined(WOLFSSL_CERT_EXT) && \
+    defined(HAVE_DECODEDCERT)
+
+/* A CSR to sign and the certificate made from it. */
+typedef struct Job {
+    byte   csr[LARGE_TEMP_SZ];
+    word32 csrSz;
+    byte   cert[LARGE_TEMP_SZ];
+    /* Length of certificate, 0 when rejected. */
+    word32 certSz;
+} Job;
+
+/* CSRs from one request of a client. */
+typedef struct Batch {
+    Job*          jobs;
+    int           count;
+    /* Next job to hand to a worker. */
+    int           next;
+    int           done;
+    struct Batch* nextBatch;
+} Batch;
+
+/* CA key and RNG of a worker. */
+typedef struct Worker {
+    pthread_t tid;
+    ecc_key   caKey;
+    WC_RNG    rng;
+    long      issued;
+    long      rejected;
+    /* Time spent parsing and signing. */
+    double    busy;
+} Worker;
+
+/* A client connection. */
+typedef struct Conn {
+    pthread_t    tid;
+    int          fd;
+    /* Set by the connection thread when it is ready to be joined. */
+    int          done;
+    struct Conn* next;
+} Conn;
+
+/* Resident CA data. */
+static byte            gCaKeyDer[LARGE_TEMP_SZ];
+static word32          gCaKeySz;
+static Cert            gTemplate;
+
+/* Batches waiting for workers. */
+static Batch*          gHead;
+static Batch*          gTail;
+static int             gStop;
+static long            gBatches;
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  gDone = PTHREAD_COND_INITIALIZER;
+static volatile int    gInterrupted;
+/* Connections being served - changed under lock. */
+static Conn*           gConns;
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static void sig_int_handler(int sig)
+{
+    (void)sig;
+    gInterrupted = 1;
+}
+
+static int read_full(int fd, void* buf, size_t len)
+{
+    ssize_t n;
+    byte*   p = (byte*)buf;
+
+    while (len > 0) {
+        n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void* buf, size_t len)
+{
+    ssize_t     n;
+    const byte* p = (const byte*)buf;
+
+    while (len > 0) {
+        n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Read a file that is PEM or DER and return the DER. */
+static int load_der(const char* fileName, int type, byte* der, word32 derMax)
+{
+    int   ret;
+    int   sz;
+    FILE* file;
+    byte  pem[LARGE_TEMP_SZ];
+
+    file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", fileName);
+        return -1;
+    }
+    sz = (int)fread(pem, 1, sizeof(pem), file);
+    fclose(file);
+    if (sz <= 0)
+        return -1;
+
+    if (type == PRIVATEKEY_TYPE)
+        ret = wc_KeyPemToDer(pem, sz, der, derMax, NULL);
+    else
+        ret = wc_CertPemToDer(pem, sz, der, derMax, type);
+    if (ret == ASN_NO_PEM_HEADER && (word32)sz <= derMax) {
+        memcpy(der, pem, sz);
+        ret = sz;
+    }
+
+    return ret;
+}
+
+/* Load the CA and set up the template all certificates are copied from. */
+static int load_ca(const char* caCertFile, const char* caKeyFile)
+{
+    int     ret;
+    int     caCertSz;
+    word32  idx = 0;
+    byte    caCert[LARGE_TEMP_SZ];
+    ecc_key caKey;
+
+    caCertSz = load_der(caCertFile, CERT_TYPE, caCert, sizeof(caCert));
+    if (caCertSz <= 0) {
+        fprintf(stderr, "Failed to load CA certificate: %d\n", caCertSz);
+        return -1;
+    }
+    ret = load_der(caKeyFile, PRIVATEKEY_TYPE, gCaKeyDer, sizeof(gCaKeyDer));
+    if (ret <= 0) {
+        fprintf(stderr, "Failed to load CA key: %d\n", ret);
+        return -1;
+    }
+    gCaKeySz = (word32)ret;
+
+    /* Check the key decodes before workers use it. */
+    ret = wc_ecc_init(&caKey);
+    if (ret != 0)
+        return ret;
+    ret = wc_EccPrivateKeyDecode(gCaKeyDer, &idx, &caKey, gCaKeySz);
+    wc_ecc_free(&caKey);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to decode CA key: %d\n", ret);
+        return ret;
+    }
+
+    ret = wc_InitCert(&gTemplate);
+    if (ret != 0)
+        return ret;
+    gTemplate.isCA    = 0;
+    gTemplate.sigType = CTC_SHA256wECDSA;
+    /* Serial Number will be randomly generated */
+    gTemplate.serialSz = 0;
+    gTemplate.daysValid = 365;
+
+    /* The CA certificate is parsed here, once, not for every CSR. */
+    ret = wc_SetIssuerBuffer(&gTemplate, caCert, caCertSz);
+    if (ret == 0) {
+        ret = wc_SetAuthKeyIdFromCert(&gTemplate, caCert, caCertSz);
+    }
+    if (ret == 0) {
+        ret = wc_SetKeyUsage(&gTemplate, "digitalSignature");
+    }
+    if (ret == 0) {
+        ret = wc_SetExtKeyUsage(&gTemplate, "serverAuth,clientAuth");
+    }
+    if (ret != 0) {
+        fprintf(stderr, "Failed to set up certificate template: %d\n", ret);
+    }
+
+    return ret;
+}
+
+/* Copy a name from the CSR, truncating to fit. */
+static void copy_name(char* dst, const char* src, int len)
+{
+    if (src == NULL)
+        return;
+    if (len > CTC_NAME_SIZE - 1)
+        len = CTC_NAME_SIZE - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/* Parse and check a CSR, then make and sign the certificate.
+ * Returns the size of the certificate or a negative error. */
+static int sign_csr(Worker* w, const byte* csr, word32 csrSz, byte* out,
+                    word32 outSz)
+{
+    int         ret;
+    int         derSz;
+    word32      idx = 0;
+    byte        der[LARGE_TEMP_SZ];
+    Cert        cert;
+    ecc_key     csrKey;
+    DecodedCert decoded;
+
+    derSz = wc_CertPemToDer(csr, csrSz, der, sizeof(der), CERTREQ_TYPE);
+    if (derSz == ASN_NO_PEM_HEADER && csrSz <= sizeof(der)) {
+        memcpy(der, csr, csrSz);
+        derSz = (int)csrSz;
+    }
+    if (derSz <= 0)
+        return derSz < 0 ? derSz : ASN_PARSE_E;
+
+    /* Verifying a CSR checks its signature with its own public key. */
+    InitDecodedCert(&decoded, der, derSz, HEAP_HINT);
+    ret = ParseCert(&decoded, CERTREQ_TYPE, VERIFY, NULL);
+    if (ret == 0 && (decoded.keyOID != ECDSAk || decoded.subjectCN == NULL ||
+            decoded.subjectCNLen == 0)) {
+        ret = BAD_FUNC_ARG;
+    }
+
+    if (ret == 0) {
+        ret = wc_ecc_init(&csrKey);
+        if (ret != 0) {
+            FreeDecodedCert(&decoded);
+            return ret;
+        }
+        ret = wc_EccPublicKeyDecode(decoded.publicKey, &idx, &csrKey,
+                                    decoded.pubKeySize);
+    }
+    else {
+        FreeDecodedCert(&decoded);
+        return ret;
+    }
+
+    if (ret == 0) {
+        /* Issuer, key ids and extensions come from the template. */
+        memcpy(&cert, &gTemplate, sizeof(cert));
+        copy_name(cert.subject.country, decoded.subjectC,
+                  decoded.subjectCLen);
+        copy_name(cert.subject.state, decoded.subjectST,
+                  decoded.subjectSTLen);
+        copy_name(cert.subject.locality, decoded.subjectL,
+                  decoded.subjectLLen);
+        copy_name(cert.subject.org, decoded.subjectO, decoded.subjectOLen);
+        copy_name(cert.subject.unit, decoded.subjectOU,
+                  decoded.subjectOULen);
+        copy_name(cert.subject.sur, decoded.subjectSN, decoded.subjectSNLen);
+        copy_name(cert.subject.serialDev, decoded.subjectSND,
+                  decoded.subjectSNDLen);
+        copy_name(cert.subject.commonName, decoded.subjectCN,
+                  decoded.subjectCNLen);
+        copy_name(cert.subject.email, decoded.subjectEmail,
+                  decoded.subjectEmailLen);
+        ret = wc_SetSubjectKeyIdFromPublicKey_ex(&cert, ECC_TYPE, &csrKey);
+    }
+    FreeDecodedCert(&decoded);
+
+    if (ret == 0) {
+        ret = wc_MakeCert_ex(&cert, out, outSz, ECC_TYPE, &csrKey, &w->rng);
+    }
+    if (ret >= 0) {
+        ret = wc_SignCert_ex(cert.bodySz, cert.sigType, out, outSz, ECC_TYPE,
+                             &w->caKey, &w->rng);
+    }
+    wc_ecc_free(&csrKey);
+
+    return ret;
+}
+
+/* Take jobs from the queued batches until stopped. */
+static void* worker_thread(void* arg)
+{
+    Worker* w = (Worker*)arg;
+    Batch*  b;
+    Job*    job;
+    int     ret;
+    double  start;
+
+    for (;;) {
+        pthread_mutex_lock(&gLock);
+        while (gHead == NULL && !gStop)
+            pthread_cond_wait(&gWork, &gLock);
+        if (gHead == NULL) {
+            pthread_mutex_unlock(&gLock);
+            break;
+        }
+        b = gHead;
+        job = &b->jobs[b->next++];
+        /* Last job handed out: the batch leaves the queue. */
+        if (b->next == b->count) {
+            gHead = b->nextBatch;
+            if (gHead == NULL)
+                gTail = NULL;
+        }
+        pthread_mutex_unlock(&gLock);
+
+        start = now();
+        ret = sign_csr(w, job->csr, job->csrSz, job->cert, sizeof(job->cert));
+        w->busy += now() - start;
+        if (ret > 0) {
+            job->certSz = (word32)ret;
+            w->issued++;
+        }
+        else {
+            job->certSz = 0;
+            w->rejected++;
+        }
+
+        pthread_mutex_lock(&gLock);
+        if (++b->done == b->count)
+            pthread_cond_broadcast(&gDone);
+        pthread_mutex_unlock(&gLock);
+    }
+
+    return NULL;
+}
+
+/* Queue a batch for the workers and wait until all of it is done. */
+static void run_batch(Batch* b)
+{
+    pthread_mutex_lock(&gLock);
+    b->next = 0;
+    b->done = 0;
+    b->nextBatch = NULL;
+    if (gTail != NULL)
+        gTail->nextBatch = b;
+    else
+        gHead = b;
+    gTail = b;
+    gBatches++;
+    pthread_cond_broadcast(&gWork);
+    while (b->done < b->count)
+        pthread_cond_wait(&gDone, &gLock);
+    pthread_mutex_unlock(&gLock);
+}
+
+/* Sign batches for a client until it disconnects or the socket is shut
+ * down. The socket is closed when the thread is joined. */
+static void* conn_thread(void* arg)
+{
+    Conn*  conn = (Conn*)arg;
+    int    fd = conn->fd;
+    int    i;
+    word32 count;
+    word32 len;
+    Batch  b;
+
+    b.jobs = NULL;
+    while (read_full(fd, &count, sizeof(count)) == 0) {
+        count = ntohl(count);
+        if (count == 0 || count > MAX_BATCH)
+            break;
+        free(b.jobs);
+        b.jobs = (Job*)malloc(sizeof(Job) * count);
+        if (b.jobs == NULL)
+            break;
+        for (i = 0; i < (int)count; i++) {
+            if (read_full(fd, &len, sizeof(len)) != 0)
+                break;
+            len = ntohl(len);
+            if (len == 0 || len > sizeof(b.jobs[i].csr) ||
+                    read_full(fd, b.jobs[i].csr, len) != 0)
+                break;
+            b.jobs[i].csrSz = len;
+        }
+        if (i < (int)count)
+            break;
+
+        b.count = (int)count;
+        run_batch(&b);
+
+        for (i = 0; i < b.count; i++) {
+            len = htonl(b.jobs[i].certSz);
+            if (write_full(fd, &len, sizeof(len)) != 0 ||
+                    write_full(fd, b.jobs[i].cert, b.jobs[i].certSz) != 0)
+                break;
+        }
+        if (i < b.count)
+            break;
+    }
+
+    free(b.jobs);
+    pthread_mutex_lock(&gLock);
+    conn->done = 1;
+    pthread_mutex_unlock(&gLock);
+    return NULL;
+}
+
+/* Join the connection threads that are done, or all when stopping. */
+static void reap_conns(int all)
+{
+    Conn*  conn;
+    Conn** prev = &gConns;
+
+    pthread_mutex_lock(&gLock);
+    while ((conn = *prev) != NULL) {
+        if (!all && !conn->done) {
+            prev = &conn->next;
+            continue;
+        }
+        *prev = conn->next;
+        pthread_mutex_unlock(&gLock);
+        pthread_join(conn->tid, NULL);
+        close(conn->fd);
+        free(conn);
+        pthread_mutex_lock(&gLock);
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+static int run_server(const char* path, const char* caCertFile,
+    const char* caKeyFile, int numThreads)
+{
+    int                ret = 0;
+    int                i;
+    int                listenFd;
+    int                fd;
+    int                started;
+    word32             idx;
+    long               issued = 0;
+    long               rejected = 0;
+    double             busy = 0;
+    Conn*              conn;
+    Worker*            workers;
+    struct sockaddr_un addr;
+    struct sigaction   sa;
+
+    ret = load_ca(caCertFile, caKeyFile);
+    if (ret != 0)
+        return ret;
+
+    workers = (Worker*)calloc(numThreads, sizeof(Worker));
+    if (workers == NULL)
+        return MEMORY_E;
+    /* Each worker signs with its own copy of the CA key. */
+    for (i = 0; ret == 0 && i < numThreads; i++) {
+        idx = 0;
+        ret = wc_ecc_init(&workers[i].caKey);
+        if (ret == 0) {
+            ret = wc_EccPrivateKeyDecode(gCaKeyDer, &idx, &workers[i].caKey,
+                                         gCaKeySz);
+            if (ret == 0) {
+                ret = wc_InitRng(&workers[i].rng);
+            }
+            if (ret != 0) {
+                wc_ecc_free(&workers[i].caKey);
+            }
+        }
+    }
+    if (ret != 0) {
+        fprintf(stderr, "Failed to set up workers: %d\n", ret);
+        numThreads = i - 1;
+        goto exit;
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        fprintf(stderr, "Failed to create socket\n");
+        ret = -1;
+        goto exit;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(listenFd, 16) != 0) {
+        fprintf(stderr, "Failed to listen on %s\n", path);
+        close(listenFd);
+        ret = -1;
+        goto exit;
+    }
+
+    /* Interrupt accept so the statistics are printed. */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sig_int_handler;
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    gStop = 0;
+    for (started = 0; started < numThreads; started++) {
+        if (pthread_create(&workers[started].tid, NULL, worker_thread,
+                           &workers[started]) != 0) {
+            fprintf(stderr, "Failed to start worker %d\n", started);
+            break;
+        }
+    }
+    printf("Signing with %d threads, serving on %s - ^C to stop\n", started,
+           path);
+    while (started > 0 && !gInterrupted) {
+        fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Failed to accept\n");
+            ret = -1;
+            break;
+        }
+        reap_conns(0);
+
+        conn = (Conn*)calloc(1, sizeof(Conn));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        pthread_mutex_lock(&gLock);
+        if (pthread_create(&conn->tid, NULL, conn_thread, conn) != 0) {
+            pthread_mutex_unlock(&gLock);
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = gConns;
+        gConns = conn;
+        pthread_mutex_unlock(&gLock);
+    }
+    close(listenFd);
+    unlink(path);
+
+    /* Stop reading requests. A batch already queued is finished by the
+     * workers, which are still running, before its thread exits. */
+    pthread_mutex_lock(&gLock);
+    for (conn = gConns; conn != NULL; conn = conn->next)
+        shutdown(conn->fd, SHUT_RDWR);
+    pthread_mutex_unlock(&gLock);
+    reap_conns(1);
+
+    /* No more batches can be queued. */
+    pthread_mutex_lock(&gLock);
+    gStop = 1;
+    pthread_cond_broadcast(&gWork);
+    pthread_mutex_unlock(&gLock);
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i].tid, NULL);
+        issued += workers[i].issued;
+        rejected += workers[i].rejected;
+        busy += workers[i].busy;
+    }
+
+    printf("Batches: %ld, issued: %ld, rejected: %ld\n", gBatches, issued,
+           rejected);
+    if (issued + rejected > 0) {
+        printf("Worker time per CSR: %.3f ms\n",
+               busy * 1000 / (issued + rejected));
+    }
+
+exit:
+    for (i = 0; i < numThreads; i++) {
+        wc_ecc_free(&workers[i].caKey);
+        wc_FreeRng(&workers[i].rng);
+    }
+    free(workers);
+
+    return ret;
+}
+
+static int connect_service(const char* path)
+{
+    int                fd;
+    struct sockaddr_un addr;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Failed to connect to %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Send a batch of CSRs and read the certificates.
+ * Returns the number of certificates issued or -1 on error. */
+static int send_batch(int fd, const byte** csr, const word32* csrSz,
+                      int count, byte* last, word32* lastSz)
+{
+    int    i;
+    int    issued = 0;
+    word32 len;
+    byte   cert[LARGE_TEMP_SZ];
+
+    len = htonl((word32)count);
+    if (write_full(fd, &len, sizeof(len)) != 0)
+        return -1;
+    for (i = 0; i < count; i++) {
+        len = htonl(csrSz[i]);
+        if (write_full(fd, &len, sizeof(len)) != 0 ||
+                write_full(fd, csr[i], csrSz[i]) != 0)
+            return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (read_full(fd, &len, sizeof(len)) != 0)
+            return -1;
+        len = ntohl(len);
+        if (len > sizeof(cert) || read_full(fd, cert, len) != 0)
+            return -1;
+        if (len > 0) {
+            issued++;
+            if (last != NULL) {
+                memcpy(last, cert, len);
+                *lastSz = len;
+            }
+        }
+    }
+
+    return issued;
+}
+
+/* Make a CSR for a new ECC key. */
+static int make_csr(WC_RNG* rng, int n, byte* der, word32 derMax)
+{
+    int     ret;
+    Cert    req;
+    ecc_key key;
+
+    ret = wc_ecc_init(&key);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_make_key_ex(rng, 32, &key, ECC_SECP256R1);
+    if (ret == 0) {
+        ret = wc_InitCert(&req);
+    }
+    if (ret == 0) {
+        strncpy(req.subject.country, "US", CTC_NAME_SIZE);
+        strncpy(req.subject.org, "wolfSSL", CTC_NAME_SIZE);
+        strncpy(req.subject.unit, "Devices", CTC_NAME_SIZE);
+        snprintf(req.subject.commonName, CTC_NAME_SIZE, "device-%d", n);
+        req.version = 0;
+        req.sigType = CTC_SHA256wECDSA;
+        ret = wc_MakeCertReq_ex(&req, der, derMax, ECC_TYPE, &key);
+    }
+    if (ret > 0) {
+        ret = wc_SignCert_ex(req.bodySz, req.sigType, der, derMax, ECC_TYPE,
+                             &key, rng);
+    }
+    wc_ecc_free(&key);
+
+    return ret;
+}
+
+/* Work of one benchmark connection. */
+typedef struct BenchConn {
+    pthread_t    tid;
+    const char*  path;
+    const byte** csr;
+    word32*      csrSz;
+    int          numCsr;
+    int          certs;
+    int          batch;
+    int          issued;
+    int          batches;
+    int          err;
+    double       latency;
+    double       maxLatency;
+} BenchConn;
+
+static void* bench_thread(void* arg)
+{
+    BenchConn*   c = (BenchConn*)arg;
+    int          fd;
+    int          i;
+    int          n;
+    int          sent;
+    int          ret;
+    double       start;
+    double       t;
+    const byte*  csr[MAX_BATCH];
+    word32       csrSz[MAX_BATCH];
+
+    fd = connect_service(c->path);
+    if (fd < 0) {
+        c->err = 1;
+        return NULL;
+    }
+
+    for (sent = 0; sent < c->certs; sent += n) {
+        n = c->certs - sent;
+        if (n > c->batch)
+            n = c->batch;
+        for (i = 0; i < n; i++) {
+            csr[i] = c->csr[(sent + i) % c->numCsr];
+            csrSz[i] = c->csrSz[(sent + i) % c->numCsr];
+        }
+
+        start = now();
+        ret = send_batch(fd, csr, csrSz, n, NULL, NULL);
+        t = now() - start;
+        if (ret < 0) {
+            c->err = 1;
+            break;
+        }
+        c->issued += ret;
+        c->batches++;
+        c->latency += t;
+        if (t > c->maxLatency)
+            c->maxLatency = t;
+    }
+
+    close(fd);
+    return NULL;
+}
+
+/* Send CSRs in batches on a number of connections and measure certs/s. */
+static int run_bench(const char* path, int numCerts, int batch, int conns)
+{
+    int         ret = 0;
+    int         i;
+    int         started;
+    int         issued = 0;
+    int         batches = 0;
+    double      latency = 0;
+    double      maxLatency = 0;
+    double      start;
+    double      elapsed;
+    WC_RNG      rng;
+    byte*       csrBuf;
+    const byte* csr[BENCH_KEYS];
+    word32      csrSz[BENCH_KEYS];
+    BenchConn   c[MAX_THREADS];
+
+    csrBuf = (byte*)XMALLOC(BENCH_KEYS * LARGE_TEMP_SZ, HEAP_HINT,
+                            DYNAMIC_TYPE_TMP_BUFFER);
+    if (csrBuf == NULL)
+        return MEMORY_E;
+
+    /* CSRs are made before timing: only the service is measured. */
+    ret = wc_InitRng(&rng);
+    for (i = 0; ret == 0 && i < BENCH_KEYS; i++) {
+        ret = make_csr(&rng, i, csrBuf + i * LARGE_TEMP_SZ, LARGE_TEMP_SZ);
+        if (ret > 0) {
+            csr[i] = csrBuf + i * LARGE_TEMP_SZ;
+            csrSz[i] = (word32)ret;
+            ret = 0;
+        }
+    }
+    wc_FreeRng(&rng);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to make CSRs: %d\n", ret);
+        XFREE(csrBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
+    }
+
+    memset(c, 0, sizeof(c));
+    start = now();
+    for (started = 0; started < conns; started++) {
+        c[started].path = path;
+        c[started].csr = csr;
+        c[started].csrSz = csrSz;
+        c[started].numCsr = BENCH_KEYS;
+        c[started].certs = numCerts / conns + (started < numCerts % conns);
+        c[started].batch = batch;
+        if (pthread_create(&c[started].tid, NULL, bench_thread,
+                           &c[started]) != 0) {
+            fprintf(stderr, "Failed to start connection %d\n", started);
+            break;
+        }
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(c[i].tid, NULL);
+        if (c[i].err)
+            ret = -1;
+        issued += c[i].issued;
+        batches += c[i].batches;
+        latency += c[i].latency;
+        if (c[i].maxLatency > maxLatency)
+            maxLatency = c[i].maxLatency;
+    }
+    elapsed = now() - start;
+    XFREE(csrBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+
+    if (ret != 0 || batches == 0) {
+        fprintf(stderr, "Benchmark failed\n");
+        return -1;
+    }
+
+    printf("%d CSRs in batches of %d on %d connections\n", numCerts, batch,
+           started);
+    printf("  %-24s %10d\n", "Issued:", issued);
+    printf("  %-24s %10d\n", "Rejected:", numCerts - issued);
+    printf("  %-24s %10.2f\n", "Seconds:", elapsed);
+    printf("  %-24s %10.1f\n", "Certs/s:", issued / elapsed);
+    printf("  %-24s %10.0f\n", "Certs/hour:", issued * 3600 / elapsed);
+    printf("  %-24s %10.3f\n", "Batch latency (ms):",
+           latency * 1000 / batches);
+    printf("  %-24s %10.3f\n", "Max batch latency (ms):", maxLatency * 1000);
+
+    return 0;
+}
+
+/* Have one CSR signed and write the certificate. */
+static int run_sign(const char* path, const char* csrFile)
+{
+    int         ret;
+    int         fd;
+    FILE*       file;
+    byte        csrBuf[LARGE_TEMP_SZ];
+    byte        cert[LARGE_TEMP_SZ];
+    word32      certSz = 0;
+    const byte* csr = csrBuf;
+    word32      csrSz;
+
+    file = fopen(csrFile, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", csrFile);
+        return -1;
+    }
+    csrSz = (word32)fread(csrBuf, 1, sizeof(csrBuf), file);
+    fclose(file);
+
+    fd = connect_service(path);
+    if (fd < 0)
+        return -1;
+    ret = send_batch(fd, &csr, &csrSz, 1, cert, &certSz);
+    close(fd);
+    if (ret != 1) {
+        fprintf(stderr, "CSR was rejected\n");
+        return -1;
+    }
+
+    file = fopen(kNewCert, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", kNewCert);
+        return -1;
+    }
+    fwrite(cert, 1, certSz, file);
+    fclose(file);
+    printf("Wrote %u byte certificate to \"%s\"\n", certSz, kNewCert);
+
+    return 0;
+}
+
+#endif
+
+/* Shows usage information */
+static void usage(void)
+{
+    fprintf(stderr, "csr_sign_service <options>:\n");
+    fprintf(stderr, "  -serve            Sign CSRs sent to the socket\n");
+    fprintf(stderr, "  -bench            Send CSRs to the service and "
+                    "measure certs/s\n");
+    fprintf(stderr, "  -sign <csr file>  Have a CSR signed, written to %s\n",
+            kNewCert);
+    fprintf(stderr, "  -ca-cert <file>   CA certificate, default %s\n",
+            kCaCert);
+    fprintf(stderr, "  -ca-key <file>    CA key, default %s\n", kCaKey);
+    fprintf(stderr, "  -threads <num>    Number of signing threads, "
+                    "default: number of cores\n");
+    fprintf(stderr, "  -n <num>          CSRs to send, default %d\n",
+            DEF_NUM_CERTS);
+    fprintf(stderr, "  -batch <num>      CSRs per request, 1-%d, default "
+                    "%d\n", MAX_BATCH, DEF_BATCH);
+    fprintf(stderr, "  -conns <num>      Client connections, default %d\n",
+            DEF_CONNS);
+    fprintf(stderr, "  -sock <path>      Unix socket of service, default "
+                    "%s\n", kSockPath);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+#if defined(WOLFSSL_CERT_REQ) && defined(WOLFSSL_CERT_GEN) && \
+    defined(HAVE_ECC) && defined(WOLFSSL_CERT_EXT) && \
+    defined(HAVE_DECODEDCERT)
+    int ret = 0;
+    int serve = 0;
+    int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int numCerts = DEF_NUM_CERTS;
+    int batch = DEF_BATCH;
+    int conns = DEF_CONNS;
+    const char* csrFile = NULL;
+    const char* sockPath = kSockPath;
+    const char* caCert = kCaCert;
+    const char* caKey = kCaKey;
+
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > MAX_THREADS)
+        numThreads = MAX_THREADS;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-bench", 7) == 0) {
+            serve = 0;
+        }
+        else if (XSTRNCMP(*argv, "-serve", 7) == 0) {
+            serve = 1;
+        }
+        else if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-sign", 6) == 0) {
+            csrFile = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-ca-cert", 9) == 0) {
+            caCert = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-ca-key", 8) == 0) {
+            caKey = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-threads", 9) == 0) {
+            numThreads = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-n", 3) == 0) {
+            numCerts = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-batch", 7) == 0) {
+            batch = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-conns", 7) == 0) {
+            conns = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-sock", 6) == 0) {
+            sockPath = *++argv;
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if (numThreads < 1 || numThreads > MAX_THREADS || numCerts < 1 ||
+            batch < 1 || batch > MAX_BATCH || conns < 1 ||
+            conns > MAX_THREADS) {
+        fprintf(stderr, "Threads and connections must be 1-%d, batch 1-%d\n",
+                MAX_THREADS, MAX_BATCH);
+        usage();
+        return 1;
+    }
+
+    wolfCrypt_Init();
+
+    if (csrFile != NULL) {
+        ret = run_sign(sockPath, csrFile);
+    }
+    else if (serve) {
+        ret = run_server(sockPath, caCert, caKey, numThreads);
+    }
+    else {
+        ret = run_bench(sockPath, numCerts, batch, conns);
+    }
+
+    wolfCrypt_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+#else
+    (void)argc;
+    (void)argv;
+    (void)kSockPath;
+    (void)kCaCert;
+    (void)kCaKey;
+    (void)kNewCert;
+    (void)usage;
+
+    printf("Please compile wolfSSL with --enable-certreq --enable-certgen "
+           "--enable-ecc --enable-certext CFLAGS=-DOPENSSL_EXTRA_X509_SMALL\n");
+    return 0;
+#endif
+}
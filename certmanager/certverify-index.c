@@ -0,0 +1,788 @@
+/* certverify-index.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *=============================================================================
+ *
+ * Example of a precompiled, memory-mappable trust store for the CertManager.
+ *
+ * A PEM bundle is converted once into an index file holding the DER of each
+ * CA plus tables sorted by subject name hash and subject key identifier.
+ * A CertManager attaches to the mapped file without parsing anything and
+ * only loads the CAs actually needed to verify a certificate.
+ * Reports the cost of a CertManager set up with wolfSSL_CertManagerLoadCA on
+ * the PEM bundle against one attached to the index.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/test.h>
+
+/* The CA of the certificate verified by default. */
+#define CA_BUNDLE   "../certs/ca-cert.pem"
+/* The system's CAs. When present, the default bundle is these and CA_BUNDLE
+ * so that the index has many CAs to choose from, as in a real trust store. */
+#define SYSTEM_CA_BUNDLE "/etc/ssl/certs/ca-certificates.crt"
+/* The default bundle written from SYSTEM_CA_BUNDLE and CA_BUNDLE. */
+#define DEFAULT_BUNDLE   "ca-bundle.pem"
+/* The default index file to write and map. */
+#define CA_INDEX    "ca-index.bin"
+/* The default certificate to verify. */
+#define VERIFY_CERT "../certs/server-cert.pem"
+/* The default number of CertManagers to set up in each run. */
+#define NUM_ITERS   100
+/* Maximum length of chain loaded from the index for one verification. */
+#define MAX_DEPTH   8
+
+/* Index file identifier and format version. */
+#define CA_INDEX_MAGIC   "WCAI"
+#define CA_INDEX_VERSION 1
+
+/* The CA has an authority key identifier. */
+#define CA_FLAG_AKID        0x01
+/* The CA is self-signed - no issuer to load. */
+#define CA_FLAG_SELF_SIGNED 0x02
+
+/* The command line options. */
+#define OPTIONS "?b:i:c:n:o"
+
+/* Header at the start of the index file.
+ * The file is a local cache so values are in host byte order.
+ */
+typedef struct CaIndexHdr {
+    /* CA_INDEX_MAGIC */
+    byte   magic[4];
+    /* CA_INDEX_VERSION */
+    word32 version;
+    /* Size of the hashes in the tables - KEYID_SIZE of the builder. */
+    word32 keyIdSz;
+    /* Number of CAs in the index. */
+    word32 count;
+    /* Offset of the CaIndexCa table. */
+    word32 caOff;
+    /* Offset of the table sorted by subject name hash. */
+    word32 nameOff;
+    /* Offset of the table sorted by subject key identifier. */
+    word32 skidOff;
+    /* Offset of the DER encoded certificates. */
+    word32 derOff;
+} CaIndexHdr;
+
+/* Information on a CA needed to find its issuer without parsing. */
+typedef struct CaIndexCa {
+    /* Offset of DER encoding from start of certificate data. */
+    word32 derOff;
+    /* Length of DER encoding. */
+    word32 derSz;
+    /* CA_FLAG_* values. */
+    word32 flags;
+    /* Hash of the issuer name. */
+    byte   issuerHash[KEYID_SIZE];
+    /* Authority key identifier - valid when CA_FLAG_AKID set. */
+    byte   akid[KEYID_SIZE];
+} CaIndexCa;
+
+/* Entry in a lookup table. */
+typedef struct CaIndexKey {
+    /* Subject name hash or subject key identifier. */
+    byte   key[KEYID_SIZE];
+    /* Index into the CaIndexCa table. */
+    word32 ca;
+} CaIndexKey;
+
+/* A mapped index file - read-only and shareable between processes. */
+typedef struct CaIndex {
+    byte*             map;
+    size_t            mapSz;
+    const CaIndexHdr* hdr;
+    const CaIndexCa*  cas;
+    const CaIndexKey* byName;
+    const CaIndexKey* bySkid;
+    const byte*       der;
+} CaIndex;
+
+/* A CertManager attached to an index. */
+typedef struct CaIndexCm {
+    WOLFSSL_CERT_MANAGER* cm;
+    const CaIndex*        idx;
+    /* One byte per CA - set when loaded into the CertManager. */
+    byte*                 loaded;
+} CaIndexCm;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+/* Read the whole of a file into a newly allocated buffer.
+ *
+ * fileName  Name of file to read.
+ * buf       Allocated buffer holding file data.
+ * bufSz     Length of file data.
+ * returns 0 on success, -1 on failure.
+ */
+static int LoadFile(const char* fileName, byte** buf, size_t* bufSz)
+{
+    FILE* file;
+    long  sz;
+
+    file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to open file: %s\n", fileName);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    sz = ftell(file);
+    rewind(file);
+
+    *buf = (byte*)malloc(sz + 1);
+    if (*buf == NULL || (long)fread(*buf, 1, sz, file) != sz) {
+        fprintf(stderr, "Unable to read file: %s\n", fileName);
+        free(*buf);
+        fclose(file);
+        return -1;
+    }
+    /* NUL terminate so PEM data can be searched as a string. */
+    (*buf)[sz] = '\0';
+    *bufSz = sz;
+    fclose(file);
+
+    return 0;
+}
+
+/* Compare lookup table entries by key for sorting and searching. */
+static int CaIndexKey_Cmp(const void* a, const void* b)
+{
+    return XMEMCMP(((const CaIndexKey*)a)->key, ((const CaIndexKey*)b)->key,
+        KEYID_SIZE);
+}
+
+
+/* Build an index file from a bundle of PEM encoded CA certificates.
+ *
+ * bundleFile  Name of PEM bundle.
+ * indexFile   Name of index file to write.
+ * returns 0 on success, -1 on failure.
+ */
+static int CaIndex_Build(const char* bundleFile, const char* indexFile)
+{
+    int         ret = 0;
+    byte*       pem = NULL;
+    size_t      pemSz;
+    byte*       der = NULL;
+    word32      derSz = 0;
+    CaIndexCa*  cas = NULL;
+    CaIndexKey* byName = NULL;
+    CaIndexKey* bySkid = NULL;
+    word32      count = 0;
+    char*       begin;
+    char*       end;
+    CaIndexHdr  hdr;
+    FILE*       file;
+    DecodedCert cert;
+
+    if (LoadFile(bundleFile, &pem, &pemSz) != 0)
+        return -1;
+
+    /* DER is always smaller than the PEM it came from. */
+    der = (byte*)malloc(pemSz);
+    cas = (CaIndexCa*)malloc(sizeof(CaIndexCa) * (pemSz / 64 + 1));
+    byName = (CaIndexKey*)malloc(sizeof(CaIndexKey) * (pemSz / 64 + 1));
+    bySkid = (CaIndexKey*)malloc(sizeof(CaIndexKey) * (pemSz / 64 + 1));
+    if (der == NULL || cas == NULL || byName == NULL || bySkid == NULL) {
+        ret = -1;
+        goto exit;
+    }
+
+    /* wc_CertPemToDer only converts the first certificate so split bundle. */
+    begin = strstr((char*)pem, "-----BEGIN CERTIFICATE-----");
+    while (begin != NULL) {
+        int sz;
+
+        end = strstr(begin, "-----END CERTIFICATE-----");
+        if (end == NULL)
+            break;
+        end += strlen("-----END CERTIFICATE-----");
+
+        sz = wc_CertPemToDer((byte*)begin, (int)(end - begin), der + derSz,
+            (int)(pemSz - derSz), CERT_TYPE);
+        if (sz <= 0) {
+            fprintf(stderr, "Skipping bad certificate (%d)\n", sz);
+            begin = strstr(end, "-----BEGIN CERTIFICATE-----");
+            continue;
+        }
+
+        wc_InitDecodedCert(&cert, der + derSz, sz, NULL);
+        ret = wc_ParseCert(&cert, CERT_TYPE, NO_VERIFY, NULL);
+        if (ret == 0) {
+            CaIndexCa* ca = &cas[count];
+
+            ca->derOff = derSz;
+            ca->derSz = sz;
+            ca->flags = 0;
+            XMEMCPY(ca->issuerHash, cert.issuerHash, KEYID_SIZE);
+            if (cert.extAuthKeyIdSet) {
+                ca->flags |= CA_FLAG_AKID;
+                XMEMCPY(ca->akid, cert.extAuthKeyId, KEYID_SIZE);
+            }
+            else {
+                XMEMSET(ca->akid, 0, KEYID_SIZE);
+            }
+            if (XMEMCMP(cert.issuerHash, cert.subjectHash, KEYID_SIZE) == 0)
+                ca->flags |= CA_FLAG_SELF_SIGNED;
+
+            /* Same hashes the CertManager uses to find a signer. */
+            XMEMCPY(byName[count].key, cert.subjectHash, KEYID_SIZE);
+            byName[count].ca = count;
+            XMEMCPY(bySkid[count].key, cert.extSubjKeyId, KEYID_SIZE);
+            bySkid[count].ca = count;
+
+            derSz += sz;
+            count++;
+        }
+        else {
+            fprintf(stderr, "Skipping unparsable certificate (%d)\n", ret);
+            ret = 0;
+        }
+        wc_FreeDecodedCert(&cert);
+
+        begin = strstr(end, "-----BEGIN CERTIFICATE-----");
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "No certificates found in: %s\n", bundleFile);
+        ret = -1;
+        goto exit;
+    }
+
+    qsort(byName, count, sizeof(CaIndexKey), CaIndexKey_Cmp);
+    qsort(bySkid, count, sizeof(CaIndexKey), CaIndexKey_Cmp);
+
+    XMEMSET(&hdr, 0, sizeof(hdr));
+    XMEMCPY(hdr.magic, CA_INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version = CA_INDEX_VERSION;
+    hdr.keyIdSz = KEYID_SIZE;
+    hdr.count   = count;
+    hdr.caOff   = sizeof(CaIndexHdr);
+    hdr.nameOff = hdr.caOff + count * sizeof(CaIndexCa);
+    hdr.skidOff = hdr.nameOff + count * sizeof(CaIndexKey);
+    hdr.derOff  = hdr.skidOff + count * sizeof(CaIndexKey);
+
+    file = fopen(indexFile, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to create index file: %s\n", indexFile);
+        ret = -1;
+        goto exit;
+    }
+    if (fwrite(&hdr, sizeof(hdr), 1, file) != 1 ||
+            fwrite(cas, sizeof(CaIndexCa), count, file) != count ||
+            fwrite(byName, sizeof(CaIndexKey), count, file) != count ||
+            fwrite(bySkid, sizeof(CaIndexKey), count, file) != count ||
+            fwrite(der, 1, derSz, file) != derSz) {
+        fprintf(stderr, "Unable to write index file: %s\n", indexFile);
+        ret = -1;
+    }
+    fclose(file);
+
+    if (ret == 0)
+        printf("Indexed %u CAs (%u bytes of DER)\n", count, derSz);
+
+exit:
+    free(bySkid);
+    free(byName);
+    free(cas);
+    free(der);
+    free(pem);
+    return ret;
+}
+
+
+/* Check the layout of a mapped index file.
+ *
+ * The file may be stale or written by another build so every offset and
+ * length is checked against the mapping before any table is used.
+ *
+ * map    Mapped index file.
+ * mapSz  Length of mapping.
+ * returns 0 when valid, -1 otherwise.
+ */
+static int CaIndex_Check(const byte* map, size_t mapSz)
+{
+    const CaIndexHdr* hdr = (const CaIndexHdr*)map;
+    const CaIndexCa*  cas;
+    const CaIndexKey* byName;
+    const CaIndexKey* bySkid;
+    size_t            derSz;
+    word32            i;
+
+    if (XMEMCMP(hdr->magic, CA_INDEX_MAGIC, sizeof(hdr->magic)) != 0 ||
+            hdr->version != CA_INDEX_VERSION || hdr->keyIdSz != KEYID_SIZE) {
+        return -1;
+    }
+
+    /* Tables follow the header in order with no gaps. Count is limited first
+     * so that the table sizes can't wrap. */
+    if (hdr->caOff != sizeof(CaIndexHdr) || hdr->count == 0 ||
+            hdr->count > (mapSz - sizeof(CaIndexHdr)) /
+                         (sizeof(CaIndexCa) + 2 * sizeof(CaIndexKey))) {
+        return -1;
+    }
+    if ((size_t)hdr->nameOff !=
+                (size_t)hdr->caOff + hdr->count * sizeof(CaIndexCa) ||
+            (size_t)hdr->skidOff !=
+                (size_t)hdr->nameOff + hdr->count * sizeof(CaIndexKey) ||
+            (size_t)hdr->derOff !=
+                (size_t)hdr->skidOff + hdr->count * sizeof(CaIndexKey) ||
+            hdr->derOff > mapSz) {
+        return -1;
+    }
+
+    /* Every certificate must lie within the DER data. */
+    cas = (const CaIndexCa*)(map + hdr->caOff);
+    derSz = mapSz - hdr->derOff;
+    for (i = 0; i < hdr->count; i++) {
+        if (cas[i].derSz == 0 || cas[i].derOff > derSz ||
+                cas[i].derSz > derSz - cas[i].derOff) {
+            return -1;
+        }
+    }
+
+    /* Lookup tables must refer to CAs in the table. */
+    byName = (const CaIndexKey*)(map + hdr->nameOff);
+    bySkid = (const CaIndexKey*)(map + hdr->skidOff);
+    for (i = 0; i < hdr->count; i++) {
+        if (byName[i].ca >= hdr->count || bySkid[i].ca >= hdr->count)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* Map an index file into memory and check its layout.
+ *
+ * idx        Index object to set up.
+ * indexFile  Name of index file.
+ * returns 0 on success, -1 on failure.
+ */
+static int CaIndex_Open(CaIndex* idx, const char* indexFile)
+{
+    int         fd;
+    struct stat st;
+    const CaIndexHdr* hdr;
+
+    XMEMSET(idx, 0, sizeof(*idx));
+
+    fd = open(indexFile, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to open index file: %s\n", indexFile);
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CaIndexHdr)) {
+        close(fd);
+        return -1;
+    }
+
+    /* Shared mapping - pages are common to all processes using the index. */
+    idx->map = (byte*)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (idx->map == MAP_FAILED) {
+        idx->map = NULL;
+        return -1;
+    }
+    idx->mapSz = st.st_size;
+
+    hdr = (const CaIndexHdr*)idx->map;
+    if (CaIndex_Check(idx->map, idx->mapSz) != 0) {
+        fprintf(stderr, "Index file not valid for this build: %s\n",
+            indexFile);
+        munmap(idx->map, idx->mapSz);
+        idx->map = NULL;
+        return -1;
+    }
+
+    idx->hdr    = hdr;
+    idx->cas    = (const CaIndexCa*)(idx->map + hdr->caOff);
+    idx->byName = (const CaIndexKey*)(idx->map + hdr->nameOff);
+    idx->bySkid = (const CaIndexKey*)(idx->map + hdr->skidOff);
+    idx->der    = idx->map + hdr->derOff;
+
+    return 0;
+}
+
+/* Unmap an index file. */
+static void CaIndex_Close(CaIndex* idx)
+{
+    if (idx->map != NULL)
+        munmap(idx->map, idx->mapSz);
+    idx->map = NULL;
+}
+
+/* Find a CA in a lookup table.
+ *
+ * idx    Index object.
+ * table  Lookup table to search.
+ * key    Subject name hash or subject key identifier to find.
+ * returns index of CA or -1 when not found.
+ */
+static int CaIndex_Find(const CaIndex* idx, const CaIndexKey* table,
+    const byte* key)
+{
+    CaIndexKey        find;
+    const CaIndexKey* found;
+
+    XMEMCPY(find.key, key, KEYID_SIZE);
+    found = (const CaIndexKey*)bsearch(&find, table, idx->hdr->count,
+        sizeof(CaIndexKey), CaIndexKey_Cmp);
+    if (found == NULL)
+        return -1;
+    return (int)found->ca;
+}
+
+
+/* Attach a CertManager to an index. No CAs are loaded until needed.
+ *
+ * icm  Attached CertManager object.
+ * cm   CertManager to load CAs into.
+ * idx  Mapped index.
+ * returns 0 on success, -1 on failure.
+ */
+static int CaIndexCm_Attach(CaIndexCm* icm, WOLFSSL_CERT_MANAGER* cm,
+    const CaIndex* idx)
+{
+    icm->cm = cm;
+    icm->idx = idx;
+    icm->loaded = (byte*)calloc(idx->hdr->count, 1);
+    if (icm->loaded == NULL)
+        return -1;
+    return 0;
+}
+
+/* Detach a CertManager from an index. CAs already loaded remain. */
+static void CaIndexCm_Detach(CaIndexCm* icm)
+{
+    free(icm->loaded);
+    icm->loaded = NULL;
+}
+
+/* Load the issuer of a certificate, and the issuer's issuers, from the index.
+ *
+ * icm         Attached CertManager object.
+ * issuerHash  Hash of the certificate's issuer name.
+ * akid        Authority key identifier of certificate or NULL when none.
+ * depth       Number of CAs above the certificate being verified.
+ * returns WOLFSSL_SUCCESS on success, ASN_NO_SIGNER_E when not in index and
+ * other negative value on failure.
+ */
+static int CaIndexCm_LoadIssuer(CaIndexCm* icm, const byte* issuerHash,
+    const byte* akid, int depth)
+{
+    int              ret;
+    int              i = -1;
+    const CaIndex*   idx = icm->idx;
+    const CaIndexCa* ca;
+
+    /* Prefer key identifier like the CertManager does. */
+    if (akid != NULL)
+        i = CaIndex_Find(idx, idx->bySkid, akid);
+    if (i < 0)
+        i = CaIndex_Find(idx, idx->byName, issuerHash);
+    if (i < 0)
+        return ASN_NO_SIGNER_E;
+    if (icm->loaded[i])
+        return WOLFSSL_SUCCESS;
+
+    ca = &idx->cas[i];
+    /* A CA is verified when added so its issuer must be loaded first. */
+    if ((ca->flags & CA_FLAG_SELF_SIGNED) == 0) {
+        if (depth >= MAX_DEPTH)
+            return ASN_NO_SIGNER_E;
+        ret = CaIndexCm_LoadIssuer(icm, ca->issuerHash,
+            (ca->flags & CA_FLAG_AKID) ? ca->akid : NULL, depth + 1);
+        if (ret != WOLFSSL_SUCCESS)
+            return ret;
+    }
+
+    ret = wolfSSL_CertManagerLoadCABuffer(icm->cm, idx->der + ca->derOff,
+        ca->derSz, WOLFSSL_FILETYPE_ASN1);
+    if (ret == WOLFSSL_SUCCESS)
+        icm->loaded[i] = 1;
+
+    return ret;
+}
+
+/* Verify a DER encoded certificate against the index.
+ *
+ * icm    Attached CertManager object.
+ * der    DER encoded certificate.
+ * derSz  Length of DER encoding.
+ * returns WOLFSSL_SUCCESS on success, other value on failure.
+ */
+static int CaIndexCm_Verify(CaIndexCm* icm, const byte* der, word32 derSz)
+{
+    int         ret;
+    DecodedCert cert;
+
+    wc_InitDecodedCert(&cert, der, derSz, NULL);
+    ret = wc_ParseCert(&cert, CERT_TYPE, NO_VERIFY, NULL);
+    if (ret == 0) {
+        ret = CaIndexCm_LoadIssuer(icm, cert.issuerHash,
+            cert.extAuthKeyIdSet ? cert.extAuthKeyId : NULL, 0);
+    }
+    wc_FreeDecodedCert(&cert);
+
+    /* Not finding an issuer in the index is left for verify to report. */
+    if (ret == WOLFSSL_SUCCESS || ret == ASN_NO_SIGNER_E) {
+        ret = wolfSSL_CertManagerVerifyBuffer(icm->cm, der, derSz,
+            WOLFSSL_FILETYPE_ASN1);
+    }
+
+    return ret;
+}
+
+
+/* Write the system's CAs followed by the test CA into one bundle.
+ *
+ * bundleFile  Name of file to write.
+ * returns 0 on success, -1 on failure.
+ */
+static int CaBundle_Make(const char* bundleFile)
+{
+    int    ret = 0;
+    FILE*  file;
+    byte*  sys = NULL;
+    size_t sysSz = 0;
+    byte*  ca = NULL;
+    size_t caSz = 0;
+
+    if (LoadFile(SYSTEM_CA_BUNDLE, &sys, &sysSz) != 0 ||
+            LoadFile(CA_BUNDLE, &ca, &caSz) != 0) {
+        free(sys);
+        return -1;
+    }
+
+    file = fopen(bundleFile, "wb");
+    if (file == NULL || fwrite(sys, 1, sysSz, file) != sysSz ||
+            fwrite("\n", 1, 1, file) != 1 ||
+            fwrite(ca, 1, caSz, file) != caSz) {
+        fprintf(stderr, "Unable to write bundle file: %s\n", bundleFile);
+        ret = -1;
+    }
+    if (file != NULL && fclose(file) != 0)
+        ret = -1;
+
+    free(ca);
+    free(sys);
+    return ret;
+}
+
+/* Display the usage of the program. */
+static void Usage(void)
+{
+    printf("certverify-index " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-b <file>   PEM bundle of CAs, default %s and %s written to %s,\n"
+           "            or %s alone\n", SYSTEM_CA_BUNDLE, CA_BUNDLE,
+           DEFAULT_BUNDLE, CA_BUNDLE);
+    printf("-i <file>   Index file to write or open, default %s\n", CA_INDEX);
+    printf("-o          Open existing index file, don't build from bundle\n");
+    printf("-c <file>   Certificate to verify, default %s\n", VERIFY_CERT);
+    printf("-n <num>    Number of CertManagers to set up, default %d\n",
+        NUM_ITERS);
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret = 0;
+    int         ch;
+    int         i;
+    const char* bundleFile = NULL;
+    const char* indexFile = CA_INDEX;
+    const char* verifyFile = VERIFY_CERT;
+    int         numIters = NUM_ITERS;
+    int         openOnly = 0;
+    word32      numCas = 0;
+    byte*       pem = NULL;
+    size_t      pemSz;
+    byte*       der = NULL;
+    int         derSz;
+    CaIndex     idx;
+    CaIndexCm   icm;
+    WOLFSSL_CERT_MANAGER* cm;
+    double      start;
+    double      buildTime;
+    double      openTime;
+    double      pemTime;
+    double      idxTime;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'b':
+                bundleFile = myoptarg;
+                break;
+            case 'i':
+                indexFile = myoptarg;
+                break;
+            case 'c':
+                verifyFile = myoptarg;
+                break;
+            case 'n':
+                numIters = atoi(myoptarg);
+                break;
+            case 'o':
+                openOnly = 1;
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    if (numIters <= 0)
+        numIters = 1;
+
+    if (bundleFile == NULL) {
+        /* One CA shows nothing: use the system's CAs when there are some. */
+        bundleFile = CA_BUNDLE;
+        if (access(SYSTEM_CA_BUNDLE, R_OK) == 0 &&
+                CaBundle_Make(DEFAULT_BUNDLE) == 0) {
+            bundleFile = DEFAULT_BUNDLE;
+        }
+    }
+
+    wolfSSL_Init();
+#ifdef DEBUG_WOLFSSL
+    wolfSSL_Debugging_ON();
+#endif
+
+    /* Certificate to verify - DER so both paths do the same verify work. */
+    if (LoadFile(verifyFile, &pem, &pemSz) != 0) {
+        ret = -1; goto exit;
+    }
+    der = (byte*)malloc(pemSz);
+    if (der == NULL) {
+        ret = -1; goto exit;
+    }
+    derSz = wc_CertPemToDer(pem, (int)pemSz, der, (int)pemSz, CERT_TYPE);
+    if (derSz <= 0) {
+        printf("wc_CertPemToDer() failed (%d)\n", derSz);
+        ret = -1; goto exit;
+    }
+
+    /* Index may have been built earlier, possibly by another process. */
+    buildTime = 0;
+    if (!openOnly) {
+        start = current_time(1);
+        ret = CaIndex_Build(bundleFile, indexFile);
+        buildTime = current_time(0) - start;
+        if (ret != 0)
+            goto exit;
+    }
+
+    /* Mapped once - workers forked after this share the pages. */
+    start = current_time(1);
+    ret = CaIndex_Open(&idx, indexFile);
+    openTime = current_time(0) - start;
+    if (ret != 0)
+        goto exit;
+    numCas = idx.hdr->count;
+
+    /* CertManager set up by parsing every CA in the PEM bundle. */
+    start = current_time(1);
+    for (i = 0; i < numIters && ret == 0; i++) {
+        cm = wolfSSL_CertManagerNew();
+        if (cm == NULL) {
+            ret = -1;
+            break;
+        }
+        ret = wolfSSL_CertManagerLoadCA(cm, bundleFile, NULL);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CertManagerVerifyBuffer(cm, der, derSz,
+                WOLFSSL_FILETYPE_ASN1);
+        }
+        if (ret != WOLFSSL_SUCCESS) {
+            printf("PEM bundle verification failed (%d): %s\n",
+                ret, wolfSSL_ERR_reason_error_string(ret));
+            ret = -1;
+        }
+        else
+            ret = 0;
+        wolfSSL_CertManagerFree(cm);
+    }
+    pemTime = current_time(0) - start;
+
+    /* CertManager attached to the index - only the chain is loaded. */
+    start = current_time(1);
+    for (i = 0; i < numIters && ret == 0; i++) {
+        cm = wolfSSL_CertManagerNew();
+        if (cm == NULL) {
+            ret = -1;
+            break;
+        }
+        ret = CaIndexCm_Attach(&icm, cm, &idx);
+        if (ret == 0) {
+            ret = CaIndexCm_Verify(&icm, der, derSz);
+            if (ret != WOLFSSL_SUCCESS) {
+                printf("Index verification failed (%d): %s\n",
+                    ret, wolfSSL_ERR_reason_error_string(ret));
+                ret = -1;
+            }
+            else
+                ret = 0;
+            CaIndexCm_Detach(&icm);
+        }
+        wolfSSL_CertManagerFree(cm);
+    }
+    idxTime = current_time(0) - start;
+
+    CaIndex_Close(&idx);
+
+    if (ret == 0) {
+        printf("Verification Successful!\n");
+        printf("CAs              : %8u in %s\n", numCas, bundleFile);
+        if (openOnly)
+            printf("Build index      :  prebuilt %s\n", indexFile);
+        else
+            printf("Build index      : %8.3f ms (once)\n", buildTime * 1000);
+        printf("Map index        : %8.3f ms (once)\n", openTime * 1000);
+        printf("PEM LoadCA+verify: %8.3f ms per CertManager\n",
+            pemTime * 1000 / numIters);
+        printf("Index attach+vfy : %8.3f ms per CertManager\n",
+            idxTime * 1000 / numIters);
+    }
+
+exit:
+    free(der);
+    free(pem);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
@@ -0,0 +1,814 @@
+/* crl-index.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *=============================================================================
+ *
+ * Example of revocation checking against large CRLs with a serial index.
+ *
+ * CRLs are parsed on a background thread (one parse thread per CRL file) into
+ * a hash table keyed by issuer name hash and serial number. The new table is
+ * published with an atomic pointer swap and the old one is freed once no
+ * reader can still be using it (RCU-style grace period). Lookups take no
+ * locks.
+ * Each CRL is checked with wolfSSL_CertManagerLoadCRLBuffer, against the CA
+ * given, before its entries are indexed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/test.h>
+
+/* The default CA that signed the CRLs. */
+#define CRL_CA          "../certs/ca-cert.pem"
+/* The default CRL to index. */
+#define CRL_FILE        "../certs/crl/crl.pem"
+/* The default certificates to check. */
+#define CHECK_CERT      "../certs/server-cert.pem"
+#define REVOKED_CERT    "../certs/server-revoked-cert.pem"
+/* The default number of lookup threads. */
+#define NUM_READERS     4
+/* The default number of seconds to run lookups for. */
+#define RUN_SECONDS     3
+/* The default number of milliseconds between reloads of the CRLs. */
+#define RELOAD_MS       500
+/* Maximum number of CRL files and lookup threads. */
+#define MAX_CRLS        64
+#define MAX_READERS     64
+/* Maximum serial number length - RFC 5280 allows 20 octets. */
+#define MAX_SERIAL_SZ   32
+/* Number of serial numbers to probe with - half revoked, half not. */
+#define NUM_PROBES      4096
+/* Size of a cache line - keeps each reader's counters apart. */
+#define CACHE_LINE      64
+
+/* The command line options. */
+#define OPTIONS "?a:c:t:s:r:"
+
+/* ASN.1 tags needed to walk a CRL. */
+#define TAG_INTEGER     0x02
+#define TAG_SEQUENCE    0x30
+#define TAG_UTC_TIME    0x17
+#define TAG_GEN_TIME    0x18
+
+/* A revoked certificate. */
+typedef struct CrlEntry {
+    /* Index of the issuer in the issuer table. */
+    word16 issuer;
+    /* Length of the serial number. */
+    byte   serialSz;
+    /* Serial number without leading zero. */
+    byte   serial[MAX_SERIAL_SZ];
+} CrlEntry;
+
+/* A published, read-only index of revoked certificates. */
+typedef struct CrlIndex {
+    /* Issuer name hashes - one per CRL. */
+    byte      (*issuers)[KEYID_SIZE];
+    int       numIssuers;
+    /* All revoked certificates. */
+    CrlEntry* entries;
+    word32    numEntries;
+    /* Open addressing hash table of entry index plus one - 0 is empty. */
+    word32*   table;
+    word32    mask;
+} CrlIndex;
+
+/* Data for parsing one CRL on its own thread. */
+typedef struct CrlParse {
+    pthread_t   tid;
+    const char* file;
+    const char* caFile;
+    byte        issuer[KEYID_SIZE];
+    CrlEntry*   entries;
+    word32      numEntries;
+    int         ret;
+} CrlParse;
+
+/* Per lookup thread data.
+ * Written on every lookup so each is on its own cache line. */
+typedef struct CrlReader {
+    pthread_t      tid __attribute__((aligned(CACHE_LINE)));
+    /* Epoch of the index being read or 0 when not reading. */
+    atomic_ulong   epoch;
+    unsigned long  lookups;
+    unsigned long  revoked;
+} CrlReader;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+/* The current index - readers load it, the loader swaps it. */
+static _Atomic(CrlIndex*) gIndex;
+/* Incremented each time a new index is published. */
+static atomic_ulong gEpoch = 1;
+/* Readers and whether to keep running. */
+static CrlReader  gReaders[MAX_READERS];
+static int        gNumReaders = NUM_READERS;
+static atomic_int gRunning;
+
+/* CRL files and CA to check them with. */
+static const char* gCrlFiles[MAX_CRLS];
+static int         gNumCrlFiles;
+static const char* gCaFile = CRL_CA;
+
+/* Probes for lookups. */
+static byte   gProbeIssuer[NUM_PROBES][KEYID_SIZE];
+static byte   gProbeSerial[NUM_PROBES][MAX_SERIAL_SZ];
+static byte   gProbeSerialSz[NUM_PROBES];
+static int    gNumProbes;
+
+
+/* Get the header of an ASN.1 item and check the tag.
+ *
+ * in     DER encoding.
+ * inSz   Length of DER encoding.
+ * idx    On in, index of item. On out, index of item's data.
+ * tag    Expected tag.
+ * len    Length of item's data.
+ * returns 0 on success, -1 when invalid.
+ */
+static int GetHeader(const byte* in, word32 inSz, word32* idx, byte tag,
+    word32* len)
+{
+    word32 i = *idx;
+    word32 l;
+    int    n;
+
+    if (i + 2 > inSz || in[i] != tag)
+        return -1;
+    i++;
+    l = in[i++];
+    if (l & 0x80) {
+        n = l & 0x7f;
+        if (n == 0 || n > 4 || i + n > inSz)
+            return -1;
+        l = 0;
+        while (n-- > 0)
+            l = (l << 8) | in[i++];
+    }
+    if (l > inSz - i)
+        return -1;
+
+    *idx = i;
+    *len = l;
+    return 0;
+}
+
+/* Hash a name the way wolfSSL does for issuer/subject hashes. */
+static int HashName(const byte* name, word32 nameSz, byte* hash)
+{
+#ifdef NO_SHA
+    return wc_Sha256Hash(name, nameSz, hash);
+#else
+    return wc_ShaHash(name, nameSz, hash);
+#endif
+}
+
+/* Walk a DER encoded CRL and collect the revoked serial numbers.
+ *
+ * p      Parse data to fill.
+ * der    DER encoded CRL - signature already checked.
+ * derSz  Length of DER encoding.
+ * returns 0 on success, -1 when invalid.
+ */
+static int CrlParse_Der(CrlParse* p, const byte* der, word32 derSz)
+{
+    word32 idx = 0;
+    word32 len;
+    word32 tbsEnd;
+    word32 listEnd;
+    word32 nameIdx;
+    word32 max = 0;
+
+    /* CertificateList, TBSCertList */
+    if (GetHeader(der, derSz, &idx, TAG_SEQUENCE, &len) != 0 ||
+            GetHeader(der, derSz, &idx, TAG_SEQUENCE, &len) != 0)
+        return -1;
+    tbsEnd = idx + len;
+    /* Optional version */
+    if (GetHeader(der, tbsEnd, &idx, TAG_INTEGER, &len) == 0)
+        idx += len;
+    /* Signature algorithm */
+    if (GetHeader(der, tbsEnd, &idx, TAG_SEQUENCE, &len) != 0)
+        return -1;
+    idx += len;
+    /* Issuer - hash includes the header. */
+    nameIdx = idx;
+    if (GetHeader(der, tbsEnd, &idx, TAG_SEQUENCE, &len) != 0)
+        return -1;
+    idx += len;
+    if (HashName(der + nameIdx, idx - nameIdx, p->issuer) != 0)
+        return -1;
+    /* This update, optional next update */
+    if (GetHeader(der, tbsEnd, &idx, TAG_UTC_TIME, &len) != 0 &&
+            GetHeader(der, tbsEnd, &idx, TAG_GEN_TIME, &len) != 0)
+        return -1;
+    idx += len;
+    if (GetHeader(der, tbsEnd, &idx, TAG_UTC_TIME, &len) == 0 ||
+            GetHeader(der, tbsEnd, &idx, TAG_GEN_TIME, &len) == 0)
+        idx += len;
+    /* Optional revoked certificates */
+    if (GetHeader(der, tbsEnd, &idx, TAG_SEQUENCE, &len) != 0)
+        return 0;
+    listEnd = idx + len;
+
+    while (idx < listEnd) {
+        word32 entryEnd;
+        const byte* serial;
+
+        if (GetHeader(der, listEnd, &idx, TAG_SEQUENCE, &len) != 0)
+            return -1;
+        entryEnd = idx + len;
+        if (GetHeader(der, entryEnd, &idx, TAG_INTEGER, &len) != 0 ||
+                len == 0)
+            return -1;
+        serial = der + idx;
+        /* Leading zero only there to keep the INTEGER positive. */
+        if (len > 1 && serial[0] == 0) {
+            serial++;
+            len--;
+        }
+        if (len > MAX_SERIAL_SZ)
+            return -1;
+
+        if (p->numEntries == max) {
+            CrlEntry* e;
+
+            max = (max == 0) ? 1024 : max * 2;
+            e = (CrlEntry*)realloc(p->entries, max * sizeof(CrlEntry));
+            if (e == NULL)
+                return -1;
+            p->entries = e;
+        }
+        p->entries[p->numEntries].serialSz = (byte)len;
+        XMEMCPY(p->entries[p->numEntries].serial, serial, len);
+        p->numEntries++;
+
+        idx = entryEnd;
+    }
+
+    return 0;
+}
+
+/* Read a file into a newly allocated buffer.
+ *
+ * returns 0 on success, -1 on failure.
+ */
+static int LoadFile(const char* fileName, byte** buf, long* bufSz)
+{
+    FILE* file;
+    long  sz;
+
+    file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to open file: %s\n", fileName);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    sz = ftell(file);
+    rewind(file);
+
+    *buf = (byte*)malloc(sz);
+    if (*buf == NULL || (long)fread(*buf, 1, sz, file) != sz) {
+        fprintf(stderr, "Unable to read file: %s\n", fileName);
+        free(*buf);
+        fclose(file);
+        return -1;
+    }
+    *bufSz = sz;
+    fclose(file);
+
+    return 0;
+}
+
+/* Thread that checks and parses one CRL file. PEM or DER. */
+static void* CrlParse_Thread(void* args)
+{
+    CrlParse*  p = (CrlParse*)args;
+    byte*      buf = NULL;
+    long       bufSz;
+    DerBuffer* der = NULL;
+    int        format;
+    WOLFSSL_CERT_MANAGER* cm = NULL;
+
+    p->ret = -1;
+    if (LoadFile(p->file, &buf, &bufSz) != 0)
+        return NULL;
+    format = (bufSz > 0 && buf[0] == TAG_SEQUENCE) ? WOLFSSL_FILETYPE_ASN1 :
+                                                     WOLFSSL_FILETYPE_PEM;
+
+    /* Signature and issuer checked by wolfSSL in a scratch CertManager. */
+    cm = wolfSSL_CertManagerNew();
+    if (cm == NULL)
+        goto exit;
+    if (wolfSSL_CertManagerLoadCA(cm, p->caFile, NULL) != WOLFSSL_SUCCESS ||
+            wolfSSL_CertManagerEnableCRL(cm, 0) != WOLFSSL_SUCCESS)
+        goto exit;
+    p->ret = wolfSSL_CertManagerLoadCRLBuffer(cm, buf, bufSz, format);
+    if (p->ret != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "CRL not valid (%d): %s\n", p->ret, p->file);
+        p->ret = -1;
+        goto exit;
+    }
+
+    if (format == WOLFSSL_FILETYPE_PEM) {
+        p->ret = wc_PemToDer(buf, bufSz, CRL_TYPE, &der, NULL, NULL, NULL);
+        if (p->ret != 0)
+            goto exit;
+        p->ret = CrlParse_Der(p, der->buffer, der->length);
+    }
+    else {
+        p->ret = CrlParse_Der(p, buf, (word32)bufSz);
+    }
+
+exit:
+    wc_FreeDer(&der);
+    wolfSSL_CertManagerFree(cm);
+    free(buf);
+    return NULL;
+}
+
+
+/* Hash of serial number and issuer index for the table. FNV-1a. */
+static word32 CrlIndex_Hash(word16 issuer, const byte* serial, byte serialSz)
+{
+    word32 h = 2166136261U ^ issuer;
+    byte   i;
+
+    for (i = 0; i < serialSz; i++) {
+        h ^= serial[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/* Dispose of an index. */
+static void CrlIndex_Free(CrlIndex* idx)
+{
+    if (idx != NULL) {
+        free(idx->table);
+        free(idx->entries);
+        free(idx->issuers);
+        free(idx);
+    }
+}
+
+/* Parse all CRL files in parallel and build a new index.
+ *
+ * returns new index or NULL on failure.
+ */
+static CrlIndex* CrlIndex_Build(void)
+{
+    CrlParse  parse[MAX_CRLS];
+    CrlIndex* idx;
+    word32    total = 0;
+    word32    sz;
+    word32    i;
+    int       f;
+    int       ret = 0;
+
+    XMEMSET(parse, 0, sizeof(parse));
+    for (f = 0; f < gNumCrlFiles; f++) {
+        parse[f].file = gCrlFiles[f];
+        parse[f].caFile = gCaFile;
+        if (pthread_create(&parse[f].tid, NULL, CrlParse_Thread,
+                &parse[f]) != 0) {
+            parse[f].ret = -1;
+            parse[f].tid = 0;
+        }
+    }
+    for (f = 0; f < gNumCrlFiles; f++) {
+        if (parse[f].tid != 0)
+            pthread_join(parse[f].tid, NULL);
+        if (parse[f].ret != 0)
+            ret = -1;
+        total += parse[f].numEntries;
+    }
+
+    idx = (CrlIndex*)calloc(1, sizeof(CrlIndex));
+    if (ret == 0 && idx != NULL) {
+        /* Table at most half full. */
+        for (sz = 16; sz < total * 2; sz <<= 1)
+            ;
+        idx->mask = sz - 1;
+        idx->table = (word32*)calloc(sz, sizeof(word32));
+        idx->entries = (CrlEntry*)malloc((total + 1) * sizeof(CrlEntry));
+        idx->issuers = (byte(*)[KEYID_SIZE])malloc(
+            gNumCrlFiles * KEYID_SIZE);
+        if (idx->table == NULL || idx->entries == NULL ||
+                idx->issuers == NULL)
+            ret = -1;
+    }
+    else {
+        ret = -1;
+    }
+
+    for (f = 0; ret == 0 && f < gNumCrlFiles; f++) {
+        word16 issuer = (word16)idx->numIssuers++;
+
+        XMEMCPY(idx->issuers[issuer], parse[f].issuer, KEYID_SIZE);
+        for (i = 0; i < parse[f].numEntries; i++) {
+            CrlEntry* e = &idx->entries[idx->numEntries];
+            word32    h;
+
+            *e = parse[f].entries[i];
+            e->issuer = issuer;
+            h = CrlIndex_Hash(issuer, e->serial, e->serialSz) & idx->mask;
+            while (idx->table[h] != 0)
+                h = (h + 1) & idx->mask;
+            idx->table[h] = ++idx->numEntries;
+        }
+    }
+
+    for (f = 0; f < gNumCrlFiles; f++)
+        free(parse[f].entries);
+    if (ret != 0) {
+        CrlIndex_Free(idx);
+        idx = NULL;
+    }
+    return idx;
+}
+
+/* Look up a certificate in an index.
+ *
+ * idx         Index to search.
+ * issuerHash  Hash of the certificate's issuer name.
+ * serial      Serial number of the certificate.
+ * serialSz    Length of serial number.
+ * returns 1 when revoked, 0 when not in index.
+ */
+static int CrlIndex_IsRevoked(const CrlIndex* idx, const byte* issuerHash,
+    const byte* serial, int serialSz)
+{
+    int    issuer;
+    word32 h;
+    word32 e;
+
+    if (serialSz > 1 && serial[0] == 0) {
+        serial++;
+        serialSz--;
+    }
+    if (serialSz <= 0 || serialSz > MAX_SERIAL_SZ)
+        return 0;
+
+    for (issuer = 0; issuer < idx->numIssuers; issuer++) {
+        if (XMEMCMP(idx->issuers[issuer], issuerHash, KEYID_SIZE) == 0)
+            break;
+    }
+    if (issuer == idx->numIssuers)
+        return 0;
+
+    h = CrlIndex_Hash((word16)issuer, serial, (byte)serialSz) & idx->mask;
+    while ((e = idx->table[h]) != 0) {
+        const CrlEntry* entry = &idx->entries[e - 1];
+
+        if (entry->issuer == issuer && entry->serialSz == serialSz &&
+                XMEMCMP(entry->serial, serial, serialSz) == 0)
+            return 1;
+        h = (h + 1) & idx->mask;
+    }
+    return 0;
+}
+
+
+/* Check a certificate against the current index - lock-free.
+ *
+ * reader  Data of the calling thread.
+ * returns 1 when revoked, 0 when not.
+ */
+static int CrlCheck(CrlReader* reader, const byte* issuerHash,
+    const byte* serial, int serialSz)
+{
+    int       revoked;
+    CrlIndex* idx;
+
+    /* Announce the epoch before taking the pointer so that the loader waits
+     * for this reader if it might have the old index. */
+    atomic_store(&reader->epoch, atomic_load(&gEpoch));
+    idx = atomic_load(&gIndex);
+    revoked = CrlIndex_IsRevoked(idx, issuerHash, serial, serialSz);
+    atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+
+    return revoked;
+}
+
+/* Publish a new index and free the old one when no reader can hold it.
+ *
+ * idx  New index.
+ */
+static void CrlIndex_Publish(CrlIndex* idx)
+{
+    CrlIndex*     old;
+    unsigned long epoch;
+    unsigned long e;
+    int           i;
+
+    old = atomic_exchange(&gIndex, idx);
+    epoch = atomic_fetch_add(&gEpoch, 1) + 1;
+
+    /* Grace period: wait for readers that started before the swap. */
+    for (i = 0; i < gNumReaders; i++) {
+        while ((e = atomic_load(&gReaders[i].epoch)) != 0 && e < epoch)
+            sched_yield();
+    }
+
+    CrlIndex_Free(old);
+}
+
+
+/* Thread that reloads the CRLs in the background. */
+static void* LoaderThread(void* args)
+{
+    long      reloadMs = *(long*)args;
+    long      swaps = 0;
+    CrlIndex* idx;
+
+    while (atomic_load(&gRunning)) {
+        usleep(reloadMs * 1000);
+        idx = CrlIndex_Build();
+        if (idx == NULL) {
+            fprintf(stderr, "Reload failed - keeping current index\n");
+            continue;
+        }
+        CrlIndex_Publish(idx);
+        swaps++;
+    }
+
+    return (void*)swaps;
+}
+
+/* Thread that performs lookups until stopped. */
+static void* ReaderThread(void* args)
+{
+    CrlReader* reader = (CrlReader*)args;
+    int        i = (int)(reader - gReaders);
+
+    while (atomic_load_explicit(&gRunning, memory_order_relaxed)) {
+        i = (i + 1) % gNumProbes;
+        reader->revoked += CrlCheck(reader, gProbeIssuer[i], gProbeSerial[i],
+            gProbeSerialSz[i]);
+        reader->lookups++;
+    }
+
+    return NULL;
+}
+
+
+/* Set up probes from the revoked entries: the serial as is and altered. */
+static void SetupProbes(const CrlIndex* idx)
+{
+    word32 i;
+
+    for (i = 0; i < idx->numEntries && gNumProbes < NUM_PROBES - 1; i++) {
+        const CrlEntry* e = &idx->entries[i];
+
+        XMEMCPY(gProbeIssuer[gNumProbes], idx->issuers[e->issuer],
+            KEYID_SIZE);
+        XMEMCPY(gProbeSerial[gNumProbes], e->serial, e->serialSz);
+        gProbeSerialSz[gNumProbes++] = e->serialSz;
+
+        XMEMCPY(gProbeIssuer[gNumProbes], idx->issuers[e->issuer],
+            KEYID_SIZE);
+        XMEMCPY(gProbeSerial[gNumProbes], e->serial, e->serialSz);
+        gProbeSerial[gNumProbes][e->serialSz - 1] ^= 0x5a;
+        gProbeSerialSz[gNumProbes++] = e->serialSz;
+    }
+}
+
+/* Check a certificate file against the current index and report. */
+static int CheckCertFile(const char* certFile)
+{
+    int         ret;
+    byte*       pem;
+    long        pemSz;
+    byte*       der;
+    int         derSz;
+    DecodedCert cert;
+
+    if (LoadFile(certFile, &pem, &pemSz) != 0)
+        return -1;
+    der = (byte*)malloc(pemSz);
+    if (der == NULL) {
+        free(pem);
+        return -1;
+    }
+    derSz = wc_CertPemToDer(pem, (int)pemSz, der, (int)pemSz, CERT_TYPE);
+    ret = (derSz > 0) ? 0 : -1;
+    if (ret == 0) {
+        wc_InitDecodedCert(&cert, der, derSz, NULL);
+        ret = wc_ParseCert(&cert, CERT_TYPE, NO_VERIFY, NULL);
+        if (ret == 0) {
+            printf("%s: %s\n", certFile,
+                CrlCheck(&gReaders[0], cert.issuerHash, cert.serial,
+                    cert.serialSz) ? "REVOKED" : "not revoked");
+        }
+        wc_FreeDecodedCert(&cert);
+    }
+
+    free(der);
+    free(pem);
+    return ret;
+}
+
+/* Time loading the CRLs into a CertManager the usual way. */
+static double TimeCertManagerLoad(void)
+{
+    double start;
+    int    f;
+    WOLFSSL_CERT_MANAGER* cm;
+
+    cm = wolfSSL_CertManagerNew();
+    if (cm == NULL)
+        return 0;
+    start = current_time(1);
+    if (wolfSSL_CertManagerLoadCA(cm, gCaFile, NULL) == WOLFSSL_SUCCESS &&
+            wolfSSL_CertManagerEnableCRL(cm, 0) == WOLFSSL_SUCCESS) {
+        for (f = 0; f < gNumCrlFiles; f++) {
+            byte* buf;
+            long  bufSz;
+
+            if (LoadFile(gCrlFiles[f], &buf, &bufSz) != 0)
+                break;
+            wolfSSL_CertManagerLoadCRLBuffer(cm, buf, bufSz,
+                buf[0] == TAG_SEQUENCE ? WOLFSSL_FILETYPE_ASN1 :
+                                         WOLFSSL_FILETYPE_PEM);
+            free(buf);
+        }
+    }
+    start = current_time(0) - start;
+    wolfSSL_CertManagerFree(cm);
+
+    return start;
+}
+
+
+/* Display the usage of the program. */
+static void Usage(void)
+{
+    printf("crl-index " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("Usage: crl-index [options] [crl-file ...]\n");
+    printf("-?          Help, print this usage\n");
+    printf("-a <file>   CA that signed the CRLs, default %s\n", CRL_CA);
+    printf("-c <file>   Certificate to check, default %s and %s\n",
+        CHECK_CERT, REVOKED_CERT);
+    printf("-t <num>    Number of lookup threads, default %d\n", NUM_READERS);
+    printf("-s <num>    Seconds to perform lookups for, default %d\n",
+        RUN_SECONDS);
+    printf("-r <num>    Milliseconds between reloads, default %d\n",
+        RELOAD_MS);
+    printf("CRL files are PEM or DER, default %s\n", CRL_FILE);
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret = 0;
+    int         ch;
+    int         i;
+    const char* certFile = NULL;
+    int         seconds = RUN_SECONDS;
+    long        reloadMs = RELOAD_MS;
+    pthread_t   loader;
+    void*       swaps = NULL;
+    CrlIndex*   idx;
+    double      start;
+    double      cmTime;
+    double      idxTime;
+    unsigned long lookups = 0;
+    unsigned long revoked = 0;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'a':
+                gCaFile = myoptarg;
+                break;
+            case 'c':
+                certFile = myoptarg;
+                break;
+            case 't':
+                gNumReaders = atoi(myoptarg);
+                if (gNumReaders < 1 || gNumReaders > MAX_READERS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 's':
+                seconds = atoi(myoptarg);
+                break;
+            case 'r':
+                reloadMs = atol(myoptarg);
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    for (i = myoptind; i < argc && gNumCrlFiles < MAX_CRLS; i++)
+        gCrlFiles[gNumCrlFiles++] = argv[i];
+    if (gNumCrlFiles == 0)
+        gCrlFiles[gNumCrlFiles++] = CRL_FILE;
+
+    wolfSSL_Init();
+#ifdef DEBUG_WOLFSSL
+    wolfSSL_Debugging_ON();
+#endif
+
+    cmTime = TimeCertManagerLoad();
+
+    start = current_time(1);
+    idx = CrlIndex_Build();
+    idxTime = current_time(0) - start;
+    if (idx == NULL) {
+        printf("Failed to build CRL index\n");
+        ret = -1; goto exit;
+    }
+    printf("Indexed %u revoked certificates from %d CRLs\n",
+        idx->numEntries, gNumCrlFiles);
+    printf("CertManager CRL load : %8.3f ms\n", cmTime * 1000);
+    printf("Parallel index build : %8.3f ms (includes CertManager check)\n",
+        idxTime * 1000);
+
+    SetupProbes(idx);
+    atomic_store(&gIndex, idx);
+
+    if (certFile != NULL) {
+        CheckCertFile(certFile);
+    }
+    else {
+        CheckCertFile(CHECK_CERT);
+        CheckCertFile(REVOKED_CERT);
+    }
+
+    if (gNumProbes == 0) {
+        printf("No revoked certificates to look up\n");
+        goto exit;
+    }
+
+    atomic_store(&gRunning, 1);
+    if (pthread_create(&loader, NULL, LoaderThread, &reloadMs) != 0) {
+        ret = -1; goto exit;
+    }
+    for (i = 0; i < gNumReaders; i++) {
+        if (pthread_create(&gReaders[i].tid, NULL, ReaderThread,
+                &gReaders[i]) != 0) {
+            gNumReaders = i;
+            break;
+        }
+    }
+
+    start = current_time(1);
+    sleep(seconds);
+    atomic_store(&gRunning, 0);
+    for (i = 0; i < gNumReaders; i++) {
+        pthread_join(gReaders[i].tid, NULL);
+        lookups += gReaders[i].lookups;
+        revoked += gReaders[i].revoked;
+    }
+    start = current_time(0) - start;
+    pthread_join(loader, &swaps);
+
+    printf("Lookups              : %lu in %.3f s with %d threads\n",
+        lookups, start, gNumReaders);
+    printf("Lookups/s            : %.0f (%lu revoked)\n", lookups / start,
+        revoked);
+    printf("Index swaps          : %ld\n", (long)swaps);
+
+exit:
+    CrlIndex_Free(atomic_load(&gIndex));
+    wolfSSL_Cleanup();
+
+    return ret;
+}
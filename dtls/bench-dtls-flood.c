@@ -0,0 +1,446 @@
+/*
+ * bench-dtls-flood.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ *=============================================================================
+ *
+ * Measures how many legitimate DTLS handshakes a server completes while it is
+ * flooded with ClientHellos. Client threads do full handshakes back to back,
+ * each from the next address in 127.1.0.0/16. After a phase without a flood,
+ * a thread sends a real ClientHello, with a new random each time, from
+ * addresses in 127.2.0.0/16 at a fixed rate. Addresses in 127.0.0.0/8 can be
+ * used on the Linux loopback interface without any set up.
+ *
+ * Run it against server-dtls-demux with and without its pre-filter:
+ *
+ *   ./server-dtls-demux > /dev/null &      (or ./server-dtls-demux -n)
+ *   ./bench-dtls-flood -r 50000 127.0.0.1
+ */
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "dtls-common.h"
+
+#define DEF_PHASE_SEC    5
+#define DEF_FLOOD_RATE   20000 /* ClientHellos per second */
+#define DEF_SOURCES      1024  /* addresses the flood comes from */
+#define DEF_CLIENTS      4     /* threads doing real handshakes */
+#define MAX_CLIENTS      64
+#define FLOOD_BATCH      64    /* ClientHellos sent between clock checks */
+#define HS_TIMEOUT_MAX   4     /* seconds: give up on a handshake sooner */
+#define RANDOM_OFFSET    (13 + 12 + 2) /* record, handshake headers, version */
+
+enum {
+    PHASE_BASELINE,
+    PHASE_FLOOD,
+    PHASE_COUNT
+};
+
+struct PhaseStats {
+    unsigned long handshakes;
+    unsigned long failed;
+    double*       lat;
+    size_t        nLat;
+    size_t        capLat;
+    double        start;
+    double        end;
+    unsigned long flooded;
+};
+
+struct Bench {
+    WOLFSSL_CTX*       ctx;
+    struct sockaddr_in servAddr;
+    int                numClients;
+    int                numSources;
+    double             floodRate;
+    byte               ch[MAXLINE];  /* ClientHello sent by the flood */
+    int                chSz;
+    volatile int       phase;
+    volatile int       stop;
+    unsigned int       nextAddr;     /* next client source address */
+    pthread_mutex_t    lock;
+    struct PhaseStats  stats[PHASE_COUNT];
+};
+
+static const char* phaseNames[PHASE_COUNT] = { "baseline", "flood" };
+
+static double currentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* A UDP socket bound to 127.<net>.<hi>.<lo> with lo and hi from idx. */
+static int newSourceSocket(int net, unsigned int idx)
+{
+    int                fd;
+    struct sockaddr_in addr;
+
+    if ((fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0)
+        return INVALID_SOCKET;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl((127u << 24) | ((unsigned int)net << 16) |
+        ((idx / 254) % 256) << 8 | (idx % 254 + 1));
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return INVALID_SOCKET;
+    }
+    return fd;
+}
+
+/* Keep the first datagram wolfSSL sends: the ClientHello. */
+static int captureSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    struct Bench* b = (struct Bench*)ctx;
+
+    (void)ssl;
+    if (b->chSz == 0 && sz <= (int)sizeof(b->ch)) {
+        memcpy(b->ch, buf, sz);
+        b->chSz = sz;
+    }
+    return sz;
+}
+
+static int captureRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    (void)ssl;
+    (void)buf;
+    (void)sz;
+    (void)ctx;
+    return WOLFSSL_CBIO_ERR_WANT_READ;
+}
+
+/* Have wolfSSL make the ClientHello for the flood, so it is one the server
+ * can't tell from a real one without doing the cookie exchange. */
+static int captureClientHello(struct Bench* b)
+{
+    WOLFSSL* ssl = wolfSSL_new(b->ctx);
+
+    if (ssl == NULL)
+        return -1;
+    wolfSSL_SSLSetIOSend(ssl, captureSend);
+    wolfSSL_SSLSetIORecv(ssl, captureRecv);
+    wolfSSL_SetIOWriteCtx(ssl, b);
+    wolfSSL_SetIOReadCtx(ssl, b);
+    (void)wolfSSL_connect(ssl);
+    wolfSSL_free(ssl);
+
+    return b->chSz > RANDOM_OFFSET + 32 ? 0 : -1;
+}
+
+static void addLatency(struct PhaseStats* st, double secs)
+{
+    double* p;
+    size_t  cap;
+
+    if (st->nLat == st->capLat) {
+        cap = st->capLat ? st->capLat * 2 : 1024;
+        p = (double*)realloc(st->lat, cap * sizeof(double));
+        if (p == NULL)
+            return;
+        st->lat = p;
+        st->capLat = cap;
+    }
+    st->lat[st->nLat++] = secs;
+}
+
+/* One full handshake from the next client address. Returns 0 on success. */
+static int handshake(struct Bench* b)
+{
+    WOLFSSL*     ssl;
+    int          fd;
+    int          ret = -1;
+    unsigned int idx;
+
+    pthread_mutex_lock(&b->lock);
+    idx = b->nextAddr++;
+    pthread_mutex_unlock(&b->lock);
+
+    if ((fd = newSourceSocket(1, idx % (254 * 256))) == INVALID_SOCKET)
+        return -1;
+    if ((ssl = wolfSSL_new(b->ctx)) != NULL &&
+            wolfSSL_dtls_set_peer(ssl, &b->servAddr, sizeof(b->servAddr))
+                == WOLFSSL_SUCCESS &&
+            wolfSSL_set_fd(ssl, fd) == WOLFSSL_SUCCESS &&
+            wolfSSL_dtls_set_timeout_max(ssl, HS_TIMEOUT_MAX)
+                == WOLFSSL_SUCCESS &&
+            wolfSSL_connect(ssl) == WOLFSSL_SUCCESS) {
+        /* Let the server free the connection now. */
+        (void)wolfSSL_shutdown(ssl);
+        ret = 0;
+    }
+    wolfSSL_free(ssl);
+    close(fd);
+    return ret;
+}
+
+static void* clientThread(void* arg)
+{
+    struct Bench*      b = (struct Bench*)arg;
+    struct PhaseStats* st;
+    double             start;
+    int                phase;
+    int                ret;
+
+    while (!b->stop) {
+        phase = b->phase;
+        start = currentTime();
+        ret = handshake(b);
+
+        pthread_mutex_lock(&b->lock);
+        st = &b->stats[phase];
+        if (ret == 0) {
+            st->handshakes++;
+            addLatency(st, currentTime() - start);
+        }
+        else {
+            st->failed++;
+        }
+        pthread_mutex_unlock(&b->lock);
+    }
+    return NULL;
+}
+
+static void* floodThread(void* arg)
+{
+    struct Bench*   b = (struct Bench*)arg;
+    int*            fds;
+    int             i;
+    unsigned int    n = 0;
+    byte            ch[MAXLINE];
+    struct timespec next;
+    double          gap = FLOOD_BATCH / b->floodRate;
+
+    fds = (int*)malloc(sizeof(int) * b->numSources);
+    if (fds == NULL)
+        return NULL;
+    for (i = 0; i < b->numSources; i++) {
+        fds[i] = newSourceSocket(2, i);
+        if (fds[i] == INVALID_SOCKET) {
+            fprintf(stderr, "cannot bind flood source %d: %s\n", i,
+                strerror(errno));
+            b->numSources = i;
+            break;
+        }
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL, 0) | O_NONBLOCK);
+    }
+    memcpy(ch, b->ch, b->chSz);
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!b->stop && b->numSources > 0) {
+        for (i = 0; i < FLOOD_BATCH; i++, n++) {
+            /* A new random each time, so each one looks like a new client. */
+            memcpy(ch + RANDOM_OFFSET, &n, sizeof(n));
+            if (sendto(fds[n % b->numSources], ch, b->chSz, 0,
+                    (struct sockaddr*)&b->servAddr, sizeof(b->servAddr))
+                    == b->chSz) {
+                b->stats[PHASE_FLOOD].flooded++;
+            }
+        }
+        next.tv_nsec += (long)(gap * 1000000000);
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    for (i = 0; i < b->numSources; i++)
+        close(fds[i]);
+    free(fds);
+    return NULL;
+}
+
+static int compareDouble(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return (da > db) - (da < db);
+}
+
+static void printPhase(struct Bench* b, int phase)
+{
+    struct PhaseStats* st = &b->stats[phase];
+    double             secs = st->end - st->start;
+    size_t             n = st->nLat;
+
+    printf("%-9s %10.0f %10lu %8.1f %7lu", phaseNames[phase],
+        st->flooded / secs, st->handshakes, st->handshakes / secs,
+        st->failed);
+    if (n > 0) {
+        qsort(st->lat, n, sizeof(double), compareDouble);
+        printf(" %8.2f %8.2f %8.2f\n", st->lat[n / 2] * 1000,
+            st->lat[(n * 99) / 100] * 1000, st->lat[n - 1] * 1000);
+    }
+    else {
+        printf(" %8s %8s %8s\n", "-", "-", "-");
+    }
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s [options] [server IP, default 127.0.0.1]\n",
+        prog);
+    fprintf(stderr, "  -t <sec>  length of each phase, default %d\n",
+        DEF_PHASE_SEC);
+    fprintf(stderr, "  -r <num>  flood ClientHellos per second, default %d\n",
+        DEF_FLOOD_RATE);
+    fprintf(stderr, "  -s <num>  flood source addresses, default %d\n",
+        DEF_SOURCES);
+    fprintf(stderr, "  -c <num>  client threads, default %d\n", DEF_CLIENTS);
+}
+
+int main(int argc, char** argv)
+{
+    int           exitVal = 1;
+    int           opt;
+    int           i;
+    int           phaseSec = DEF_PHASE_SEC;
+    int           started = 0;
+    const char*   servIp = "127.0.0.1";
+    pthread_t     clients[MAX_CLIENTS];
+    pthread_t     flood;
+    struct rlimit rl;
+    struct Bench  b;
+
+    memset(&b, 0, sizeof(b));
+    b.numClients = DEF_CLIENTS;
+    b.numSources = DEF_SOURCES;
+    b.floodRate = DEF_FLOOD_RATE;
+
+    while ((opt = getopt(argc, argv, "t:r:s:c:h")) != -1) {
+        switch (opt) {
+            case 't': phaseSec = atoi(optarg); break;
+            case 'r': b.floodRate = atof(optarg); break;
+            case 's': b.numSources = atoi(optarg); break;
+            case 'c': b.numClients = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return exitVal;
+        }
+    }
+    if (optind < argc)
+        servIp = argv[optind];
+    if (phaseSec < 1 || b.floodRate <= 0 || b.numSources < 1 ||
+            b.numSources > 254 * 256 || b.numClients < 1 ||
+            b.numClients > MAX_CLIENTS) {
+        usage(argv[0]);
+        return exitVal;
+    }
+
+    memset(&b.servAddr, 0, sizeof(b.servAddr));
+    b.servAddr.sin_family = AF_INET;
+    b.servAddr.sin_port = htons(SERV_PORT);
+    if (inet_pton(AF_INET, servIp, &b.servAddr.sin_addr) != 1) {
+        fprintf(stderr, "invalid server address %s\n", servIp);
+        return exitVal;
+    }
+
+    /* A socket per flood source, and one per client thread. */
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = rl.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    if (wolfSSL_Init() != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "wolfSSL_Init error.\n");
+        return exitVal;
+    }
+    pthread_mutex_init(&b.lock, NULL);
+
+    if ((b.ctx = wolfSSL_CTX_new(
+#ifdef WOLFSSL_DTLS13
+            wolfDTLSv1_3_client_method()
+#else
+            wolfDTLSv1_2_client_method()
+#endif
+            )) == NULL) {
+        fprintf(stderr, "wolfSSL_CTX_new error.\n");
+        goto cleanup;
+    }
+    if (wolfSSL_CTX_load_verify_locations(b.ctx, caCertLoc, NULL)
+            != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "Error loading %s, please check the file.\n",
+            caCertLoc);
+        goto cleanup;
+    }
+    if (captureClientHello(&b) != 0) {
+        fprintf(stderr, "could not make a ClientHello to flood with\n");
+        goto cleanup;
+    }
+
+    b.phase = PHASE_BASELINE;
+    b.stats[PHASE_BASELINE].start = currentTime();
+    for (started = 0; started < b.numClients; started++) {
+        if (pthread_create(&clients[started], NULL, clientThread, &b) != 0)
+            break;
+    }
+    sleep(phaseSec);
+
+    /* Start the flood and count handshakes begun from now in its phase. */
+    b.stats[PHASE_BASELINE].end = currentTime();
+    b.stats[PHASE_FLOOD].start = b.stats[PHASE_BASELINE].end;
+    b.phase = PHASE_FLOOD;
+    if (pthread_create(&flood, NULL, floodThread, &b) != 0) {
+        b.stop = 1;
+    }
+    else {
+        sleep(phaseSec);
+        b.stop = 1;
+        pthread_join(flood, NULL);
+    }
+    b.stats[PHASE_FLOOD].end = currentTime();
+    for (i = 0; i < started; i++)
+        pthread_join(clients[i], NULL);
+
+    printf("ClientHello of %d bytes from %d sources\n", b.chSz, b.numSources);
+    printf("%-9s %10s %10s %8s %7s %8s %8s %8s\n", "phase", "flood/s",
+        "handshakes", "hs/s", "failed", "p50 ms", "p99 ms", "max ms");
+    printPhase(&b, PHASE_BASELINE);
+    printPhase(&b, PHASE_FLOOD);
+    exitVal = 0;
+
+cleanup:
+    for (i = 0; i < PHASE_COUNT; i++)
+        free(b.stats[i].lat);
+    wolfSSL_CTX_free(b.ctx);
+    pthread_mutex_destroy(&b.lock);
+    wolfSSL_Cleanup();
+    return exitVal;
+}
@@ -0,0 +1,709 @@
+/*
+ * client-dtls13-cid-migrate.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ *=============================================================================
+ *
+ * Load harness for Connection ID migration. Opens many DTLS 1.3 sessions that
+ * use a CID against an echo server (such as server-dtls-demux), each from its
+ * own UDP socket, and sends a probe on every session at a fixed interval.
+ * Then runs two phases of equal length: a steady one, and one in which
+ * sessions are moved to a new socket (a new local port, and a new local
+ * address when several are given), the way a NAT rebinding looks to the
+ * server.
+ *
+ * For each phase it reports probes sent, echoed and lost. For the migrating
+ * phase it reports the re-association latency: the time from the first
+ * record sent from the new address until the first echo arrives there. Given
+ * the server's pid, it reports the server's CPU time in each phase and the
+ * extra CPU time per migration.
+ */
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "dtls-common.h"
+
+#if defined(WOLFSSL_DTLS13) && defined(WOLFSSL_DTLS_CID)
+
+#define DEF_SESSIONS     1000
+#define DEF_CONCURRENT   32    /* handshakes in flight at once */
+#define DEF_INTERVAL_MS  1000  /* time between probes on a session */
+#define DEF_PHASE_SEC    10
+#define DEF_MIG_RATE     100   /* migrations per second */
+#define DEF_DRAIN_MS     1000  /* wait for echoes after the last phase */
+#define SETUP_LIMIT_SEC  120   /* give up on handshakes after this */
+#define MAX_LOCAL_ADDRS  16
+
+enum {
+    PHASE_SETUP,
+    PHASE_STEADY,
+    PHASE_MIGRATE,
+    PHASE_DRAIN,
+    PHASE_COUNT
+};
+
+enum {
+    SESS_IDLE,
+    SESS_HANDSHAKE,
+    SESS_ESTABLISHED,
+    SESS_FAILED
+};
+
+/* Sent on a session and echoed back by the server. */
+struct Probe {
+    unsigned int session;
+    unsigned int seq;
+    unsigned int phase;
+    unsigned int pad;
+    double       sentAt;
+};
+
+struct Session {
+    WOLFSSL*     ssl;
+    int          fd;
+    int          state;
+    double       timeoutAt;  /* handshake retransmission */
+    double       nextProbe;
+    unsigned int seq;
+    double       migratedAt; /* 0 when not waiting to re-associate */
+    unsigned int migSeq;     /* first probe sent from the new address */
+};
+
+struct PhaseStats {
+    unsigned long probes;
+    unsigned long echoed;
+    unsigned long migrations;
+    double        rttSum;
+    double*       reassoc;   /* re-association latencies in seconds */
+    size_t        nReassoc;
+    size_t        capReassoc;
+    double        srvCpu;
+    double        cliCpu;
+};
+
+struct Harness {
+    WOLFSSL_CTX*       ctx;
+    struct Session*    sess;
+    int                numSess;
+    int                concurrent;
+    double             interval;
+    double             migRate;
+    struct sockaddr_in servAddr;
+    struct in_addr     local[MAX_LOCAL_ADDRS];
+    int                numLocal;
+    int                nextLocal;
+    int                serverPid;
+    /* progress of the setup phase */
+    int                started;
+    int                inFlight;
+    int                established;
+    int                failed;
+    int                withCid;
+    struct PhaseStats  stats[PHASE_COUNT];
+};
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "setup", "steady", "migrating", "drain"
+};
+
+static volatile int intCalled = 0;
+
+static void teardown(int signum)
+{
+    (void)signum;
+    intCalled = 1;
+}
+
+static double currentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* CPU time of this process in seconds. */
+static double clientCpu(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1000000 +
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1000000;
+}
+
+/* CPU time of another process in seconds, from /proc, or -1. */
+static double serverCpu(int pid)
+{
+    char          path[64];
+    char          line[1024];
+    char*         p;
+    unsigned long utime;
+    unsigned long stime;
+    FILE*         f;
+
+    if (pid <= 0)
+        return -1;
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    if ((f = fopen(path, "r")) == NULL)
+        return -1;
+    p = fgets(line, sizeof(line), f);
+    fclose(f);
+    /* The command name may hold spaces: skip to after its ')'. */
+    if (p == NULL || (p = strrchr(line, ')')) == NULL)
+        return -1;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+            &utime, &stime) != 2)
+        return -1;
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+/* A non-blocking UDP socket, bound to the next local address if any. */
+static int newSocket(struct Harness* h)
+{
+    int                fd;
+    struct sockaddr_in addr;
+
+    if ((fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0)
+        return INVALID_SOCKET;
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+        close(fd);
+        return INVALID_SOCKET;
+    }
+    if (h->numLocal > 0) {
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr = h->local[h->nextLocal];
+        addr.sin_port = 0;
+        h->nextLocal = (h->nextLocal + 1) % h->numLocal;
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return INVALID_SOCKET;
+        }
+    }
+    return fd;
+}
+
+static void addReassoc(struct PhaseStats* st, double secs)
+{
+    double* p;
+    size_t  cap;
+
+    if (st->nReassoc == st->capReassoc) {
+        cap = st->capReassoc ? st->capReassoc * 2 : 1024;
+        p = (double*)realloc(st->reassoc, cap * sizeof(double));
+        if (p == NULL)
+            return;
+        st->reassoc = p;
+        st->capReassoc = cap;
+    }
+    st->reassoc[st->nReassoc++] = secs;
+}
+
+static void failSession(struct Harness* h, struct Session* s)
+{
+    if (s->state == SESS_HANDSHAKE) {
+        h->inFlight--;
+        h->failed++;
+    }
+    s->state = SESS_FAILED;
+    if (s->fd != INVALID_SOCKET) {
+        close(s->fd);
+        s->fd = INVALID_SOCKET;
+    }
+}
+
+static int startSession(struct Harness* h, struct Session* s, double now)
+{
+    if ((s->ssl = wolfSSL_new(h->ctx)) == NULL)
+        return -1;
+    if ((s->fd = newSocket(h)) == INVALID_SOCKET) {
+        fprintf(stderr, "cannot create a socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (wolfSSL_dtls_cid_use(s->ssl) != WOLFSSL_SUCCESS ||
+            wolfSSL_dtls_set_peer(s->ssl, &h->servAddr, sizeof(h->servAddr))
+            != WOLFSSL_SUCCESS ||
+            wolfSSL_set_fd(s->ssl, s->fd) != WOLFSSL_SUCCESS) {
+        return -1;
+    }
+    wolfSSL_dtls_set_using_nonblock(s->ssl, 1);
+    s->state = SESS_HANDSHAKE;
+    s->timeoutAt = now + wolfSSL_dtls_get_current_timeout(s->ssl);
+    return 0;
+}
+
+/* Move on with the handshake. Returns -1 on failure. */
+static int continueHandshake(struct Harness* h, struct Session* s, int idx,
+    double now)
+{
+    int ret = wolfSSL_connect(s->ssl);
+    int err;
+
+    if (ret != WOLFSSL_SUCCESS) {
+        err = wolfSSL_get_error(s->ssl, ret);
+        if (err != WOLFSSL_ERROR_WANT_READ && err != WOLFSSL_ERROR_WANT_WRITE)
+            return -1;
+        s->timeoutAt = now + wolfSSL_dtls_get_current_timeout(s->ssl);
+        return 0;
+    }
+
+    s->state = SESS_ESTABLISHED;
+    h->inFlight--;
+    h->established++;
+    if (wolfSSL_dtls_cid_is_enabled(s->ssl))
+        h->withCid++;
+    /* Spread the probes of all sessions over the interval. */
+    s->nextProbe = now + h->interval * idx / h->numSess;
+    return 0;
+}
+
+static int sendProbe(struct Harness* h, struct Session* s, int idx, int phase,
+    double now)
+{
+    struct Probe probe;
+    int          ret;
+    int          err;
+
+    memset(&probe, 0, sizeof(probe));
+    probe.session = (unsigned int)idx;
+    probe.seq = s->seq++;
+    probe.phase = (unsigned int)phase;
+    probe.sentAt = now;
+    h->stats[phase].probes++;
+    s->nextProbe = now + h->interval;
+
+    ret = wolfSSL_write(s->ssl, &probe, sizeof(probe));
+    if (ret != (int)sizeof(probe)) {
+        err = wolfSSL_get_error(s->ssl, ret);
+        /* A datagram the socket can't take now is a lost record. */
+        if (err != WOLFSSL_ERROR_WANT_WRITE)
+            return -1;
+    }
+    return 0;
+}
+
+static int readEchoes(struct Harness* h, struct Session* s, int idx,
+    double now)
+{
+    struct Probe probe;
+    byte         buf[MAXLINE];
+    int          ret;
+    int          err;
+
+    for (;;) {
+        ret = wolfSSL_read(s->ssl, buf, sizeof(buf));
+        if (ret <= 0) {
+            err = wolfSSL_get_error(s->ssl, ret);
+            return (err == WOLFSSL_ERROR_WANT_READ) ? 0 : -1;
+        }
+        if (ret != (int)sizeof(probe))
+            continue;
+        memcpy(&probe, buf, sizeof(probe));
+        if (probe.session != (unsigned int)idx || probe.phase >= PHASE_COUNT)
+            continue;
+
+        h->stats[probe.phase].echoed++;
+        h->stats[probe.phase].rttSum += now - probe.sentAt;
+        if (s->migratedAt != 0 && probe.seq >= s->migSeq) {
+            addReassoc(&h->stats[PHASE_MIGRATE], now - s->migratedAt);
+            s->migratedAt = 0;
+        }
+    }
+}
+
+/* Rebind a session to a new socket, as a NAT would, and send from it. */
+static int migrate(struct Harness* h, struct Session* s, int idx, int phase,
+    double now)
+{
+    int fd = newSocket(h);
+
+    if (fd == INVALID_SOCKET)
+        return -1;
+    if (wolfSSL_set_fd(s->ssl, fd) != WOLFSSL_SUCCESS) {
+        close(fd);
+        return -1;
+    }
+    close(s->fd);
+    s->fd = fd;
+
+    h->stats[phase].migrations++;
+    /* A session that had not re-associated yet counts from now. */
+    s->migratedAt = now;
+    s->migSeq = s->seq;
+    return sendProbe(h, s, idx, phase, now);
+}
+
+/* Run the event loop until the time given or, in setup, until all sessions
+ * are up. Probes are sent in all phases but drain, and migrations happen in
+ * the migrating phase. */
+static int runPhase(struct Harness* h, int phase, double until)
+{
+    struct pollfd* fds;
+    int*           idx;
+    int            cnt;
+    int            i;
+    int            ret;
+    int            migNext = 0;
+    double         now = currentTime();
+    double         next;
+    double         nextMig = now;
+    double         cpu = clientCpu();
+    double         srv = serverCpu(h->serverPid);
+    struct Session* s;
+
+    fds = (struct pollfd*)malloc(sizeof(struct pollfd) * h->numSess);
+    idx = (int*)malloc(sizeof(int) * h->numSess);
+    if (fds == NULL || idx == NULL) {
+        free(fds);
+        free(idx);
+        return -1;
+    }
+
+    while (!intCalled && now < until) {
+        if (phase == PHASE_SETUP) {
+            while (h->inFlight < h->concurrent && h->started < h->numSess) {
+                s = &h->sess[h->started++];
+                if (startSession(h, s, now) != 0) {
+                    h->failed++;
+                    failSession(h, s);
+                    continue;
+                }
+                h->inFlight++;
+                if (continueHandshake(h, s, h->started - 1, now) != 0)
+                    failSession(h, s);
+            }
+            if (h->established + h->failed == h->numSess)
+                break;
+        }
+
+        /* Find the next thing to do and the sockets to wait on. */
+        next = until;
+        if (phase == PHASE_MIGRATE && nextMig < next)
+            next = nextMig;
+        for (i = 0, cnt = 0; i < h->numSess; i++) {
+            s = &h->sess[i];
+            if (s->state == SESS_HANDSHAKE) {
+                if (s->timeoutAt < next)
+                    next = s->timeoutAt;
+            }
+            else if (s->state == SESS_ESTABLISHED) {
+                if (phase != PHASE_DRAIN && s->nextProbe < next)
+                    next = s->nextProbe;
+            }
+            else {
+                continue;
+            }
+            fds[cnt].fd = s->fd;
+            fds[cnt].events = POLLIN;
+            fds[cnt].revents = 0;
+            idx[cnt++] = i;
+        }
+
+        ret = poll(fds, cnt, next > now ? (int)((next - now) * 1000) + 1 : 0);
+        if (ret < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        now = currentTime();
+
+        for (i = 0; ret > 0 && i < cnt; i++) {
+            if (fds[i].revents == 0)
+                continue;
+            s = &h->sess[idx[i]];
+            if (s->state == SESS_HANDSHAKE)
+                ret = continueHandshake(h, s, idx[i], now);
+            else
+                ret = readEchoes(h, s, idx[i], now);
+            if (ret != 0)
+                failSession(h, s);
+            ret = 1;
+        }
+
+        for (i = 0; i < h->numSess; i++) {
+            s = &h->sess[i];
+            if (s->state == SESS_HANDSHAKE && s->timeoutAt <= now) {
+                if (wolfSSL_dtls_got_timeout(s->ssl) != WOLFSSL_SUCCESS)
+                    failSession(h, s);
+                else
+                    s->timeoutAt = now +
+                        wolfSSL_dtls_get_current_timeout(s->ssl);
+            }
+            else if (s->state == SESS_ESTABLISHED && phase != PHASE_DRAIN &&
+                    s->nextProbe <= now) {
+                if (sendProbe(h, s, i, phase, now) != 0)
+                    failSession(h, s);
+            }
+        }
+
+        /* Rebind sessions in turn at the rate asked for. */
+        for (; phase == PHASE_MIGRATE && nextMig <= now && h->established > 0;
+                nextMig += 1.0 / h->migRate) {
+            for (i = 0; i < h->numSess; i++) {
+                s = &h->sess[migNext];
+                migNext = (migNext + 1) % h->numSess;
+                if (s->state == SESS_ESTABLISHED)
+                    break;
+            }
+            if (s->state == SESS_ESTABLISHED &&
+                    migrate(h, s, (int)(s - h->sess), phase, now) != 0)
+                failSession(h, s);
+        }
+    }
+
+    h->stats[phase].cliCpu = clientCpu() - cpu;
+    if (srv >= 0)
+        h->stats[phase].srvCpu = serverCpu(h->serverPid) - srv;
+    else
+        h->stats[phase].srvCpu = -1;
+
+    free(fds);
+    free(idx);
+    return intCalled ? -1 : 0;
+}
+
+static int compareDouble(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return (da > db) - (da < db);
+}
+
+static void printPhase(struct Harness* h, int phase)
+{
+    struct PhaseStats* st = &h->stats[phase];
+    size_t             n = st->nReassoc;
+
+    printf("%-10s %8lu %8lu %8lu %8.3f %6lu %6lu", phaseNames[phase],
+        st->probes, st->echoed, st->probes - st->echoed,
+        st->echoed ? st->rttSum * 1000 / st->echoed : 0.0,
+        st->migrations, (unsigned long)n);
+    if (n > 0) {
+        qsort(st->reassoc, n, sizeof(double), compareDouble);
+        printf(" %8.3f %8.3f %8.3f", st->reassoc[n / 2] * 1000,
+            st->reassoc[(n * 99) / 100] * 1000, st->reassoc[n - 1] * 1000);
+    }
+    else {
+        printf(" %8s %8s %8s", "-", "-", "-");
+    }
+    if (st->srvCpu >= 0)
+        printf(" %9.1f", st->srvCpu * 1000);
+    else
+        printf(" %9s", "n/a");
+    printf(" %9.1f\n", st->cliCpu * 1000);
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s [options] [server IP, default 127.0.0.1]\n",
+        prog);
+    fprintf(stderr, "  -n <num>   sessions, default %d\n", DEF_SESSIONS);
+    fprintf(stderr, "  -c <num>   handshakes in flight, default %d\n",
+        DEF_CONCURRENT);
+    fprintf(stderr, "  -i <ms>    probe interval per session, default %d\n",
+        DEF_INTERVAL_MS);
+    fprintf(stderr, "  -t <sec>   length of each phase, default %d\n",
+        DEF_PHASE_SEC);
+    fprintf(stderr, "  -m <num>   migrations per second, default %d\n",
+        DEF_MIG_RATE);
+    fprintf(stderr, "  -w <ms>    wait for echoes at the end, default %d\n",
+        DEF_DRAIN_MS);
+    fprintf(stderr, "  -p <pid>   server process to measure CPU time of\n");
+    fprintf(stderr, "  -l <addrs> comma separated local IPv4 addresses to "
+                    "rebind across\n");
+}
+
+int main(int argc, char** argv)
+{
+    int             exitVal = 1;
+    int             opt;
+    int             i;
+    int             phaseSec = DEF_PHASE_SEC;
+    int             drainMs = DEF_DRAIN_MS;
+    char*           tok;
+    const char*     servIp = "127.0.0.1";
+    double          start;
+    double          hsTime;
+    struct rlimit   rl;
+    struct Harness  h;
+    struct PhaseStats* st;
+
+    memset(&h, 0, sizeof(h));
+    h.numSess = DEF_SESSIONS;
+    h.concurrent = DEF_CONCURRENT;
+    h.interval = DEF_INTERVAL_MS / 1000.0;
+    h.migRate = DEF_MIG_RATE;
+
+    while ((opt = getopt(argc, argv, "n:c:i:t:m:w:p:l:h")) != -1) {
+        switch (opt) {
+            case 'n': h.numSess = atoi(optarg); break;
+            case 'c': h.concurrent = atoi(optarg); break;
+            case 'i': h.interval = atoi(optarg) / 1000.0; break;
+            case 't': phaseSec = atoi(optarg); break;
+            case 'm': h.migRate = atof(optarg); break;
+            case 'w': drainMs = atoi(optarg); break;
+            case 'p': h.serverPid = atoi(optarg); break;
+            case 'l':
+                for (tok = strtok(optarg, ","); tok != NULL &&
+                        h.numLocal < MAX_LOCAL_ADDRS; tok = strtok(NULL, ",")) {
+                    if (inet_pton(AF_INET, tok, &h.local[h.numLocal]) != 1) {
+                        fprintf(stderr, "invalid local address %s\n", tok);
+                        return exitVal;
+                    }
+                    h.numLocal++;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return exitVal;
+        }
+    }
+    if (optind < argc)
+        servIp = argv[optind];
+    if (h.numSess < 1 || h.concurrent < 1 || h.interval <= 0 ||
+            phaseSec < 1 || h.migRate <= 0 || drainMs < 0) {
+        usage(argv[0]);
+        return exitVal;
+    }
+
+    memset(&h.servAddr, 0, sizeof(h.servAddr));
+    h.servAddr.sin_family = AF_INET;
+    h.servAddr.sin_port = htons(SERV_PORT);
+    if (inet_pton(AF_INET, servIp, &h.servAddr.sin_addr) != 1) {
+        fprintf(stderr, "invalid server address %s\n", servIp);
+        return exitVal;
+    }
+
+    /* One socket per session, plus one briefly while migrating. */
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = rl.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &rl);
+        if (rl.rlim_cur < (rlim_t)h.numSess + 16) {
+            fprintf(stderr, "open file limit %lu is too low for %d sessions\n",
+                (unsigned long)rl.rlim_cur, h.numSess);
+            return exitVal;
+        }
+    }
+
+    signal(SIGINT, teardown);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (wolfSSL_Init() != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "wolfSSL_Init error.\n");
+        return exitVal;
+    }
+
+    if ((h.ctx = wolfSSL_CTX_new(wolfDTLSv1_3_client_method())) == NULL) {
+        fprintf(stderr, "wolfSSL_CTX_new error.\n");
+        goto cleanup;
+    }
+    if (wolfSSL_CTX_load_verify_locations(h.ctx, caCertLoc, NULL)
+            != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "Error loading %s, please check the file.\n",
+            caCertLoc);
+        goto cleanup;
+    }
+
+    h.sess = (struct Session*)calloc(h.numSess, sizeof(struct Session));
+    if (h.sess == NULL) {
+        fprintf(stderr, "Out of memory!\n");
+        goto cleanup;
+    }
+    for (i = 0; i < h.numSess; i++)
+        h.sess[i].fd = INVALID_SOCKET;
+
+    start = currentTime();
+    if (runPhase(&h, PHASE_SETUP, start + SETUP_LIMIT_SEC) != 0)
+        goto cleanup;
+    hsTime = currentTime() - start;
+    printf("%d sessions up, %d failed, %d with a CID, in %.3f s (%.0f/s)\n",
+        h.established, h.failed, h.withCid, hsTime, h.established / hsTime);
+    if (h.withCid < h.established)
+        printf("Sessions without a CID will not survive migration.\n");
+    if (h.established == 0)
+        goto cleanup;
+
+    if (runPhase(&h, PHASE_STEADY, currentTime() + phaseSec) != 0 ||
+            runPhase(&h, PHASE_MIGRATE, currentTime() + phaseSec) != 0 ||
+            runPhase(&h, PHASE_DRAIN, currentTime() + drainMs / 1000.0) != 0)
+        goto cleanup;
+
+    printf("%-10s %8s %8s %8s %8s %6s %6s %8s %8s %8s %9s %9s\n", "phase",
+        "probes", "echoed", "lost", "rtt ms", "migr", "reasc", "p50 ms",
+        "p99 ms", "max ms", "srv cpu", "cli cpu");
+    printPhase(&h, PHASE_STEADY);
+    printPhase(&h, PHASE_MIGRATE);
+
+    st = &h.stats[PHASE_MIGRATE];
+    if (st->migrations > 0) {
+        printf("%lu of %lu migrations not re-associated\n",
+            st->migrations - (unsigned long)st->nReassoc, st->migrations);
+        if (st->srvCpu >= 0)
+            printf("server CPU per migration: %.1f us\n",
+                (st->srvCpu - h.stats[PHASE_STEADY].srvCpu) * 1000000 /
+                st->migrations);
+        printf("client CPU per migration: %.1f us\n",
+            (st->cliCpu - h.stats[PHASE_STEADY].cliCpu) * 1000000 /
+            st->migrations);
+    }
+    exitVal = 0;
+
+cleanup:
+    for (i = 0; h.sess != NULL && i < h.numSess; i++) {
+        if (h.sess[i].state == SESS_ESTABLISHED)
+            (void)wolfSSL_shutdown(h.sess[i].ssl);
+        wolfSSL_free(h.sess[i].ssl);
+        if (h.sess[i].fd != INVALID_SOCKET)
+            close(h.sess[i].fd);
+    }
+    for (i = 0; i < PHASE_COUNT; i++)
+        free(h.stats[i].reassoc);
+    free(h.sess);
+    wolfSSL_CTX_free(h.ctx);
+    wolfSSL_Cleanup();
+    return exitVal;
+}
+
+#else
+
+int main(void)
+{
+    fprintf(stderr, "wolfSSL must be built with DTLS 1.3 and CID support\n");
+    return 1;
+}
+
+#endif /* WOLFSSL_DTLS13 && WOLFSSL_DTLS_CID */
@@ -0,0 +1,336 @@
+/*
+ * dtls-prefilter.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#include "dtls-prefilter.h"
+
+#define RECORD_HDR_SZ    13 /* type, version, epoch, sequence, length */
+#define HS_HDR_SZ        12 /* type, length, message seq, offset, length */
+#define CONTENT_HANDSHAKE 22
+#define HS_CLIENT_HELLO  1
+#define EXT_COOKIE       44
+#define RANDOM_SZ        32
+#define MAX_SESSION_ID   32
+
+struct FilterBucket {
+    unsigned int key;    /* source address, 0 when unused */
+    float        tokens;
+    double       last;   /* time tokens was last brought up to date */
+};
+
+struct DtlsFilter {
+    WC_RNG*              rng;
+    byte                 secret[FILTER_SECRET_SZ];
+    double               rotatedAt;
+    int                  rotateSec;
+    double               rate;
+    double               burst;
+    double               globalRate;
+    struct FilterBucket  global;
+    struct FilterBucket* table;
+    unsigned int         mask;
+    /* Random so that a flooder can't pick addresses that share a bucket. */
+    unsigned int         hashKey;
+    struct FilterStats   stats;
+};
+
+static double filterTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static unsigned int get16(const byte* p)
+{
+    return ((unsigned int)p[0] << 8) | p[1];
+}
+
+static unsigned int get24(const byte* p)
+{
+    return ((unsigned int)p[0] << 16) | ((unsigned int)p[1] << 8) | p[2];
+}
+
+/* Check the datagram holds a ClientHello that wolfSSL will look at.
+ * Returns 0 when it does and sets hasCookie and isFragment. */
+static int parseClientHello(const byte* msg, size_t sz, int* hasCookie,
+    int* isFragment)
+{
+    const byte*  hs;
+    const byte*  b;
+    unsigned int recLen;
+    unsigned int len;
+    unsigned int i;
+    unsigned int n;
+    unsigned int extEnd;
+    unsigned int fragOff;
+    unsigned int fragLen;
+
+    *hasCookie = 0;
+    *isFragment = 0;
+
+    if (sz < RECORD_HDR_SZ + HS_HDR_SZ)
+        return -1;
+    /* DTLS versions all start with 0xfe. The epoch is 0 before keys. */
+    if (msg[0] != CONTENT_HANDSHAKE || msg[1] != 0xfe || get16(msg + 3) != 0)
+        return -1;
+    recLen = get16(msg + 11);
+    if (RECORD_HDR_SZ + (size_t)recLen > sz || recLen < HS_HDR_SZ)
+        return -1;
+
+    hs = msg + RECORD_HDR_SZ;
+    len = get24(hs + 1);
+    fragOff = get24(hs + 6);
+    fragLen = get24(hs + 9);
+    if (hs[0] != HS_CLIENT_HELLO || fragOff > len || fragLen > len - fragOff ||
+            HS_HDR_SZ + fragLen > recLen)
+        return -1;
+    /* A ClientHello bigger than the MTU, such as one with post-quantum key
+     * shares, comes in fragments. Only the fragment's bounds can be checked
+     * here - wolfSSL reassembles it. */
+    if (fragLen != len) {
+        *isFragment = 1;
+        return 0;
+    }
+
+    b = hs + HS_HDR_SZ;
+    i = 2 + RANDOM_SZ;
+    if (i + 1 > len || b[0] != 0xfe)
+        return -1;
+    n = b[i++];                              /* session id */
+    if (n > MAX_SESSION_ID || i + n + 1 > len)
+        return -1;
+    i += n;
+    n = b[i++];                              /* legacy cookie */
+    if (i + n + 2 > len)
+        return -1;
+    if (n > 0)
+        *hasCookie = 1;
+    i += n;
+    n = get16(b + i);                        /* cipher suites */
+    i += 2;
+    if (n == 0 || (n & 1) != 0 || i + n + 1 > len)
+        return -1;
+    i += n;
+    n = b[i++];                              /* compression methods */
+    if (n == 0 || i + n > len)
+        return -1;
+    i += n;
+    if (i == len)
+        return 0;                            /* no extensions */
+
+    if (i + 2 > len || i + 2 + get16(b + i) != len)
+        return -1;
+    extEnd = len;
+    for (i += 2; i < extEnd; i += 4 + n) {
+        if (i + 4 > extEnd)
+            return -1;
+        n = get16(b + i + 2);
+        if (i + 4 + n > extEnd)
+            return -1;
+        if (get16(b + i) == EXT_COOKIE)
+            *hasCookie = 1;
+    }
+    return 0;
+}
+
+/* Bring the bucket up to date and take a token. Returns 1 if there was one. */
+static int takeToken(struct FilterBucket* b, double rate, double burst,
+    double now)
+{
+    b->tokens += (float)((now - b->last) * rate);
+    if (b->tokens > burst)
+        b->tokens = (float)burst;
+    b->last = now;
+    if (b->tokens < 1)
+        return 0;
+    b->tokens -= 1;
+    return 1;
+}
+
+static unsigned int sourceKey(const struct sockaddr* peer, socklen_t peerSz)
+{
+    unsigned int key = 0;
+
+    if (peer->sa_family == AF_INET && peerSz >= sizeof(struct sockaddr_in)) {
+        key = ((const struct sockaddr_in*)peer)->sin_addr.s_addr;
+    }
+    else if (peer->sa_family == AF_INET6 &&
+            peerSz >= sizeof(struct sockaddr_in6)) {
+        /* A host is given a /64: key on the network part. */
+        const byte* a = ((const struct sockaddr_in6*)peer)->sin6_addr.s6_addr;
+        key = (get16(a) << 16 | get16(a + 2)) ^ (get16(a + 4) << 16 |
+              get16(a + 6));
+    }
+    /* 0 marks an unused bucket. */
+    return key != 0 ? key : 1;
+}
+
+static struct FilterBucket* findBucket(struct DtlsFilter* f, unsigned int key,
+    double now)
+{
+    unsigned int         h = (key ^ f->hashKey) * 2654435761u;
+    struct FilterBucket* b = &f->table[(h ^ (h >> 16)) & f->mask];
+
+    if (b->key == 0) {
+        /* A new source starts full. */
+        b->key = key;
+        b->tokens = (float)f->burst;
+        b->last = now;
+    }
+    else if (b->key != key) {
+        /* Taking over a bucket gives at most one token. Sources that share a
+         * bucket and take turns then share its rate rather than refilling
+         * it for each other. */
+        b->key = key;
+        if (b->tokens + (now - b->last) * f->rate > 1) {
+            b->tokens = 1;
+            b->last = now;
+        }
+    }
+    return b;
+}
+
+static int newSecret(struct DtlsFilter* f)
+{
+    if (wc_RNG_GenerateBlock(f->rng, f->secret, sizeof(f->secret)) != 0)
+        return -1;
+    f->rotatedAt = filterTime();
+    return 0;
+}
+
+struct DtlsFilter* filterNew(WC_RNG* rng, double rate, double burst,
+    double globalRate, unsigned int tableSz, int rotateSec)
+{
+    struct DtlsFilter* f;
+    unsigned int       sz = 1;
+
+    if (rng == NULL || rate <= 0 || burst < 1 ||
+            (globalRate != 0 && globalRate < 1))
+        return NULL;
+    while (sz < tableSz)
+        sz <<= 1;
+
+    f = (struct DtlsFilter*)calloc(1, sizeof(struct DtlsFilter));
+    if (f == NULL)
+        return NULL;
+    f->table = (struct FilterBucket*)calloc(sz, sizeof(struct FilterBucket));
+    if (f->table == NULL) {
+        free(f);
+        return NULL;
+    }
+    f->rng = rng;
+    f->mask = sz - 1;
+    f->rate = rate;
+    f->burst = burst;
+    f->globalRate = globalRate;
+    f->rotateSec = rotateSec;
+    /* Allow a second's worth of ClientHellos at once in total. */
+    f->global.tokens = (float)globalRate;
+    f->global.last = filterTime();
+
+    if (newSecret(f) != 0 || wc_RNG_GenerateBlock(rng, (byte*)&f->hashKey,
+            sizeof(f->hashKey)) != 0) {
+        filterFree(f);
+        return NULL;
+    }
+    return f;
+}
+
+void filterFree(struct DtlsFilter* f)
+{
+    if (f == NULL)
+        return;
+    memset(f->secret, 0, sizeof(f->secret));
+    free(f->table);
+    free(f);
+}
+
+int filterCheck(struct DtlsFilter* f, const byte* msg, size_t sz,
+    const struct sockaddr* peer, socklen_t peerSz)
+{
+    double now;
+    int    hasCookie;
+    int    isFragment;
+
+    if (parseClientHello(msg, sz, &hasCookie, &isFragment) != 0) {
+        f->stats.malformed++;
+        return FILTER_DROP;
+    }
+
+    now = filterTime();
+    if (!takeToken(findBucket(f, sourceKey(peer, peerSz), now), f->rate,
+            f->burst, now)) {
+        f->stats.limited++;
+        return FILTER_DROP;
+    }
+    if (f->globalRate > 0 &&
+            !takeToken(&f->global, f->globalRate, f->globalRate, now)) {
+        f->stats.globalLimited++;
+        return FILTER_DROP;
+    }
+
+    f->stats.passed++;
+    if (hasCookie)
+        f->stats.withCookie++;
+    if (isFragment)
+        f->stats.fragments++;
+    return FILTER_PASS;
+}
+
+int filterRotate(struct DtlsFilter* f)
+{
+    if (f->rotateSec <= 0 || filterTime() - f->rotatedAt < f->rotateSec)
+        return 0;
+    /* Keep the old secret if no new one could be made. */
+    if (newSecret(f) != 0)
+        return 0;
+    f->stats.rotations++;
+    return 1;
+}
+
+int filterSetSecret(struct DtlsFilter* f, WOLFSSL* ssl)
+{
+    int ret;
+
+#if defined(WOLFSSL_SEND_HRR_COOKIE)
+    /* DTLS 1.3 cookies, in the HelloRetryRequest - fails on DTLS 1.2 */
+    if (wolfSSL_version(ssl) == DTLS1_3_VERSION) {
+        ret = wolfSSL_send_hrr_cookie(ssl, f->secret, sizeof(f->secret));
+        if (ret != WOLFSSL_SUCCESS)
+            return ret;
+    }
+#endif
+    /* DTLS 1.2 cookies, in the HelloVerifyRequest */
+    ret = wolfSSL_DTLS_SetCookieSecret(ssl, f->secret, sizeof(f->secret));
+    return ret == 0 ? WOLFSSL_SUCCESS : ret;
+}
+
+const struct FilterStats* filterGetStats(const struct DtlsFilter* f)
+{
+    return &f->stats;
+}
@@ -0,0 +1,146 @@
+/*
+ * dtls-prefilter.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Pre-filter for datagrams from peers that have no connection yet. It runs
+ * before any WOLFSSL object sees the datagram and drops:
+ *  - anything that is not an epoch 0 ClientHello or a fragment of one
+ *  - ClientHellos beyond a per-source token bucket (keyed by IP address, so
+ *    changing the port does not help a flooder). A source that lands in a
+ *    bucket held by another gets at most one token, so colliding sources
+ *    can't refill the bucket for each other.
+ *  - ClientHellos beyond an optional global token bucket
+ *
+ * Each fragment of a ClientHello costs a token. wolfSSL reassembles them.
+ *
+ * The filter also owns the cookie secret. It is random, replaced every few
+ * seconds, and set on the listening WOLFSSL object with filterSetSecret(), so
+ * the cookies wolfSSL issues in its stateless exchange expire. A ClientHello
+ * that returns a cookie issued just before a change fails and gets a new
+ * cookie: one extra round trip.
+ *
+ * Nothing is allocated per datagram: buckets live in a fixed size table.
+ */
+
+#ifndef DTLS_PREFILTER_H_
+#define DTLS_PREFILTER_H_
+
+#include <sys/socket.h>
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/random.h>
+
+#define FILTER_PASS      0 /**< hand the datagram to wolfSSL */
+#define FILTER_DROP      1 /**< drop the datagram */
+
+#define FILTER_RATE      5    /**< default ClientHellos per second per source */
+#define FILTER_BURST     10   /**< default bucket depth per source */
+#define FILTER_GLOBAL_RATE 2000 /**< default ClientHellos per second in total */
+#define FILTER_TABLE_SZ  4096 /**< default number of source buckets */
+#define FILTER_ROTATE    30   /**< default seconds between secret changes */
+#define FILTER_SECRET_SZ 32
+
+/**
+ * \struct FilterStats
+ * \brief Counts of what the filter did with datagrams.
+ */
+struct FilterStats {
+    unsigned long passed;     /**< ClientHellos handed to wolfSSL */
+    unsigned long withCookie; /**< of those, ones that carried a cookie */
+    unsigned long fragments;  /**< of those, fragments of a ClientHello */
+    unsigned long malformed;  /**< not a ClientHello we accept */
+    unsigned long limited;    /**< over the per-source rate */
+    unsigned long globalLimited; /**< over the global rate */
+    unsigned long rotations;  /**< times the secret was changed */
+};
+
+struct DtlsFilter;
+
+/**
+ * \brief Create a filter.
+ *
+ * \param rng Random number generator for the secret and the table hash key.
+ * \param rate ClientHellos per second allowed from one source address.
+ * \param burst Number of ClientHellos one source may send at once.
+ * \param globalRate ClientHellos per second allowed in total, 0 for no limit.
+ * \param tableSz Number of source buckets, rounded up to a power of 2.
+ * \param rotateSec Seconds between secret changes, 0 to never change it.
+ *
+ * \return Pointer to the new filter, or NULL on error.
+ */
+struct DtlsFilter* filterNew(WC_RNG* rng, double rate, double burst,
+    double globalRate, unsigned int tableSz, int rotateSec);
+
+/**
+ * \brief Free a filter.
+ *
+ * \param f Pointer to the filter.
+ */
+void filterFree(struct DtlsFilter* f);
+
+/**
+ * \brief Decide whether a datagram from a peer without a connection may be
+ *        handed to wolfSSL.
+ *
+ * \param f Pointer to the filter.
+ * \param msg Pointer to the datagram.
+ * \param sz Size of the datagram.
+ * \param peer Pointer to the peer address.
+ * \param peerSz Length of the peer address.
+ *
+ * \return FILTER_PASS or FILTER_DROP.
+ */
+int filterCheck(struct DtlsFilter* f, const byte* msg, size_t sz,
+    const struct sockaddr* peer, socklen_t peerSz);
+
+/**
+ * \brief Change the secret if it is due.
+ *
+ * \param f Pointer to the filter.
+ *
+ * \return 1 when the secret changed and must be set again, 0 otherwise.
+ */
+int filterRotate(struct DtlsFilter* f);
+
+/**
+ * \brief Set the current secret as the cookie secret of a WOLFSSL object.
+ *
+ * \param f Pointer to the filter.
+ * \param ssl Pointer to the WOLFSSL object that listens for new peers.
+ *
+ * \return WOLFSSL_SUCCESS on success, an error code otherwise.
+ */
+int filterSetSecret(struct DtlsFilter* f, WOLFSSL* ssl);
+
+/**
+ * \brief Get the counts of what the filter did.
+ *
+ * \param f Pointer to the filter.
+ *
+ * \return Pointer to the counts.
+ */
+const struct FilterStats* filterGetStats(const struct DtlsFilter* f);
+
+#endif /* DTLS_PREFILTER_H_ */
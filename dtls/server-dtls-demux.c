@@ -23,6 +23,11 @@
  * Example of complete DTLS server using a single socket with de-multiplexing,
  * timeout support, and using `poll`. This example his no external dependencies
  * on any event libraries.
+ *
+ * Datagrams from unknown peers go through a pre-filter (dtls-prefilter.c)
+ * that rate limits ClientHellos per source before any WOLFSSL object sees
+ * them, and that changes the cookie secret periodically. Run with -n to hand
+ * every datagram to wolfSSL, for comparison.
  */
 
 #include <wolfssl/options.h>
@@ -41,6 +46,7 @@
 #include <time.h>
 
 #include "dtls-common.h"
+#include "dtls-prefilter.h"
 
 /* We need a constant CID size because the CID field in the record header doesn't have a length field */
 #define CID_SIZE 8
@@ -98,10 +104,12 @@ WOLFSSL_CTX* newCTX(void);
  * \param fd File descriptor for the socket.
  * \param rng Pointer to the random number generator.
  * \param connList Pointer to the list of connections.
+ * \param filter Pointer to the pre-filter that holds the cookie secret.
  *
  * \return Pointer to the new WOLFSSL object, or NULL on error.
  */
-WOLFSSL* newSSL(WOLFSSL_CTX* ctx, int fd, WC_RNG* rng, struct ConnList* connList);
+WOLFSSL* newSSL(WOLFSSL_CTX* ctx, int fd, WC_RNG* rng, struct ConnList* connList,
+                struct DtlsFilter* filter);
 
 /**
  * \brief Create a new socket.
@@ -232,9 +240,12 @@ static int handleApplicationData(WOLFSSL* ssl, byte* appData, int appDataSz, int
 /**
  * \brief Main function for the DTLS server.
  *
+ * \param argc Number of arguments.
+ * \param argv Arguments: -n turns off the pre-filter.
+ *
  * \return 0 on success, non-zero on error.
  */
-int main(void)
+int main(int argc, char** argv)
 {
     int exitVal = 1;
     WOLFSSL_CTX*  ctx = NULL;
@@ -248,6 +259,9 @@ int main(void)
     /* Our one socket that we read from and send to. We do the demultiplexing ourselves. */
     struct pollfd listenfd;
     WC_RNG* rng = NULL;
+    /* Rate limits new peers and holds the cookie secret */
+    struct DtlsFilter* filter = NULL;
+    int useFilter = !(argc > 1 && strcmp(argv[1], "-n") == 0);
 
     signal(SIGINT, teardown);
     memset(&listenfd, 0, sizeof(listenfd));
@@ -278,7 +292,13 @@ int main(void)
         goto cleanup;
     }
 
-    if ((listenSSL = newSSL(ctx, listenfd.fd, rng, connList)) == NULL) {
+    if ((filter = filterNew(rng, FILTER_RATE, FILTER_BURST,
+            FILTER_GLOBAL_RATE, FILTER_TABLE_SZ, FILTER_ROTATE)) == NULL) {
+        fprintf(stderr, "filterNew error.\n");
+        goto cleanup;
+    }
+
+    if ((listenSSL = newSSL(ctx, listenfd.fd, rng, connList, filter)) == NULL) {
         fprintf(stderr, "newSSL error.\n");
         goto cleanup;
     }
@@ -319,6 +339,12 @@ int main(void)
             if (sz <= 0)
                 goto cleanup;
 
+            /* Cookies made with an old secret stop being accepted */
+            if (filterRotate(filter) && filterSetSecret(filter, listenSSL) != WOLFSSL_SUCCESS) {
+                fprintf(stderr, "filterSetSecret error.\n");
+                goto cleanup;
+            }
+
             /* find ssl object */
             conn = findConn(connList, readBuf, sz, &peerAddr, peerAddrLen);
             if (conn != NULL) {
@@ -329,6 +355,10 @@ int main(void)
                     conn = NULL;
                 }
             }
+            else if (useFilter &&
+                    filterCheck(filter, readBuf, sz, &peerAddr, peerAddrLen) != FILTER_PASS) {
+                /* dropped before any WOLFSSL object saw it */
+            }
             else {
                 ret = dispatchNewConnection(listenSSL, readBuf, sz, &peerAddr, peerAddrLen);
                 if (ret == WOLFSSL_SUCCESS) {
@@ -337,7 +367,7 @@ int main(void)
                         fprintf(stderr, "newConn error.\n");
                         goto cleanup;
                     }
-                    if ((listenSSL = newSSL(ctx, listenfd.fd, rng, connList)) == NULL) {
+                    if ((listenSSL = newSSL(ctx, listenfd.fd, rng, connList, filter)) == NULL) {
                         fprintf(stderr, "newSSL error.\n");
                         goto cleanup;
                     }
@@ -345,7 +375,7 @@ int main(void)
                 else if (ret == WOLFSSL_FATAL_ERROR) {
                     /* clean up the connection */
                     wolfSSL_free(listenSSL);
-                    if ((listenSSL = newSSL(ctx, listenfd.fd, rng, connList)) == NULL) {
+                    if ((listenSSL = newSSL(ctx, listenfd.fd, rng, connList, filter)) == NULL) {
                         fprintf(stderr, "newSSL error.\n");
                         goto cleanup;
                     }
@@ -359,6 +389,14 @@ int main(void)
 
     exitVal = 0;
 cleanup:
+    if (filter != NULL && useFilter) {
+        const struct FilterStats* st = filterGetStats(filter);
+        fprintf(stderr, "pre-filter: %lu passed (%lu with a cookie, %lu fragments), "
+                "%lu malformed, %lu over the source rate, %lu over the global rate\n",
+                st->passed, st->withCookie, st->fragments, st->malformed,
+                st->limited, st->globalLimited);
+    }
+    filterFree(filter);
     while (timeouts != NULL) {
         struct DtlsTimeout* t = timeouts;
         timeouts = timeouts->next;
@@ -413,11 +451,10 @@ WOLFSSL_CTX* newCTX(void)
     return ctx;
 }
 
-WOLFSSL* newSSL(WOLFSSL_CTX* ctx, int fd, WC_RNG* rng, struct ConnList* connList)
+WOLFSSL* newSSL(WOLFSSL_CTX* ctx, int fd, WC_RNG* rng, struct ConnList* connList,
+                struct DtlsFilter* filter)
 {
     WOLFSSL* ssl = NULL;
-    /* Applications should update this secret periodically */
-    char *secret = "My secret";
     byte newCid[CID_SIZE];
 
     /* Create the WOLFSSL Object */
@@ -425,16 +462,9 @@ WOLFSSL* newSSL(WOLFSSL_CTX* ctx, int fd, WC_RNG* rng, struct ConnList* connList
         fprintf(stderr, "wolfSSL_new error.\n");
         return NULL;
     }
-    /* Set the secret for cookie creation */
-#if defined(WOLFSSL_SEND_HRR_COOKIE)
-    if (wolfSSL_send_hrr_cookie(ssl, (byte*)secret, strlen(secret)) != WOLFSSL_SUCCESS) {
-        fprintf(stderr, "wolfSSL_send_hrr_cookie error.\n");
-        wolfSSL_free(ssl);
-        return NULL;
-    }
-#endif
-    if (wolfSSL_DTLS_SetCookieSecret(ssl, (byte*)secret, strlen(secret)) != 0) {
-        fprintf(stderr, "wolfSSL_DTLS_SetCookieSecret error.\n");
+    /* Set the secret for cookie creation. The filter changes it periodically. */
+    if (filterSetSecret(filter, ssl) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "filterSetSecret error.\n");
         wolfSSL_free(ssl);
         return NULL;
     }
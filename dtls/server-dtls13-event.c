@@ -32,6 +32,11 @@
  * results in lost packets between when the messages are received and when
  * `connect` is called. We recommend using one socket and de-multiplexing. See
  * the server-dtls-demux.c example for how to do this.
+ *
+ * New connections go through the pre-filter in dtls-prefilter.c: each datagram
+ * on the listening socket is peeked at and dropped unless it is a ClientHello
+ * within the rate allowed for its source, before the pending WOLFSSL object
+ * reads it. The filter also changes the cookie secret periodically.
  */
 
 #include <wolfssl/options.h>
@@ -52,6 +57,7 @@
 #include <event2/event.h>
 
 #include "dtls-common.h"
+#include "dtls-prefilter.h"
 
 #define QUICK_MULT  4               /* Our quick timeout multiplier */
 #define CHGOODCB_E  (-1000)         /* An error outside the range of wolfSSL
@@ -73,6 +79,10 @@ WOLFSSL*      pendingSSL = NULL;
 int           listenfd = INVALID_SOCKET;   /* Initialize our socket */
 conn_ctx* active = NULL;
 struct event* newConnEvent = NULL;
+WC_RNG*       rng = NULL;
+struct DtlsFilter* filter = NULL;
+/* Datagrams from new peers too big to look at - dropped */
+unsigned long oversized = 0;
 
 static void sig_handler(const int sig);
 static void free_resources(void);
@@ -131,6 +141,17 @@ int main(int argc, char** argv)
     if (listenfd == INVALID_SOCKET)
         goto cleanup;
 
+    if ((rng = wc_rng_new(NULL, 0, NULL)) == NULL) {
+        fprintf(stderr, "wc_rng_new error.\n");
+        goto cleanup;
+    }
+    filter = filterNew(rng, FILTER_RATE, FILTER_BURST, FILTER_GLOBAL_RATE,
+            FILTER_TABLE_SZ, FILTER_ROTATE);
+    if (filter == NULL) {
+        fprintf(stderr, "filterNew error.\n");
+        goto cleanup;
+    }
+
     if (!newPendingSSL())
         goto cleanup;
 
@@ -247,18 +268,12 @@ static int newPendingSSL(void)
         return 0;
     }
 
-#if !defined(USE_DTLS12) && defined(WOLFSSL_SEND_HRR_COOKIE)
-    {
-        /* Applications should update this secret periodically */
-        char *secret = "My secret";
-        if (wolfSSL_send_hrr_cookie(ssl, (byte*)secret, strlen(secret))
-                != WOLFSSL_SUCCESS) {
-            fprintf(stderr, "wolfSSL_send_hrr_cookie error.\n");
-            wolfSSL_free(ssl);
-            return 0;
-        }
+    /* The filter changes the cookie secret periodically */
+    if (filterSetSecret(filter, ssl) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "filterSetSecret error.\n");
+        wolfSSL_free(ssl);
+        return 0;
     }
-#endif
 
     pendingSSL = ssl;
 
@@ -271,10 +286,40 @@ static void newConn(evutil_socket_t fd, short events, void* arg)
     int                err;
     /* Store pointer because pendingSSL can be modified in chGoodCb */
     WOLFSSL*           ssl = pendingSSL;
+    byte               msg[MAXLINE];
+    ssize_t            msgSz;
+    struct sockaddr_in peer;
+    socklen_t          peerLen = sizeof(peer);
 
     (void)events;
     (void)arg;
 
+    if (filterRotate(filter) && filterSetSecret(filter, ssl) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "filterSetSecret error.\n");
+        free_resources();
+        wolfSSL_Cleanup();
+        exit(1);
+    }
+
+    /* Look at the datagram before wolfSSL does. Drop it if the filter says so,
+     * otherwise leave it for wolfSSL_accept to read. MSG_TRUNC gives the real
+     * size: a datagram bigger than the buffer is no handshake record wolfSSL
+     * would take, so drop it rather than filter what was cut off. */
+    msgSz = recvfrom(fd, msg, sizeof(msg), MSG_PEEK | MSG_TRUNC,
+            (struct sockaddr*)&peer, &peerLen);
+    if (msgSz < 0)
+        return;
+    if ((size_t)msgSz > sizeof(msg)) {
+        oversized++;
+        (void)recv(fd, msg, sizeof(msg), 0);
+        return;
+    }
+    if (filterCheck(filter, msg, (size_t)msgSz, (struct sockaddr*)&peer,
+            peerLen) != FILTER_PASS) {
+        (void)recv(fd, msg, sizeof(msg), 0);
+        return;
+    }
+
     ret = wolfSSL_accept(ssl);
     if (ret != WOLFSSL_SUCCESS) {
         err = wolfSSL_get_error(ssl, 0);
@@ -521,7 +566,17 @@ static void conn_ctx_free(conn_ctx* connCtx)
 
 static void sig_handler(const int sig)
 {
+    const struct FilterStats* st;
+
     printf("Received signal %d. Cleaning up.\n", sig);
+    if (filter != NULL) {
+        st = filterGetStats(filter);
+        printf("pre-filter: %lu passed (%lu with a cookie, %lu fragments), "
+               "%lu malformed, %lu over the source rate, %lu over the global "
+               "rate, %lu too big\n", st->passed, st->withCookie,
+               st->fragments, st->malformed, st->limited, st->globalLimited,
+               oversized);
+    }
     free_resources();
     wolfSSL_Cleanup();
     exit(0);
@@ -557,4 +612,8 @@ static void free_resources(void)
         event_base_free(base);
         base = NULL;
     }
+    filterFree(filter);
+    filter = NULL;
+    wc_rng_free(rng);
+    rng = NULL;
 }
@@ -0,0 +1,589 @@
+/* ecc-fw-stream.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *=============================================================================
+ *
+ * Streaming firmware signer and verifier.
+ *
+ * ecc-sign.c hashes a static buffer 128 bytes at a time and ecc-verify.c
+ * needs the whole image in memory. This example hashes an image of any size
+ * as it is read from a file, a pipe or stdin:
+ *   - a reader thread fills a ring of page aligned buffers with large reads
+ *     while the main thread hashes the buffer filled before it,
+ *   - or, with -M, the file is mapped and the kernel is asked to read ahead
+ *     the next chunk while the current one is hashed.
+ * When verifying, the public key and signature are loaded before the first
+ * byte is read so that only the hash final and the ECDSA verify are left
+ * when the last byte arrives.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+/* Private key used to sign - generated when it doesn't exist. */
+#define PRIV_KEY_FILE   "ECC_FW_KEY.der"
+/* Public key written with a generated private key. */
+#define PUB_KEY_FILE    "ECC_FW_PUB.der"
+/* Default signature file. */
+#define SIG_FILE        "ECC_FW_SIG.der"
+/* Default size of each read in KB. */
+#define CHUNK_KB        1024
+/* Default number of buffers in the ring. */
+#define RING_DEPTH      4
+/* Maximum number of buffers in the ring. */
+#define MAX_RING_DEPTH  64
+/* Alignment of the buffers - a page. */
+#define BUF_ALIGN       4096
+/* Largest DER encoded key. */
+#define MAX_KEY_DER_SZ  256
+/* Size of generated key - matches ecc-sign. */
+#define ECC_KEY_SIZE    48
+/* Curve of generated key - matches ecc-sign. */
+#define ECC_KEY_CURVE   ECC_SECP384R1
+
+/* The command line options. */
+#define OPTIONS "?m:k:s:c:q:M"
+
+#if defined(HAVE_ECC) && !defined(NO_SHA256)
+
+/* Buffer of the ring. */
+typedef struct FwChunk {
+    byte*  buf;
+    size_t len;
+    /* Set on the chunk holding the end of the image. */
+    int    last;
+} FwChunk;
+
+/* Ring of buffers filled by the reader and hashed by the main thread. */
+typedef struct FwStream {
+    int             fd;
+    size_t          chunkSz;
+    int             depth;
+    FwChunk         chunks[MAX_RING_DEPTH];
+    /* Next chunk to hash. */
+    int             head;
+    /* Next chunk to fill. */
+    int             tail;
+    /* Number of chunks filled and not hashed. */
+    int             filled;
+    int             err;
+    /* Time the last byte was read. */
+    double          lastByte;
+    /* Time the hashing thread spent waiting for data. */
+    double          waitTime;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+} FwStream;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+
+static double CurrentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static int ReadFile(const char* file, byte* buf, word32* len)
+{
+    FILE* f;
+
+    f = fopen(file, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: failed to open %s\n", file);
+        return BAD_PATH_ERROR;
+    }
+    *len = (word32)fread(buf, 1, *len, f);
+    fclose(f);
+
+    return 0;
+}
+
+static int WriteFile(const char* file, const byte* buf, word32 len)
+{
+    int   ret = 0;
+    FILE* f;
+
+    f = fopen(file, "wb");
+    if (f == NULL || fwrite(buf, 1, len, f) != len) {
+        fprintf(stderr, "ERROR: failed to write %s\n", file);
+        ret = BAD_PATH_ERROR;
+    }
+    if (f != NULL)
+        fclose(f);
+
+    return ret;
+}
+
+/* Fill up a chunk - a short chunk is only returned at the end of the data. */
+static ssize_t ReadChunk(int fd, byte* buf, size_t len)
+{
+    ssize_t n;
+    size_t  total = 0;
+
+    while (total < len) {
+        n = read(fd, buf + total, len - total);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+        total += n;
+    }
+
+    return (ssize_t)total;
+}
+
+/* Read the image into the ring until the end or an error. */
+static void* Reader_Thread(void* arg)
+{
+    FwStream* s = (FwStream*)arg;
+    FwChunk*  chunk;
+    ssize_t   n;
+    int       last;
+
+    do {
+        pthread_mutex_lock(&s->lock);
+        while (s->filled == s->depth)
+            pthread_cond_wait(&s->cond, &s->lock);
+        chunk = &s->chunks[s->tail];
+        pthread_mutex_unlock(&s->lock);
+
+        /* Read outside the lock so that hashing continues. */
+        n = ReadChunk(s->fd, chunk->buf, s->chunkSz);
+
+        pthread_mutex_lock(&s->lock);
+        if (n < 0) {
+            s->err = errno;
+            chunk->len = 0;
+        }
+        else {
+            chunk->len = (size_t)n;
+        }
+        last = (n < (ssize_t)s->chunkSz);
+        chunk->last = last;
+        if (last)
+            s->lastByte = CurrentTime();
+        s->tail = (s->tail + 1) % s->depth;
+        s->filled++;
+        pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+    } while (!last);
+
+    return NULL;
+}
+
+/* Hash the data from the file descriptor, reading ahead in another thread. */
+static int HashStream(int fd, size_t chunkSz, int depth, wc_Sha256* sha,
+    word64* total, double* lastByte, double* waitTime)
+{
+    int       ret = 0;
+    int       i;
+    int       last = 0;
+    int       allocated = 0;
+    int       started = 0;
+    double    start;
+    FwChunk*  chunk;
+    FwStream  s;
+    pthread_t tid;
+
+    XMEMSET(&s, 0, sizeof(s));
+    s.fd = fd;
+    s.chunkSz = chunkSz;
+    s.depth = depth;
+    for (; allocated < depth; allocated++) {
+        if (posix_memalign((void**)&s.chunks[allocated].buf, BUF_ALIGN,
+                chunkSz) != 0) {
+            ret = MEMORY_E;
+            break;
+        }
+    }
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.cond, NULL);
+    if (ret == 0) {
+        if (pthread_create(&tid, NULL, Reader_Thread, &s) == 0)
+            started = 1;
+        else
+            ret = -1;
+    }
+
+    while (ret == 0 && !last) {
+        pthread_mutex_lock(&s.lock);
+        start = CurrentTime();
+        while (s.filled == 0)
+            pthread_cond_wait(&s.cond, &s.lock);
+        s.waitTime += CurrentTime() - start;
+        chunk = &s.chunks[s.head];
+        pthread_mutex_unlock(&s.lock);
+
+        /* Hash this chunk while the reader fills the next. */
+        ret = wc_Sha256Update(sha, chunk->buf, (word32)chunk->len);
+        *total += chunk->len;
+        last = chunk->last;
+
+        pthread_mutex_lock(&s.lock);
+        s.head = (s.head + 1) % s.depth;
+        s.filled--;
+        pthread_cond_signal(&s.cond);
+        pthread_mutex_unlock(&s.lock);
+    }
+    if (started) {
+        /* Keep taking chunks on error so that the reader finishes. */
+        pthread_mutex_lock(&s.lock);
+        while (!last) {
+            while (s.filled == 0)
+                pthread_cond_wait(&s.cond, &s.lock);
+            last = s.chunks[s.head].last;
+            s.head = (s.head + 1) % s.depth;
+            s.filled--;
+            pthread_cond_signal(&s.cond);
+        }
+        pthread_mutex_unlock(&s.lock);
+        pthread_join(tid, NULL);
+    }
+    if (ret == 0 && s.err != 0) {
+        fprintf(stderr, "ERROR: failed to read image: %s\n", strerror(s.err));
+        ret = -1;
+    }
+
+    *lastByte = s.lastByte;
+    *waitTime = s.waitTime;
+    pthread_cond_destroy(&s.cond);
+    pthread_mutex_destroy(&s.lock);
+    for (i = 0; i < allocated; i++)
+        free(s.chunks[i].buf);
+
+    return ret;
+}
+
+/* Hash a mapped file, asking the kernel to read the next chunk ahead. */
+static int HashMapped(int fd, size_t chunkSz, wc_Sha256* sha, word64* total,
+    double* lastByte)
+{
+    int         ret = 0;
+    struct stat st;
+    byte*       image;
+    size_t      off;
+    size_t      len;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "ERROR: -M needs a regular file\n");
+        return BAD_FUNC_ARG;
+    }
+    *lastByte = CurrentTime();
+    if (st.st_size == 0)
+        return 0;
+
+    image = (byte*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd,
+        0);
+    if (image == MAP_FAILED) {
+        fprintf(stderr, "ERROR: failed to map image: %s\n", strerror(errno));
+        return MEMORY_E;
+    }
+    madvise(image, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    for (off = 0; ret == 0 && off < (size_t)st.st_size; off += len) {
+        len = (size_t)st.st_size - off;
+        if (len > chunkSz)
+            len = chunkSz;
+        if (off + len < (size_t)st.st_size) {
+            /* Offsets are multiples of the chunk size - page aligned. */
+            madvise(image + off + len, ((size_t)st.st_size - off - len <
+                chunkSz) ? (size_t)st.st_size - off - len : chunkSz,
+                MADV_WILLNEED);
+        }
+        ret = wc_Sha256Update(sha, image + off, (word32)len);
+        *total += len;
+    }
+    /* Last byte is in memory when it has been hashed. */
+    *lastByte = CurrentTime();
+
+    munmap(image, (size_t)st.st_size);
+
+    return ret;
+}
+
+/* Load the signing key or generate one and write out the key pair. */
+static int LoadSignKey(const char* file, ecc_key* key)
+{
+    int    ret;
+    int    derSz;
+    byte   der[MAX_KEY_DER_SZ];
+    word32 len = sizeof(der);
+    word32 idx = 0;
+    WC_RNG rng;
+
+    if (access(file, R_OK) == 0) {
+        ret = ReadFile(file, der, &len);
+        if (ret == 0)
+            ret = wc_EccPrivateKeyDecode(der, &idx, key, len);
+        if (ret != 0)
+            fprintf(stderr, "ERROR: failed to load key %s: %d\n", file, ret);
+        return ret;
+    }
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_make_key_ex(&rng, ECC_KEY_SIZE, key, ECC_KEY_CURVE);
+    wc_FreeRng(&rng);
+    if (ret == 0) {
+        derSz = wc_EccKeyToDer(key, der, sizeof(der));
+        ret = (derSz < 0) ? derSz : WriteFile(file, der, (word32)derSz);
+    }
+    if (ret == 0) {
+        derSz = wc_EccPublicKeyToDer(key, der, sizeof(der), 1);
+        ret = (derSz < 0) ? derSz : WriteFile(PUB_KEY_FILE, der,
+            (word32)derSz);
+    }
+    if (ret == 0)
+        printf("Generated key: %s, %s\n", file, PUB_KEY_FILE);
+
+    return ret;
+}
+
+static int LoadVerifyKey(const char* file, ecc_key* key)
+{
+    int    ret;
+    byte   der[MAX_KEY_DER_SZ];
+    word32 len = sizeof(der);
+    word32 idx = 0;
+
+    ret = ReadFile(file, der, &len);
+    if (ret == 0)
+        ret = wc_EccPublicKeyDecode(der, &idx, key, len);
+    if (ret != 0)
+        fprintf(stderr, "ERROR: failed to load key %s: %d\n", file, ret);
+
+    return ret;
+}
+
+static void Usage(void)
+{
+    printf("ecc-fw-stream " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("Usage: ecc-fw-stream [options] <image | ->\n");
+    printf("-?          Help, print this usage\n");
+    printf("-m <mode>   sign or verify, default sign\n");
+    printf("-k <file>   DER key, default %s to sign and %s to verify\n",
+        PRIV_KEY_FILE, PUB_KEY_FILE);
+    printf("-s <file>   DER signature, default %s\n", SIG_FILE);
+    printf("-c <num>    Size of each read in KB, default %d\n", CHUNK_KB);
+    printf("-q <num>    Number of buffers read ahead, default %d\n",
+        RING_DEPTH);
+    printf("-M          Map the image instead of reading it\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret = 0;
+    int         ch;
+    int         sign = 1;
+    int         useMmap = 0;
+    int         depth = RING_DEPTH;
+    int         fd = -1;
+    int         verify = 0;
+    int         keyInit = 0;
+    size_t      chunkSz = (size_t)CHUNK_KB * 1024;
+    const char* keyFile = NULL;
+    const char* sigFile = SIG_FILE;
+    const char* image;
+    word64      total = 0;
+    word32      sigLen = ECC_MAX_SIG_SIZE;
+    double      start;
+    double      lastByte = 0;
+    double      waitTime = 0;
+    double      end;
+    byte        hash[WC_SHA256_DIGEST_SIZE];
+    byte        sig[ECC_MAX_SIG_SIZE];
+    wc_Sha256   sha;
+    ecc_key     key;
+    WC_RNG      rng;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'm':
+                if (XSTRCMP(myoptarg, "sign") == 0)
+                    sign = 1;
+                else if (XSTRCMP(myoptarg, "verify") == 0)
+                    sign = 0;
+                else {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'k':
+                keyFile = myoptarg;
+                break;
+            case 's':
+                sigFile = myoptarg;
+                break;
+            case 'c':
+                /* Whole KB keeps the chunks page aligned. */
+                chunkSz = (size_t)atoi(myoptarg) * 1024;
+                break;
+            case 'q':
+                depth = atoi(myoptarg);
+                break;
+            case 'M':
+                useMmap = 1;
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    if (myoptind != argc - 1 || chunkSz == 0 || chunkSz % BUF_ALIGN != 0 ||
+            depth < 2 || depth > MAX_RING_DEPTH) {
+        Usage();
+        return 1;
+    }
+    image = argv[myoptind];
+    if (keyFile == NULL)
+        keyFile = sign ? PRIV_KEY_FILE : PUB_KEY_FILE;
+
+    wolfCrypt_Init();
+
+    /* Key and signature are ready before the first byte of the image. */
+    ret = wc_ecc_init(&key);
+    if (ret == 0) {
+        keyInit = 1;
+        if (sign)
+            ret = LoadSignKey(keyFile, &key);
+        else
+            ret = LoadVerifyKey(keyFile, &key);
+    }
+    if (ret == 0 && !sign)
+        ret = ReadFile(sigFile, sig, &sigLen);
+    if (ret != 0)
+        goto exit;
+
+    if (XSTRCMP(image, "-") == 0) {
+        if (useMmap) {
+            fprintf(stderr, "ERROR: -M needs a file\n");
+            ret = BAD_FUNC_ARG;
+            goto exit;
+        }
+        fd = STDIN_FILENO;
+    }
+    else {
+        fd = open(image, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "ERROR: failed to open %s\n", image);
+            ret = BAD_PATH_ERROR;
+            goto exit;
+        }
+    #ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    #endif
+    }
+
+    ret = wc_InitSha256(&sha);
+    if (ret != 0)
+        goto exit;
+    start = CurrentTime();
+    if (useMmap)
+        ret = HashMapped(fd, chunkSz, &sha, &total, &lastByte);
+    else {
+        ret = HashStream(fd, chunkSz, depth, &sha, &total, &lastByte,
+            &waitTime);
+    }
+    if (ret == 0)
+        ret = wc_Sha256Final(&sha, hash);
+    wc_Sha256Free(&sha);
+
+    if (ret == 0 && sign) {
+        ret = wc_InitRng(&rng);
+        if (ret == 0) {
+            ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &sigLen, &rng,
+                &key);
+            wc_FreeRng(&rng);
+        }
+        if (ret == 0)
+            ret = WriteFile(sigFile, sig, sigLen);
+    }
+    else if (ret == 0) {
+        ret = wc_ecc_verify_hash(sig, sigLen, hash, sizeof(hash), &verify,
+            &key);
+        if (ret == 0 && !verify)
+            ret = SIG_VERIFY_E;
+    }
+    end = CurrentTime();
+    if (ret != 0)
+        goto exit;
+
+    printf("%s %s: %llu bytes\n", sign ? "Signed" : "Verified", image,
+        (unsigned long long)total);
+    printf("Total          : %.3f ms, %.1f MB/s\n", (end - start) * 1000,
+        (end > start) ? total / (end - start) / 1000000 : 0);
+    if (!useMmap)
+        printf("Waiting on I/O : %.3f ms\n", waitTime * 1000);
+    printf("After last byte: %.3f ms\n", (end - lastByte) * 1000);
+    if (sign)
+        printf("Signature      : %s (%u bytes)\n", sigFile, sigLen);
+
+exit:
+    if (fd > STDIN_FILENO)
+        close(fd);
+    if (keyInit)
+        wc_ecc_free(&key);
+    if (ret != 0)
+        fprintf(stderr, "%s failed: %d\n", sign ? "Sign" : "Verify", ret);
+
+    wolfCrypt_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with ECC and SHA-256\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,994 @@
+/* ecc-sign-service.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *=============================================================================
+ *
+ * ECDSA signing service for one long-lived key.
+ *
+ * ecc-sign.c creates an RNG for every signature. This service keeps, in each
+ * signer thread, its own copy of the key, its own RNG and - when wolfSSL is
+ * built with FP_ECC - its own fixed-base point table for the generator. These
+ * are made once when the thread starts and stay warm for all signatures.
+ *
+ * Modes:
+ *   server - accept batches of digests on a Unix socket, split each batch
+ *            across the signer threads and return the signatures in order.
+ *   client - send digests to the server in batches and report signatures/s.
+ *   bench  - in process: compare the per-call path (RNG and key set up for
+ *            each signature), one warm signer and the warm signer pool.
+ *
+ * Protocol (integers in network byte order):
+ *   request:  u32 count, then count x (u8 length, digest)
+ *   response: u32 count, then count x (u16 length, DER signature)
+ *             - a length of 0 means the digest couldn't be signed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+/* Default path of the service's socket. */
+#define DEFAULT_SOCK_PATH   "/tmp/ecc-sign.sock"
+/* File the public key is written to when a key is generated. */
+#define PUB_KEY_FILE        "ECC_SIGN_PUB.der"
+/* Default number of signer threads. */
+#define NUM_SIGNERS         4
+/* Maximum number of signer threads. */
+#define MAX_SIGNERS         256
+/* Most digests accepted in one request. */
+#define MAX_BATCH           4096
+/* Default number of digests in a request sent by the client. */
+#define BATCH_SZ            64
+/* Default number of signatures made by the client and bench. */
+#define NUM_SIGS            10000
+/* Number of digests a signer claims from a batch at a time. */
+#define SIGN_CHUNK          8
+/* Largest DER encoded private key. */
+#define MAX_KEY_DER_SZ      256
+
+/* The command line options. */
+#define OPTIONS "?m:u:k:c:w:b:n:"
+
+#if defined(HAVE_ECC) && !defined(NO_SHA256)
+
+enum {
+    MODE_SERVER,
+    MODE_CLIENT,
+    MODE_BENCH
+};
+
+/* A digest to sign and its signature. */
+typedef struct SignItem {
+    byte   digest[WC_MAX_DIGEST_SIZE];
+    byte   digestLen;
+    byte   sig[ECC_MAX_SIG_SIZE];
+    word32 sigLen;
+} SignItem;
+
+/* Digests of a request being signed by the signer threads. */
+typedef struct SignBatch {
+    SignItem*         items;
+    int               count;
+    /* Index of next digest to be claimed by a signer. */
+    int               next;
+    /* Number of digests signed. */
+    int               done;
+    pthread_cond_t    cond;
+    struct SignBatch* nextBatch;
+} SignBatch;
+
+/* Data of each signer thread - all kept for the life of the thread. */
+typedef struct Signer {
+    pthread_t tid;
+    ecc_key   key;
+    WC_RNG    rng;
+    long      sigs;
+    int       ret;
+} Signer;
+
+/* A client connection being served. */
+typedef struct Conn {
+    pthread_t    tid;
+    int          fd;
+    /* Set by the connection thread when it can be joined. */
+    int          done;
+    struct Conn* next;
+} Conn;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static byte            gKeyDer[MAX_KEY_DER_SZ];
+static word32          gKeyDerSz;
+static int             gCurveSz = 32;
+static int             gCurveId = ECC_SECP256R1;
+static Signer*         gSigners;
+static int             gNumSigners = NUM_SIGNERS;
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gCond = PTHREAD_COND_INITIALIZER;
+static SignBatch*      gHead;
+static SignBatch*      gTail;
+static int             gStop;
+static volatile int    gInterrupted;
+/* Connections being served - changed under lock. */
+static Conn*           gConns;
+
+
+static double CurrentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static void SigIntHandler(int sig)
+{
+    (void)sig;
+    gInterrupted = 1;
+}
+
+/* Load the private key of the service from a DER file. */
+static int LoadKey(const char* file)
+{
+    int     ret = 0;
+    word32  idx = 0;
+    FILE*   f;
+    ecc_key key;
+
+    f = fopen(file, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: failed to open %s\n", file);
+        return BAD_PATH_ERROR;
+    }
+    gKeyDerSz = (word32)fread(gKeyDer, 1, sizeof(gKeyDer), f);
+    fclose(f);
+
+    /* Check key and use its curve for the digests of the client. */
+    ret = wc_ecc_init(&key);
+    if (ret == 0) {
+        ret = wc_EccPrivateKeyDecode(gKeyDer, &idx, &key, gKeyDerSz);
+        if (ret == 0) {
+            gCurveSz = wc_ecc_size(&key);
+            gCurveId = key.dp->id;
+        }
+        wc_ecc_free(&key);
+    }
+    if (ret != 0)
+        fprintf(stderr, "ERROR: failed to decode key in %s: %d\n", file, ret);
+
+    return ret;
+}
+
+/* Generate the private key of the service and write the public key out so
+ * that clients can verify. */
+static int GenerateKey(void)
+{
+    int     ret;
+    int     derSz;
+    byte    pubDer[MAX_KEY_DER_SZ];
+    FILE*   f;
+    WC_RNG  rng;
+    ecc_key key;
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_init(&key);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex(&rng, gCurveSz, &key, gCurveId);
+        if (ret == 0) {
+            derSz = wc_EccKeyToDer(&key, gKeyDer, sizeof(gKeyDer));
+            if (derSz < 0)
+                ret = derSz;
+            else
+                gKeyDerSz = (word32)derSz;
+        }
+        if (ret == 0) {
+            derSz = wc_EccPublicKeyToDer(&key, pubDer, sizeof(pubDer), 1);
+            if (derSz < 0)
+                ret = derSz;
+        }
+        if (ret == 0) {
+            f = fopen(PUB_KEY_FILE, "wb");
+            if (f == NULL || fwrite(pubDer, 1, derSz, f) != (size_t)derSz) {
+                fprintf(stderr, "ERROR: failed to write %s\n", PUB_KEY_FILE);
+                ret = BAD_PATH_ERROR;
+            }
+            if (f != NULL)
+                fclose(f);
+        }
+        wc_ecc_free(&key);
+    }
+    wc_FreeRng(&rng);
+
+    return ret;
+}
+
+/* Set up the key and RNG of a signer. */
+static int Signer_Init(Signer* signer)
+{
+    int    ret;
+    word32 idx = 0;
+
+    ret = wc_InitRng(&signer->rng);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_init(&signer->key);
+    if (ret == 0) {
+        ret = wc_EccPrivateKeyDecode(gKeyDer, &idx, &signer->key, gKeyDerSz);
+    }
+#if defined(ECC_TIMING_RESISTANT) && (!defined(HAVE_FIPS) || \
+    (!defined(HAVE_FIPS_VERSION) || (HAVE_FIPS_VERSION != 2))) && \
+    !defined(HAVE_SELFTEST)
+    if (ret == 0)
+        ret = wc_ecc_set_rng(&signer->key, &signer->rng);
+#endif
+    if (ret != 0) {
+        wc_ecc_free(&signer->key);
+        wc_FreeRng(&signer->rng);
+    }
+
+    return ret;
+}
+
+static void Signer_Free(Signer* signer)
+{
+    wc_ecc_free(&signer->key);
+    wc_FreeRng(&signer->rng);
+#ifdef FP_ECC
+    /* Table of fixed points is kept per thread. */
+    wc_ecc_fp_free();
+#endif
+}
+
+static void Signer_Sign(Signer* signer, SignItem* item)
+{
+    item->sigLen = sizeof(item->sig);
+    if (wc_ecc_sign_hash(item->digest, item->digestLen, item->sig,
+            &item->sigLen, &signer->rng, &signer->key) != 0) {
+        item->sigLen = 0;
+    }
+    signer->sigs++;
+}
+
+/* Claim digests from the queued batches and sign them until stopped. */
+static void* Signer_Thread(void* arg)
+{
+    Signer*    signer = (Signer*)arg;
+    SignBatch* batch;
+    SignItem   warm;
+    int        start;
+    int        cnt;
+    int        i;
+
+    /* First signature builds the precomputation - do it before any
+     * request arrives. */
+    XMEMSET(&warm, 0, sizeof(warm));
+    warm.digestLen = WC_SHA256_DIGEST_SIZE;
+    Signer_Sign(signer, &warm);
+    signer->sigs = 0;
+
+    pthread_mutex_lock(&gLock);
+    for (;;) {
+        while (gHead == NULL && !gStop)
+            pthread_cond_wait(&gCond, &gLock);
+        if (gHead == NULL)
+            break;
+
+        batch = gHead;
+        start = batch->next;
+        cnt = batch->count - start;
+        if (cnt > SIGN_CHUNK)
+            cnt = SIGN_CHUNK;
+        batch->next += cnt;
+        if (batch->next == batch->count) {
+            /* All claimed - others sign the next batch. */
+            gHead = batch->nextBatch;
+            if (gHead == NULL)
+                gTail = NULL;
+        }
+        pthread_mutex_unlock(&gLock);
+
+        for (i = start; i < start + cnt; i++)
+            Signer_Sign(signer, &batch->items[i]);
+
+        pthread_mutex_lock(&gLock);
+        batch->done += cnt;
+        if (batch->done == batch->count)
+            pthread_cond_signal(&batch->cond);
+    }
+    pthread_mutex_unlock(&gLock);
+
+    Signer_Free(signer);
+    return NULL;
+}
+
+/* Sign all digests with the signer threads - returns when all are done. */
+static void SignBatch_Run(SignItem* items, int count)
+{
+    SignBatch batch;
+
+    if (count == 0)
+        return;
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.items = items;
+    batch.count = count;
+    pthread_cond_init(&batch.cond, NULL);
+
+    pthread_mutex_lock(&gLock);
+    if (gTail == NULL)
+        gHead = &batch;
+    else
+        gTail->nextBatch = &batch;
+    gTail = &batch;
+    pthread_cond_broadcast(&gCond);
+    while (batch.done < batch.count)
+        pthread_cond_wait(&batch.cond, &gLock);
+    pthread_mutex_unlock(&gLock);
+
+    pthread_cond_destroy(&batch.cond);
+}
+
+static int Signers_Start(void)
+{
+    int ret = 0;
+    int i;
+
+    gSigners = (Signer*)calloc(gNumSigners, sizeof(Signer));
+    if (gSigners == NULL)
+        return MEMORY_E;
+    for (i = 0; ret == 0 && i < gNumSigners; i++) {
+        ret = Signer_Init(&gSigners[i]);
+        if (ret == 0 && pthread_create(&gSigners[i].tid, NULL, Signer_Thread,
+                &gSigners[i]) != 0) {
+            Signer_Free(&gSigners[i]);
+            ret = -1;
+        }
+    }
+    if (ret != 0) {
+        fprintf(stderr, "ERROR: failed to start signer %d\n", i - 1);
+        gNumSigners = i - 1;
+    }
+
+    return ret;
+}
+
+static void Signers_Stop(void)
+{
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    gStop = 1;
+    pthread_cond_broadcast(&gCond);
+    pthread_mutex_unlock(&gLock);
+    for (i = 0; i < gNumSigners; i++)
+        pthread_join(gSigners[i].tid, NULL);
+    free(gSigners);
+    gSigners = NULL;
+}
+
+static int ReadFull(int fd, void* buf, size_t len)
+{
+    ssize_t n;
+    byte*   p = (byte*)buf;
+
+    while (len > 0) {
+        n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int WriteFull(int fd, const void* buf, size_t len)
+{
+    ssize_t     n;
+    const byte* p = (const byte*)buf;
+
+    while (len > 0) {
+        n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Encode the signatures of a batch into a response. */
+static int EncodeResponse(const SignItem* items, int count, byte* out)
+{
+    int    i;
+    int    len = 0;
+    word32 n;
+    word16 sigLen;
+
+    n = htonl((word32)count);
+    XMEMCPY(out, &n, sizeof(n));
+    len += sizeof(n);
+    for (i = 0; i < count; i++) {
+        sigLen = htons((word16)items[i].sigLen);
+        XMEMCPY(out + len, &sigLen, sizeof(sigLen));
+        len += sizeof(sigLen);
+        XMEMCPY(out + len, items[i].sig, items[i].sigLen);
+        len += items[i].sigLen;
+    }
+
+    return len;
+}
+
+/* Serve requests of a client until it disconnects or the socket is shut
+ * down. The socket is closed when the thread is joined. */
+static void* Conn_Thread(void* arg)
+{
+    Conn*     conn = (Conn*)arg;
+    int       fd = conn->fd;
+    int       i;
+    int       count;
+    int       len;
+    word32    n;
+    SignItem* items;
+    byte*     resp;
+
+    items = (SignItem*)malloc(sizeof(SignItem) * MAX_BATCH);
+    resp = (byte*)malloc(sizeof(word32) +
+        MAX_BATCH * (sizeof(word16) + ECC_MAX_SIG_SIZE));
+    while (items != NULL && resp != NULL) {
+        if (ReadFull(fd, &n, sizeof(n)) != 0)
+            break;
+        count = (int)ntohl(n);
+        if (count < 0 || count > MAX_BATCH) {
+            fprintf(stderr, "ERROR: batch of %d digests too big\n", count);
+            break;
+        }
+        for (i = 0; i < count; i++) {
+            if (ReadFull(fd, &items[i].digestLen, 1) != 0 ||
+                    items[i].digestLen > WC_MAX_DIGEST_SIZE ||
+                    ReadFull(fd, items[i].digest, items[i].digestLen) != 0) {
+                break;
+            }
+        }
+        if (i < count)
+            break;
+
+        SignBatch_Run(items, count);
+
+        len = EncodeResponse(items, count, resp);
+        if (WriteFull(fd, resp, len) != 0)
+            break;
+    }
+
+    free(resp);
+    free(items);
+    pthread_mutex_lock(&gLock);
+    conn->done = 1;
+    pthread_mutex_unlock(&gLock);
+    return NULL;
+}
+
+/* Join the connection threads that are done, or all when stopping. */
+static void Conn_Reap(int all)
+{
+    Conn*  conn;
+    Conn** prev = &gConns;
+
+    pthread_mutex_lock(&gLock);
+    while ((conn = *prev) != NULL) {
+        if (!all && !conn->done) {
+            prev = &conn->next;
+            continue;
+        }
+        *prev = conn->next;
+        pthread_mutex_unlock(&gLock);
+        pthread_join(conn->tid, NULL);
+        close(conn->fd);
+        free(conn);
+        pthread_mutex_lock(&gLock);
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+static int RunServer(const char* path)
+{
+    int                ret = 0;
+    int                listenFd;
+    int                fd;
+    long               sigs = 0;
+    int                i;
+    Conn*              conn;
+    struct sockaddr_un addr;
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        fprintf(stderr, "ERROR: failed to create socket\n");
+        return -1;
+    }
+    XMEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(listenFd, 16) != 0) {
+        fprintf(stderr, "ERROR: failed to listen on %s\n", path);
+        close(listenFd);
+        return -1;
+    }
+
+    printf("Signing with %d threads on %s - ^C to stop\n", gNumSigners, path);
+    while (!gInterrupted) {
+        fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "ERROR: failed to accept\n");
+            ret = -1;
+            break;
+        }
+        Conn_Reap(0);
+
+        conn = (Conn*)calloc(1, sizeof(Conn));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        pthread_mutex_lock(&gLock);
+        if (pthread_create(&conn->tid, NULL, Conn_Thread, conn) != 0) {
+            pthread_mutex_unlock(&gLock);
+            fprintf(stderr, "ERROR: failed to create connection thread\n");
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = gConns;
+        gConns = conn;
+        pthread_mutex_unlock(&gLock);
+    }
+
+    close(listenFd);
+    unlink(path);
+
+    /* Stop reading requests and wait for the connection threads. A batch
+     * already queued is signed first as the signers are still running. */
+    pthread_mutex_lock(&gLock);
+    for (conn = gConns; conn != NULL; conn = conn->next)
+        shutdown(conn->fd, SHUT_RDWR);
+    pthread_mutex_unlock(&gLock);
+    Conn_Reap(1);
+
+    for (i = 0; i < gNumSigners; i++)
+        sigs += gSigners[i].sigs;
+    printf("Signatures   : %ld\n", sigs);
+
+    return ret;
+}
+
+/* Make a digest for each request - stands in for hashes of artifacts. */
+static void MakeDigest(long i, SignItem* item)
+{
+    wc_Sha256Hash((const byte*)&i, sizeof(i), item->digest);
+    item->digestLen = WC_SHA256_DIGEST_SIZE;
+}
+
+static int RunClient(const char* path, long numSigs, int batchSz)
+{
+    int                ret = 0;
+    int                fd;
+    int                i;
+    int                count;
+    int                len;
+    int                verify;
+    long               sent = 0;
+    long               failed = 0;
+    long               batches = 0;
+    word32             idx = 0;
+    word32             n;
+    word16             sigLen;
+    double             start;
+    double             elapsed;
+    byte               pubDer[MAX_KEY_DER_SZ];
+    int                pubDerSz = 0;
+    int                haveKey = 0;
+    byte*              req = NULL;
+    SignItem*          items = NULL;
+    ecc_key            pub;
+    FILE*              f;
+    struct sockaddr_un addr;
+
+    /* Public key of the service to check a signature of each batch. */
+    f = fopen(PUB_KEY_FILE, "rb");
+    if (f != NULL) {
+        pubDerSz = (int)fread(pubDer, 1, sizeof(pubDer), f);
+        fclose(f);
+        if (wc_ecc_init(&pub) == 0) {
+            haveKey = (wc_EccPublicKeyDecode(pubDer, &idx, &pub,
+                pubDerSz) == 0);
+            if (!haveKey)
+                wc_ecc_free(&pub);
+        }
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    XMEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "ERROR: failed to connect to %s\n", path);
+        ret = -1;
+        goto exit;
+    }
+
+    items = (SignItem*)malloc(sizeof(SignItem) * batchSz);
+    req = (byte*)malloc(sizeof(word32) + batchSz * (1 + WC_MAX_DIGEST_SIZE));
+    if (items == NULL || req == NULL) {
+        ret = MEMORY_E;
+        goto exit;
+    }
+
+    start = CurrentTime();
+    while (ret == 0 && sent < numSigs) {
+        count = batchSz;
+        if (count > numSigs - sent)
+            count = (int)(numSigs - sent);
+
+        n = htonl((word32)count);
+        XMEMCPY(req, &n, sizeof(n));
+        len = sizeof(n);
+        for (i = 0; i < count; i++) {
+            MakeDigest(sent + i, &items[i]);
+            req[len++] = items[i].digestLen;
+            XMEMCPY(req + len, items[i].digest, items[i].digestLen);
+            len += items[i].digestLen;
+        }
+        if (WriteFull(fd, req, len) != 0 || ReadFull(fd, &n, sizeof(n)) != 0 ||
+                (int)ntohl(n) != count) {
+            ret = -1;
+            break;
+        }
+        for (i = 0; ret == 0 && i < count; i++) {
+            if (ReadFull(fd, &sigLen, sizeof(sigLen)) != 0) {
+                ret = -1;
+                break;
+            }
+            items[i].sigLen = ntohs(sigLen);
+            if (items[i].sigLen > sizeof(items[i].sig) ||
+                    ReadFull(fd, items[i].sig, items[i].sigLen) != 0) {
+                ret = -1;
+                break;
+            }
+            if (items[i].sigLen == 0)
+                failed++;
+        }
+        if (ret == 0 && haveKey && items[0].sigLen > 0) {
+            verify = 0;
+            ret = wc_ecc_verify_hash(items[0].sig, items[0].sigLen,
+                items[0].digest, items[0].digestLen, &verify, &pub);
+            if (ret == 0 && !verify) {
+                fprintf(stderr, "ERROR: signature didn't verify\n");
+                ret = SIG_VERIFY_E;
+            }
+        }
+        sent += count;
+        batches++;
+    }
+    elapsed = CurrentTime() - start;
+
+    if (ret != 0)
+        fprintf(stderr, "ERROR: request failed: %d\n", ret);
+    else {
+        printf("Signatures   : %ld (%ld failed) in %.3f s, %.1f sigs/s\n",
+            sent, failed, elapsed, sent / elapsed);
+        printf("Batches      : %ld of up to %d, %.3f ms per batch\n", batches,
+            batchSz, elapsed * 1000 / batches);
+        if (!haveKey)
+            printf("Not verified : %s not found\n", PUB_KEY_FILE);
+    }
+
+exit:
+    free(req);
+    free(items);
+    if (fd >= 0)
+        close(fd);
+    if (haveKey)
+        wc_ecc_free(&pub);
+
+    return ret;
+}
+
+/* Sign with the RNG and key set up for each signature. */
+static int BenchPerCall(SignItem* items, long numSigs)
+{
+    int     ret = 0;
+    long    i;
+    word32  idx;
+    WC_RNG  rng;
+    ecc_key key;
+
+    for (i = 0; ret == 0 && i < numSigs; i++) {
+        ret = wc_InitRng(&rng);
+        if (ret != 0)
+            break;
+        idx = 0;
+        ret = wc_ecc_init(&key);
+        if (ret == 0)
+            ret = wc_EccPrivateKeyDecode(gKeyDer, &idx, &key, gKeyDerSz);
+        if (ret == 0) {
+            items[i].sigLen = sizeof(items[i].sig);
+            ret = wc_ecc_sign_hash(items[i].digest, items[i].digestLen,
+                items[i].sig, &items[i].sigLen, &rng, &key);
+        }
+        wc_ecc_free(&key);
+        wc_FreeRng(&rng);
+    }
+
+    return ret;
+}
+
+/* Sign with one warm signer in this thread. */
+static int BenchWarm(SignItem* items, long numSigs)
+{
+    int    ret;
+    long   i;
+    Signer signer;
+
+    XMEMSET(&signer, 0, sizeof(signer));
+    ret = Signer_Init(&signer);
+    if (ret != 0)
+        return ret;
+    for (i = 0; i < numSigs; i++) {
+        Signer_Sign(&signer, &items[i]);
+        if (items[i].sigLen == 0)
+            ret = -1;
+    }
+    Signer_Free(&signer);
+
+    return ret;
+}
+
+/* Sign in batches with the pool of warm signers. */
+static int BenchPool(SignItem* items, long numSigs, int batchSz)
+{
+    int  ret = 0;
+    long i;
+    int  count;
+
+    for (i = 0; i < numSigs; i += count) {
+        count = batchSz;
+        if (count > numSigs - i)
+            count = (int)(numSigs - i);
+        SignBatch_Run(items + i, count);
+    }
+    for (i = 0; i < numSigs; i++) {
+        if (items[i].sigLen == 0)
+            ret = -1;
+    }
+
+    return ret;
+}
+
+static int RunBench(long numSigs, int batchSz)
+{
+    int       ret = 0;
+    long      i;
+    double    start;
+    double    elapsed;
+    double    perCall = 0;
+    char      name[32];
+    SignItem* items;
+
+    items = (SignItem*)malloc(sizeof(SignItem) * numSigs);
+    if (items == NULL)
+        return MEMORY_E;
+    for (i = 0; i < numSigs; i++)
+        MakeDigest(i, &items[i]);
+
+    printf("ECDSA P-%d, %ld signatures\n", gCurveSz * 8, numSigs);
+    for (i = 0; ret == 0 && i < 3; i++) {
+        start = CurrentTime();
+        if (i == 0) {
+            snprintf(name, sizeof(name), "per-call");
+            ret = BenchPerCall(items, numSigs);
+        }
+        else if (i == 1) {
+            snprintf(name, sizeof(name), "warm, 1 thread");
+            ret = BenchWarm(items, numSigs);
+        }
+        else {
+            snprintf(name, sizeof(name), "warm, %d threads", gNumSigners);
+            ret = BenchPool(items, numSigs, batchSz);
+        }
+        elapsed = CurrentTime() - start;
+        if (i == 0)
+            perCall = elapsed;
+        if (ret == 0) {
+            printf("%-18s : %10.1f sigs/s, %8.1f us/sig, %5.2fx\n", name,
+                numSigs / elapsed, elapsed * 1000000 / numSigs,
+                perCall / elapsed);
+        }
+    }
+    if (ret != 0)
+        fprintf(stderr, "ERROR: signing failed: %d\n", ret);
+
+    free(items);
+    return ret;
+}
+
+static void Usage(void)
+{
+    printf("ecc-sign-service " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-m <mode>   server, client or bench, default bench\n");
+    printf("-u <path>   Path of Unix socket, default %s\n", DEFAULT_SOCK_PATH);
+    printf("-k <file>   DER private key, default generate and write %s\n",
+        PUB_KEY_FILE);
+    printf("-c <bits>   Curve of generated key: 256 or 384, default 256\n");
+    printf("-w <num>    Number of signer threads, default %d\n", NUM_SIGNERS);
+    printf("-b <num>    Digests in each request, default %d\n", BATCH_SZ);
+    printf("-n <num>    Number of signatures to make, default %d\n",
+        NUM_SIGS);
+}
+
+int main(int argc, char* argv[])
+{
+    int              ret = 0;
+    int              ch;
+    int              mode = MODE_BENCH;
+    int              batchSz = BATCH_SZ;
+    long             numSigs = NUM_SIGS;
+    const char*      path = DEFAULT_SOCK_PATH;
+    const char*      keyFile = NULL;
+    struct sigaction sa;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'm':
+                if (XSTRCMP(myoptarg, "server") == 0)
+                    mode = MODE_SERVER;
+                else if (XSTRCMP(myoptarg, "client") == 0)
+                    mode = MODE_CLIENT;
+                else if (XSTRCMP(myoptarg, "bench") == 0)
+                    mode = MODE_BENCH;
+                else {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'u':
+                path = myoptarg;
+                break;
+            case 'k':
+                keyFile = myoptarg;
+                break;
+            case 'c':
+                if (atoi(myoptarg) == 256) {
+                    gCurveSz = 32;
+                    gCurveId = ECC_SECP256R1;
+                }
+                else if (atoi(myoptarg) == 384) {
+                    gCurveSz = 48;
+                    gCurveId = ECC_SECP384R1;
+                }
+                else {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'w':
+                gNumSigners = atoi(myoptarg);
+                if (gNumSigners < 1 || gNumSigners > MAX_SIGNERS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'b':
+                batchSz = atoi(myoptarg);
+                if (batchSz < 1 || batchSz > MAX_BATCH) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'n':
+                numSigs = atol(myoptarg);
+                if (numSigs < 1) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+
+    wolfCrypt_Init();
+
+    if (mode == MODE_CLIENT) {
+        ret = RunClient(path, numSigs, batchSz);
+    }
+    else {
+        if (keyFile != NULL)
+            ret = LoadKey(keyFile);
+        else
+            ret = GenerateKey();
+        if (ret == 0)
+            ret = Signers_Start();
+        if (ret == 0) {
+            if (mode == MODE_SERVER) {
+                /* Interrupt accept so the statistics are printed. */
+                XMEMSET(&sa, 0, sizeof(sa));
+                sa.sa_handler = SigIntHandler;
+                sigaction(SIGINT, &sa, NULL);
+                signal(SIGPIPE, SIG_IGN);
+
+                ret = RunServer(path);
+            }
+            else {
+                ret = RunBench(numSigs, batchSz);
+            }
+        }
+        if (gSigners != NULL)
+            Signers_Stop();
+    }
+
+    wolfCrypt_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with ECC and SHA-256\n");
+    return 0;
+}
+
+#endif
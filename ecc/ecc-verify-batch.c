@@ -0,0 +1,688 @@
+/* ecc-verify-batch.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *=============================================================================
+ *
+ * Batch verification of ECDSA P-256 or Ed25519 signed records.
+ *
+ * ecc-verify.c decodes the public key for each signature it verifies. Here a
+ * batch of records, each naming one of a set of public keys, is verified by a
+ * number of threads. Each thread imports every public key once and keeps it
+ * for the whole batch. With FP_ECC the fixed point table of each ECDSA public
+ * key is also built once per thread. Every record gets its own result so
+ * that a record that fails is identified without checking the batch again.
+ *
+ * The records are generated and signed at start. Some can be corrupted with
+ * -f to show that exactly those records are reported as failing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#ifdef HAVE_ED25519
+    #include <wolfssl/wolfcrypt/ed25519.h>
+#endif
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#if defined(HAVE_ED25519) && defined(HAVE_ED25519_SIGN) && \
+    defined(HAVE_ED25519_VERIFY)
+    #define BATCH_ED25519
+#endif
+
+/* Default number of records to verify. */
+#define NUM_RECORDS     20000
+/* Default size of each record in bytes. */
+#define RECORD_SZ       128
+/* Default number of signing keys. */
+#define NUM_KEYS        1
+/* Maximum number of signing keys. */
+#define MAX_KEYS        64
+/* Default number of verifying threads. */
+#define NUM_THREADS     4
+/* Maximum number of verifying threads. */
+#define MAX_THREADS     256
+/* Default number of records in a batch. */
+#define BATCH_SZ        4096
+/* Number of records a thread claims from a batch at a time. */
+#define VERIFY_CHUNK    16
+/* Largest public key: uncompressed P-256 point. */
+#define MAX_PUB_SZ      (1 + 2 * 32)
+/* Largest signature: DER encoded ECDSA P-256. */
+#define MAX_SIG_SZ      72
+/* Most random data generated in one call. */
+#define RNG_BLOCK_SZ    4096
+/* Number of failing records to print. */
+#define MAX_PRINT_FAIL  10
+
+/* The command line options. */
+#define OPTIONS "?a:n:m:k:t:b:f:"
+
+#if defined(HAVE_ECC) && defined(HAVE_ECC_VERIFY) && defined(HAVE_ECC_SIGN) && \
+    !defined(NO_SHA256)
+
+enum {
+    ALG_ECDSA,
+    ALG_ED25519
+};
+
+/* Public key that records are signed with. */
+typedef struct PubKey {
+    byte   der[MAX_PUB_SZ];
+    word32 sz;
+} PubKey;
+
+/* A signed record and its verification result. */
+typedef struct VerifyItem {
+    const byte* msg;
+    word32      msgSz;
+    byte        sig[MAX_SIG_SZ];
+    word32      sigSz;
+    int         keyIdx;
+    /* 1 when signature verified, 0 otherwise. */
+    int         result;
+} VerifyItem;
+
+/* Batch of records shared by the verifying threads. */
+typedef struct VerifyBatch {
+    int             alg;
+    const PubKey*   keys;
+    int             numKeys;
+    VerifyItem*     items;
+    int             count;
+    /* Index of next record to be claimed by a thread. */
+    int             next;
+    int             ret;
+    pthread_mutex_t lock;
+} VerifyBatch;
+
+/* Public keys imported by one verifying thread. */
+typedef struct Verifier {
+    int          alg;
+    int          numKeys;
+    ecc_key*     ecc;
+#ifdef BATCH_ED25519
+    ed25519_key* ed;
+#endif
+} Verifier;
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static double CurrentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Import a public key into the key object for the algorithm. */
+static int ImportKey(int alg, const PubKey* pub, void* key)
+{
+    int ret;
+
+    if (alg == ALG_ECDSA) {
+        ret = wc_ecc_init((ecc_key*)key);
+        if (ret == 0) {
+            ret = wc_ecc_import_x963_ex(pub->der, pub->sz, (ecc_key*)key,
+                ECC_SECP256R1);
+            if (ret != 0)
+                wc_ecc_free((ecc_key*)key);
+        }
+    }
+#ifdef BATCH_ED25519
+    else {
+        ret = wc_ed25519_init((ed25519_key*)key);
+        if (ret == 0) {
+            ret = wc_ed25519_import_public(pub->der, pub->sz,
+                (ed25519_key*)key);
+            if (ret != 0)
+                wc_ed25519_free((ed25519_key*)key);
+        }
+    }
+#else
+    else {
+        ret = NOT_COMPILED_IN;
+    }
+#endif
+
+    return ret;
+}
+
+static void FreeKey(int alg, void* key)
+{
+    if (alg == ALG_ECDSA)
+        wc_ecc_free((ecc_key*)key);
+#ifdef BATCH_ED25519
+    else
+        wc_ed25519_free((ed25519_key*)key);
+#endif
+}
+
+/* Verify the signature of one record with an imported key. */
+static void VerifyOne(int alg, void* key, VerifyItem* item)
+{
+    int  ret;
+    int  res = 0;
+    byte hash[WC_SHA256_DIGEST_SIZE];
+
+    if (alg == ALG_ECDSA) {
+        ret = wc_Sha256Hash(item->msg, item->msgSz, hash);
+        if (ret == 0) {
+            ret = wc_ecc_verify_hash(item->sig, item->sigSz, hash,
+                sizeof(hash), &res, (ecc_key*)key);
+        }
+    }
+#ifdef BATCH_ED25519
+    else {
+        ret = wc_ed25519_verify_msg(item->sig, item->sigSz, item->msg,
+            item->msgSz, &res, (ed25519_key*)key);
+    }
+#else
+    else {
+        ret = NOT_COMPILED_IN;
+    }
+#endif
+
+    /* A badly encoded signature is a failed record, not a failed batch. */
+    item->result = (ret == 0 && res == 1);
+}
+
+static int Verifier_Init(Verifier* v, int alg, const PubKey* keys,
+    int numKeys)
+{
+    int ret = 0;
+    int i;
+
+    XMEMSET(v, 0, sizeof(*v));
+    v->alg = alg;
+    if (alg == ALG_ECDSA) {
+        v->ecc = (ecc_key*)malloc(sizeof(ecc_key) * numKeys);
+        if (v->ecc == NULL)
+            return MEMORY_E;
+    }
+#ifdef BATCH_ED25519
+    else {
+        v->ed = (ed25519_key*)malloc(sizeof(ed25519_key) * numKeys);
+        if (v->ed == NULL)
+            return MEMORY_E;
+    }
+#endif
+
+    for (i = 0; ret == 0 && i < numKeys; i++) {
+        if (alg == ALG_ECDSA)
+            ret = ImportKey(alg, &keys[i], &v->ecc[i]);
+    #ifdef BATCH_ED25519
+        else
+            ret = ImportKey(alg, &keys[i], &v->ed[i]);
+    #endif
+        if (ret == 0)
+            v->numKeys++;
+    }
+
+    return ret;
+}
+
+static void* Verifier_Key(Verifier* v, int idx)
+{
+#ifdef BATCH_ED25519
+    if (v->alg == ALG_ED25519)
+        return &v->ed[idx];
+#endif
+    return &v->ecc[idx];
+}
+
+static void Verifier_Free(Verifier* v)
+{
+    int i;
+
+    for (i = 0; i < v->numKeys; i++)
+        FreeKey(v->alg, Verifier_Key(v, i));
+    free(v->ecc);
+#ifdef BATCH_ED25519
+    free(v->ed);
+#endif
+#ifdef FP_ECC
+    /* Table of fixed points is kept per thread. */
+    if (v->alg == ALG_ECDSA)
+        wc_ecc_fp_free();
+#endif
+}
+
+/* Claim records from the batch and verify them until all are claimed. */
+static void* Verify_Thread(void* arg)
+{
+    VerifyBatch* batch = (VerifyBatch*)arg;
+    Verifier     v;
+    int          ret;
+    int          start;
+    int          cnt;
+    int          i;
+
+    ret = Verifier_Init(&v, batch->alg, batch->keys, batch->numKeys);
+    if (ret != 0) {
+        pthread_mutex_lock(&batch->lock);
+        if (batch->ret == 0)
+            batch->ret = ret;
+        pthread_mutex_unlock(&batch->lock);
+    }
+
+    while (ret == 0) {
+        pthread_mutex_lock(&batch->lock);
+        start = batch->next;
+        cnt = batch->count - start;
+        if (cnt > VERIFY_CHUNK)
+            cnt = VERIFY_CHUNK;
+        batch->next += cnt;
+        pthread_mutex_unlock(&batch->lock);
+        if (cnt == 0)
+            break;
+
+        for (i = start; i < start + cnt; i++) {
+            VerifyOne(batch->alg, Verifier_Key(&v, batch->items[i].keyIdx),
+                &batch->items[i]);
+        }
+    }
+
+    Verifier_Free(&v);
+    return NULL;
+}
+
+/* Verify all records of a batch with a number of threads.
+ *
+ * Returns the number of records that failed to verify or a negative error
+ * when the batch couldn't be checked.
+ */
+static int VerifyBatch_Run(int alg, const PubKey* keys, int numKeys,
+    VerifyItem* items, int count, int numThreads)
+{
+    int          i;
+    int          started;
+    int          failed = 0;
+    VerifyBatch  batch;
+    pthread_t    tid[MAX_THREADS];
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.alg = alg;
+    batch.keys = keys;
+    batch.numKeys = numKeys;
+    batch.items = items;
+    batch.count = count;
+    pthread_mutex_init(&batch.lock, NULL);
+
+    if (numThreads == 1) {
+        Verify_Thread(&batch);
+    }
+    else {
+        for (started = 0; started < numThreads; started++) {
+            if (pthread_create(&tid[started], NULL, Verify_Thread,
+                    &batch) != 0) {
+                break;
+            }
+        }
+        /* Threads that started verify the records of any that didn't. */
+        if (started == 0)
+            Verify_Thread(&batch);
+        for (i = 0; i < started; i++)
+            pthread_join(tid[i], NULL);
+    }
+    pthread_mutex_destroy(&batch.lock);
+
+    if (batch.ret != 0)
+        return batch.ret;
+    for (i = 0; i < count; i++) {
+        if (!items[i].result)
+            failed++;
+    }
+    return failed;
+}
+
+/* Verify each record importing the key each time, like ecc-verify. */
+static int VerifyPerCall(int alg, const PubKey* keys, VerifyItem* items,
+    int count)
+{
+    int ret = 0;
+    int i;
+    int failed = 0;
+    union {
+        ecc_key     ecc;
+    #ifdef BATCH_ED25519
+        ed25519_key ed;
+    #endif
+    } key;
+
+    for (i = 0; ret == 0 && i < count; i++) {
+        ret = ImportKey(alg, &keys[items[i].keyIdx], &key);
+        if (ret == 0) {
+            VerifyOne(alg, &key, &items[i]);
+            FreeKey(alg, &key);
+            if (!items[i].result)
+                failed++;
+        }
+    }
+
+#ifdef FP_ECC
+    if (alg == ALG_ECDSA)
+        wc_ecc_fp_free();
+#endif
+
+    return (ret != 0) ? ret : failed;
+}
+
+/* Generate the keys and sign the records. */
+static int MakeRecords(int alg, WC_RNG* rng, PubKey* keys, int numKeys,
+    VerifyItem* items, byte* msgs, int count, word32 msgSz)
+{
+    int          ret = 0;
+    int          i;
+    int          made = 0;
+    size_t       off;
+    size_t       len = 0;
+    byte         hash[WC_SHA256_DIGEST_SIZE];
+    ecc_key*     ecc = NULL;
+#ifdef BATCH_ED25519
+    ed25519_key* ed = NULL;
+#endif
+
+    if (alg == ALG_ECDSA)
+        ecc = (ecc_key*)malloc(sizeof(ecc_key) * numKeys);
+#ifdef BATCH_ED25519
+    else
+        ed = (ed25519_key*)malloc(sizeof(ed25519_key) * numKeys);
+    if (ecc == NULL && ed == NULL)
+        return MEMORY_E;
+#else
+    if (ecc == NULL)
+        return MEMORY_E;
+#endif
+
+    for (made = 0; ret == 0 && made < numKeys; made++) {
+        keys[made].sz = sizeof(keys[made].der);
+        if (alg == ALG_ECDSA) {
+            ret = wc_ecc_init(&ecc[made]);
+            if (ret != 0)
+                break;
+            ret = wc_ecc_make_key_ex(rng, 32, &ecc[made], ECC_SECP256R1);
+            if (ret == 0) {
+                ret = wc_ecc_export_x963(&ecc[made], keys[made].der,
+                    &keys[made].sz);
+            }
+        }
+    #ifdef BATCH_ED25519
+        else {
+            ret = wc_ed25519_init(&ed[made]);
+            if (ret != 0)
+                break;
+            ret = wc_ed25519_make_key(rng, ED25519_KEY_SIZE, &ed[made]);
+            if (ret == 0) {
+                ret = wc_ed25519_export_public(&ed[made], keys[made].der,
+                    &keys[made].sz);
+            }
+        }
+    #endif
+    }
+    /* Random content in blocks the RNG can generate in one call. */
+    for (off = 0; ret == 0 && off < (size_t)count * msgSz; off += len) {
+        len = (size_t)count * msgSz - off;
+        if (len > RNG_BLOCK_SZ)
+            len = RNG_BLOCK_SZ;
+        ret = wc_RNG_GenerateBlock(rng, msgs + off, (word32)len);
+    }
+    for (i = 0; ret == 0 && i < count; i++) {
+        items[i].msg = msgs + (size_t)i * msgSz;
+        items[i].msgSz = msgSz;
+        items[i].keyIdx = i % numKeys;
+        items[i].sigSz = sizeof(items[i].sig);
+        if (alg == ALG_ECDSA) {
+            ret = wc_Sha256Hash(items[i].msg, msgSz, hash);
+            if (ret == 0) {
+                ret = wc_ecc_sign_hash(hash, sizeof(hash), items[i].sig,
+                    &items[i].sigSz, rng, &ecc[items[i].keyIdx]);
+            }
+        }
+    #ifdef BATCH_ED25519
+        else {
+            ret = wc_ed25519_sign_msg(items[i].msg, msgSz, items[i].sig,
+                &items[i].sigSz, &ed[items[i].keyIdx]);
+        }
+    #endif
+    }
+
+    for (i = 0; i < made; i++) {
+        if (alg == ALG_ECDSA)
+            wc_ecc_free(&ecc[i]);
+    #ifdef BATCH_ED25519
+        else
+            wc_ed25519_free(&ed[i]);
+    #endif
+    }
+    free(ecc);
+#ifdef BATCH_ED25519
+    free(ed);
+#endif
+
+    return ret;
+}
+
+/* Check the failing records are exactly the corrupted ones. */
+static int CheckFailed(const VerifyItem* items, const byte* corrupt,
+    int count, int print)
+{
+    int i;
+    int printed = 0;
+    int ret = 0;
+
+    for (i = 0; i < count; i++) {
+        if (!items[i].result != corrupt[i]) {
+            fprintf(stderr, "ERROR: record %d %s\n", i, items[i].result ?
+                "verified but was corrupted" : "failed but wasn't corrupted");
+            ret = -1;
+        }
+        else if (print && !items[i].result && printed < MAX_PRINT_FAIL) {
+            printf("Record %d failed to verify\n", i);
+            printed++;
+        }
+    }
+
+    return ret;
+}
+
+static void Usage(void)
+{
+    printf("ecc-verify-batch " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-a <alg>    ecdsa or ed25519, default ecdsa\n");
+    printf("-n <num>    Number of records, default %d\n", NUM_RECORDS);
+    printf("-m <num>    Size of each record in bytes, default %d\n",
+        RECORD_SZ);
+    printf("-k <num>    Number of signing keys, default %d\n", NUM_KEYS);
+    printf("-t <num>    Number of verifying threads, default %d\n",
+        NUM_THREADS);
+    printf("-b <num>    Records in each batch, default %d\n", BATCH_SZ);
+    printf("-f <num>    Number of records to corrupt, default 0\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret = 0;
+    int         ch;
+    int         alg = ALG_ECDSA;
+    int         count = NUM_RECORDS;
+    int         msgSz = RECORD_SZ;
+    int         numKeys = NUM_KEYS;
+    int         numThreads = NUM_THREADS;
+    int         batchSz = BATCH_SZ;
+    int         numCorrupt = 0;
+    int         i;
+    int         j;
+    int         n;
+    int         failed;
+    word32      r;
+    double      start;
+    double      elapsed;
+    double      perCall = 0;
+    char        name[32];
+    WC_RNG      rng;
+    PubKey      keys[MAX_KEYS];
+    VerifyItem* items = NULL;
+    byte*       msgs = NULL;
+    byte*       corrupt = NULL;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'a':
+                if (XSTRCMP(myoptarg, "ecdsa") == 0)
+                    alg = ALG_ECDSA;
+            #ifdef BATCH_ED25519
+                else if (XSTRCMP(myoptarg, "ed25519") == 0)
+                    alg = ALG_ED25519;
+            #endif
+                else {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'n':
+                count = atoi(myoptarg);
+                break;
+            case 'm':
+                msgSz = atoi(myoptarg);
+                break;
+            case 'k':
+                numKeys = atoi(myoptarg);
+                break;
+            case 't':
+                numThreads = atoi(myoptarg);
+                break;
+            case 'b':
+                batchSz = atoi(myoptarg);
+                break;
+            case 'f':
+                numCorrupt = atoi(myoptarg);
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    if (count < 1 || msgSz < 1 || numKeys < 1 || numKeys > MAX_KEYS ||
+            numThreads < 1 || numThreads > MAX_THREADS || batchSz < 1 ||
+            numCorrupt < 0 || numCorrupt > count) {
+        Usage();
+        return 1;
+    }
+
+    wolfCrypt_Init();
+
+    items = (VerifyItem*)calloc(count, sizeof(VerifyItem));
+    msgs = (byte*)malloc((size_t)count * msgSz);
+    corrupt = (byte*)calloc(count, 1);
+    if (items == NULL || msgs == NULL || corrupt == NULL) {
+        ret = MEMORY_E;
+        goto exit;
+    }
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0)
+        goto exit;
+    printf("Signing %d records of %d bytes with %d %s key(s)\n", count, msgSz,
+        numKeys, alg == ALG_ECDSA ? "ECDSA P-256" : "Ed25519");
+    ret = MakeRecords(alg, &rng, keys, numKeys, items, msgs, count,
+        (word32)msgSz);
+    /* Flip a bit in the randomly chosen records. */
+    for (i = 0; ret == 0 && i < numCorrupt; ) {
+        ret = wc_RNG_GenerateBlock(&rng, (byte*)&r, sizeof(r));
+        if (ret == 0 && !corrupt[r % count]) {
+            corrupt[r % count] = 1;
+            msgs[(size_t)(r % count) * msgSz] ^= 0x01;
+            i++;
+        }
+    }
+    wc_FreeRng(&rng);
+    if (ret != 0) {
+        fprintf(stderr, "ERROR: failed to make records: %d\n", ret);
+        goto exit;
+    }
+
+    for (i = 0; ret == 0 && i < 3; i++) {
+        failed = 0;
+        start = CurrentTime();
+        if (i == 0) {
+            snprintf(name, sizeof(name), "per-call");
+            ret = VerifyPerCall(alg, keys, items, count);
+            failed = ret;
+        }
+        else {
+            n = (i == 1) ? 1 : numThreads;
+            snprintf(name, sizeof(name), "batch, %d thread%s", n,
+                n == 1 ? "" : "s");
+            for (j = 0; j < count; j += batchSz) {
+                ret = VerifyBatch_Run(alg, keys, numKeys, items + j,
+                    (count - j < batchSz) ? count - j : batchSz, n);
+                if (ret < 0)
+                    break;
+                failed += ret;
+            }
+        }
+        elapsed = CurrentTime() - start;
+        if (ret < 0) {
+            fprintf(stderr, "ERROR: failed to verify: %d\n", ret);
+            break;
+        }
+        if (i == 0)
+            perCall = elapsed;
+        printf("%-18s : %10.1f verifies/s, %5.2fx, %d failed\n", name,
+            count / elapsed, perCall / elapsed, failed);
+        ret = CheckFailed(items, corrupt, count, i == 2);
+    }
+
+exit:
+    free(corrupt);
+    free(msgs);
+    free(items);
+
+    wolfCrypt_Cleanup();
+
+    return (ret >= 0) ? 0 : 1;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with ECC and SHA-256\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,682 @@
+/* dh-pg-service.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * DH group cache and parameter generation service.
+ *
+ * Groups are checked once, when they are added to the cache: the prime test
+ * of wc_DhSetCheckKey() is the slow part of setting up a key. Workers then
+ * set their keys from the cache as trusted, which skips the test.
+ *
+ * The named FFDHE groups are added at start. Custom parameters are generated
+ * by background threads and added to the cache as each is made, while key
+ * agreements are measured on the named groups. Once generation is done the
+ * custom groups are measured too.
+ *
+ * A key agreement is one side's work: generating a key pair and computing the
+ * secret from the peer's public key.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/dh.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#define MAX_DH_BITS       4096
+#define MAX_DH_Q_SIZE     256
+#define DEF_KA_CHECKS     256
+#define DEF_PARAMS_GEN    4
+#define MAX_THREADS       256
+/* Named groups and custom ones. */
+#define MAX_GROUPS        64
+
+#ifndef NO_DH
+
+/* A checked group in the cache. */
+typedef struct DhGroup {
+    char          name[24];
+    int           bits;
+    unsigned char p[MAX_DH_BITS/8];
+    word32        p_len;
+    unsigned char g[MAX_DH_BITS/8];
+    word32        g_len;
+    unsigned char q[MAX_DH_Q_SIZE/8];
+    word32        q_len;
+    /* Time to check the group, paid once. */
+    double        check;
+} DhGroup;
+
+/* Work and results of a key agreement thread. */
+typedef struct KaWorker {
+    pthread_t      tid;
+    const DhGroup* group;
+    int            checks;
+    int            ret;
+    double         keyGen;
+    double         agree;
+} KaWorker;
+
+static DhGroup         gGroups[MAX_GROUPS];
+static int             gNumGroups;
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef WOLFSSL_KEY_GEN
+static int             gGenBits;
+static int             gGenTotal;
+static int             gGenNext;
+static int             gGenMade;
+static int             gGenErr;
+static double          gGenTime;
+#endif
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Print the buffer as bytes */
+static void print_data(FILE* f, const char *name, const unsigned char *data,
+                       int len)
+{
+    int i;
+    fprintf(f, "static unsigned char %s[%d] = {\n", name, len);
+    for (i = 0; i < len; i++) {
+        if ((i & 7) == 0) {
+            fprintf(f, "    ");
+        }
+        fprintf(f, "0x%02x, ", data[i]);
+        if ((i & 7) == 7) {
+            fprintf(f, "\n");
+        }
+    }
+    if ((i & 7) != 0) {
+        fprintf(f, "\n");
+    }
+    fprintf(f, "};\n");
+}
+
+/* Check a group and add it to the cache. */
+static int cache_add(const char* name, int bits, const unsigned char* p,
+                     word32 p_len, const unsigned char* g, word32 g_len,
+                     const unsigned char* q, word32 q_len, WC_RNG* rng)
+{
+    int     ret;
+    DhKey   key;
+    DhGroup* group;
+    double  start;
+
+    if (p_len > sizeof(group->p) || g_len > sizeof(group->g) ||
+            q_len > sizeof(group->q))
+        return BAD_FUNC_ARG;
+
+    ret = wc_InitDhKey(&key);
+    if (ret != 0)
+        return ret;
+    /* Not trusted: p (and q when given) are tested for primality. */
+    start = now();
+    ret = wc_DhSetCheckKey(&key, p, p_len, g, g_len, q_len > 0 ? q : NULL,
+                           q_len, 0, rng);
+    wc_FreeDhKey(&key);
+    if (ret != 0)
+        return ret;
+
+    pthread_mutex_lock(&gLock);
+    if (gNumGroups == MAX_GROUPS) {
+        ret = BUFFER_E;
+    }
+    else {
+        group = &gGroups[gNumGroups];
+        snprintf(group->name, sizeof(group->name), "%s", name);
+        group->bits = bits;
+        XMEMCPY(group->p, p, p_len);
+        group->p_len = p_len;
+        XMEMCPY(group->g, g, g_len);
+        group->g_len = g_len;
+        if (q_len > 0)
+            XMEMCPY(group->q, q, q_len);
+        group->q_len = q_len;
+        group->check = now() - start;
+        gNumGroups++;
+    }
+    pthread_mutex_unlock(&gLock);
+
+    return ret;
+}
+
+/* Set a key from a cached group. It was checked when it was added. */
+static int cache_set_key(const DhGroup* group, DhKey* key, WC_RNG* rng)
+{
+    return wc_DhSetCheckKey(key, group->p, group->p_len, group->g,
+                            group->g_len, group->q_len > 0 ? group->q : NULL,
+                            group->q_len, 1, rng);
+}
+
+/* Add the named FFDHE groups of the sizes in the list. */
+static int cache_add_ffdhe(const char* bitsList, WC_RNG* rng)
+{
+    int             ret = 0;
+    int             bits;
+    const char*     s = bitsList;
+    const DhParams* params;
+    char            name[24];
+
+    while (ret == 0 && *s != '\0') {
+        bits = atoi(s);
+        s += strcspn(s, ",");
+        s += (*s == ',');
+
+        params = NULL;
+        if (0) {
+        }
+#ifdef HAVE_FFDHE_2048
+        else if (bits == 2048) {
+            params = wc_Dh_ffdhe2048_Get();
+        }
+#endif
+#ifdef HAVE_FFDHE_3072
+        else if (bits == 3072) {
+            params = wc_Dh_ffdhe3072_Get();
+        }
+#endif
+#ifdef HAVE_FFDHE_4096
+        else if (bits == 4096) {
+            params = wc_Dh_ffdhe4096_Get();
+        }
+#endif
+        if (params == NULL) {
+            fprintf(stderr, "Unsupported FFDHE parameters: %d\n", bits);
+            continue;
+        }
+
+        snprintf(name, sizeof(name), "ffdhe%d", bits);
+        ret = cache_add(name, bits, params->p, params->p_len, params->g,
+                        params->g_len, NULL, 0, rng);
+        if (ret != 0) {
+            fprintf(stderr, "Failed to check %s: %d\n", name, ret);
+        }
+    }
+
+    return ret;
+}
+
+#ifdef WOLFSSL_KEY_GEN
+/* Generate parameters until enough are made, adding each to the cache. */
+static void* gen_thread(void* arg)
+{
+    int           ret;
+    int           n;
+    WC_RNG        rng;
+    DhKey         key;
+    unsigned char p[MAX_DH_BITS/8];
+    unsigned char g[MAX_DH_BITS/8];
+    unsigned char q[MAX_DH_Q_SIZE/8];
+    word32        p_len, g_len, q_len;
+    char          name[24];
+
+    (void)arg;
+
+    ret = wc_InitRng(&rng);
+    while (ret == 0) {
+        pthread_mutex_lock(&gLock);
+        n = (gGenErr == 0 && gGenNext < gGenTotal) ? ++gGenNext : 0;
+        pthread_mutex_unlock(&gLock);
+        if (n == 0)
+            break;
+
+        ret = wc_InitDhKey(&key);
+        if (ret == 0) {
+            ret = wc_DhGenerateParams(&rng, gGenBits, &key);
+            if (ret == 0) {
+                p_len = sizeof(p);
+                q_len = sizeof(q);
+                g_len = sizeof(g);
+                ret = wc_DhExportParamsRaw(&key, p, &p_len, q, &q_len, g,
+                                           &g_len);
+            }
+            wc_FreeDhKey(&key);
+        }
+        if (ret == 0) {
+            snprintf(name, sizeof(name), "custom%d-%d", gGenBits, n);
+            ret = cache_add(name, gGenBits, p, p_len, g, g_len, q, q_len,
+                            &rng);
+        }
+        if (ret == 0) {
+            pthread_mutex_lock(&gLock);
+            gGenMade++;
+            pthread_mutex_unlock(&gLock);
+        }
+    }
+    wc_FreeRng(&rng);
+
+    if (ret != 0) {
+        pthread_mutex_lock(&gLock);
+        if (gGenErr == 0)
+            gGenErr = ret;
+        pthread_mutex_unlock(&gLock);
+    }
+
+    return NULL;
+}
+
+/* Wait for the generating threads and report. */
+static int gen_finish(pthread_t* tids, int started, double start)
+{
+    int i;
+
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    gGenTime = now() - start;
+
+    if (gGenErr != 0) {
+        fprintf(stderr, "Failed to generate DH params: %d\n", gGenErr);
+        return gGenErr;
+    }
+    printf("Generated %d %d-bit parameter sets with %d threads in %.2f s, "
+           "%.2f per minute\n", gGenMade, gGenBits, started, gGenTime,
+           gGenMade * 60 / gGenTime);
+
+    return 0;
+}
+
+/* Write the first custom group in the format of dh-params.h. */
+static int write_params(const char* fileName)
+{
+    int   i;
+    FILE* f;
+
+    for (i = 0; i < gNumGroups; i++) {
+        if (gGroups[i].q_len > 0)
+            break;
+    }
+    if (i == gNumGroups)
+        return BAD_FUNC_ARG;
+
+    f = fopen(fileName, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Unable to write %s\n", fileName);
+        return -1;
+    }
+    print_data(f, "dh_p", gGroups[i].p, gGroups[i].p_len);
+    print_data(f, "dh_g", gGroups[i].g, gGroups[i].g_len);
+    print_data(f, "dh_q", gGroups[i].q, gGroups[i].q_len);
+    fclose(f);
+    printf("Wrote %s to %s\n", gGroups[i].name, fileName);
+
+    return 0;
+}
+#endif /* WOLFSSL_KEY_GEN */
+
+/* Perform key agreements with a cached group. */
+static void* ka_thread(void* arg)
+{
+    KaWorker*     w = (KaWorker*)arg;
+    int           ret;
+    int           i;
+    WC_RNG        rng;
+    DhKey         key;
+    unsigned char priv1[MAX_DH_BITS/8], priv2[MAX_DH_BITS/8];
+    unsigned char pub1[MAX_DH_BITS/8], pub2[MAX_DH_BITS/8];
+    unsigned char secret1[MAX_DH_BITS/8], secret2[MAX_DH_BITS/8];
+    word32        priv1_len, priv2_len, pub1_len, pub2_len;
+    word32        secret1_len, secret2_len;
+    double        start;
+
+    ret = wc_InitRng(&rng);
+    if (ret == 0) {
+        ret = wc_InitDhKey(&key);
+        if (ret == 0) {
+            ret = cache_set_key(w->group, &key, &rng);
+        }
+        /* Each check is two agreements: one for each peer. */
+        for (i = 0; ret == 0 && i < w->checks; i++) {
+            priv1_len = sizeof(priv1);
+            pub1_len = sizeof(pub1);
+            priv2_len = sizeof(priv2);
+            pub2_len = sizeof(pub2);
+            start = now();
+            ret = wc_DhGenerateKeyPair(&key, &rng, priv1, &priv1_len, pub1,
+                                       &pub1_len);
+            if (ret == 0) {
+                ret = wc_DhGenerateKeyPair(&key, &rng, priv2, &priv2_len,
+                                           pub2, &pub2_len);
+            }
+            w->keyGen += now() - start;
+
+            start = now();
+            if (ret == 0) {
+                secret1_len = sizeof(secret1);
+                ret = wc_DhAgree(&key, secret1, &secret1_len, priv1,
+                                 priv1_len, pub2, pub2_len);
+            }
+            if (ret == 0) {
+                secret2_len = sizeof(secret2);
+                ret = wc_DhAgree(&key, secret2, &secret2_len, priv2,
+                                 priv2_len, pub1, pub1_len);
+            }
+            w->agree += now() - start;
+
+            if (ret == 0 && ((secret1_len != secret2_len) ||
+                    (XMEMCMP(secret1, secret2, secret1_len) != 0))) {
+                ret = -1;
+            }
+        }
+        wc_FreeDhKey(&key);
+        wc_FreeRng(&rng);
+    }
+
+    w->ret = ret;
+    return NULL;
+}
+
+/* Measure key agreements/s with a group on one thread and on all. */
+static int run_ka(const DhGroup* group, int numThreads, int checks)
+{
+    int       ret = 0;
+    int       t;
+    int       i;
+    int       started;
+    double    start;
+    double    elapsed;
+    double    single = 0;
+    double    keyGen;
+    double    agree;
+    KaWorker  workers[MAX_THREADS];
+
+    for (t = 1; ret == 0; t = numThreads) {
+        XMEMSET(workers, 0, sizeof(workers));
+        start = now();
+        for (started = 0; started < t; started++) {
+            workers[started].group = group;
+            workers[started].checks = checks;
+            if (pthread_create(&workers[started].tid, NULL, ka_thread,
+                               &workers[started]) != 0) {
+                fprintf(stderr, "Failed to start worker %d\n", started);
+                break;
+            }
+        }
+        keyGen = 0;
+        agree = 0;
+        for (i = 0; i < started; i++) {
+            pthread_join(workers[i].tid, NULL);
+            if (workers[i].ret != 0 && ret == 0)
+                ret = workers[i].ret;
+            keyGen += workers[i].keyGen;
+            agree += workers[i].agree;
+        }
+        elapsed = now() - start;
+        if (started == 0)
+            ret = -1;
+
+        if (ret != 0) {
+            fprintf(stderr, "Key agreement with %s failed: %d\n", group->name,
+                    ret);
+            break;
+        }
+        if (t == 1)
+            single = elapsed;
+        printf("%-16s  %7d  %10.1f  %9.3f  %9.3f  %6.2fx\n", group->name,
+               started, 2.0 * checks * started / elapsed,
+               keyGen * 1000 / (2.0 * checks * started),
+               agree * 1000 / (2.0 * checks * started), single / elapsed);
+        if (t == numThreads)
+            break;
+    }
+
+    return ret;
+}
+
+static void print_ka_header(void)
+{
+    printf("%-16s  %7s  %10s  %9s  %9s  %7s\n", "Group", "Threads",
+           "Agrees/s", "KeyGen ms", "Agree ms", "Speedup");
+}
+
+/* Show usage information */
+static void usage(void)
+{
+    fprintf(stderr, "dh-pg-service <options>:\n");
+    fprintf(stderr, "  -bits <list>       FFDHE group sizes to cache, comma "
+                    "separated\n");
+    fprintf(stderr, "                     Default 2048,3072,4096\n");
+    fprintf(stderr, "  -threads <num>     Number of key agreement threads, "
+                    "default: number of cores\n");
+    fprintf(stderr, "  -checks <num>      Key exchanges per thread, default "
+                    "%d\n", DEF_KA_CHECKS);
+#ifdef WOLFSSL_KEY_GEN
+    fprintf(stderr, "  -gen <bits>        Generate custom parameters in the "
+                    "background: 2048 or 3072\n");
+    fprintf(stderr, "  -num-gen <num>     Number of params to generate, "
+                    "default %d\n", DEF_PARAMS_GEN);
+    fprintf(stderr, "  -gen-threads <num> Number of generating threads, "
+                    "default 1\n");
+    fprintf(stderr, "  -out <file>        Write the first custom params in "
+                    "the format of dh-params.h\n");
+#endif
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int         ret = 0;
+    int         i;
+    int         numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int         checks = DEF_KA_CHECKS;
+    int         numNamed;
+    const char* bitsList = "2048,3072,4096";
+    WC_RNG      rng;
+#ifdef WOLFSSL_KEY_GEN
+    int         genThreads = 1;
+    int         genStarted = 0;
+    const char* outFile = NULL;
+    double      genStart = 0;
+    pthread_t   genTids[MAX_THREADS];
+#endif
+
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > MAX_THREADS)
+        numThreads = MAX_THREADS;
+#ifdef WOLFSSL_KEY_GEN
+    gGenTotal = DEF_PARAMS_GEN;
+#endif
+
+    /* Skip the program name */
+    --argc;
+    ++argv;
+
+    /* Process the command line arguments */
+    while (argc > 0) {
+        /* Display usage information */
+        if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        /* Sizes of FFDHE groups to cache */
+        else if (XSTRNCMP(*argv, "-bits", 6) == 0) {
+            bitsList = *++argv;
+            argc--;
+        }
+        /* Number of key agreement threads */
+        else if (XSTRNCMP(*argv, "-threads", 9) == 0) {
+            numThreads = atoi(*++argv);
+            argc--;
+        }
+        /* Number of key exchanges per thread */
+        else if (XSTRNCMP(*argv, "-checks", 8) == 0) {
+            checks = atoi(*++argv);
+            argc--;
+        }
+#ifdef WOLFSSL_KEY_GEN
+        /* Size of custom parameters to generate */
+        else if (XSTRNCMP(*argv, "-gen", 5) == 0) {
+            gGenBits = atoi(*++argv);
+            argc--;
+        }
+        /* Number of custom parameters to generate */
+        else if (XSTRNCMP(*argv, "-num-gen", 9) == 0) {
+            gGenTotal = atoi(*++argv);
+            argc--;
+        }
+        /* Number of generating threads */
+        else if (XSTRNCMP(*argv, "-gen-threads", 13) == 0) {
+            genThreads = atoi(*++argv);
+            argc--;
+        }
+        /* File to write custom parameters to */
+        else if (XSTRNCMP(*argv, "-out", 5) == 0) {
+            outFile = *++argv;
+            argc--;
+        }
+#endif
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        --argc;
+        ++argv;
+    }
+
+    if (numThreads < 1 || numThreads > MAX_THREADS || checks < 1) {
+        fprintf(stderr, "Threads must be 1-%d, checks at least 1\n",
+                MAX_THREADS);
+        usage();
+        return 1;
+    }
+#ifdef WOLFSSL_KEY_GEN
+    if (gGenBits != 0 && ((gGenBits != 2048 && gGenBits != 3072) ||
+            gGenTotal < 1 || gGenTotal > MAX_GROUPS - 3 || genThreads < 1 ||
+            genThreads > MAX_THREADS)) {
+        fprintf(stderr, "Generate 1-%d sets of 2048 or 3072-bit params with "
+                "1-%d threads\n", MAX_GROUPS - 3, MAX_THREADS);
+        usage();
+        return 1;
+    }
+#endif
+
+    /* Initialise a random number generator for checking */
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to initialize random\n");
+        return 1;
+    }
+
+    /* Named groups first: custom ones are added after them. */
+    ret = cache_add_ffdhe(bitsList, &rng);
+    numNamed = gNumGroups;
+
+#ifdef WOLFSSL_KEY_GEN
+    /* Generate custom parameters while the named groups are in use. */
+    if (ret == 0 && gGenBits != 0) {
+        genStart = now();
+        for (genStarted = 0; genStarted < genThreads; genStarted++) {
+            if (pthread_create(&genTids[genStarted], NULL, gen_thread,
+                               NULL) != 0) {
+                fprintf(stderr, "Failed to start generating thread %d\n",
+                        genStarted);
+                break;
+            }
+        }
+        printf("Generating %d %d-bit parameter sets on %d threads in the "
+               "background\n", gGenTotal, gGenBits, genStarted);
+    }
+#endif
+
+    if (ret == 0 && numNamed > 0) {
+        printf("\n%-16s  %12s  %14s\n", "Group", "Check ms",
+               "Cached set ms");
+        for (i = 0; ret == 0 && i < numNamed; i++) {
+            DhKey  key;
+            double start;
+
+            /* Compare with setting a key from the cache. */
+            ret = wc_InitDhKey(&key);
+            if (ret == 0) {
+                start = now();
+                ret = cache_set_key(&gGroups[i], &key, &rng);
+                if (ret == 0) {
+                    printf("%-16s  %12.3f  %14.3f\n", gGroups[i].name,
+                           gGroups[i].check * 1000, (now() - start) * 1000);
+                }
+                wc_FreeDhKey(&key);
+            }
+        }
+
+        printf("\n");
+        print_ka_header();
+        for (i = 0; ret == 0 && i < numNamed; i++) {
+            ret = run_ka(&gGroups[i], numThreads, checks);
+        }
+    }
+
+#ifdef WOLFSSL_KEY_GEN
+    if (gGenBits != 0) {
+        int err;
+
+        printf("\n");
+        err = gen_finish(genTids, genStarted, genStart);
+        if (ret == 0)
+            ret = err;
+        if (ret == 0 && gNumGroups > numNamed) {
+            printf("\n");
+            print_ka_header();
+            ret = run_ka(&gGroups[numNamed], numThreads, checks);
+        }
+        if (ret == 0 && outFile != NULL) {
+            ret = write_params(outFile);
+        }
+    }
+#endif
+
+    wc_FreeRng(&rng);
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    printf("wolfSSL missing build features.\n");
+    printf("Please build without `--disable-dh`\n");
+    return 1;
+}
+
+#endif /* NO_DH */
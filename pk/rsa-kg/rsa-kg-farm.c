@@ -0,0 +1,866 @@
+/* rsa-kg-farm.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/*
+* RSA key generation farm using wolfSSL
+*
+* Worker threads, one per core by default, generate RSA keys into a pool for
+* each key size. Each worker has its own RNG and generates a whole key, so
+* the prime searches of different keys run on all cores at once. Workers
+* refill the pool that is emptiest, relative to its size, in the background.
+*
+* Usage:
+./rsa-kg-farm -bench [-bits 2048,3072,4096] [-threads <num>] [-n <num>]
+./rsa-kg-farm -serve [-bits 2048,3072] [-pool <num>] [-sock <path>]
+./rsa-kg-farm -get <bits> [-n <num>] [-priv <file>] [-pub <file>]
+*
+* The service hands out private keys in DER over a Unix socket:
+*   request:  u32 bits
+*   response: u32 length, then the DER encoded private key
+*             - a length of 0 means keys of that size aren't generated.
+* Integers are in network byte order.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/rsa.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#define MAX_DER_SIZE        2500
+#define MIN_RSA_KEY_SIZE    1024
+#define MAX_RSA_KEY_SIZE    4096
+#define DEF_RSA_KEY_SIZE    2048
+/* Most key sizes generated at once. */
+#define MAX_POOLS           8
+/* Default number of keys kept in each pool. */
+#define DEF_POOL_SIZE       16
+/* Default number of keys generated or fetched. */
+#define DEF_NUM_KEYS        8
+/* Most worker threads. */
+#define MAX_THREADS         256
+
+static const char* kSockPath = "/tmp/rsa-kg-farm.sock";
+static const char* kRsaPubKey = "./rsa-public.der";
+static const char* kRsaPrivKey = "./rsa-private.der";
+
+#if !defined(NO_RSA) && defined(WOLFSSL_KEY_GEN)
+
+/* Pool of generated keys of one size. */
+typedef struct KeyPool {
+    int     bits;
+    /* Number of keys to keep in the pool. */
+    int     target;
+    /* Ring of DER encoded private keys. */
+    byte**  der;
+    word32* derSz;
+    int     head;
+    int     count;
+    /* Number of keys being generated for the pool. */
+    int     inProgress;
+    long    made;
+    long    served;
+    /* Number of times a key was asked for and the pool was empty. */
+    long    empty;
+} KeyPool;
+
+/* A client connection of the service. */
+typedef struct Conn {
+    pthread_t    tid;
+    int          fd;
+    /* Set by the connection thread when it is ready to be joined. */
+    int          done;
+    struct Conn* next;
+} Conn;
+
+static KeyPool         gPools[MAX_POOLS];
+static int             gNumPools;
+static int             gStop;
+static int             gGenErr;
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+/* Signalled when there is room in a pool. */
+static pthread_cond_t  gNeedKey = PTHREAD_COND_INITIALIZER;
+/* Signalled when a key is added to a pool. */
+static pthread_cond_t  gHaveKey = PTHREAD_COND_INITIALIZER;
+static volatile int    gInterrupted;
+/* Connections being served - changed under lock. */
+static Conn*           gConns;
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static void sig_int_handler(int sig)
+{
+    (void)sig;
+    gInterrupted = 1;
+}
+
+/* Check the key size can be generated with this build of wolfSSL. */
+static int check_bits(int bits)
+{
+    if ((bits < MIN_RSA_KEY_SIZE || bits > MAX_RSA_KEY_SIZE)) {
+        fprintf(stderr, "Bits out of range (%d-%d): %d\n", MIN_RSA_KEY_SIZE,
+                MAX_RSA_KEY_SIZE, bits);
+        return 0;
+    }
+#ifdef WOLFSSL_SP_MATH
+    if (0) {
+    }
+#ifndef WOLFSSL_SP_NO_2048
+    else if (bits == 2048) {
+    }
+#endif
+#ifndef WOLFSSL_SP_NO_3072
+    else if (bits == 3072) {
+    }
+#endif
+#ifdef WOLFSSL_SP_4096
+    else if (bits == 4096) {
+    }
+#endif
+    else {
+        fprintf(stderr, "Bit size not supported with SP_MATH: %d\n", bits);
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+/* Create a pool for each size in the comma separated list. */
+static int add_pools(const char* list, int target)
+{
+    const char* p = list;
+    int         bits;
+    KeyPool*    pool;
+
+    while (*p != '\0') {
+        bits = atoi(p);
+        if (!check_bits(bits) || gNumPools == MAX_POOLS)
+            return 0;
+
+        pool = &gPools[gNumPools];
+        memset(pool, 0, sizeof(*pool));
+        pool->bits = bits;
+        pool->target = target;
+        pool->der = (byte**)calloc(target, sizeof(byte*));
+        pool->derSz = (word32*)calloc(target, sizeof(word32));
+        if (pool->der == NULL || pool->derSz == NULL) {
+            free(pool->der);
+            free(pool->derSz);
+            return 0;
+        }
+        gNumPools++;
+
+        p = strchr(p, ',');
+        if (p == NULL)
+            break;
+        p++;
+    }
+
+    return gNumPools > 0;
+}
+
+static void free_pools(void)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < gNumPools; i++) {
+        for (j = 0; j < gPools[i].count; j++) {
+            free(gPools[i].der[(gPools[i].head + j) % gPools[i].target]);
+        }
+        free(gPools[i].der);
+        free(gPools[i].derSz);
+    }
+    gNumPools = 0;
+}
+
+/* Pick the pool with the fewest keys, relative to its size, that isn't
+ * full. Call with lock held. */
+static KeyPool* pool_to_fill(void)
+{
+    int      i;
+    int      have;
+    KeyPool* pool = NULL;
+
+    for (i = 0; i < gNumPools; i++) {
+        have = gPools[i].count + gPools[i].inProgress;
+        if (have < gPools[i].target && (pool == NULL ||
+                have * pool->target <
+                (pool->count + pool->inProgress) * gPools[i].target)) {
+            pool = &gPools[i];
+        }
+    }
+
+    return pool;
+}
+
+/* Generate a key and encode it as DER. */
+static int gen_key(WC_RNG* rng, RsaKey* key, int bits, byte** der,
+    word32* derSz)
+{
+    int  ret;
+    byte derBuf[MAX_DER_SIZE];
+
+    ret = wc_InitRsaKey(key, NULL);
+    if (ret != 0)
+        return ret;
+    ret = wc_MakeRsaKey(key, bits, WC_RSA_EXPONENT, rng);
+    if (ret == 0) {
+        ret = wc_RsaKeyToDer(key, derBuf, sizeof(derBuf));
+        if (ret > 0) {
+            *derSz = (word32)ret;
+            *der = (byte*)malloc(*derSz);
+            if (*der == NULL)
+                ret = MEMORY_E;
+            else {
+                memcpy(*der, derBuf, *derSz);
+                ret = 0;
+            }
+        }
+        else if (ret == 0) {
+            ret = BUFFER_E;
+        }
+    }
+    wc_FreeRsaKey(key);
+
+    return ret;
+}
+
+/* Generate keys into the pools until stopped. */
+static void* worker_thread(void* arg)
+{
+    int      ret;
+    WC_RNG   rng;
+    RsaKey*  key;
+    KeyPool* pool;
+    byte*    der = NULL;
+    word32   derSz = 0;
+
+    (void)arg;
+
+    key = (RsaKey*)malloc(sizeof(RsaKey));
+    if (key == NULL)
+        ret = MEMORY_E;
+    else
+        ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        pthread_mutex_lock(&gLock);
+        gGenErr = ret;
+        pthread_cond_broadcast(&gHaveKey);
+        pthread_mutex_unlock(&gLock);
+        free(key);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&gLock);
+    while (!gStop) {
+        pool = pool_to_fill();
+        if (pool == NULL) {
+            pthread_cond_wait(&gNeedKey, &gLock);
+            continue;
+        }
+        pool->inProgress++;
+        pthread_mutex_unlock(&gLock);
+
+        /* The prime search takes the time - done outside the lock. */
+        ret = gen_key(&rng, key, pool->bits, &der, &derSz);
+
+        pthread_mutex_lock(&gLock);
+        pool->inProgress--;
+        if (ret != 0) {
+            fprintf(stderr, "Failed to generate %d-bit key: %d\n",
+                    pool->bits, ret);
+            gGenErr = ret;
+            pthread_cond_broadcast(&gHaveKey);
+            break;
+        }
+        pool->der[(pool->head + pool->count) % pool->target] = der;
+        pool->derSz[(pool->head + pool->count) % pool->target] = derSz;
+        pool->count++;
+        pool->made++;
+        pthread_cond_broadcast(&gHaveKey);
+    }
+    pthread_mutex_unlock(&gLock);
+
+    wc_FreeRng(&rng);
+    free(key);
+    return NULL;
+}
+
+/* Take a key from the pool for the size, waiting for one if empty.
+ * Caller frees the DER. Returns 0 when no pool for size or on error. */
+static word32 take_key(int bits, byte** der)
+{
+    int      i;
+    word32   derSz = 0;
+    KeyPool* pool = NULL;
+
+    for (i = 0; i < gNumPools; i++) {
+        if (gPools[i].bits == bits)
+            pool = &gPools[i];
+    }
+    if (pool == NULL)
+        return 0;
+
+    pthread_mutex_lock(&gLock);
+    if (pool->count == 0)
+        pool->empty++;
+    while (pool->count == 0 && !gStop && gGenErr == 0)
+        pthread_cond_wait(&gHaveKey, &gLock);
+    if (pool->count > 0) {
+        *der = pool->der[pool->head];
+        derSz = pool->derSz[pool->head];
+        pool->head = (pool->head + 1) % pool->target;
+        pool->count--;
+        pool->served++;
+        /* Room in the pool - a worker refills it. */
+        pthread_cond_signal(&gNeedKey);
+    }
+    pthread_mutex_unlock(&gLock);
+
+    return derSz;
+}
+
+static int start_workers(pthread_t* tids, int numThreads)
+{
+    int i;
+
+    gStop = 0;
+    gGenErr = 0;
+    for (i = 0; i < numThreads; i++) {
+        if (pthread_create(&tids[i], NULL, worker_thread, NULL) != 0) {
+            fprintf(stderr, "Failed to start worker %d\n", i);
+            break;
+        }
+    }
+
+    return i;
+}
+
+static void stop_workers(pthread_t* tids, int numThreads)
+{
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    gStop = 1;
+    pthread_cond_broadcast(&gNeedKey);
+    pthread_cond_broadcast(&gHaveKey);
+    pthread_mutex_unlock(&gLock);
+    /* Workers finish the key they are generating. */
+    for (i = 0; i < numThreads; i++)
+        pthread_join(tids[i], NULL);
+}
+
+/* Measure keys/minute for each size with one worker and with all. */
+static int run_bench(const char* bitsList, int numThreads, int numKeys)
+{
+    int       ret = 0;
+    int       t;
+    int       n;
+    int       started;
+    double    start;
+    double    elapsed;
+    double    single = 0;
+    char      bits[16];
+    const char* s = bitsList;
+    pthread_t tids[MAX_THREADS];
+
+    printf("%6s  %7s  %6s  %10s  %11s  %7s\n", "Bits", "Threads", "Keys",
+           "Seconds", "Keys/minute", "Speedup");
+    while (ret == 0 && *s != '\0') {
+        /* One size at a time so the rates are per size. */
+        n = (int)strcspn(s, ",");
+        snprintf(bits, sizeof(bits), "%.*s", n, s);
+        s += n + (s[n] == ',');
+
+        for (t = 1; ret == 0; t = numThreads) {
+            if (!add_pools(bits, numKeys)) {
+                ret = BAD_FUNC_ARG;
+                break;
+            }
+            start = now();
+            started = start_workers(tids, t);
+            pthread_mutex_lock(&gLock);
+            while (started > 0 && gPools[0].made < numKeys && gGenErr == 0)
+                pthread_cond_wait(&gHaveKey, &gLock);
+            ret = (started > 0) ? gGenErr : -1;
+            pthread_mutex_unlock(&gLock);
+            elapsed = now() - start;
+            stop_workers(tids, started);
+
+            if (ret == 0) {
+                if (t == 1)
+                    single = elapsed;
+                printf("%6d  %7d  %6d  %10.2f  %11.1f  %6.2fx\n",
+                       gPools[0].bits, started, numKeys, elapsed,
+                       numKeys * 60 / elapsed, single / elapsed);
+            }
+            free_pools();
+            if (t == numThreads)
+                break;
+        }
+    }
+
+    return ret;
+}
+
+static int read_full(int fd, void* buf, size_t len)
+{
+    ssize_t n;
+    byte*   p = (byte*)buf;
+
+    while (len > 0) {
+        n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void* buf, size_t len)
+{
+    ssize_t     n;
+    const byte* p = (const byte*)buf;
+
+    while (len > 0) {
+        n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Hand out keys to a client until it disconnects or the service stops.
+ * The socket is closed when the thread is joined. */
+static void* conn_thread(void* arg)
+{
+    int    ret = 0;
+    Conn*  conn = (Conn*)arg;
+    int    fd = conn->fd;
+    word32 bits;
+    word32 derSz;
+    word32 len;
+    byte*  der = NULL;
+
+    while (read_full(fd, &bits, sizeof(bits)) == 0) {
+        derSz = take_key((int)ntohl(bits), &der);
+        len = htonl(derSz);
+        ret = write_full(fd, &len, sizeof(len));
+        if (ret == 0 && derSz > 0)
+            ret = write_full(fd, der, derSz);
+        if (der != NULL) {
+            /* Private key is no longer needed here. */
+            memset(der, 0, derSz);
+            free(der);
+            der = NULL;
+        }
+        if (ret != 0)
+            break;
+    }
+
+    pthread_mutex_lock(&gLock);
+    conn->done = 1;
+    pthread_mutex_unlock(&gLock);
+    return NULL;
+}
+
+/* Join the connection threads that are done, or all when stopping. */
+static void reap_conns(int all)
+{
+    Conn*  conn;
+    Conn** prev = &gConns;
+
+    pthread_mutex_lock(&gLock);
+    while ((conn = *prev) != NULL) {
+        if (!all && !conn->done) {
+            prev = &conn->next;
+            continue;
+        }
+        *prev = conn->next;
+        /* Thread may be waiting for a key - gStop wakes it. */
+        pthread_mutex_unlock(&gLock);
+        pthread_join(conn->tid, NULL);
+        close(conn->fd);
+        free(conn);
+        pthread_mutex_lock(&gLock);
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+static int run_server(const char* path, int numThreads)
+{
+    int                ret = 0;
+    int                i;
+    int                listenFd;
+    int                fd;
+    int                started;
+    Conn*              conn;
+    pthread_t          tids[MAX_THREADS];
+    struct sockaddr_un addr;
+    struct sigaction   sa;
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        fprintf(stderr, "Failed to create socket\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(listenFd, 16) != 0) {
+        fprintf(stderr, "Failed to listen on %s\n", path);
+        close(listenFd);
+        return -1;
+    }
+
+    /* Interrupt accept so the statistics are printed. */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sig_int_handler;
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    started = start_workers(tids, numThreads);
+    if (started == 0) {
+        close(listenFd);
+        unlink(path);
+        return -1;
+    }
+    printf("Generating with %d threads, serving on %s - ^C to stop\n",
+           started, path);
+    while (!gInterrupted) {
+        fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Failed to accept\n");
+            ret = -1;
+            break;
+        }
+        reap_conns(0);
+
+        conn = (Conn*)calloc(1, sizeof(Conn));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        pthread_mutex_lock(&gLock);
+        if (pthread_create(&conn->tid, NULL, conn_thread, conn) != 0) {
+            pthread_mutex_unlock(&gLock);
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = gConns;
+        gConns = conn;
+        pthread_mutex_unlock(&gLock);
+    }
+    close(listenFd);
+    unlink(path);
+
+    /* Wake connection threads reading requests. Those waiting for a key are
+     * woken by stopping the workers. All are joined before the pools are
+     * freed. */
+    pthread_mutex_lock(&gLock);
+    for (conn = gConns; conn != NULL; conn = conn->next)
+        shutdown(conn->fd, SHUT_RDWR);
+    pthread_mutex_unlock(&gLock);
+    stop_workers(tids, started);
+    reap_conns(1);
+
+    printf("%6s  %8s  %8s  %8s  %8s\n", "Bits", "Made", "Served", "Pooled",
+           "Empty");
+    for (i = 0; i < gNumPools; i++) {
+        printf("%6d  %8ld  %8ld  %8d  %8ld\n", gPools[i].bits, gPools[i].made,
+               gPools[i].served, gPools[i].count, gPools[i].empty);
+    }
+
+    return ret;
+}
+
+static int write_file(const char* name, const byte* der, int sz)
+{
+    FILE* f;
+
+    if (sz <= 0) {
+        fprintf(stderr, "Failed to encode %s: %d\n", name, sz);
+        return -1;
+    }
+    f = fopen(name, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Unable to write %s\n", name);
+        return -1;
+    }
+    fwrite(der, 1, sz, f);
+    fclose(f);
+    printf("Writing key to %s\n", name);
+
+    return 0;
+}
+
+/* Fetch keys from the service and write the last one out. */
+static int run_client(const char* path, int bits, int numKeys,
+    const char* privKey, const char* pubKey)
+{
+    int                ret = 0;
+    int                i;
+    int                fd;
+    word32             req = htonl((word32)bits);
+    word32             len = 0;
+    word32             idx = 0;
+    double             start;
+    double             elapsed;
+    byte               der[MAX_DER_SIZE];
+    byte               pubDer[MAX_DER_SIZE];
+    RsaKey             key;
+    struct sockaddr_un addr;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Failed to connect to %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    start = now();
+    for (i = 0; ret == 0 && i < numKeys; i++) {
+        if (write_full(fd, &req, sizeof(req)) != 0 ||
+                read_full(fd, &len, sizeof(len)) != 0) {
+            fprintf(stderr, "Failed to request key\n");
+            ret = -1;
+            break;
+        }
+        len = ntohl(len);
+        if (len == 0 || len > sizeof(der)) {
+            fprintf(stderr, "No %d-bit keys from service\n", bits);
+            ret = -1;
+            break;
+        }
+        if (read_full(fd, der, len) != 0)
+            ret = -1;
+    }
+    elapsed = now() - start;
+    close(fd);
+    if (ret != 0)
+        return ret;
+
+    printf("Fetched %d %d-bit keys in %.3f ms, %.3f ms per key\n", numKeys,
+           bits, elapsed * 1000, elapsed * 1000 / numKeys);
+
+    /* Check the key decodes and write it out as rsa-kg does. */
+    ret = wc_InitRsaKey(&key, NULL);
+    if (ret != 0)
+        return ret;
+    ret = wc_RsaPrivateKeyDecode(der, &idx, &key, len);
+    if (ret == 0)
+        ret = write_file(pubKey, pubDer,
+                         wc_RsaKeyToPublicDer(&key, pubDer, sizeof(pubDer)));
+    if (ret == 0)
+        ret = write_file(privKey, der, (int)len);
+    wc_FreeRsaKey(&key);
+    memset(der, 0, sizeof(der));
+
+    return ret;
+}
+
+#endif
+
+/* Shows usage information */
+void usage()
+{
+    fprintf(stderr, "rsa-kg-farm <options>:\n");
+    fprintf(stderr, "  -bench            Measure keys/minute per key size "
+                    "(default)\n");
+    fprintf(stderr, "  -serve            Keep pools of keys and hand them "
+                    "out\n");
+    fprintf(stderr, "  -get <bits>       Fetch keys of size from the "
+                    "service\n");
+    fprintf(stderr, "  -bits <list>      Key sizes to generate, comma "
+                    "separated\n");
+    fprintf(stderr, "                    Range: 1024-4096, default %d\n",
+                    DEF_RSA_KEY_SIZE);
+    fprintf(stderr, "  -threads <num>    Number of generating threads, "
+                    "default: cores\n");
+    fprintf(stderr, "  -pool <num>       Keys kept in each pool, default "
+                    "%d\n", DEF_POOL_SIZE);
+    fprintf(stderr, "  -n <num>          Keys to generate or fetch, default "
+                    "%d\n", DEF_NUM_KEYS);
+    fprintf(stderr, "  -sock <path>      Unix socket of service, default "
+                    "%s\n", kSockPath);
+    fprintf(stderr, "  -priv <filename>  Private key filename for -get\n");
+    fprintf(stderr, "  -pub <filename>   Public key filename for -get\n");
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+/* These examples require RSA and Key Gen */
+#if !defined(NO_RSA) && defined(WOLFSSL_KEY_GEN)
+    int ret = 0;
+    int serve = 0;
+    int getBits = 0;
+    int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int poolSize = DEF_POOL_SIZE;
+    int numKeys = DEF_NUM_KEYS;
+    const char* bitsList = "2048";
+    const char* sockPath = kSockPath;
+    const char* pubKey = kRsaPubKey;
+    const char* privKey = kRsaPrivKey;
+
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > MAX_THREADS)
+        numThreads = MAX_THREADS;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-bench", 7) == 0) {
+            serve = 0;
+        }
+        else if (XSTRNCMP(*argv, "-serve", 7) == 0) {
+            serve = 1;
+        }
+        else if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-get", 5) == 0) {
+            getBits = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-bits", 6) == 0) {
+            bitsList = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-threads", 9) == 0) {
+            numThreads = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-pool", 6) == 0) {
+            poolSize = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-n", 3) == 0) {
+            numKeys = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-sock", 6) == 0) {
+            sockPath = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-priv", 6) == 0) {
+            privKey = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-pub", 5) == 0) {
+            pubKey = *++argv;
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if (numThreads < 1 || numThreads > MAX_THREADS || poolSize < 1 ||
+            numKeys < 1) {
+        fprintf(stderr, "Threads must be 1-%d, pool and keys at least 1\n",
+                MAX_THREADS);
+        usage();
+        return 1;
+    }
+
+    wolfSSL_Init();
+
+    if (getBits != 0) {
+        ret = run_client(sockPath, getBits, numKeys, privKey, pubKey);
+    }
+    else if (serve) {
+        if (!add_pools(bitsList, poolSize)) {
+            usage();
+            ret = 1;
+        }
+        else {
+            ret = run_server(sockPath, numThreads);
+            free_pools();
+        }
+    }
+    else {
+        ret = run_bench(bitsList, numThreads, numKeys);
+    }
+
+    wolfSSL_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+#else
+    (void)kSockPath;
+    (void)kRsaPubKey;
+    (void)kRsaPrivKey;
+
+    printf("wolfSSL missing build features.\n");
+    printf("Please build using `./configure --enable-keygen`\n");
+    return 1;
+#endif
+}
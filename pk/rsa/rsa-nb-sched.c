@@ -0,0 +1,564 @@
+/* rsa-nb-sched.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/*
+* A cooperative scheduler that interleaves many non-blocking RSA signing
+* operations with network I/O in one thread.
+*
+* An event loop polls a socket and then runs RSA operations for at most a
+* time budget before polling again. Each RSA key has its own non-blocking
+* context so operations progress in turn, a chunk at a time. A peer thread
+* sends timestamped messages at a fixed interval and the loop records how long
+* each waited to be read. The same load is then run with blocking RSA, where
+* each operation runs to completion before the socket is polled again.
+* Usage:
+./rsa-nb-sched [-jobs <num>] [-n <num>] [-budget <us>] [-ping <us>]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/rsa.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+static const char* kRsaKey = "../../certs/client-key.der";
+#define RSA_TEST_BYTES 512
+
+/* Default number of RSA operations in progress at once */
+#define DEF_NUM_JOBS    8
+/* Default number of RSA operations to perform */
+#define DEF_NUM_OPS     32
+/* Default microseconds of RSA work between polls */
+#define DEF_BUDGET_US   200
+/* Default microseconds between messages from the peer */
+#define DEF_PING_US     1000
+#define MAX_JOBS        64
+/* Most I/O latencies recorded for each run */
+#define MAX_SAMPLES     (1 << 20)
+
+#if !defined(NO_RSA) && defined(USE_FAST_MATH) && defined(WC_RSA_NONBLOCK)
+
+/* An RSA operation slot with its own key and non-blocking context */
+typedef struct rsa_job {
+    RsaKey key;
+    RsaNb  nb;
+    int    inProgress;
+    byte   sig[RSA_TEST_BYTES];
+} rsa_job;
+
+/* State of one run of the event loop */
+typedef struct sched {
+    rsa_job* jobs;
+    int      numJobs;
+    int      nonBlock;
+    double   budget;
+    int      next;
+    int      started;
+    int      done;
+    int      total;
+    WC_RNG*  rng;
+    const byte* ref;
+    int      refSz;
+    double*  lat;
+    int      numLat;
+} sched;
+
+/* Peer sending timestamped messages */
+typedef struct ping_ctx {
+    int          fd;
+    long         intervalUs;
+    volatile int stop;
+    /* Messages not sent as the socket's queue was full */
+    long         dropped;
+} ping_ctx;
+
+static const char* kMsg = "Everyone gets Friday off.";
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static int load_file_to_buffer(const char* filename, byte** fileBuf,
+                               int* fileLen)
+{
+    int ret = 0;
+    FILE* file = NULL;
+
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+        printf("File %s does not exist!\n", filename);
+        ret = -1;
+        goto exit;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *fileLen = (int) ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *fileBuf = malloc((size_t) *fileLen);
+    if (*fileBuf == NULL) {
+        printf("File buffer malloc failed!\n");
+        ret = -1;
+        goto exit;
+    }
+
+    if ((int)fread(*fileBuf, 1, (size_t) *fileLen, file) != *fileLen) {
+        printf("Error reading file %s\n", filename);
+        ret = -1;
+    }
+
+exit:
+    if (file)
+        fclose(file);
+
+    return ret;
+}
+
+/* Sends the current time at fixed intervals until stopped */
+static void* ping_thread(void* arg)
+{
+    ping_ctx* ctx = (ping_ctx*)arg;
+    struct timespec next;
+    double t;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!ctx->stop) {
+        next.tv_nsec += ctx->intervalUs * 1000;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        /* Never block: the queue fills while a blocking sign runs and the
+         * reader may have stopped reading for good. */
+        t = now();
+        if (send(ctx->fd, &t, sizeof(t), MSG_DONTWAIT) != (ssize_t)sizeof(t)) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                break;
+            ctx->dropped++;
+        }
+    }
+
+    return NULL;
+}
+
+/* Reads all waiting messages and records how long each waited */
+static int handle_io(sched* s, int fd)
+{
+    double t;
+    double recvd;
+    ssize_t n;
+
+    for (;;) {
+        n = recv(fd, &t, sizeof(t), 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+        if (n != (ssize_t)sizeof(t))
+            return -1;
+
+        recvd = now();
+        if (s->numLat < MAX_SAMPLES)
+            s->lat[s->numLat++] = recvd - t;
+    }
+}
+
+/* Continues the RSA operation of a job. Returns FP_WOULDBLOCK while it is in
+ * progress. */
+static int step_job(sched* s, rsa_job* job)
+{
+    int ret;
+
+    if (!job->inProgress) {
+        job->inProgress = 1;
+        s->started++;
+    }
+
+    ret = wc_RsaSSL_Sign((const byte*)kMsg, (word32)XSTRLEN(kMsg), job->sig,
+                         sizeof(job->sig), &job->key, s->rng);
+    if (ret == FP_WOULDBLOCK)
+        return ret;
+
+    job->inProgress = 0;
+    if (ret < 0)
+        return ret;
+    /* PKCS #1 v1.5 signatures are deterministic */
+    if (ret != s->refSz || XMEMCMP(job->sig, s->ref, (size_t)ret) != 0)
+        return SIG_VERIFY_E;
+    s->done++;
+
+    return 0;
+}
+
+/* Runs RSA operations, in turn, until the budget is spent. With blocking RSA
+ * one whole operation is run. */
+static int run_slice(sched* s)
+{
+    int ret = 0;
+    int i;
+    double deadline = now() + s->budget;
+    rsa_job* job;
+
+    do {
+        /* Find the next job that is in progress or may start one */
+        job = NULL;
+        for (i = 0; i < s->numJobs; i++) {
+            job = &s->jobs[s->next];
+            s->next = (s->next + 1) % s->numJobs;
+            if (job->inProgress || s->started < s->total)
+                break;
+            job = NULL;
+        }
+        if (job == NULL)
+            break;
+
+        ret = step_job(s, job);
+        if (ret == FP_WOULDBLOCK)
+            ret = 0;
+    }
+    while (ret == 0 && s->nonBlock && now() < deadline);
+
+    return ret;
+}
+
+static int compare_double(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return (da > db) - (da < db);
+}
+
+/* Runs the event loop until all RSA operations are done and prints the RSA
+ * throughput and I/O latency. */
+static int run(const char* name, sched* s, long pingUs)
+{
+    int ret = 0;
+    int fds[2];
+    int ioRet;
+    double start;
+    double elapsed;
+    pthread_t tid;
+    ping_ctx ping;
+    struct pollfd pfd;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) != 0) {
+        perror("socketpair");
+        return -1;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    ping.fd = fds[1];
+    ping.intervalUs = pingUs;
+    ping.stop = 0;
+    ping.dropped = 0;
+    if (pthread_create(&tid, NULL, ping_thread, &ping) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    s->next = 0;
+    s->started = 0;
+    s->done = 0;
+    s->numLat = 0;
+    pfd.fd = fds[0];
+    pfd.events = POLLIN;
+
+    start = now();
+    while (ret == 0 && s->done < s->total) {
+        /* RSA work is always waiting so do not block in poll */
+        if (poll(&pfd, 1, 0) > 0) {
+            ioRet = handle_io(s, fds[0]);
+            if (ioRet != 0) {
+                fprintf(stderr, "Reading from peer failed\n");
+                ret = -1;
+                break;
+            }
+        }
+        ret = run_slice(s);
+    }
+    elapsed = now() - start;
+
+    ping.stop = 1;
+    pthread_join(tid, NULL);
+    close(fds[0]);
+    close(fds[1]);
+
+    if (ret != 0) {
+        printf("%s failed %s (%d)\n", name, wc_GetErrorString(ret), ret);
+        return ret;
+    }
+
+    printf("%-12s: %d signs in %.2f s, %.1f signs/s\n", name, s->done, elapsed,
+           s->done / elapsed);
+    if (ping.dropped > 0)
+        printf("%-12s  %ld messages dropped as the queue was full\n", "",
+               ping.dropped);
+    if (s->numLat == 0) {
+        printf("%-12s  no messages received\n", "");
+        return 0;
+    }
+    qsort(s->lat, (size_t)s->numLat, sizeof(double), compare_double);
+    printf("%-12s  I/O latency p50 %.3f ms, p99 %.3f ms, max %.3f ms "
+           "(%d messages)\n", "", s->lat[s->numLat / 2] * 1000,
+           s->lat[(s->numLat * 99) / 100] * 1000,
+           s->lat[s->numLat - 1] * 1000, s->numLat);
+
+    return 0;
+}
+
+/* Decodes the private key into each job and, for non-blocking, gives each key
+ * its own non-blocking context. */
+static int init_jobs(rsa_job* jobs, int numJobs, const byte* der, int derSz,
+                     WC_RNG* rng, int nonBlock)
+{
+    int ret = 0;
+    int i;
+    word32 idx;
+
+    for (i = 0; i < numJobs; i++) {
+        XMEMSET(&jobs[i], 0, sizeof(jobs[i]));
+        ret = wc_InitRsaKey(&jobs[i].key, NULL);
+        if (ret != 0)
+            break;
+        idx = 0;
+        ret = wc_RsaPrivateKeyDecode(der, &idx, &jobs[i].key, (word32)derSz);
+        if (ret == 0)
+            ret = wc_RsaSetRNG(&jobs[i].key, rng);
+        if (ret == 0 && nonBlock)
+            ret = wc_RsaSetNonBlock(&jobs[i].key, &jobs[i].nb);
+        if (ret != 0) {
+            wc_FreeRsaKey(&jobs[i].key);
+            break;
+        }
+    }
+    if (ret != 0) {
+        while (--i >= 0)
+            wc_FreeRsaKey(&jobs[i].key);
+    }
+
+    return ret;
+}
+
+static void free_jobs(rsa_job* jobs, int numJobs)
+{
+    int i;
+
+    for (i = 0; i < numJobs; i++)
+        wc_FreeRsaKey(&jobs[i].key);
+}
+
+#endif
+
+/* Shows usage information */
+void usage()
+{
+    fprintf(stderr, "rsa-nb-sched <options>:\n");
+    fprintf(stderr, "  -jobs <num>    RSA operations in progress at once, "
+                    "default %d\n", DEF_NUM_JOBS);
+    fprintf(stderr, "  -n <num>       RSA operations to perform, default "
+                    "%d\n", DEF_NUM_OPS);
+    fprintf(stderr, "  -budget <us>   RSA work between polls, default %d\n",
+                    DEF_BUDGET_US);
+    fprintf(stderr, "  -ping <us>     Time between messages from peer, "
+                    "default %d\n", DEF_PING_US);
+    fprintf(stderr, "  -key <file>    RSA private key in DER, default %s\n",
+                    kRsaKey);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+/* These examples require RSA, FastMath and Non-blocking */
+#if !defined(NO_RSA) && defined(USE_FAST_MATH) && defined(WC_RSA_NONBLOCK)
+    int ret = 0;
+    int numJobs = DEF_NUM_JOBS;
+    int numOps = DEF_NUM_OPS;
+    int budgetUs = DEF_BUDGET_US;
+    int pingUs = DEF_PING_US;
+    const char* keyFile = kRsaKey;
+    byte* derBuf = NULL;
+    int derSz = 0;
+    word32 idx;
+    int refSz;
+    byte ref[RSA_TEST_BYTES];
+    RsaKey refKey;
+    WC_RNG rng;
+    rsa_job* jobs = NULL;
+    sched s;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-jobs", 6) == 0) {
+            numJobs = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-n", 3) == 0) {
+            numOps = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-budget", 8) == 0) {
+            budgetUs = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-ping", 6) == 0) {
+            pingUs = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-key", 5) == 0) {
+            keyFile = *++argv;
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if (numJobs < 1 || numJobs > MAX_JOBS || numOps < 1 || budgetUs < 1 ||
+            pingUs < 1) {
+        fprintf(stderr, "Jobs must be 1-%d, other values at least 1\n",
+                MAX_JOBS);
+        usage();
+        return 1;
+    }
+
+    wolfSSL_Init();
+
+    XMEMSET(&s, 0, sizeof(s));
+    ret = load_file_to_buffer(keyFile, &derBuf, &derSz);
+    if (ret != 0)
+        goto prog_end;
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        printf("Init RNG failed %d\n", ret);
+        goto prog_end;
+    }
+
+    /* Reference signature made with blocking RSA */
+    ret = wc_InitRsaKey(&refKey, NULL);
+    if (ret == 0) {
+        idx = 0;
+        ret = wc_RsaPrivateKeyDecode(derBuf, &idx, &refKey, (word32)derSz);
+        if (ret == 0)
+            ret = wc_RsaSetRNG(&refKey, &rng);
+        if (ret == 0) {
+            ret = wc_RsaSSL_Sign((const byte*)kMsg, (word32)XSTRLEN(kMsg),
+                                 ref, sizeof(ref), &refKey, &rng);
+        }
+        wc_FreeRsaKey(&refKey);
+    }
+    if (ret < 0) {
+        printf("RSA reference sign failed %d\n", ret);
+        goto free_rng;
+    }
+    refSz = ret;
+    ret = 0;
+
+    jobs = (rsa_job*)malloc(sizeof(rsa_job) * (size_t)numJobs);
+    s.lat = (double*)malloc(sizeof(double) * MAX_SAMPLES);
+    if (jobs == NULL || s.lat == NULL) {
+        ret = MEMORY_E;
+        goto free_rng;
+    }
+    s.jobs = jobs;
+    s.numJobs = numJobs;
+    s.budget = budgetUs / 1000000.0;
+    s.total = numOps;
+    s.rng = &rng;
+    s.ref = ref;
+    s.refSz = refSz;
+
+    printf("%d RSA signs, %d in progress, %d us budget, message every %d "
+           "us\n", numOps, numJobs, budgetUs, pingUs);
+
+    /* Blocking: one whole operation between polls */
+    s.nonBlock = 0;
+    ret = init_jobs(jobs, numJobs, derBuf, derSz, &rng, 0);
+    if (ret == 0) {
+        ret = run("blocking", &s, pingUs);
+        free_jobs(jobs, numJobs);
+    }
+
+    /* Non-blocking: time sliced by budget */
+    if (ret == 0) {
+        s.nonBlock = 1;
+        ret = init_jobs(jobs, numJobs, derBuf, derSz, &rng, 1);
+        if (ret == 0) {
+            ret = run("non-blocking", &s, pingUs);
+            free_jobs(jobs, numJobs);
+        }
+    }
+
+free_rng:
+    wc_FreeRng(&rng);
+prog_end:
+    if (ret != 0)
+        printf("Failure %s (%d)\n", wc_GetErrorString(ret), ret);
+
+    free(jobs);
+    free(s.lat);
+    free(derBuf);
+    wolfSSL_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+#else
+    (void)argc;
+    (void)argv;
+    (void)kRsaKey;
+
+    printf("wolfSSL missing build features.\n");
+    printf("Please build using `./configure --enable-fastmath CFLAGS=\"-DWC_RSA_NONBLOCK\"`\n");
+    return -1;
+#endif
+}
@@ -0,0 +1,107 @@
+/* srp_auth.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "srp_auth.h"
+
+#ifdef WOLFCRYPT_HAVE_SRP
+
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include <string.h>
+
+int srp_auth_start(SrpAuth* auth, const SrpDb* db, const SrpDbEntry* entry,
+                   byte* pubKey, word32* pubKeySz)
+{
+    int         ret;
+    const byte* n;
+    word32      nSz;
+    const byte* g;
+    word32      gSz;
+
+    if (auth == NULL || db == NULL || entry == NULL || pubKey == NULL ||
+            pubKeySz == NULL)
+        return BAD_FUNC_ARG;
+
+    ret = srp_db_group(srp_db_group_of(db), &n, &nSz, &g, &gSz);
+    if (ret != 0)
+        return ret;
+    ret = wc_SrpInit(&auth->srp, (SrpType)srp_db_hash_of(db),
+                     SRP_SERVER_SIDE);
+    if (ret != 0)
+        return ret;
+
+    ret = wc_SrpSetUsername(&auth->srp, (const byte*)entry->user,
+                            entry->userSz);
+    if (ret == 0) {
+        ret = wc_SrpSetParams(&auth->srp, n, nSz, g, gSz, entry->salt,
+                              entry->saltSz);
+    }
+    if (ret == 0) {
+        ret = wc_SrpSetVerifier(&auth->srp, entry->verifier,
+                                entry->verifierSz);
+    }
+    if (ret == 0) {
+        auth->pubKeySz = (word32)sizeof(auth->pubKey);
+        ret = wc_SrpGetPublic(&auth->srp, auth->pubKey, &auth->pubKeySz);
+    }
+    if (ret == 0 && auth->pubKeySz > *pubKeySz)
+        ret = BUFFER_E;
+    if (ret != 0) {
+        wc_SrpTerm(&auth->srp);
+        return ret;
+    }
+
+    /* B is needed again to compute the key. */
+    memcpy(pubKey, auth->pubKey, auth->pubKeySz);
+    *pubKeySz = auth->pubKeySz;
+    return 0;
+}
+
+int srp_auth_finish(SrpAuth* auth, const byte* clientPubKey,
+                    word32 clientPubKeySz, const byte* clientProof,
+                    word32 clientProofSz, byte* proof, word32* proofSz)
+{
+    int ret;
+
+    if (auth == NULL || clientPubKey == NULL || clientProof == NULL ||
+            proof == NULL || proofSz == NULL)
+        return BAD_FUNC_ARG;
+
+    ret = wc_SrpComputeKey(&auth->srp, (byte*)clientPubKey, clientPubKeySz,
+                           auth->pubKey, auth->pubKeySz);
+    if (ret == 0) {
+        ret = wc_SrpVerifyPeersProof(&auth->srp, (byte*)clientProof,
+                                     clientProofSz);
+    }
+    if (ret == 0) {
+        ret = wc_SrpGetProof(&auth->srp, proof, proofSz);
+    }
+
+    return ret;
+}
+
+void srp_auth_free(SrpAuth* auth)
+{
+    if (auth != NULL)
+        wc_SrpTerm(&auth->srp);
+}
+
+#endif /* WOLFCRYPT_HAVE_SRP */
@@ -0,0 +1,63 @@
+/* srp_auth.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Server side of SRP authentication against a verifier store.
+ *
+ * The client sends its username. The server looks it up with
+ * srp_db_lookup() and calls srp_auth_start(), then sends the salt of the
+ * record and B. The client answers with A and its proof M1, and
+ * srp_auth_finish() checks M1 and makes M2 for the client to check.
+ *
+ * The group and hash are the store's. An SrpAuth is used by one thread.
+ */
+
+#ifndef SRP_AUTH_H
+#define SRP_AUTH_H
+
+#include "srp_db.h"
+
+#ifdef WOLFCRYPT_HAVE_SRP
+
+#include <wolfssl/wolfcrypt/srp.h>
+
+/* State of one authentication between start and finish. */
+typedef struct SrpAuth {
+    Srp    srp;
+    byte   pubKey[SRP_DB_MAX_N];
+    word32 pubKeySz;
+} SrpAuth;
+
+/* Start authenticating the user of a record: generate the server's public
+ * key B into pubKey. pubKeySz is the size of pubKey in and of B out. On
+ * error there is nothing to free. */
+int srp_auth_start(SrpAuth* auth, const SrpDb* db, const SrpDbEntry* entry,
+                   byte* pubKey, word32* pubKeySz);
+/* Check the client's public key A and proof M1 and generate the server's
+ * proof M2 into proof. Returns 0 only when the client knows the password. */
+int srp_auth_finish(SrpAuth* auth, const byte* clientPubKey,
+                    word32 clientPubKeySz, const byte* clientProof,
+                    word32 clientProofSz, byte* proof, word32* proofSz);
+/* Free an authentication, finished or not. */
+void srp_auth_free(SrpAuth* auth);
+
+#endif /* WOLFCRYPT_HAVE_SRP */
+
+#endif /* SRP_AUTH_H */
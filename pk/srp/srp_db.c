@@ -0,0 +1,343 @@
+/* srp_db.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "srp_db.h"
+
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SRP_RFC5054_GROUPS
+#include "srp_params.h"
+
+/* Version 2: the large groups are those of RFC 5054. */
+static const byte srp_db_magic[8] = { 'w', 'o', 'l', 'f', 'S', 'R', 'P', '2' };
+
+typedef struct SrpDbHeader {
+    byte   magic[8];
+    word32 group;
+    word32 hashType;
+    word32 count;
+    word32 bucketCount;   /* a power of 2 */
+    word64 recordsOff;
+    word64 fileSz;
+} SrpDbHeader;
+
+/* A slot of the index. Records never start at offset 0, so 0 is empty. */
+typedef struct SrpDbSlot {
+    word32 tag;           /* top of the hash: most misses skip the record */
+    word32 pad;
+    word64 off;
+} SrpDbSlot;
+
+/* Each record is: user length (1 byte), salt length (1 byte), verifier
+ * length (2 bytes), then the user, salt and verifier. */
+#define SRP_DB_REC_HDR_SZ   4
+
+struct SrpDbWriter {
+    FILE*       file;
+    SrpDbHeader hdr;
+    SrpDbSlot*  index;
+    word64      off;
+    word32      added;
+};
+
+struct SrpDb {
+    byte*              map;
+    const SrpDbHeader* hdr;
+    const SrpDbSlot*   index;
+};
+
+/* FNV-1a */
+static word64 srp_db_hash(const char* user, word32 userSz)
+{
+    word64 h = 0xcbf29ce484222325ULL;
+    word32 i;
+
+    for (i = 0; i < userSz; i++) {
+        h ^= (byte)user[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+int srp_db_group(int group, const byte** n, word32* nSz, const byte** g,
+                 word32* gSz)
+{
+    switch (group) {
+        case SRP_GROUP_640:
+            *n = srp_n_640;
+            *nSz = (word32)sizeof(srp_n_640);
+            *g = srp_g_640;
+            *gSz = (word32)sizeof(srp_g_640);
+            return 0;
+        case SRP_GROUP_2048:
+            *n = srp_n_2048;
+            *nSz = (word32)sizeof(srp_n_2048);
+            *g = srp_g_2048;
+            *gSz = (word32)sizeof(srp_g_2048);
+            return 0;
+        case SRP_GROUP_3072:
+            *n = srp_n_3072;
+            *nSz = (word32)sizeof(srp_n_3072);
+            *g = srp_g_3072;
+            *gSz = (word32)sizeof(srp_g_3072);
+            return 0;
+        case SRP_GROUP_4096:
+            *n = srp_n_4096;
+            *nSz = (word32)sizeof(srp_n_4096);
+            *g = srp_g_4096;
+            *gSz = (word32)sizeof(srp_g_4096);
+            return 0;
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+int srp_db_create(const char* path, int group, int hashType, word32 count,
+                  SrpDbWriter** writer)
+{
+    SrpDbWriter* w;
+    word32       buckets = 16;
+
+    if (path == NULL || writer == NULL || count == 0 || count > (1U << 30))
+        return BAD_FUNC_ARG;
+    /* At most half full, so probes are short. */
+    while (buckets < 2 * count)
+        buckets <<= 1;
+
+    w = (SrpDbWriter*)calloc(1, sizeof(SrpDbWriter));
+    if (w == NULL)
+        return MEMORY_E;
+    w->index = (SrpDbSlot*)calloc(buckets, sizeof(SrpDbSlot));
+    w->file = fopen(path, "wb");
+    if (w->index == NULL || w->file == NULL) {
+        int ret = (w->file == NULL) ? -1 : MEMORY_E;
+
+        if (w->file != NULL)
+            fclose(w->file);
+        free(w->index);
+        free(w);
+        return ret;
+    }
+
+    memcpy(w->hdr.magic, srp_db_magic, sizeof(srp_db_magic));
+    w->hdr.group = (word32)group;
+    w->hdr.hashType = (word32)hashType;
+    w->hdr.count = count;
+    w->hdr.bucketCount = buckets;
+    w->hdr.recordsOff = sizeof(SrpDbHeader) + (word64)buckets *
+                        sizeof(SrpDbSlot);
+    w->off = w->hdr.recordsOff;
+
+    /* Records are written as they come, the header and index at the end. */
+    if (fseek(w->file, (long)w->off, SEEK_SET) != 0) {
+        fclose(w->file);
+        free(w->index);
+        free(w);
+        return -1;
+    }
+
+    *writer = w;
+    return 0;
+}
+
+int srp_db_add(SrpDbWriter* w, const char* user, const byte* salt,
+               word32 saltSz, const byte* verifier, word32 verifierSz)
+{
+    word32 userSz;
+    word64 h;
+    word32 i;
+    word16 vSz = (word16)verifierSz;
+    byte   recHdr[SRP_DB_REC_HDR_SZ];
+
+    if (w == NULL || user == NULL || salt == NULL || verifier == NULL)
+        return BAD_FUNC_ARG;
+    userSz = (word32)strlen(user);
+    if (userSz == 0 || userSz > SRP_DB_MAX_USER || saltSz > SRP_DB_MAX_SALT ||
+            verifierSz > SRP_DB_MAX_N || w->added == w->hdr.count)
+        return BAD_FUNC_ARG;
+
+    recHdr[0] = (byte)userSz;
+    recHdr[1] = (byte)saltSz;
+    memcpy(recHdr + 2, &vSz, sizeof(vSz));
+    if (fwrite(recHdr, 1, sizeof(recHdr), w->file) != sizeof(recHdr) ||
+            fwrite(user, 1, userSz, w->file) != userSz ||
+            fwrite(salt, 1, saltSz, w->file) != saltSz ||
+            fwrite(verifier, 1, verifierSz, w->file) != verifierSz)
+        return -1;
+
+    /* Never full: there are at least twice as many slots as users. */
+    h = srp_db_hash(user, userSz);
+    for (i = (word32)h & (w->hdr.bucketCount - 1); w->index[i].off != 0;
+         i = (i + 1) & (w->hdr.bucketCount - 1)) {
+    }
+    w->index[i].tag = (word32)(h >> 32);
+    w->index[i].off = w->off;
+
+    w->off += sizeof(recHdr) + userSz + saltSz + verifierSz;
+    w->added++;
+    return 0;
+}
+
+int srp_db_finish(SrpDbWriter* w)
+{
+    int ret = 0;
+
+    if (w == NULL)
+        return BAD_FUNC_ARG;
+
+    w->hdr.count = w->added;
+    w->hdr.fileSz = w->off;
+    if (fseek(w->file, 0, SEEK_SET) != 0 ||
+            fwrite(&w->hdr, sizeof(w->hdr), 1, w->file) != 1 ||
+            fwrite(w->index, sizeof(SrpDbSlot), w->hdr.bucketCount, w->file)
+                != w->hdr.bucketCount) {
+        ret = -1;
+    }
+    if (fclose(w->file) != 0)
+        ret = -1;
+
+    free(w->index);
+    free(w);
+    return ret;
+}
+
+int srp_db_open(const char* path, SrpDb** db)
+{
+    int                fd;
+    struct stat        st;
+    byte*              map;
+    const SrpDbHeader* hdr;
+    SrpDb*             d;
+
+    if (path == NULL || db == NULL)
+        return BAD_FUNC_ARG;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SrpDbHeader)) {
+        close(fd);
+        return -1;
+    }
+    map = (byte*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    hdr = (const SrpDbHeader*)map;
+    if (memcmp(hdr->magic, srp_db_magic, sizeof(srp_db_magic)) != 0 ||
+            hdr->fileSz != (word64)st.st_size || hdr->bucketCount == 0 ||
+            (hdr->bucketCount & (hdr->bucketCount - 1)) != 0 ||
+            hdr->recordsOff != sizeof(SrpDbHeader) +
+                (word64)hdr->bucketCount * sizeof(SrpDbSlot) ||
+            hdr->recordsOff > hdr->fileSz) {
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    d = (SrpDb*)malloc(sizeof(SrpDb));
+    if (d == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return MEMORY_E;
+    }
+    d->map = map;
+    d->hdr = hdr;
+    d->index = (const SrpDbSlot*)(map + sizeof(SrpDbHeader));
+    /* Lookups hit random pages. */
+    (void)madvise(map, (size_t)st.st_size, MADV_RANDOM);
+
+    *db = d;
+    return 0;
+}
+
+int srp_db_lookup(const SrpDb* db, const char* user, word32 userSz,
+                  SrpDbEntry* entry)
+{
+    word64      h = srp_db_hash(user, userSz);
+    word32      mask = db->hdr->bucketCount - 1;
+    word32      i;
+    word32      n;
+    word16      vSz;
+    const byte* rec;
+
+    for (i = (word32)h & mask, n = 0; n <= mask; i = (i + 1) & mask, n++) {
+        const SrpDbSlot* slot = &db->index[i];
+
+        if (slot->off == 0)
+            break;
+        if (slot->tag != (word32)(h >> 32) ||
+                slot->off + SRP_DB_REC_HDR_SZ > db->hdr->fileSz)
+            continue;
+
+        rec = db->map + slot->off;
+        memcpy(&vSz, rec + 2, sizeof(vSz));
+        if (rec[0] != userSz || slot->off + SRP_DB_REC_HDR_SZ + rec[0] +
+                rec[1] + vSz > db->hdr->fileSz ||
+                memcmp(rec + SRP_DB_REC_HDR_SZ, user, userSz) != 0)
+            continue;
+
+        entry->user = (const char*)rec + SRP_DB_REC_HDR_SZ;
+        entry->userSz = rec[0];
+        entry->salt = rec + SRP_DB_REC_HDR_SZ + rec[0];
+        entry->saltSz = rec[1];
+        entry->verifier = entry->salt + rec[1];
+        entry->verifierSz = vSz;
+        return 0;
+    }
+
+    return -1;
+}
+
+word32 srp_db_count(const SrpDb* db)
+{
+    return db->hdr->count;
+}
+
+int srp_db_group_of(const SrpDb* db)
+{
+    return (int)db->hdr->group;
+}
+
+int srp_db_hash_of(const SrpDb* db)
+{
+    return (int)db->hdr->hashType;
+}
+
+word64 srp_db_size(const SrpDb* db)
+{
+    return db->hdr->fileSz;
+}
+
+void srp_db_close(SrpDb* db)
+{
+    if (db != NULL) {
+        munmap(db->map, (size_t)db->hdr->fileSz);
+        free(db);
+    }
+}
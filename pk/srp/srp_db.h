@@ -0,0 +1,95 @@
+/* srp_db.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* An on-disk store of SRP verifiers, looked up by username.
+ *
+ * The file holds a header, a hash index and the records. The server maps it
+ * read only, so a lookup touches one index slot and one record and the store
+ * may be much larger than memory. The file is in host byte order.
+ *
+ * The group (N and g) and hash of the verifiers are kept in the header so
+ * that the server uses the ones the verifiers were made with.
+ */
+
+#ifndef SRP_DB_H
+#define SRP_DB_H
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/types.h>
+
+#define SRP_DB_MAX_USER     255
+#define SRP_DB_MAX_SALT     64
+/* Largest verifier: the size of a 4096-bit modulus. */
+#define SRP_DB_MAX_N        512
+
+/* Users and passwords made by srp_db_gen for benchmarking. */
+#define SRP_DB_BENCH_USER   "user%u"
+#define SRP_DB_BENCH_PASS   "pass%u"
+
+/* Groups by size of modulus in bits. 640 is the small group of the other
+ * examples, the others are the RFC 5054 groups. All are in srp_params.h. */
+#define SRP_GROUP_640       640
+#define SRP_GROUP_2048      2048
+#define SRP_GROUP_3072      3072
+#define SRP_GROUP_4096      4096
+
+typedef struct SrpDb       SrpDb;
+typedef struct SrpDbWriter SrpDbWriter;
+
+/* A record of the store. Pointers are into the mapped file. */
+typedef struct SrpDbEntry {
+    const char* user;
+    word32      userSz;
+    const byte* salt;
+    word32      saltSz;
+    const byte* verifier;
+    word32      verifierSz;
+} SrpDbEntry;
+
+/* Get the modulus and generator of a group. Returns 0 or BAD_FUNC_ARG. */
+int srp_db_group(int group, const byte** n, word32* nSz, const byte** g,
+                 word32* gSz);
+
+/* Create a store for count users. Records are added in any order. */
+int srp_db_create(const char* path, int group, int hashType, word32 count,
+                  SrpDbWriter** writer);
+/* Add a user. Not thread safe. */
+int srp_db_add(SrpDbWriter* writer, const char* user, const byte* salt,
+               word32 saltSz, const byte* verifier, word32 verifierSz);
+/* Write the index and close the store. Frees the writer. */
+int srp_db_finish(SrpDbWriter* writer);
+
+/* Map a store for lookups. */
+int srp_db_open(const char* path, SrpDb** db);
+/* Find a user. Returns 0 when found, -1 when not. Thread safe. */
+int srp_db_lookup(const SrpDb* db, const char* user, word32 userSz,
+                  SrpDbEntry* entry);
+word32 srp_db_count(const SrpDb* db);
+int srp_db_group_of(const SrpDb* db);
+int srp_db_hash_of(const SrpDb* db);
+/* Size of the mapped file in bytes. */
+word64 srp_db_size(const SrpDb* db);
+void srp_db_close(SrpDb* db);
+
+#endif /* SRP_DB_H */
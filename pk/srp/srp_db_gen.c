@@ -0,0 +1,307 @@
+/* srp_db_gen.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Generate a verifier store for srp_server.
+ *
+ * Users are named user0, user1, ... with passwords pass0, pass1, ... so that
+ * srp_server can play the client. Each user gets a random salt. Verifiers are
+ * calculated on all cores and written to the store as they are made.
+ */
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/srp.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef WOLFCRYPT_HAVE_SRP
+
+#include "srp_db.h"
+
+#define SALT_SZ         16
+#define MAX_THREADS     256
+#define DEF_USERS       100000
+/* Users between progress reports. */
+#define PROGRESS        100000
+
+static SrpDbWriter*    gWriter;
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static word32          gNext;
+static word32          gUsers;
+static int             gErr;
+static int             gHashType;
+static const byte*     gN;
+static word32          gNSz;
+static const byte*     gG;
+static word32          gGSz;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Calculate the verifier of a user as the client does at registration. */
+static int make_verifier(const char* username, const char* password,
+                         const byte* salt, byte* verifier, word32* vSz)
+{
+    int ret;
+    Srp srp;
+
+    ret = wc_SrpInit(&srp, (SrpType)gHashType, SRP_CLIENT_SIDE);
+    if (ret == 0) {
+        ret = wc_SrpSetUsername(&srp, (byte*)username, XSTRLEN(username));
+        if (ret == 0) {
+            ret = wc_SrpSetParams(&srp, gN, gNSz, gG, gGSz, salt, SALT_SZ);
+        }
+        if (ret == 0) {
+            ret = wc_SrpSetPassword(&srp, (byte*)password, XSTRLEN(password));
+        }
+        if (ret == 0) {
+            ret = wc_SrpGetVerifier(&srp, verifier, vSz);
+        }
+
+        wc_SrpTerm(&srp);
+    }
+
+    return ret;
+}
+
+static void* gen_thread(void* arg)
+{
+    int    ret;
+    WC_RNG rng;
+    word32 i;
+    char   username[32];
+    char   password[32];
+    byte   salt[SALT_SZ];
+    byte   verifier[SRP_DB_MAX_N];
+    word32 vSz;
+
+    (void)arg;
+
+    ret = wc_InitRng(&rng);
+    while (ret == 0) {
+        pthread_mutex_lock(&gLock);
+        i = gNext;
+        if (i < gUsers && gErr == 0)
+            gNext++;
+        else
+            i = gUsers;
+        pthread_mutex_unlock(&gLock);
+        if (i == gUsers)
+            break;
+
+        snprintf(username, sizeof(username), SRP_DB_BENCH_USER, i);
+        snprintf(password, sizeof(password), SRP_DB_BENCH_PASS, i);
+        vSz = (word32)sizeof(verifier);
+        ret = wc_RNG_GenerateBlock(&rng, salt, sizeof(salt));
+        if (ret == 0) {
+            ret = make_verifier(username, password, salt, verifier, &vSz);
+        }
+        if (ret == 0) {
+            /* The writer appends to one file. */
+            pthread_mutex_lock(&gLock);
+            ret = srp_db_add(gWriter, username, salt, sizeof(salt), verifier,
+                             vSz);
+            pthread_mutex_unlock(&gLock);
+        }
+        if (ret == 0 && (i + 1) % PROGRESS == 0) {
+            printf("  %u users\n", i + 1);
+            fflush(stdout);
+        }
+    }
+    wc_FreeRng(&rng);
+
+    if (ret != 0) {
+        pthread_mutex_lock(&gLock);
+        if (gErr == 0)
+            gErr = ret;
+        pthread_mutex_unlock(&gLock);
+    }
+
+    return NULL;
+}
+
+static int parse_hash(const char* name)
+{
+    if (XSTRNCMP(name, "sha", 4) == 0)
+        return SRP_TYPE_SHA;
+    if (XSTRNCMP(name, "sha256", 7) == 0)
+        return SRP_TYPE_SHA256;
+    if (XSTRNCMP(name, "sha384", 7) == 0)
+        return SRP_TYPE_SHA384;
+    if (XSTRNCMP(name, "sha512", 7) == 0)
+        return SRP_TYPE_SHA512;
+    return -1;
+}
+
+/* Shows usage information */
+static void usage(void)
+{
+    fprintf(stderr, "srp_db_gen <options>:\n");
+    fprintf(stderr, "  -out <file>       Store to write\n");
+    fprintf(stderr, "  -users <num>      Number of users, default %d\n",
+            DEF_USERS);
+    fprintf(stderr, "  -group <bits>     640, 2048, 3072 or 4096, default "
+                    "%d\n", SRP_GROUP_2048);
+    fprintf(stderr, "  -hash <name>      sha, sha256, sha384 or sha512, "
+                    "default sha256\n");
+    fprintf(stderr, "  -threads <num>    Number of threads, default: number "
+                    "of cores\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret;
+    int         i;
+    int         started;
+    int         numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int         users = DEF_USERS;
+    int         group = SRP_GROUP_2048;
+    const char* hash = "sha256";
+    const char* out = NULL;
+    double      start;
+    double      elapsed;
+    pthread_t   tids[MAX_THREADS];
+
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > MAX_THREADS)
+        numThreads = MAX_THREADS;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-out", 5) == 0) {
+            out = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-users", 7) == 0) {
+            users = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-group", 7) == 0) {
+            group = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-hash", 6) == 0) {
+            hash = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-threads", 9) == 0) {
+            numThreads = atoi(*++argv);
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    gHashType = parse_hash(hash);
+    if (out == NULL || users < 1 || numThreads < 1 ||
+            numThreads > MAX_THREADS || gHashType < 0) {
+        usage();
+        return 1;
+    }
+    if (srp_db_group(group, &gN, &gNSz, &gG, &gGSz) != 0) {
+        fprintf(stderr, "Unknown group: %d\n", group);
+        return 1;
+    }
+
+    ret = srp_db_create(out, group, gHashType, (word32)users, &gWriter);
+    if (ret != 0) {
+        fprintf(stderr, "Unable to create %s\n", out);
+        return 1;
+    }
+
+    printf("Generating %d users, %d-bit group, %s, %d threads\n", users,
+           group, hash, numThreads);
+    gUsers = (word32)users;
+    start = now();
+    for (started = 0; started < numThreads; started++) {
+        if (pthread_create(&tids[started], NULL, gen_thread, NULL) != 0) {
+            fprintf(stderr, "Failed to start thread %d\n", started);
+            break;
+        }
+    }
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    elapsed = now() - start;
+
+    ret = gErr;
+    if (started == 0)
+        ret = -1;
+    if (ret == 0) {
+        ret = srp_db_finish(gWriter);
+    }
+    else {
+        srp_db_finish(gWriter);
+        /* Don't leave a partial store for the server to find. */
+        remove(out);
+    }
+
+    if (ret == 0) {
+        printf("Wrote %d users to %s in %.2f s, %.0f verifiers/s\n", users,
+               out, elapsed, users / elapsed);
+    }
+    else {
+        fprintf(stderr, "Failed to generate store: %d\n", ret);
+    }
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "Must build wolfSSL with SRP enabled for this example\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,364 @@
+/* srp_server.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* SRP server side authentication against a verifier store.
+ *
+ * The store made by srp_db_gen is mapped and shared by a pool of worker
+ * threads. Each worker authenticates random users of the store: the server's
+ * side is the API in srp_auth.h and the worker plays the client against it,
+ * checking both proofs. The server's steps are timed on their own so that
+ * the rate one server could sustain is reported apart from the cost of the
+ * client.
+ */
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/srp.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef WOLFCRYPT_HAVE_SRP
+
+#include "srp_auth.h"
+
+#define MAX_THREADS     256
+#define DEF_AUTHS       1000
+
+/* Work and results of one worker. */
+typedef struct Worker {
+    pthread_t tid;
+    int       auths;
+    word32    seed;
+    long      done;
+    long      failed;
+    /* Users looked up that weren't in the store. */
+    long      missing;
+    double    lookup;
+    double    server;
+} Worker;
+
+static const SrpDb* gDb;
+static SrpType      gHashType;
+static const byte*  gN;
+static word32       gNSz;
+static const byte*  gG;
+static word32       gGSz;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Pick users with a cheap generator: this is not security sensitive. */
+static word32 next_rand(word32* seed)
+{
+    word32 x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+/* Calculate the client's public key */
+static int client_calc_public(Srp* srp, const char* username,
+                              const char* password, const byte* salt,
+                              word32 saltSz, byte* pubKey, word32* pubKeySz)
+{
+    int ret;
+
+    ret = wc_SrpSetUsername(srp, (byte*)username, XSTRLEN(username));
+    if (ret == 0) {
+        ret = wc_SrpSetParams(srp, gN, gNSz, gG, gGSz, salt, saltSz);
+    }
+    if (ret == 0) {
+        ret = wc_SrpSetPassword(srp, (byte*)password, XSTRLEN(password));
+    }
+    if (ret == 0) {
+        ret = wc_SrpGetPublic(srp, pubKey, pubKeySz);
+    }
+
+    return ret;
+}
+
+/* Authenticate one user of the store. */
+static int authenticate(Worker* w, word32 user)
+{
+    int        ret;
+    Srp        cli;
+    SrpAuth    srv;
+    SrpDbEntry entry;
+    char       username[32];
+    char       password[32];
+    byte       serverPubKey[SRP_DB_MAX_N];
+    word32     serverPubKeySz = (word32)sizeof(serverPubKey);
+    byte       clientPubKey[SRP_DB_MAX_N];
+    word32     clientPubKeySz = (word32)sizeof(clientPubKey);
+    byte       clientProof[SRP_MAX_DIGEST_SIZE];
+    word32     clientProofSz = (word32)sizeof(clientProof);
+    byte       serverProof[SRP_MAX_DIGEST_SIZE];
+    word32     serverProofSz = (word32)sizeof(serverProof);
+    double     start;
+
+    snprintf(username, sizeof(username), SRP_DB_BENCH_USER, user);
+    snprintf(password, sizeof(password), SRP_DB_BENCH_PASS, user);
+
+    /* Server: find the user. */
+    start = now();
+    ret = srp_db_lookup(gDb, username, (word32)XSTRLEN(username), &entry);
+    w->lookup += now() - start;
+    if (ret != 0) {
+        w->missing++;
+        return ret;
+    }
+
+    /* Server: generates B and sends it with the salt. */
+    start = now();
+    ret = srp_auth_start(&srv, gDb, &entry, serverPubKey, &serverPubKeySz);
+    w->server += now() - start;
+    if (ret != 0)
+        return ret;
+
+    ret = wc_SrpInit(&cli, gHashType, SRP_CLIENT_SIDE);
+    if (ret != 0) {
+        srp_auth_free(&srv);
+        return ret;
+    }
+
+    /* Client: sent its username, got the salt and B. */
+    ret = client_calc_public(&cli, username, password, entry.salt,
+                             entry.saltSz, clientPubKey, &clientPubKeySz);
+    if (ret == 0) {
+        ret = wc_SrpComputeKey(&cli, clientPubKey, clientPubKeySz,
+                               serverPubKey, serverPubKeySz);
+    }
+    if (ret == 0) {
+        ret = wc_SrpGetProof(&cli, clientProof, &clientProofSz);
+    }
+    if (ret == 0) {
+        /* Server: checks A and M1, sends M2. */
+        start = now();
+        ret = srp_auth_finish(&srv, clientPubKey, clientPubKeySz, clientProof,
+                              clientProofSz, serverProof, &serverProofSz);
+        w->server += now() - start;
+    }
+    if (ret == 0) {
+        ret = wc_SrpVerifyPeersProof(&cli, serverProof, serverProofSz);
+    }
+
+    srp_auth_free(&srv);
+    wc_SrpTerm(&cli);
+
+    return ret;
+}
+
+static void* worker_thread(void* arg)
+{
+    Worker* w = (Worker*)arg;
+    word32  count = srp_db_count(gDb);
+    int     i;
+
+    for (i = 0; i < w->auths; i++) {
+        if (authenticate(w, next_rand(&w->seed) % count) == 0)
+            w->done++;
+        else
+            w->failed++;
+    }
+
+    return NULL;
+}
+
+/* Shows usage information */
+static void usage(void)
+{
+    fprintf(stderr, "srp_server <options>:\n");
+    fprintf(stderr, "  -db <file>        Store made by srp_db_gen\n");
+    fprintf(stderr, "  -threads <num>    Number of workers, default: number "
+                    "of cores\n");
+    fprintf(stderr, "  -n <num>          Number of authentications, default "
+                    "%d\n", DEF_AUTHS);
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret = 0;
+    int         i;
+    int         started;
+    int         numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int         auths = DEF_AUTHS;
+    const char* path = NULL;
+    SrpDb*      db = NULL;
+    Worker*     workers;
+    long        done = 0;
+    long        failed = 0;
+    long        missing = 0;
+    double      lookup = 0;
+    double      server = 0;
+    double      start;
+    double      elapsed;
+
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > MAX_THREADS)
+        numThreads = MAX_THREADS;
+
+    argc--;
+    argv++;
+    while (argc > 0) {
+        if (XSTRNCMP(*argv, "-help", 6) == 0) {
+            usage();
+            return 0;
+        }
+        else if (argc == 1) {
+            fprintf(stderr, "Missing value for %s\n", *argv);
+            usage();
+            return 1;
+        }
+        else if (XSTRNCMP(*argv, "-db", 4) == 0) {
+            path = *++argv;
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-threads", 9) == 0) {
+            numThreads = atoi(*++argv);
+            argc--;
+        }
+        else if (XSTRNCMP(*argv, "-n", 3) == 0) {
+            auths = atoi(*++argv);
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Unrecognized option: %s\n", *argv);
+            usage();
+            return 1;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if (path == NULL || auths < 1 || numThreads < 1 ||
+            numThreads > MAX_THREADS) {
+        usage();
+        return 1;
+    }
+
+    if (srp_db_open(path, &db) != 0) {
+        fprintf(stderr, "Unable to open store %s\n", path);
+        return 1;
+    }
+    gDb = db;
+    gHashType = (SrpType)srp_db_hash_of(db);
+    if (srp_db_count(db) == 0 || srp_db_group(srp_db_group_of(db), &gN,
+            &gNSz, &gG, &gGSz) != 0) {
+        fprintf(stderr, "Store is empty or its %d-bit group is unknown\n",
+                srp_db_group_of(db));
+        srp_db_close(db);
+        return 1;
+    }
+
+    workers = (Worker*)XMALLOC(sizeof(Worker) * numThreads, NULL,
+                               DYNAMIC_TYPE_TMP_BUFFER);
+    if (workers == NULL) {
+        srp_db_close(db);
+        return 1;
+    }
+    XMEMSET(workers, 0, sizeof(Worker) * numThreads);
+
+    /* Initialize wolfSSL library. */
+    wolfSSL_Init();
+
+    printf("Store: %u users, %d-bit group, %.1f MB mapped\n",
+           srp_db_count(db), srp_db_group_of(db),
+           (double)srp_db_size(db) / (1024 * 1024));
+
+    start = now();
+    for (started = 0; started < numThreads; started++) {
+        workers[started].auths = auths / numThreads +
+                                 (started < auths % numThreads);
+        workers[started].seed = 0x9e3779b9u * (word32)(started + 1);
+        if (pthread_create(&workers[started].tid, NULL, worker_thread,
+                           &workers[started]) != 0) {
+            fprintf(stderr, "Failed to start worker %d\n", started);
+            break;
+        }
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i].tid, NULL);
+        done += workers[i].done;
+        failed += workers[i].failed;
+        missing += workers[i].missing;
+        lookup += workers[i].lookup;
+        server += workers[i].server;
+    }
+    elapsed = now() - start;
+
+    if (started == 0 || done == 0) {
+        fprintf(stderr, "No authentications succeeded\n");
+        ret = -1;
+    }
+    else {
+        printf("%ld authentications in %.2f s with %d threads\n", done,
+               elapsed, started);
+        printf("  %-28s %10.1f\n", "Authentications/s:", done / elapsed);
+        printf("  %-28s %10.2f\n", "Lookup (us):",
+               lookup * 1000000 / (done + missing));
+        printf("  %-28s %10.3f\n", "Server work per auth (ms):",
+               server * 1000 / done);
+        /* Without the client's work on the same cores. */
+        printf("  %-28s %10.1f\n", "Server-only auths/s:",
+               started * done / server);
+        printf("  %-28s %10ld\n", "Failed:", failed);
+        if (missing > 0)
+            printf("  %-28s %10ld\n", "Of those, not in store:", missing);
+    }
+
+    XFREE(workers, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    srp_db_close(db);
+
+    /* Cleanup wolfSSL library. */
+    wolfSSL_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "Must build wolfSSL with SRP enabled for this example\n");
+    return 0;
+}
+
+#endif
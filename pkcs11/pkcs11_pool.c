@@ -0,0 +1,420 @@
+/* pkcs11_pool.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* PKCS #11 device with a pool of sessions.
+ *
+ * A PKCS #11 session must only be used by one thread at a time, so a single
+ * opened Pkcs11Token serializes all operations. Here each operation takes a
+ * session from the pool and returns it when done.
+ *
+ * wolfSSL looks up a private key by its identifier on each operation. With the
+ * cache on, the handles of private keys are remembered - object handles are
+ * valid in all sessions of the application - and ECDSA signing and raw RSA
+ * private key operations are done directly with the cached handle. All other
+ * operations are passed to wc_Pkcs11_CryptoDevCb with the session's token.
+ *
+ * An HMAC is calculated in a session over a number of calls, so the thread
+ * keeps the session from the first update until the final. A thread holds at
+ * most one session: any other operation, or freeing the HMAC with
+ * Pkcs11Pool_HmacFree(), ends the unfinished HMAC and returns the session.
+ */
+
+#include "pkcs11_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/cryptocb.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/rsa.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#if defined(HAVE_PKCS11) && defined(WOLF_CRYPTO_CB)
+
+/* Take a session from the pool, waiting for one when all are in use.
+ *
+ * returns the index of the token with the session.
+ */
+static int Pkcs11Pool_Get(Pkcs11Pool* pool)
+{
+    int idx;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->numFree == 0) {
+        pool->waits++;
+        while (pool->numFree == 0)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    idx = pool->free[--pool->numFree];
+    pool->ops++;
+    pthread_mutex_unlock(&pool->lock);
+
+    return idx;
+}
+
+/* Return a session to the pool. */
+static void Pkcs11Pool_Put(Pkcs11Pool* pool, int idx)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->free[pool->numFree++] = idx;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Count a cache hit or miss. */
+static void Pkcs11Pool_Count(Pkcs11Pool* pool, int hit)
+{
+    pthread_mutex_lock(&pool->lock);
+    if (hit)
+        pool->cacheHits++;
+    else
+        pool->cacheMisses++;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Find the handle of a private key by identifier, in the cache or else on
+ * the token.
+ *
+ * returns 0 on success, WC_HW_E when not found.
+ */
+static int Pkcs11Pool_FindKey(Pkcs11Pool* pool, Pkcs11Token* token,
+    const byte* id, int idLen, CK_OBJECT_HANDLE* handle)
+{
+    int               i;
+    int               found = 0;
+    CK_RV             rv;
+    CK_ULONG          count = 0;
+    CK_OBJECT_CLASS   keyClass = CKO_PRIVATE_KEY;
+    CK_ATTRIBUTE      tmpl[] = {
+        { CKA_CLASS, &keyClass, sizeof(keyClass) },
+        { CKA_ID,    (CK_VOID_PTR)id, (CK_ULONG)idLen }
+    };
+
+    pthread_rwlock_rdlock(&pool->keysLock);
+    for (i = 0; i < pool->numKeys; i++) {
+        if (pool->keys[i].idLen == idLen &&
+                XMEMCMP(pool->keys[i].id, id, idLen) == 0) {
+            *handle = pool->keys[i].handle;
+            found = 1;
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&pool->keysLock);
+    Pkcs11Pool_Count(pool, found);
+    if (found)
+        return 0;
+
+    rv = token->func->C_FindObjectsInit(token->handle, tmpl,
+        sizeof(tmpl) / sizeof(*tmpl));
+    if (rv != CKR_OK)
+        return WC_HW_E;
+    rv = token->func->C_FindObjects(token->handle, handle, 1, &count);
+    token->func->C_FindObjectsFinal(token->handle);
+    if (rv != CKR_OK || count != 1)
+        return WC_HW_E;
+
+    /* Another thread may have added it - a duplicate is harmless. */
+    pthread_rwlock_wrlock(&pool->keysLock);
+    if (pool->numKeys < PKCS11_POOL_CACHE_SZ) {
+        XMEMCPY(pool->keys[pool->numKeys].id, id, idLen);
+        pool->keys[pool->numKeys].idLen = idLen;
+        pool->keys[pool->numKeys].handle = *handle;
+        pool->numKeys++;
+    }
+    pthread_rwlock_unlock(&pool->keysLock);
+
+    return 0;
+}
+
+/* Forget a handle that the token no longer knows. */
+static void Pkcs11Pool_ForgetKey(Pkcs11Pool* pool, CK_OBJECT_HANDLE handle)
+{
+    int i;
+
+    pthread_rwlock_wrlock(&pool->keysLock);
+    for (i = 0; i < pool->numKeys; i++) {
+        if (pool->keys[i].handle == handle) {
+            pool->keys[i] = pool->keys[--pool->numKeys];
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&pool->keysLock);
+}
+
+/* Do a private key operation with a cached key handle.
+ *
+ * returns CRYPTOCB_UNAVAILABLE when the key isn't known here, otherwise the
+ * result of the operation.
+ */
+static int Pkcs11Pool_KeyOp(Pkcs11Pool* pool, Pkcs11Token* token,
+    const byte* id, int idLen, CK_MECHANISM_TYPE mechType, int decrypt,
+    const byte* in, word32 inLen, byte* out, CK_ULONG* outLen)
+{
+    int              ret;
+    CK_RV            rv;
+    CK_OBJECT_HANDLE handle;
+    CK_MECHANISM     mech;
+
+    if (idLen == 0 || idLen > PKCS11_POOL_ID_SZ)
+        return CRYPTOCB_UNAVAILABLE;
+    ret = Pkcs11Pool_FindKey(pool, token, id, idLen, &handle);
+    if (ret != 0)
+        return CRYPTOCB_UNAVAILABLE;
+
+    mech.mechanism      = mechType;
+    mech.pParameter     = NULL;
+    mech.ulParameterLen = 0;
+    if (decrypt) {
+        rv = token->func->C_DecryptInit(token->handle, &mech, handle);
+        if (rv == CKR_OK) {
+            rv = token->func->C_Decrypt(token->handle, (CK_BYTE_PTR)in, inLen,
+                out, outLen);
+        }
+    }
+    else {
+        rv = token->func->C_SignInit(token->handle, &mech, handle);
+        if (rv == CKR_OK) {
+            rv = token->func->C_Sign(token->handle, (CK_BYTE_PTR)in, inLen,
+                out, outLen);
+        }
+    }
+    if (rv == CKR_KEY_HANDLE_INVALID || rv == CKR_OBJECT_HANDLE_INVALID) {
+        /* Key was removed - look it up again next time. */
+        Pkcs11Pool_ForgetKey(pool, handle);
+        return CRYPTOCB_UNAVAILABLE;
+    }
+    return (rv == CKR_OK) ? 0 : WC_HW_E;
+}
+
+#ifdef HAVE_ECC
+static int Pkcs11Pool_EccSign(Pkcs11Pool* pool, Pkcs11Token* token,
+    wc_CryptoInfo* info)
+{
+    int      ret;
+    ecc_key* key = info->pk.eccsign.key;
+    word32   inLen = info->pk.eccsign.inlen;
+    byte     sig[2 * MAX_ECC_BYTES];
+    CK_ULONG sigLen = sizeof(sig);
+
+    /* Token doesn't truncate the hash to the size of the order. */
+    if (key->dp != NULL && inLen > (word32)key->dp->size)
+        inLen = (word32)key->dp->size;
+    ret = Pkcs11Pool_KeyOp(pool, token, key->id, key->idLen, CKM_ECDSA, 0,
+        info->pk.eccsign.in, inLen, sig, &sigLen);
+    if (ret == 0) {
+        /* Token returns r and s, each the size of the order. */
+        ret = wc_ecc_rs_raw_to_sig(sig, (word32)sigLen / 2,
+            sig + sigLen / 2, (word32)sigLen / 2, info->pk.eccsign.out,
+            info->pk.eccsign.outlen);
+    }
+    return ret;
+}
+#endif
+
+#if !defined(NO_RSA) && !defined(WOLF_CRYPTO_CB_RSA_PAD)
+/* Input is already padded for the raw operations. */
+static int Pkcs11Pool_RsaPrivate(Pkcs11Pool* pool, Pkcs11Token* token,
+    wc_CryptoInfo* info)
+{
+    int      ret;
+    RsaKey*  key = info->pk.rsa.key;
+    CK_ULONG outLen = *info->pk.rsa.outLen;
+
+    if (info->pk.rsa.type != RSA_PRIVATE_ENCRYPT &&
+            info->pk.rsa.type != RSA_PRIVATE_DECRYPT)
+        return CRYPTOCB_UNAVAILABLE;
+
+    ret = Pkcs11Pool_KeyOp(pool, token, key->id, key->idLen, CKM_RSA_X_509,
+        info->pk.rsa.type == RSA_PRIVATE_DECRYPT, info->pk.rsa.in,
+        info->pk.rsa.inLen, info->pk.rsa.out, &outLen);
+    if (ret == 0)
+        *info->pk.rsa.outLen = (word32)outLen;
+    return ret;
+}
+#endif
+
+#ifndef NO_HMAC
+/* Session kept by this thread from an HMAC update until the final. */
+static THREAD_LS_T Pkcs11Pool* heldPool = NULL;
+static THREAD_LS_T int         heldIdx = -1;
+static THREAD_LS_T const Hmac* heldHmac = NULL;
+
+/* End the unfinished HMAC in the held session and return it to the pool. */
+static void Pkcs11Pool_Release(void)
+{
+    Pkcs11Token* token = &heldPool->tokens[heldIdx];
+    byte         mac[WC_MAX_DIGEST_SIZE];
+    CK_ULONG     macLen = sizeof(mac);
+
+    /* A final with a large enough buffer always ends the operation. */
+    (void)token->func->C_SignFinal(token->handle, mac, &macLen);
+    Pkcs11Pool_Put(heldPool, heldIdx);
+    heldPool = NULL;
+    heldIdx = -1;
+    heldHmac = NULL;
+}
+#endif
+
+/* Crypto callback of the pool - ctx is the pool. */
+static int Pkcs11Pool_CryptoDevCb(int devId, wc_CryptoInfo* info, void* ctx)
+{
+    Pkcs11Pool*  pool = (Pkcs11Pool*)ctx;
+    Pkcs11Token* token;
+    int          idx;
+    int          ret = CRYPTOCB_UNAVAILABLE;
+
+#ifndef NO_HMAC
+    if (heldPool == pool && info->algo_type == WC_ALGO_TYPE_HMAC &&
+            info->hmac.hmac == heldHmac) {
+        idx = heldIdx;
+        heldPool = NULL;
+        heldHmac = NULL;
+    }
+    else {
+        /* HMAC was abandoned - the session can't be used for anything else
+         * until its operation is ended. */
+        if (heldPool != NULL)
+            Pkcs11Pool_Release();
+        idx = Pkcs11Pool_Get(pool);
+    }
+#else
+    idx = Pkcs11Pool_Get(pool);
+#endif
+    token = &pool->tokens[idx];
+
+    if (pool->useCache && info->algo_type == WC_ALGO_TYPE_PK) {
+    #ifdef HAVE_ECC
+        if (info->pk.type == WC_PK_TYPE_ECDSA_SIGN)
+            ret = Pkcs11Pool_EccSign(pool, token, info);
+    #endif
+    #if !defined(NO_RSA) && !defined(WOLF_CRYPTO_CB_RSA_PAD)
+        if (info->pk.type == WC_PK_TYPE_RSA)
+            ret = Pkcs11Pool_RsaPrivate(pool, token, info);
+    #endif
+    }
+    if (ret == CRYPTOCB_UNAVAILABLE)
+        ret = wc_Pkcs11_CryptoDevCb(devId, info, token);
+
+#ifndef NO_HMAC
+    /* The HMAC operation is in the session until the final. */
+    if (ret == 0 && info->algo_type == WC_ALGO_TYPE_HMAC &&
+            info->hmac.digest == NULL) {
+        heldPool = pool;
+        heldIdx = idx;
+        heldHmac = info->hmac.hmac;
+        return ret;
+    }
+#endif
+    Pkcs11Pool_Put(pool, idx);
+    return ret;
+}
+
+
+int Pkcs11Pool_Init(Pkcs11Pool* pool, Pkcs11Dev* dev, int slotId,
+                    const char* tokenName, const byte* userPin, int userPinSz,
+                    int numSessions, int useCache)
+{
+    int   ret = 0;
+    int   i;
+    CK_RV rv;
+
+    if (pool == NULL || dev == NULL || numSessions <= 0)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(pool, 0, sizeof(*pool));
+    pool->tokens = (Pkcs11Token*)XMALLOC(sizeof(Pkcs11Token) * numSessions,
+        NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    pool->free = (int*)XMALLOC(sizeof(int) * numSessions, NULL,
+        DYNAMIC_TYPE_TMP_BUFFER);
+    if (pool->tokens == NULL || pool->free == NULL) {
+        XFREE(pool->tokens, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(pool->free, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return MEMORY_E;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pthread_rwlock_init(&pool->keysLock, NULL);
+    pool->useCache = useCache;
+
+    for (i = 0; i < numSessions && ret == 0; i++) {
+        /* Login is shared by all sessions so tokens don't keep the PIN. */
+        ret = wc_Pkcs11Token_Init(&pool->tokens[i], dev, slotId, tokenName,
+            NULL, 0);
+        if (ret == 0) {
+            ret = wc_Pkcs11Token_Open(&pool->tokens[i], 1);
+            if (ret != 0)
+                wc_Pkcs11Token_Final(&pool->tokens[i]);
+        }
+        if (ret == 0) {
+            pool->free[i] = i;
+            pool->numTokens++;
+        }
+    }
+    if (ret == 0 && userPin != NULL) {
+        rv = pool->tokens[0].func->C_Login(pool->tokens[0].handle, CKU_USER,
+            (CK_UTF8CHAR_PTR)userPin, (CK_ULONG)userPinSz);
+        if (rv != CKR_OK && rv != CKR_USER_ALREADY_LOGGED_IN)
+            ret = WC_HW_E;
+    }
+    pool->numFree = pool->numTokens;
+
+    if (ret != 0)
+        Pkcs11Pool_Free(pool);
+    return ret;
+}
+
+int Pkcs11Pool_Register(Pkcs11Pool* pool, int devId)
+{
+    return wc_CryptoCb_RegisterDevice(devId, Pkcs11Pool_CryptoDevCb, pool);
+}
+
+#ifndef NO_HMAC
+void Pkcs11Pool_HmacFree(Hmac* hmac)
+{
+    if (hmac == NULL)
+        return;
+
+    if (heldPool != NULL && heldHmac == hmac)
+        Pkcs11Pool_Release();
+    wc_HmacFree(hmac);
+}
+#endif
+
+void Pkcs11Pool_Free(Pkcs11Pool* pool)
+{
+    int i;
+
+    if (pool == NULL || pool->tokens == NULL)
+        return;
+
+    /* Only close the pool's sessions - others of the application remain. */
+    for (i = 0; i < pool->numTokens; i++)
+        wc_Pkcs11Token_Close(&pool->tokens[i]);
+    XFREE(pool->tokens, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(pool->free, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    pool->tokens = NULL;
+    pool->free = NULL;
+    pthread_rwlock_destroy(&pool->keysLock);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+#endif /* HAVE_PKCS11 && WOLF_CRYPTO_CB */
@@ -0,0 +1,87 @@
+/* pkcs11_pool.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef _PKCS11_POOL_H_
+#define _PKCS11_POOL_H_
+
+#include <pthread.h>
+
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+#include <wolfssl/wolfcrypt/wc_pkcs11.h>
+
+/* Maximum number of private key handles remembered. */
+#ifndef PKCS11_POOL_CACHE_SZ
+    #define PKCS11_POOL_CACHE_SZ    32
+#endif
+/* Longest key identifier remembered. */
+#define PKCS11_POOL_ID_SZ           32
+
+/* A private key object found by its identifier. */
+typedef struct Pkcs11PoolKey {
+    byte             id[PKCS11_POOL_ID_SZ];
+    int              idLen;
+    CK_OBJECT_HANDLE handle;
+} Pkcs11PoolKey;
+
+/* Sessions open on one slot, handed out one per operation.
+ *
+ * Register the pool with Pkcs11Pool_Register() in place of registering
+ * wc_Pkcs11_CryptoDevCb with a single token.
+ */
+typedef struct Pkcs11Pool {
+    /* One token per session - each has its session open. */
+    Pkcs11Token*     tokens;
+    int              numTokens;
+    /* Indices of the tokens not in use. */
+    int*             free;
+    int              numFree;
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    /* Private key handles - valid in all sessions of the application. */
+    int              useCache;
+    Pkcs11PoolKey    keys[PKCS11_POOL_CACHE_SZ];
+    int              numKeys;
+    pthread_rwlock_t keysLock;
+    /* Statistics - changed under lock. */
+    long             ops;
+    long             waits;
+    long             cacheHits;
+    long             cacheMisses;
+} Pkcs11Pool;
+
+/* Open numSessions sessions on the slot. useCache remembers private key
+ * handles and does ECDSA and raw RSA private key operations with them. */
+int  Pkcs11Pool_Init(Pkcs11Pool* pool, Pkcs11Dev* dev, int slotId,
+                     const char* tokenName, const byte* userPin, int userPinSz,
+                     int numSessions, int useCache);
+/* Perform operations of the device identifier using the pool. */
+int  Pkcs11Pool_Register(Pkcs11Pool* pool, int devId);
+#ifndef NO_HMAC
+/* Free an HMAC of the pool's device. Use in place of wc_HmacFree() so that a
+ * session held for an unfinished HMAC is returned to the pool. */
+void Pkcs11Pool_HmacFree(Hmac* hmac);
+#endif
+/* Close all sessions. */
+void Pkcs11Pool_Free(Pkcs11Pool* pool);
+
+#endif /* !_PKCS11_POOL_H_ */
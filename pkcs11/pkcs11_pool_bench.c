@@ -0,0 +1,304 @@
+/* pkcs11_pool_bench.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Measure ECDSA signs per second through a PKCS #11 token as the number of
+ * threads grows, with:
+ *   - one session shared by all threads (as with a single Pkcs11Token),
+ *   - a pool with a session per thread,
+ *   - a pool with a session per thread and cached key handles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "pkcs11_pool.h"
+
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/cryptocb.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/logging.h>
+
+/* Device identifier of the token used to generate the key. */
+#define KEYGEN_DEVID    1
+/* Device identifier of the pool being measured. */
+#define POOL_DEVID      2
+/* Identifier of the key on the token. */
+#define KEY_ID          "pool-bench-ecc"
+/* Default maximum number of threads. */
+#define MAX_THREADS     16
+/* Default seconds to run each measurement. */
+#define BENCH_SECS      3
+
+#if defined(HAVE_PKCS11) && defined(WOLF_CRYPTO_CB) && defined(HAVE_ECC)
+
+/* Data for each signing thread. */
+typedef struct BenchThread {
+    pthread_t tid;
+    long      signs;
+    int       ret;
+} BenchThread;
+
+/* Public key of the generated key - each thread makes its own key object. */
+static byte              pubKey[2 * MAX_ECC_BYTES + 1];
+static word32            pubKeySz;
+static volatile int      stop;
+
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1000000;
+}
+
+/* Generate the key on the token with the identifier and keep the public
+ * key. */
+static int gen_key(WC_RNG* rng)
+{
+    int     ret;
+    ecc_key key;
+
+    ret = wc_ecc_init_id(&key, (unsigned char*)KEY_ID, sizeof(KEY_ID) - 1,
+        NULL, KEYGEN_DEVID);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex2(rng, 32, &key, ECC_SECP256R1,
+            WC_ECC_FLAG_DEC_SIGN);
+        if (ret != 0)
+            fprintf(stderr, "Failed to generate EC key: %d\n", ret);
+        if (ret == 0) {
+            pubKeySz = sizeof(pubKey);
+            ret = wc_ecc_export_x963(&key, pubKey, &pubKeySz);
+        }
+        wc_ecc_free(&key);
+    }
+    return ret;
+}
+
+/* Sign until stopped, then check the last signature in software. */
+static void* sign_thread(void* args)
+{
+    BenchThread* t = (BenchThread*)args;
+    ecc_key      key;
+    WC_RNG       rng;
+    byte         hash[32];
+    byte         sig[ECC_MAX_SIG_SIZE];
+    word32       sigSz = 0;
+    int          verify = 0;
+
+    memset(hash, 9, sizeof(hash));
+    t->ret = wc_InitRng(&rng);
+    if (t->ret != 0)
+        return NULL;
+    t->ret = wc_ecc_init_id(&key, (unsigned char*)KEY_ID, sizeof(KEY_ID) - 1,
+        NULL, POOL_DEVID);
+    if (t->ret == 0) {
+        t->ret = wc_ecc_import_x963_ex(pubKey, pubKeySz, &key,
+            ECC_SECP256R1);
+    }
+    while (t->ret == 0 && !stop) {
+        sigSz = sizeof(sig);
+        t->ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &sigSz, &rng, &key);
+        if (t->ret == 0)
+            t->signs++;
+    }
+    if (t->ret == 0 && t->signs > 0) {
+        /* Don't use device for public key operation. */
+        key.devId = INVALID_DEVID;
+        t->ret = wc_ecc_verify_hash(sig, sigSz, hash, sizeof(hash), &verify,
+            &key);
+        if (t->ret == 0 && !verify)
+            t->ret = SIG_VERIFY_E;
+    }
+    wc_ecc_free(&key);
+    wc_FreeRng(&rng);
+    return NULL;
+}
+
+/* Run one measurement and print a row of the table. */
+static int bench(Pkcs11Dev* dev, int slotId, const char* tokenName,
+    const char* userPin, int numThreads, int numSessions, int useCache,
+    int secs)
+{
+    int         ret;
+    int         i;
+    int         started;
+    long        signs = 0;
+    double      start;
+    Pkcs11Pool  pool;
+    BenchThread threads[256];
+
+    ret = Pkcs11Pool_Init(&pool, dev, slotId, tokenName, (const byte*)userPin,
+        userPin == NULL ? 0 : (int)strlen(userPin), numSessions, useCache);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to open %d sessions: %d\n", numSessions, ret);
+        return ret;
+    }
+    ret = Pkcs11Pool_Register(&pool, POOL_DEVID);
+    if (ret != 0) {
+        Pkcs11Pool_Free(&pool);
+        return ret;
+    }
+
+    memset(threads, 0, sizeof(threads));
+    stop = 0;
+    start = now();
+    for (started = 0; started < numThreads; started++) {
+        if (pthread_create(&threads[started].tid, NULL, sign_thread,
+                &threads[started]) != 0)
+            break;
+    }
+    sleep(secs);
+    stop = 1;
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i].tid, NULL);
+        signs += threads[i].signs;
+        if (threads[i].ret != 0 && ret == 0)
+            ret = threads[i].ret;
+    }
+    start = now() - start;
+
+    /* Without the cache every operation finds the key on the token. */
+    printf("%8d  %8d  %5s  %10.1f  %8ld  %8ld\n", started, pool.numTokens,
+        useCache ? "yes" : "no", signs / start, pool.waits,
+        useCache ? pool.cacheMisses : pool.ops);
+    if (ret != 0)
+        fprintf(stderr, "Signing failed: %d\n", ret);
+
+    wc_CryptoCb_UnRegisterDevice(POOL_DEVID);
+    Pkcs11Pool_Free(&pool);
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    int         ret;
+    const char* library;
+    const char* slot;
+    const char* tokenName;
+    const char* userPin;
+    Pkcs11Dev   dev;
+    Pkcs11Token token;
+    WC_RNG      rng;
+    int         slotId;
+    int         maxThreads = MAX_THREADS;
+    int         secs = BENCH_SECS;
+    int         t;
+
+    if (argc < 5 || argc > 7) {
+        fprintf(stderr,
+           "Usage: pkcs11_pool_bench <libname> <slot> <tokenname> <userpin> "
+           "[maxthreads] [seconds]\n");
+        return 1;
+    }
+
+    library = argv[1];
+    slot = argv[2];
+    tokenName = argv[3];
+    userPin = argv[4];
+    slotId = atoi(slot);
+    if (argc > 5)
+        maxThreads = atoi(argv[5]);
+    if (argc > 6)
+        secs = atoi(argv[6]);
+    if (maxThreads < 1 || maxThreads > 256 || secs < 1) {
+        fprintf(stderr, "Threads must be 1-256 and seconds at least 1\n");
+        return 1;
+    }
+
+#if defined(DEBUG_WOLFSSL)
+    wolfSSL_Debugging_ON();
+#endif
+    wolfCrypt_Init();
+
+    ret = wc_Pkcs11_Initialize(&dev, library, NULL);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to initialize PKCS#11 library\n");
+        ret = 2;
+    }
+    if (ret == 0) {
+        ret = wc_Pkcs11Token_Init(&token, &dev, slotId, tokenName,
+            (byte*)userPin, strlen(userPin));
+        if (ret != 0) {
+            fprintf(stderr, "Failed to initialize PKCS#11 token\n");
+            ret = 2;
+        }
+        if (ret == 0) {
+            /* Session stays open so the key lasts for all measurements. */
+            ret = wc_Pkcs11Token_Open(&token, 1);
+            if (ret == 0) {
+                ret = wc_CryptoDev_RegisterDevice(KEYGEN_DEVID,
+                    wc_Pkcs11_CryptoDevCb, &token);
+            }
+            if (ret == 0)
+                ret = wc_InitRng(&rng);
+            if (ret == 0) {
+                ret = gen_key(&rng);
+                wc_FreeRng(&rng);
+            }
+            if (ret != 0) {
+                fprintf(stderr, "Failed to create key on token\n");
+                ret = 2;
+            }
+
+            if (ret == 0) {
+                printf(" Threads  Sessions  Cache     Signs/s     Waits  "
+                       "Lookups\n");
+                for (t = 1; ret == 0 && t <= maxThreads; t *= 2) {
+                    /* One session shared by all threads. */
+                    ret = bench(&dev, slotId, tokenName, userPin, t, 1, 0,
+                        secs);
+                    if (ret == 0) {
+                        ret = bench(&dev, slotId, tokenName, userPin, t, t, 0,
+                            secs);
+                    }
+                    if (ret == 0) {
+                        ret = bench(&dev, slotId, tokenName, userPin, t, t, 1,
+                            secs);
+                    }
+                }
+                if (ret != 0)
+                    ret = 1;
+            }
+            wc_Pkcs11Token_Final(&token);
+        }
+        wc_Pkcs11_Finalize(&dev);
+    }
+
+    wolfCrypt_Cleanup();
+
+    return ret;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with --enable-pkcs11 and "
+           "ECC\n");
+    return 0;
+}
+
+#endif
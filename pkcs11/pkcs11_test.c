@@ -20,6 +20,10 @@
  */
 
 
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+
 #include <wolfssl/options.h>
 #include <wolfssl/wolfcrypt/settings.h>
 #include <wolfssl/wolfcrypt/wc_pkcs11.h>
@@ -27,6 +31,8 @@
 #include <wolfssl/wolfcrypt/error-crypt.h>
 #include <wolfssl/wolfcrypt/logging.h>
 
+#include "pkcs11_pool.h"
+
 #ifndef NO_RSA
 static const unsigned char client_key_der_2048[] =
 {
@@ -1371,6 +1377,801 @@ int pkcs11_test(int devId, Pkcs11Token* token)
     return ret;
 }
 
+/* Benchmark of the mechanisms through the token and in software.
+ *
+ * Each thread of the token runs gets its own session from a Pkcs11Pool.
+ */
+
+/* Device identifier of the session pool used when benchmarking. */
+#define BENCH_DEVID         2
+/* Default number of seconds to run each benchmark. */
+#define BENCH_SECS          1
+/* Default maximum number of threads. */
+#define BENCH_MAX_THREADS   4
+/* Latencies are counted in buckets, BENCH_HIST_SUB to each doubling from
+ * BENCH_HIST_MIN microseconds, so a percentile is within 1/32 of its value. */
+#define BENCH_HIST_MIN      0.01
+#define BENCH_HIST_SUB      32
+#define BENCH_HIST_SZ       (BENCH_HIST_SUB * 40)
+/* Largest buffer processed by symmetric operations. */
+#define BENCH_MAX_SZ        16384
+
+enum {
+    BENCH_KEY_RSA,
+    BENCH_KEY_ECC
+};
+
+/* Private key used by a benchmark - one on the token and one in software. */
+typedef struct BenchKey {
+    int         type;
+    const char* id;
+    /* Bits of RSA modulus or bytes of ECC curve order. */
+    int         size;
+    int         curveId;
+    /* Public key of the key on the token. */
+    byte        pub[1024];
+    word32      pubSz;
+    byte        exp[8];
+    word32      expSz;
+    /* DER encoding of the software private key. */
+    byte        der[2400];
+    word32      derSz;
+    int         ready;
+} BenchKey;
+
+/* Objects of a benchmark owned by one thread. */
+typedef struct BenchCtx {
+    int     devId;
+    WC_RNG  rng;
+#ifndef NO_RSA
+    RsaKey  rsa;
+#endif
+#ifdef HAVE_ECC
+    ecc_key ecc;
+    ecc_key peer;
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+    Aes     aes;
+#endif
+#ifndef NO_HMAC
+    Hmac    hmac;
+#endif
+    WC_RNG  devRng;
+    byte    in[BENCH_MAX_SZ];
+    byte    out[BENCH_MAX_SZ];
+    byte    tag[16];
+} BenchCtx;
+
+typedef struct BenchCase BenchCase;
+/* Set up, perform and free the operation of a benchmark. */
+typedef int (*BenchInitFunc)(BenchCtx* ctx, const BenchCase* bc);
+typedef int (*BenchOpFunc)(BenchCtx* ctx, const BenchCase* bc);
+typedef void (*BenchFreeFunc)(BenchCtx* ctx, const BenchCase* bc);
+
+struct BenchCase {
+    const char*   name;
+    BenchKey*     key;
+    /* Bytes of data processed by each operation. */
+    word32        size;
+    BenchInitFunc init;
+    BenchOpFunc   op;
+    BenchFreeFunc free;
+};
+
+/* Result of running a benchmark with a number of threads. */
+typedef struct BenchResult {
+    const char* name;
+    const char* device;
+    word32      size;
+    int         threads;
+    long        ops;
+    double      secs;
+    double      min;
+    double      mean;
+    double      p50;
+    double      p90;
+    double      p99;
+    double      max;
+} BenchResult;
+
+/* Data for each benchmark thread. */
+typedef struct BenchThread {
+    pthread_t           tid;
+    const BenchCase*    bc;
+    int                 devId;
+    /* Count of operations by latency - see bench_hist_idx(). */
+    long*               hist;
+    /* Latencies of all operations in microseconds. */
+    double              min;
+    double              max;
+    double              total;
+    long                ops;
+    int                 ret;
+} BenchThread;
+
+static volatile int    bench_stop;
+/* Threads wait until all are ready before starting. */
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  bench_cond = PTHREAD_COND_INITIALIZER;
+static int             bench_ready;
+static int             bench_go;
+
+#if !defined(NO_RSA) && defined(WOLFSSL_KEY_GEN)
+static BenchKey bench_rsa2048 = { BENCH_KEY_RSA, "bench-rsa2048", 2048 };
+static BenchKey bench_rsa3072 = { BENCH_KEY_RSA, "bench-rsa3072", 3072 };
+#endif
+#ifdef HAVE_ECC
+static BenchKey bench_p256 = { BENCH_KEY_ECC, "bench-p256", 32, ECC_SECP256R1 };
+#ifdef HAVE_ECC384
+static BenchKey bench_p384 = { BENCH_KEY_ECC, "bench-p384", 48, ECC_SECP384R1 };
+#endif
+#endif
+
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000 + (double)ts.tv_nsec / 1000;
+}
+
+#if !defined(NO_RSA) && defined(WOLFSSL_KEY_GEN)
+/* Generate the RSA key on the token and in software. */
+static int bench_gen_rsa(BenchKey* bk, int devId)
+{
+    int    ret;
+    int    derSz;
+    RsaKey key;
+
+    ret = wc_InitRsaKey_Id(&key, (unsigned char*)bk->id, (int)XSTRLEN(bk->id),
+        NULL, devId);
+    if (ret == 0) {
+        ret = wc_MakeRsaKey(&key, bk->size, WC_RSA_EXPONENT, &rng);
+        if (ret == 0) {
+            bk->expSz = sizeof(bk->exp);
+            bk->pubSz = sizeof(bk->pub);
+            ret = wc_RsaFlattenPublicKey(&key, bk->exp, &bk->expSz, bk->pub,
+                &bk->pubSz);
+        }
+        wc_FreeRsaKey(&key);
+    }
+    if (ret == 0)
+        ret = wc_InitRsaKey(&key, NULL);
+    if (ret == 0) {
+        ret = wc_MakeRsaKey(&key, bk->size, WC_RSA_EXPONENT, &rng);
+        if (ret == 0) {
+            derSz = wc_RsaKeyToDer(&key, bk->der, sizeof(bk->der));
+            if (derSz < 0)
+                ret = derSz;
+            else
+                bk->derSz = (word32)derSz;
+        }
+        wc_FreeRsaKey(&key);
+    }
+    if (ret != 0)
+        fprintf(stderr, "Failed to generate RSA-%d keys: %d\n", bk->size, ret);
+
+    return ret;
+}
+
+static int bench_rsa_init(BenchCtx* ctx, const BenchCase* bc)
+{
+    int       ret;
+    word32    idx = 0;
+    BenchKey* bk = bc->key;
+
+    if (ctx->devId == INVALID_DEVID) {
+        ret = wc_InitRsaKey(&ctx->rsa, NULL);
+        if (ret == 0)
+            ret = wc_RsaPrivateKeyDecode(bk->der, &idx, &ctx->rsa, bk->derSz);
+    }
+    else {
+        ret = wc_InitRsaKey_Id(&ctx->rsa, (unsigned char*)bk->id,
+            (int)XSTRLEN(bk->id), NULL, ctx->devId);
+        if (ret == 0) {
+            ret = wc_RsaPublicKeyDecodeRaw(bk->pub, bk->pubSz, bk->exp,
+                bk->expSz, &ctx->rsa);
+        }
+    }
+#ifdef WC_RSA_BLINDING
+    if (ret == 0)
+        ret = wc_RsaSetRNG(&ctx->rsa, &ctx->rng);
+#endif
+
+    return ret;
+}
+
+static int bench_rsa_sign(BenchCtx* ctx, const BenchCase* bc)
+{
+    int ret;
+
+    (void)bc;
+
+    /* PKCS #1 v1.5 signature of a SHA-256 DigestInfo sized input. */
+    ret = wc_RsaSSL_Sign(ctx->in, 51, ctx->out, sizeof(ctx->out), &ctx->rsa,
+        &ctx->rng);
+    return (ret < 0) ? ret : 0;
+}
+
+static void bench_rsa_free(BenchCtx* ctx, const BenchCase* bc)
+{
+    (void)bc;
+
+    wc_FreeRsaKey(&ctx->rsa);
+}
+#endif
+
+#ifdef HAVE_ECC
+/* Generate the ECC key on the token and in software. */
+static int bench_gen_ecc(BenchKey* bk, int devId)
+{
+    int     ret;
+    int     derSz;
+    ecc_key key;
+
+    ret = wc_ecc_init_id(&key, (unsigned char*)bk->id, (int)XSTRLEN(bk->id),
+        NULL, devId);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex(&rng, bk->size, &key, bk->curveId);
+        if (ret == 0) {
+            bk->pubSz = sizeof(bk->pub);
+            ret = wc_ecc_export_x963(&key, bk->pub, &bk->pubSz);
+        }
+        wc_ecc_free(&key);
+    }
+    if (ret == 0)
+        ret = wc_ecc_init(&key);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex(&rng, bk->size, &key, bk->curveId);
+        if (ret == 0) {
+            derSz = wc_EccKeyToDer(&key, bk->der, sizeof(bk->der));
+            if (derSz < 0)
+                ret = derSz;
+            else
+                bk->derSz = (word32)derSz;
+        }
+        wc_ecc_free(&key);
+    }
+    if (ret != 0) {
+        fprintf(stderr, "Failed to generate ECC-%d keys: %d\n", bk->size * 8,
+            ret);
+    }
+
+    return ret;
+}
+
+static int bench_ecc_init(BenchCtx* ctx, const BenchCase* bc)
+{
+    int       ret;
+    word32    idx = 0;
+    BenchKey* bk = bc->key;
+
+    if (ctx->devId == INVALID_DEVID) {
+        ret = wc_ecc_init(&ctx->ecc);
+        if (ret == 0)
+            ret = wc_EccPrivateKeyDecode(bk->der, &idx, &ctx->ecc, bk->derSz);
+    }
+    else {
+        ret = wc_ecc_init_id(&ctx->ecc, (unsigned char*)bk->id,
+            (int)XSTRLEN(bk->id), NULL, ctx->devId);
+        if (ret == 0) {
+            ret = wc_ecc_import_x963_ex(bk->pub, bk->pubSz, &ctx->ecc,
+                bk->curveId);
+        }
+    }
+#if defined(ECC_TIMING_RESISTANT) && (!defined(HAVE_FIPS) || \
+    (!defined(HAVE_FIPS_VERSION) || (HAVE_FIPS_VERSION != 2))) && \
+    !defined(HAVE_SELFTEST)
+    if (ret == 0)
+        ret = wc_ecc_set_rng(&ctx->ecc, &ctx->rng);
+#endif
+    /* Peer's key for ECDH - always in software. */
+    if (ret == 0)
+        ret = wc_ecc_init(&ctx->peer);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex(&ctx->rng, bk->size, &ctx->peer,
+            bk->curveId);
+    }
+
+    return ret;
+}
+
+static int bench_ecdsa_sign(BenchCtx* ctx, const BenchCase* bc)
+{
+    word32 outSz = sizeof(ctx->out);
+
+    return wc_ecc_sign_hash(ctx->in, (word32)bc->key->size, ctx->out, &outSz,
+        &ctx->rng, &ctx->ecc);
+}
+
+static int bench_ecdh(BenchCtx* ctx, const BenchCase* bc)
+{
+    word32 outSz = sizeof(ctx->out);
+
+    (void)bc;
+
+    return wc_ecc_shared_secret(&ctx->ecc, &ctx->peer, ctx->out, &outSz);
+}
+
+static void bench_ecc_free(BenchCtx* ctx, const BenchCase* bc)
+{
+    (void)bc;
+
+    wc_ecc_free(&ctx->peer);
+    wc_ecc_free(&ctx->ecc);
+}
+#endif
+
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+static int bench_aesgcm_init(BenchCtx* ctx, const BenchCase* bc)
+{
+    int ret;
+
+    (void)bc;
+
+    ret = wc_AesInit(&ctx->aes, NULL, ctx->devId);
+    if (ret == 0)
+        ret = wc_AesGcmSetKey(&ctx->aes, ctx->in, AES_256_KEY_SIZE);
+
+    return ret;
+}
+
+static int bench_aesgcm_enc(BenchCtx* ctx, const BenchCase* bc)
+{
+    /* Same nonce each time - only acceptable when benchmarking. */
+    return wc_AesGcmEncrypt(&ctx->aes, ctx->out, ctx->in, bc->size, ctx->in,
+        GCM_NONCE_MID_SZ, ctx->tag, sizeof(ctx->tag), NULL, 0);
+}
+
+static void bench_aesgcm_free(BenchCtx* ctx, const BenchCase* bc)
+{
+    (void)bc;
+
+    wc_AesFree(&ctx->aes);
+}
+#endif
+
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+static int bench_hmac_init(BenchCtx* ctx, const BenchCase* bc)
+{
+    int ret;
+
+    (void)bc;
+
+    ret = wc_HmacInit(&ctx->hmac, NULL, ctx->devId);
+    if (ret == 0)
+        ret = wc_HmacSetKey(&ctx->hmac, WC_SHA256, ctx->in, 32);
+
+    return ret;
+}
+
+static int bench_hmac(BenchCtx* ctx, const BenchCase* bc)
+{
+    int ret;
+
+    ret = wc_HmacUpdate(&ctx->hmac, ctx->in, bc->size);
+    if (ret == 0)
+        ret = wc_HmacFinal(&ctx->hmac, ctx->out);
+
+    return ret;
+}
+
+static void bench_hmac_free(BenchCtx* ctx, const BenchCase* bc)
+{
+    (void)bc;
+
+    /* Returns a session still held by the pool for an unfinished HMAC. */
+    Pkcs11Pool_HmacFree(&ctx->hmac);
+}
+#endif
+
+static int bench_rng_init(BenchCtx* ctx, const BenchCase* bc)
+{
+    (void)bc;
+
+    return wc_InitRng_ex(&ctx->devRng, NULL, ctx->devId);
+}
+
+static int bench_rng(BenchCtx* ctx, const BenchCase* bc)
+{
+    return wc_RNG_GenerateBlock(&ctx->devRng, ctx->out, bc->size);
+}
+
+static void bench_rng_free(BenchCtx* ctx, const BenchCase* bc)
+{
+    (void)bc;
+
+    wc_FreeRng(&ctx->devRng);
+}
+
+static const BenchCase bench_cases[] = {
+#if !defined(NO_RSA) && defined(WOLFSSL_KEY_GEN)
+    { "RSA-2048 sign", &bench_rsa2048, 0,
+      bench_rsa_init, bench_rsa_sign, bench_rsa_free },
+    { "RSA-3072 sign", &bench_rsa3072, 0,
+      bench_rsa_init, bench_rsa_sign, bench_rsa_free },
+#endif
+#ifdef HAVE_ECC
+    { "ECDSA P-256 sign", &bench_p256, 0,
+      bench_ecc_init, bench_ecdsa_sign, bench_ecc_free },
+#ifdef HAVE_ECC384
+    { "ECDSA P-384 sign", &bench_p384, 0,
+      bench_ecc_init, bench_ecdsa_sign, bench_ecc_free },
+#endif
+    { "ECDH P-256", &bench_p256, 0,
+      bench_ecc_init, bench_ecdh, bench_ecc_free },
+#ifdef HAVE_ECC384
+    { "ECDH P-384", &bench_p384, 0,
+      bench_ecc_init, bench_ecdh, bench_ecc_free },
+#endif
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+    { "AES-256-GCM enc", NULL, 16,
+      bench_aesgcm_init, bench_aesgcm_enc, bench_aesgcm_free },
+    { "AES-256-GCM enc", NULL, 256,
+      bench_aesgcm_init, bench_aesgcm_enc, bench_aesgcm_free },
+    { "AES-256-GCM enc", NULL, 1024,
+      bench_aesgcm_init, bench_aesgcm_enc, bench_aesgcm_free },
+    { "AES-256-GCM enc", NULL, BENCH_MAX_SZ,
+      bench_aesgcm_init, bench_aesgcm_enc, bench_aesgcm_free },
+#endif
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+    { "HMAC-SHA256", NULL, 1024,
+      bench_hmac_init, bench_hmac, bench_hmac_free },
+#endif
+    { "RNG", NULL, 32,
+      bench_rng_init, bench_rng, bench_rng_free },
+};
+#define BENCH_CASES_CNT     (int)(sizeof(bench_cases) / sizeof(*bench_cases))
+
+/* Bucket of a latency in microseconds. */
+static int bench_hist_idx(double lat)
+{
+    int    exp;
+    int    idx;
+    double m = frexp(lat / BENCH_HIST_MIN, &exp);
+
+    if (exp < 1)
+        return 0;
+    /* m is in [0.5, 1): split each doubling evenly. */
+    idx = (exp - 1) * BENCH_HIST_SUB + (int)((2 * m - 1) * BENCH_HIST_SUB);
+    return (idx < BENCH_HIST_SZ) ? idx : BENCH_HIST_SZ - 1;
+}
+
+/* Middle latency of a bucket in microseconds. */
+static double bench_hist_val(int idx)
+{
+    return ldexp(BENCH_HIST_MIN * (1 + (idx % BENCH_HIST_SUB + 0.5) /
+        BENCH_HIST_SUB), idx / BENCH_HIST_SUB);
+}
+
+/* Latency that a percentage of the operations took at most. */
+static double bench_hist_pct(const long* hist, long ops, int pct,
+    const BenchResult* res)
+{
+    int    i;
+    long   rank = ops * pct / 100;
+    long   seen = 0;
+    double val;
+
+    for (i = 0; i < BENCH_HIST_SZ - 1; i++) {
+        seen += hist[i];
+        if (seen > rank)
+            break;
+    }
+    val = bench_hist_val(i);
+    if (val < res->min)
+        val = res->min;
+    if (val > res->max)
+        val = res->max;
+    return val;
+}
+
+/* Perform the operation until stopped, counting each latency. */
+static void* bench_thread(void* args)
+{
+    BenchThread* t = (BenchThread*)args;
+    BenchCtx*    ctx;
+    double       start;
+    double       end;
+    double       lat;
+
+    ctx = (BenchCtx*)XMALLOC(sizeof(BenchCtx), NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (ctx == NULL)
+        t->ret = MEMORY_E;
+    else {
+        memset(ctx, 0, sizeof(BenchCtx));
+        memset(ctx->in, 9, sizeof(ctx->in));
+        ctx->devId = t->devId;
+        t->ret = wc_InitRng(&ctx->rng);
+        if (t->ret == 0) {
+            t->ret = t->bc->init(ctx, t->bc);
+            if (t->ret != 0)
+                t->bc->free(ctx, t->bc);
+        }
+    }
+
+    /* All threads start together - even when they failed to set up. */
+    pthread_mutex_lock(&bench_lock);
+    bench_ready++;
+    pthread_cond_broadcast(&bench_cond);
+    while (!bench_go)
+        pthread_cond_wait(&bench_cond, &bench_lock);
+    pthread_mutex_unlock(&bench_lock);
+
+    if (t->ret == 0) {
+        end = bench_now();
+        while (!bench_stop) {
+            start = end;
+            t->ret = t->bc->op(ctx, t->bc);
+            if (t->ret != 0)
+                break;
+            end = bench_now();
+            lat = end - start;
+            t->hist[bench_hist_idx(lat)]++;
+            if (t->ops == 0 || lat < t->min)
+                t->min = lat;
+            if (lat > t->max)
+                t->max = lat;
+            t->total += lat;
+            t->ops++;
+        }
+        t->bc->free(ctx, t->bc);
+    }
+    if (ctx != NULL) {
+        wc_FreeRng(&ctx->rng);
+        XFREE(ctx, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+
+    return NULL;
+}
+
+/* Run a benchmark with a number of threads and summarize the latencies. */
+static int bench_run(const BenchCase* bc, int devId, int numThreads, int secs,
+    BenchResult* res)
+{
+    int               ret = 0;
+    int               i;
+    int               j;
+    int               started;
+    double            start;
+    double            total = 0;
+    long*             hist;
+    BenchThread*      threads;
+
+    threads = (BenchThread*)XMALLOC(sizeof(BenchThread) * numThreads, NULL,
+        DYNAMIC_TYPE_TMP_BUFFER);
+    /* One histogram for each thread and one for all. */
+    hist = (long*)XMALLOC(sizeof(long) * BENCH_HIST_SZ * (numThreads + 1),
+        NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (threads == NULL || hist == NULL) {
+        XFREE(hist, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(threads, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return MEMORY_E;
+    }
+    memset(threads, 0, sizeof(BenchThread) * numThreads);
+    memset(hist, 0, sizeof(long) * BENCH_HIST_SZ * (numThreads + 1));
+
+    bench_stop = 0;
+    bench_ready = 0;
+    bench_go = 0;
+    for (started = 0; started < numThreads; started++) {
+        threads[started].bc = bc;
+        threads[started].devId = devId;
+        threads[started].hist = hist + (long)(started + 1) * BENCH_HIST_SZ;
+        if (pthread_create(&threads[started].tid, NULL, bench_thread,
+                &threads[started]) != 0) {
+            break;
+        }
+    }
+    if (started < numThreads) {
+        fprintf(stderr, "Failed to start thread %d\n", started);
+        bench_stop = 1;
+        ret = -1;
+    }
+
+    pthread_mutex_lock(&bench_lock);
+    while (bench_ready < started)
+        pthread_cond_wait(&bench_cond, &bench_lock);
+    bench_go = 1;
+    pthread_cond_broadcast(&bench_cond);
+    pthread_mutex_unlock(&bench_lock);
+    start = bench_now();
+    if (ret == 0)
+        sleep(secs);
+    bench_stop = 1;
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i].tid, NULL);
+        if (threads[i].ret != 0 && ret == 0)
+            ret = threads[i].ret;
+    }
+
+    memset(res, 0, sizeof(*res));
+    res->name = bc->name;
+    res->device = (devId == INVALID_DEVID) ? "software" : "token";
+    res->size = bc->size;
+    res->threads = numThreads;
+    res->secs = (bench_now() - start) / 1000000;
+    /* Add the histograms of all threads into the first. */
+    for (i = 0; i < started; i++) {
+        if (threads[i].ops == 0)
+            continue;
+        if (res->ops == 0 || threads[i].min < res->min)
+            res->min = threads[i].min;
+        if (threads[i].max > res->max)
+            res->max = threads[i].max;
+        res->ops += threads[i].ops;
+        total += threads[i].total;
+        for (j = 0; j < BENCH_HIST_SZ; j++)
+            hist[j] += threads[i].hist[j];
+    }
+    if (ret == 0 && res->ops > 0) {
+        res->mean = total / res->ops;
+        res->p50  = bench_hist_pct(hist, res->ops, 50, res);
+        res->p90  = bench_hist_pct(hist, res->ops, 90, res);
+        res->p99  = bench_hist_pct(hist, res->ops, 99, res);
+    }
+    else {
+        res->min = 0;
+        res->max = 0;
+    }
+
+    XFREE(hist, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(threads, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+
+    return ret;
+}
+
+static void bench_print(const BenchResult* res)
+{
+    char name[32];
+
+    if (res->size > 0)
+        snprintf(name, sizeof(name), "%s %u", res->name, res->size);
+    else
+        snprintf(name, sizeof(name), "%s", res->name);
+    printf("%-22s %-8s %7d %11.1f %9.1f %9.1f %9.1f %9.1f\n", name,
+        res->device, res->threads, res->ops / res->secs, res->p50, res->p90,
+        res->p99, res->max);
+}
+
+/* Write a string as a JSON string. */
+static void bench_json_str(FILE* f, const char* str)
+{
+    fputc('"', f);
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', f);
+        fputc(*str, f);
+    }
+    fputc('"', f);
+}
+
+static int bench_json(const char* file, const char* library, int secs,
+    const BenchResult* res, int numRes)
+{
+    int   i;
+    FILE* f;
+
+    f = fopen(file, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open report file: %s\n", file);
+        return -1;
+    }
+
+    fprintf(f, "{\n  \"library\": ");
+    bench_json_str(f, library);
+    fprintf(f, ",\n  \"seconds\": %d,\n  \"results\": [\n", secs);
+    for (i = 0; i < numRes; i++) {
+        fprintf(f, "    { \"name\": ");
+        bench_json_str(f, res[i].name);
+        fprintf(f, ", \"device\": \"%s\", \"bytes\": %u, \"threads\": %d,\n",
+            res[i].device, res[i].size, res[i].threads);
+        fprintf(f, "      \"ops\": %ld, \"seconds\": %.3f, "
+                   "\"ops_per_sec\": %.1f,\n",
+            res[i].ops, res[i].secs, res[i].ops / res[i].secs);
+        fprintf(f, "      \"latency_us\": { \"min\": %.1f, \"mean\": %.1f, "
+                   "\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+                   "\"max\": %.1f } }%s\n",
+            res[i].min, res[i].mean, res[i].p50, res[i].p90, res[i].p99,
+            res[i].max, (i + 1 < numRes) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+
+    return 0;
+}
+
+int pkcs11_bench(int devId, Pkcs11Token* token, Pkcs11Dev* dev, int slotId,
+                 const char* tokenName, const char* userPin, int secs,
+                 int maxThreads, const char* library, const char* report)
+{
+    int          ret = 0;
+    int          i;
+    int          t;
+    int          numRes = 0;
+    int          maxRes;
+    BenchResult* res;
+    Pkcs11Pool   pool;
+
+    /* Keys generated on the token last while this session is open. */
+    ret = wc_Pkcs11Token_Open(token, 1);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to open session: %d\n", ret);
+        return ret;
+    }
+
+    for (i = 0; ret == 0 && i < BENCH_CASES_CNT; i++) {
+        BenchKey* bk = bench_cases[i].key;
+
+        if (bk == NULL || bk->ready)
+            continue;
+        fprintf(stderr, "Generate %s keys\n", bench_cases[i].name);
+    #if !defined(NO_RSA) && defined(WOLFSSL_KEY_GEN)
+        if (bk->type == BENCH_KEY_RSA)
+            ret = bench_gen_rsa(bk, devId);
+    #endif
+    #ifdef HAVE_ECC
+        if (bk->type == BENCH_KEY_ECC)
+            ret = bench_gen_ecc(bk, devId);
+    #endif
+        bk->ready = 1;
+    }
+
+    for (maxRes = 0, t = 1; t <= maxThreads; t *= 2)
+        maxRes += 2 * BENCH_CASES_CNT;
+    res = (BenchResult*)XMALLOC(sizeof(BenchResult) * maxRes, NULL,
+        DYNAMIC_TYPE_TMP_BUFFER);
+    if (ret == 0 && res == NULL)
+        ret = MEMORY_E;
+
+    if (ret == 0) {
+        printf("%-22s %-8s %7s %11s %9s %9s %9s %9s\n", "Mechanism", "Device",
+            "Threads", "ops/s", "p50 us", "p90 us", "p99 us", "max us");
+    }
+    for (i = 0; ret == 0 && i < BENCH_CASES_CNT; i++) {
+        for (t = 1; ret == 0 && t <= maxThreads; t *= 2) {
+            /* A session for each thread. */
+            ret = Pkcs11Pool_Init(&pool, dev, slotId, tokenName,
+                (const byte*)userPin,
+                userPin == NULL ? 0 : (int)strlen(userPin), t, 0);
+            if (ret == 0) {
+                ret = Pkcs11Pool_Register(&pool, BENCH_DEVID);
+                if (ret == 0) {
+                    ret = bench_run(&bench_cases[i], BENCH_DEVID, t, secs,
+                        &res[numRes]);
+                }
+                if (ret == 0)
+                    bench_print(&res[numRes++]);
+                wc_CryptoCb_UnRegisterDevice(BENCH_DEVID);
+                Pkcs11Pool_Free(&pool);
+            }
+            if (ret == 0) {
+                ret = bench_run(&bench_cases[i], INVALID_DEVID, t, secs,
+                    &res[numRes]);
+                if (ret == 0)
+                    bench_print(&res[numRes++]);
+            }
+            if (ret != 0) {
+                fprintf(stderr, "Failed to benchmark %s: %d\n",
+                    bench_cases[i].name, ret);
+            }
+        }
+    }
+
+    if (ret == 0 && report != NULL)
+        ret = bench_json(report, library, secs, res, numRes);
+
+    XFREE(res, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    wc_Pkcs11Token_Close(token);
+
+    if (ret == 0)
+        fprintf(stderr, "Success\n");
+
+    return ret;
+}
+
 int main(int argc, char* argv[])
 {
     int ret;
@@ -1382,10 +2183,18 @@ int main(int argc, char* argv[])
     Pkcs11Token token;
     int slotId;
     int devId = 1;
-
-    if (argc != 4 && argc != 5) {
+    int bench = 0;
+    int secs = BENCH_SECS;
+    int maxThreads = BENCH_MAX_THREADS;
+    const char* report = NULL;
+
+    if (argc >= 6 && strcmp(argv[5], "bench") == 0)
+        bench = 1;
+    if ((argc != 4 && argc != 5 && !bench) || argc > 9) {
         fprintf(stderr,
-                "Usage: pkcs11_test <libname> <slot> <tokenname> [userpin]\n");
+                "Usage: pkcs11_test <libname> <slot> <tokenname> [userpin]\n"
+                "       pkcs11_test <libname> <slot> <tokenname> <userpin> "
+                "bench [seconds] [maxthreads] [report.json]\n");
         return 1;
     }
 
@@ -1394,6 +2203,16 @@ int main(int argc, char* argv[])
     tokenName = argv[3];
     userPin = (argc == 4) ? NULL : argv[4];
     slotId = atoi(slot);
+    if (argc > 6)
+        secs = atoi(argv[6]);
+    if (argc > 7)
+        maxThreads = atoi(argv[7]);
+    if (argc > 8)
+        report = argv[8];
+    if (secs < 1 || maxThreads < 1) {
+        fprintf(stderr, "Seconds and threads must be at least 1\n");
+        return 1;
+    }
 
 #if defined(DEBUG_WOLFSSL)
     wolfSSL_Debugging_ON();
@@ -1422,7 +2241,12 @@ int main(int argc, char* argv[])
             if (ret == 0) {
                 wc_InitRng_ex(&rng, NULL, devId);
 
-                ret = pkcs11_test(devId, &token);
+                if (bench) {
+                    ret = pkcs11_bench(devId, &token, &dev, slotId,
+                        tokenName, userPin, secs, maxThreads, library, report);
+                }
+                else
+                    ret = pkcs11_test(devId, &token);
                 if (ret != 0)
                     ret = 1;
 
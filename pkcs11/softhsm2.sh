@@ -30,4 +30,7 @@ echo "# Random Number Generation example"
 echo
 echo "# PKCS#11 test"
 ./pkcs11_test /usr/local/lib/softhsm/libsofthsm2.so $SOFTHSM2_SLOTID SoftToken cryptoki
+echo
+echo "# PKCS#11 session pool benchmark"
+./pkcs11_pool_bench /usr/local/lib/softhsm/libsofthsm2.so $SOFTHSM2_SLOTID SoftToken cryptoki 4 1
 
@@ -0,0 +1,489 @@
+/* bench-cryptocb.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * Cost of the operations of a TLS connection through a crypto callback
+ * device compared with the built-in software:
+ *   - AES-256-GCM protection of records of different sizes,
+ *   - ECDHE with P-256: key generation and shared secret,
+ *   - SHA-256 of a handshake transcript built from many updates.
+ *
+ * Each operation is done by a number of threads through:
+ *   software  - no device,
+ *   cryptocb  - myCryptoCb called directly in the thread,
+ *   engine/1  - the emulated offload engine, one request per submission,
+ *   engine/N  - the emulated offload engine, up to N requests per submission.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* threads */
+#include <pthread.h>
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+#include <wolfssl/wolfcrypt/aes.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/cryptocb.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "cryptocb-common.h"
+#include "cryptocb-engine.h"
+
+/* Default number of threads. */
+#define NUM_THREADS         4
+/* Maximum number of threads. */
+#define MAX_THREADS         256
+/* Default maximum number of requests in an engine submission. */
+#define BATCH_MAX           16
+/* Default microseconds each engine submission costs. */
+#define SUBMIT_US           20
+/* Default seconds to run each measurement. */
+#define BENCH_SECS          1
+/* Largest record - TLS maximum plaintext. */
+#define MAX_RECORD_SZ       16384
+/* Bytes of each update and number of updates in a transcript. */
+#define TRANSCRIPT_MSG_SZ   256
+#define TRANSCRIPT_MSGS     256
+
+/* The command line options. */
+#define OPTIONS "?t:b:s:d:"
+
+#if defined(WOLF_CRYPTO_CB) && !defined(NO_AES) && defined(HAVE_AESGCM) && \
+    defined(HAVE_ECC) && !defined(NO_SHA256)
+
+/* How an operation is performed. */
+enum {
+    PATH_SOFTWARE,
+    PATH_CRYPTOCB,
+    PATH_ENGINE_ONE,
+    PATH_ENGINE_BATCH,
+    PATH_CNT
+};
+
+/* Operations benchmarked. */
+enum {
+    OP_AESGCM,
+    OP_ECDHE,
+    OP_TRANSCRIPT
+};
+
+/* Data of each benchmark thread. */
+typedef struct BenchThread {
+    pthread_t tid;
+    int       op;
+    int       devId;
+    word32    size;
+    long      count;
+    int       ret;
+} BenchThread;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static const char* gPathNames[PATH_CNT] = {
+    "software", "cryptocb", "engine/1", "engine/N"
+};
+/* Device identifier of each path. */
+static const int   gPathDevIds[PATH_CNT] = { INVALID_DEVID, 1, 2, 3 };
+
+static volatile int gStop;
+static int          gNumThreads = NUM_THREADS;
+static int          gSecs = BENCH_SECS;
+/* Public key of the peer in ECDHE. */
+static byte         gPeerPub[2 * MAX_ECC_BYTES + 1];
+static word32       gPeerPubSz;
+
+
+static double CurrentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+/* Protect records with AES-256-GCM as TLS does. */
+static int BenchAesGcm(BenchThread* t)
+{
+    int  ret;
+    Aes  aes;
+    byte key[AES_256_KEY_SIZE];
+    byte iv[GCM_NONCE_MID_SZ];
+    byte aad[13];
+    byte tag[AES_BLOCK_SIZE];
+    byte* in;
+    byte* out;
+
+    in = (byte*)malloc(t->size);
+    out = (byte*)malloc(t->size);
+    if (in == NULL || out == NULL) {
+        free(out);
+        free(in);
+        return MEMORY_E;
+    }
+    XMEMSET(key, 1, sizeof(key));
+    XMEMSET(iv, 2, sizeof(iv));
+    XMEMSET(aad, 3, sizeof(aad));
+    XMEMSET(in, 4, t->size);
+
+    ret = wc_AesInit(&aes, NULL, t->devId);
+    if (ret == 0) {
+        ret = wc_AesGcmSetKey(&aes, key, sizeof(key));
+        while (ret == 0 && !gStop) {
+            /* Same nonce each time - only acceptable when benchmarking. */
+            ret = wc_AesGcmEncrypt(&aes, out, in, t->size, iv, sizeof(iv),
+                tag, sizeof(tag), aad, sizeof(aad));
+            if (ret == 0)
+                t->count++;
+        }
+        wc_AesFree(&aes);
+    }
+
+    free(out);
+    free(in);
+    return ret;
+}
+
+/* Generate an ephemeral key and calculate the secret with the peer's key. */
+static int BenchEcdhe(BenchThread* t)
+{
+    int     ret;
+    WC_RNG  rng;
+    ecc_key key;
+    ecc_key peer;
+    byte    secret[MAX_ECC_BYTES];
+    word32  secretSz;
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_init(&peer);
+    if (ret == 0) {
+        ret = wc_ecc_import_x963_ex(gPeerPub, gPeerPubSz, &peer,
+            ECC_SECP256R1);
+    }
+    while (ret == 0 && !gStop) {
+        ret = wc_ecc_init_ex(&key, NULL, t->devId);
+        if (ret != 0)
+            break;
+        ret = wc_ecc_make_key_ex(&rng, 32, &key, ECC_SECP256R1);
+    #if defined(ECC_TIMING_RESISTANT) && (!defined(HAVE_FIPS) || \
+        (!defined(HAVE_FIPS_VERSION) || (HAVE_FIPS_VERSION != 2))) && \
+        !defined(HAVE_SELFTEST)
+        if (ret == 0)
+            ret = wc_ecc_set_rng(&key, &rng);
+    #endif
+        if (ret == 0) {
+            secretSz = sizeof(secret);
+            ret = wc_ecc_shared_secret(&key, &peer, secret, &secretSz);
+        }
+        wc_ecc_free(&key);
+        if (ret == 0)
+            t->count++;
+    }
+    wc_ecc_free(&peer);
+    wc_FreeRng(&rng);
+
+    return ret;
+}
+
+/* Hash a transcript of many messages, as a handshake does. */
+static int BenchTranscript(BenchThread* t)
+{
+    int        ret;
+    int        i;
+    wc_Sha256  sha;
+    byte       msg[TRANSCRIPT_MSG_SZ];
+    byte       digest[WC_SHA256_DIGEST_SIZE];
+
+    XMEMSET(msg, 5, sizeof(msg));
+
+    ret = wc_InitSha256_ex(&sha, NULL, t->devId);
+    while (ret == 0 && !gStop) {
+        for (i = 0; ret == 0 && i < TRANSCRIPT_MSGS; i++)
+            ret = wc_Sha256Update(&sha, msg, sizeof(msg));
+        if (ret == 0)
+            ret = wc_Sha256Final(&sha, digest);
+        if (ret == 0)
+            t->count++;
+    }
+    wc_Sha256Free(&sha);
+
+    return ret;
+}
+
+static void* BenchThreadMain(void* arg)
+{
+    BenchThread* t = (BenchThread*)arg;
+
+    switch (t->op) {
+        case OP_AESGCM:
+            t->ret = BenchAesGcm(t);
+            break;
+        case OP_ECDHE:
+            t->ret = BenchEcdhe(t);
+            break;
+        case OP_TRANSCRIPT:
+            t->ret = BenchTranscript(t);
+            break;
+    }
+
+    return NULL;
+}
+
+/* Run an operation on all threads through a path and print the cost. */
+static int BenchRun(const char* name, int op, word32 size, int path)
+{
+    int          ret = 0;
+    int          i;
+    int          started;
+    long         count = 0;
+    double       start;
+    double       elapsed;
+    BenchThread* threads;
+
+    threads = (BenchThread*)calloc(gNumThreads, sizeof(BenchThread));
+    if (threads == NULL)
+        return MEMORY_E;
+
+    gStop = 0;
+    start = CurrentTime();
+    for (started = 0; started < gNumThreads; started++) {
+        threads[started].op = op;
+        threads[started].devId = gPathDevIds[path];
+        threads[started].size = size;
+        if (pthread_create(&threads[started].tid, NULL, BenchThreadMain,
+                &threads[started]) != 0) {
+            break;
+        }
+    }
+    sleep(gSecs);
+    gStop = 1;
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i].tid, NULL);
+        count += threads[i].count;
+        if (threads[i].ret != 0 && ret == 0)
+            ret = threads[i].ret;
+    }
+    elapsed = CurrentTime() - start;
+
+    if (ret != 0) {
+        fprintf(stderr, "ERROR: %s through %s failed: %d\n", name,
+            gPathNames[path], ret);
+    }
+    else if (count > 0) {
+        /* Time taken for each operation by a thread. */
+        printf("%-28s %-8s : %11.1f ops/s %10.2f us/op\n", name,
+            gPathNames[path], count / elapsed,
+            elapsed * started * 1000000 / count);
+    }
+
+    free(threads);
+    return ret;
+}
+
+/* Generate the peer's key for ECDHE. */
+static int MakePeerKey(void)
+{
+    int     ret;
+    WC_RNG  rng;
+    ecc_key key;
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0)
+        return ret;
+    ret = wc_ecc_init(&key);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex(&rng, 32, &key, ECC_SECP256R1);
+        if (ret == 0) {
+            gPeerPubSz = sizeof(gPeerPub);
+            ret = wc_ecc_export_x963(&key, gPeerPub, &gPeerPubSz);
+        }
+        wc_ecc_free(&key);
+    }
+    wc_FreeRng(&rng);
+
+    return ret;
+}
+
+static void PrintEngine(const char* name, Engine* engine)
+{
+    printf("%-28s : %ld submissions, %ld requests, %.1f per submission, "
+           "max %d\n", name, engine->submissions, engine->requests,
+           engine->submissions ? (double)engine->requests / engine->submissions
+                               : 0.0,
+           engine->maxBatch);
+}
+
+static void Usage(void)
+{
+    printf("bench-cryptocb " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-t <num>    Number of threads, default %d\n", NUM_THREADS);
+    printf("-b <num>    Most requests in an engine submission, default %d\n",
+        BATCH_MAX);
+    printf("-s <num>    Microseconds each engine submission costs, "
+           "default %d\n", SUBMIT_US);
+    printf("-d <num>    Seconds to run each measurement, default %d\n",
+        BENCH_SECS);
+}
+
+int main(int argc, char* argv[])
+{
+    int           ret = 0;
+    int           ch;
+    int           path;
+    int           i;
+    int           batchMax = BATCH_MAX;
+    int           submitUs = SUBMIT_US;
+    int           engineOneInit = 0;
+    int           engineBatchInit = 0;
+    char          name[32];
+    Engine        engineOne;
+    Engine        engineBatch;
+    myCryptoCbCtx myCtx;
+    static const word32 recordSizes[] = { 64, 1024, MAX_RECORD_SZ };
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 't':
+                gNumThreads = atoi(myoptarg);
+                if (gNumThreads < 1 || gNumThreads > MAX_THREADS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'b':
+                batchMax = atoi(myoptarg);
+                if (batchMax < 1) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 's':
+                submitUs = atoi(myoptarg);
+                if (submitUs < 0) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'd':
+                gSecs = atoi(myoptarg);
+                if (gSecs < 1) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+
+    wolfSSL_Init();
+
+    /* example data for callback */
+    XMEMSET(&myCtx, 0, sizeof(myCtx));
+
+    ret = wc_CryptoCb_RegisterDevice(gPathDevIds[PATH_CRYPTOCB], myCryptoCb,
+        &myCtx);
+    if (ret == 0) {
+        ret = Engine_Init(&engineOne, 1, submitUs);
+        engineOneInit = (ret == 0);
+    }
+    if (ret == 0) {
+        ret = wc_CryptoCb_RegisterDevice(gPathDevIds[PATH_ENGINE_ONE],
+            Engine_CryptoCb, &engineOne);
+    }
+    if (ret == 0) {
+        ret = Engine_Init(&engineBatch, batchMax, submitUs);
+        engineBatchInit = (ret == 0);
+    }
+    if (ret == 0) {
+        ret = wc_CryptoCb_RegisterDevice(gPathDevIds[PATH_ENGINE_BATCH],
+            Engine_CryptoCb, &engineBatch);
+    }
+    if (ret == 0)
+        ret = MakePeerKey();
+    if (ret != 0) {
+        fprintf(stderr, "ERROR: failed to set up devices: %d\n", ret);
+        goto exit;
+    }
+
+    printf("Threads: %d, engine submission: %d us, batch of up to %d\n",
+        gNumThreads, submitUs, batchMax);
+
+    for (i = 0; ret == 0 && i < (int)(sizeof(recordSizes) /
+            sizeof(*recordSizes)); i++) {
+        snprintf(name, sizeof(name), "AES-256-GCM %u byte record",
+            recordSizes[i]);
+        for (path = 0; ret == 0 && path < PATH_CNT; path++)
+            ret = BenchRun(name, OP_AESGCM, recordSizes[i], path);
+    }
+    for (path = 0; ret == 0 && path < PATH_CNT; path++)
+        ret = BenchRun("ECDHE P-256", OP_ECDHE, 0, path);
+    /* Hashing isn't queued to the engine - compare with software only. */
+    snprintf(name, sizeof(name), "SHA-256 %d x %d byte msgs", TRANSCRIPT_MSGS,
+        TRANSCRIPT_MSG_SZ);
+    for (path = 0; ret == 0 && path <= PATH_CRYPTOCB; path++)
+        ret = BenchRun(name, OP_TRANSCRIPT, 0, path);
+
+    PrintEngine("Engine/1", &engineOne);
+    PrintEngine("Engine/N", &engineBatch);
+
+exit:
+    for (path = PATH_CRYPTOCB; path < PATH_CNT; path++)
+        wc_CryptoCb_UnRegisterDevice(gPathDevIds[path]);
+    if (engineBatchInit)
+        Engine_Free(&engineBatch);
+    if (engineOneInit)
+        Engine_Free(&engineOne);
+    wolfSSL_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(void)
+{
+    printf("Please configure wolfSSL with --enable-cryptocb and try again\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,433 @@
+/* bench-ephpool.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * Handshake latency under bursty load with and without a pool of
+ * pre-generated ephemeral keys.
+ *
+ * TLS 1.3 handshakes are done in memory by one thread, the client and server
+ * taking turns. Handshakes arrive in bursts: all handshakes of a burst are
+ * queued at once and the latency of each is the time from the start of the
+ * burst to its completion. Between bursts there is an idle period in which
+ * the pool is refilled by threads running at idle priority.
+ *
+ * The client and server contexts both take keys from the pool: the server's
+ * ECDHE/X25519 key share and the client's key shares, including ML-KEM.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "ephkey-pool.h"
+
+#define CERT_FILE   "../certs/server-ecc.pem"
+#define KEY_FILE    "../certs/ecc-key.pem"
+#define CA_FILE     "../certs/ca-ecc-cert.pem"
+
+/* Default number of handshakes in a burst. */
+#define BURST_SZ            32
+/* Default number of bursts. */
+#define NUM_BURSTS          10
+/* Default milliseconds between bursts. */
+#define IDLE_MS             200
+/* Default number of threads filling the pool. */
+#define NUM_THREADS         2
+/* Default number of key pairs of each kind in the pool. */
+#define POOL_SZ             64
+/* Size of the buffer for each direction of a connection. */
+#define MEM_BUF_SZ          (64 * 1024)
+/* Most calls to connect and accept for a handshake. */
+#define MAX_HS_STEPS        64
+
+/* The command line options. */
+#define OPTIONS "?g:b:r:i:t:s:"
+
+#if defined(WOLF_CRYPTO_CB) && defined(WOLFSSL_TLS13) && defined(HAVE_ECC)
+
+/* Data in flight in one direction. */
+typedef struct MemBuf {
+    byte buf[MEM_BUF_SZ];
+    int  len;
+} MemBuf;
+
+/* Key exchange groups that can be benchmarked. */
+typedef struct BenchGroup {
+    const char* name;
+    int         group;
+} BenchGroup;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static const BenchGroup gGroups[] = {
+    { "p256",           WOLFSSL_ECC_SECP256R1   },
+#ifdef HAVE_CURVE25519
+    { "x25519",         WOLFSSL_ECC_X25519      },
+#endif
+#ifdef WOLFSSL_HAVE_MLKEM
+    { "mlkem768",       WOLFSSL_ML_KEM_768      },
+    #ifdef HAVE_CURVE25519
+    { "x25519mlkem768", WOLFSSL_X25519MLKEM768  },
+    #endif
+#endif
+};
+#define NUM_GROUPS  ((int)(sizeof(gGroups) / sizeof(gGroups[0])))
+
+static const char* gKindNames[EPHKEY_KINDS] = {
+    "P-256", "X25519", "ML-KEM-768"
+};
+
+
+static double CurrentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static int MemSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemBuf* mem = (MemBuf*)ctx;
+
+    (void)ssl;
+
+    if (sz > MEM_BUF_SZ - mem->len)
+        sz = MEM_BUF_SZ - mem->len;
+    if (sz == 0)
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    XMEMCPY(mem->buf + mem->len, buf, sz);
+    mem->len += sz;
+
+    return sz;
+}
+
+static int MemRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemBuf* mem = (MemBuf*)ctx;
+
+    (void)ssl;
+
+    if (mem->len == 0)
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    if (sz > mem->len)
+        sz = mem->len;
+    XMEMCPY(buf, mem->buf, sz);
+    mem->len -= sz;
+    XMEMMOVE(mem->buf, mem->buf + sz, mem->len);
+
+    return sz;
+}
+
+/* Create the client and server contexts. */
+static int CreateCtxs(WOLFSSL_CTX** cctx, WOLFSSL_CTX** sctx, int usePool)
+{
+    *cctx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    *sctx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    if (*cctx == NULL || *sctx == NULL) {
+        fprintf(stderr, "ERROR: failed to create WOLFSSL_CTX\n");
+        return -1;
+    }
+    if (wolfSSL_CTX_load_verify_locations(*cctx, CA_FILE, NULL)
+            != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s\n", CA_FILE);
+        return -1;
+    }
+    if (wolfSSL_CTX_use_certificate_file(*sctx, CERT_FILE,
+            WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_file(*sctx, KEY_FILE,
+            WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s or %s\n", CERT_FILE,
+            KEY_FILE);
+        return -1;
+    }
+    wolfSSL_CTX_SetIOSend(*cctx, MemSend);
+    wolfSSL_CTX_SetIORecv(*cctx, MemRecv);
+    wolfSSL_CTX_SetIOSend(*sctx, MemSend);
+    wolfSSL_CTX_SetIORecv(*sctx, MemRecv);
+
+    if (usePool) {
+        if (EphKeyPool_Attach(*cctx) != 0 || EphKeyPool_Attach(*sctx) != 0) {
+            fprintf(stderr, "ERROR: failed to attach key pool\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Whether the handshake can continue after a call to connect or accept. */
+static int HandshakeStep(WOLFSSL* ssl, int ret, int* done)
+{
+    int err;
+
+    if (ret == WOLFSSL_SUCCESS) {
+        *done = 1;
+        return 0;
+    }
+    err = wolfSSL_get_error(ssl, ret);
+    if (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE)
+        return 0;
+    return err;
+}
+
+/* Do a full handshake between a new client and server. */
+static int Handshake(WOLFSSL_CTX* cctx, WOLFSSL_CTX* sctx, int group)
+{
+    int      ret = 0;
+    int      i;
+    int      cliDone = 0;
+    int      srvDone = 0;
+    WOLFSSL* cli;
+    WOLFSSL* srv;
+    static MemBuf toSrv;
+    static MemBuf toCli;
+
+    toSrv.len = 0;
+    toCli.len = 0;
+    cli = wolfSSL_new(cctx);
+    srv = wolfSSL_new(sctx);
+    if (cli == NULL || srv == NULL)
+        ret = MEMORY_E;
+    if (ret == 0) {
+        wolfSSL_SetIOWriteCtx(cli, &toSrv);
+        wolfSSL_SetIOReadCtx(cli, &toCli);
+        wolfSSL_SetIOWriteCtx(srv, &toCli);
+        wolfSSL_SetIOReadCtx(srv, &toSrv);
+        if (wolfSSL_UseKeyShare(cli, (word16)group) != WOLFSSL_SUCCESS ||
+                wolfSSL_set_groups(cli, &group, 1) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "ERROR: failed to set key share group\n");
+            ret = -1;
+        }
+    }
+
+    for (i = 0; ret == 0 && (!cliDone || !srvDone); i++) {
+        if (i == MAX_HS_STEPS) {
+            ret = -1;
+            break;
+        }
+        if (!cliDone)
+            ret = HandshakeStep(cli, wolfSSL_connect(cli), &cliDone);
+        if (ret == 0 && !srvDone)
+            ret = HandshakeStep(srv, wolfSSL_accept(srv), &srvDone);
+    }
+    if (ret != 0)
+        fprintf(stderr, "ERROR: handshake failed: %d\n", ret);
+
+    wolfSSL_free(srv);
+    wolfSSL_free(cli);
+
+    return ret;
+}
+
+static int CompareDouble(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return (da > db) - (da < db);
+}
+
+/* Run the bursts of handshakes and print the latencies. */
+static int RunBursts(const char* name, WOLFSSL_CTX* cctx, WOLFSSL_CTX* sctx,
+    int group, int burstSz, int numBursts, int idleMs)
+{
+    int     ret = 0;
+    int     b;
+    int     i;
+    int     n = burstSz * numBursts;
+    double  start;
+    double  busy = 0;
+    double  sum = 0;
+    double* lat;
+
+    lat = (double*)malloc(sizeof(double) * n);
+    if (lat == NULL)
+        return MEMORY_E;
+
+    /* Not measured: loads certificates and tables. */
+    ret = Handshake(cctx, sctx, group);
+    for (b = 0; ret == 0 && b < numBursts; b++) {
+        usleep(idleMs * 1000);
+
+        /* All handshakes of the burst arrive now and are served in turn. */
+        start = CurrentTime();
+        for (i = 0; ret == 0 && i < burstSz; i++) {
+            ret = Handshake(cctx, sctx, group);
+            lat[b * burstSz + i] = (CurrentTime() - start) * 1000;
+        }
+        busy += CurrentTime() - start;
+    }
+
+    if (ret == 0) {
+        for (i = 0; i < n; i++)
+            sum += lat[i];
+        qsort(lat, n, sizeof(double), CompareDouble);
+        printf("%-9s : mean %8.2f ms, p50 %8.2f ms, p99 %8.2f ms, "
+               "max %8.2f ms, %8.1f hs/s\n", name, sum / n, lat[n / 2],
+               lat[(n * 99) / 100], lat[n - 1], n / busy);
+    }
+
+    free(lat);
+    return ret;
+}
+
+static void Usage(void)
+{
+    int i;
+
+    printf("bench-ephpool " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-g <group>  Key exchange group, default %s:", gGroups[0].name);
+    for (i = 0; i < NUM_GROUPS; i++)
+        printf(" %s", gGroups[i].name);
+    printf("\n");
+    printf("-b <num>    Handshakes in each burst, default %d\n", BURST_SZ);
+    printf("-r <num>    Number of bursts, default %d\n", NUM_BURSTS);
+    printf("-i <ms>     Idle time between bursts, default %d\n", IDLE_MS);
+    printf("-t <num>    Threads filling the pool, default %d\n", NUM_THREADS);
+    printf("-s <num>    Key pairs of each kind in the pool, default %d\n",
+        POOL_SZ);
+}
+
+int main(int argc, char* argv[])
+{
+    int             ret = 0;
+    int             ch;
+    int             i;
+    int             g = 0;
+    int             usePool;
+    int             burstSz = BURST_SZ;
+    int             numBursts = NUM_BURSTS;
+    int             idleMs = IDLE_MS;
+    int             numThreads = NUM_THREADS;
+    int             poolSz = POOL_SZ;
+    WOLFSSL_CTX*    cctx = NULL;
+    WOLFSSL_CTX*    sctx = NULL;
+    EphKeyPoolStats stats;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'g':
+                for (g = 0; g < NUM_GROUPS; g++) {
+                    if (XSTRCMP(myoptarg, gGroups[g].name) == 0)
+                        break;
+                }
+                if (g == NUM_GROUPS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'b':
+                burstSz = atoi(myoptarg);
+                break;
+            case 'r':
+                numBursts = atoi(myoptarg);
+                break;
+            case 'i':
+                idleMs = atoi(myoptarg);
+                break;
+            case 't':
+                numThreads = atoi(myoptarg);
+                break;
+            case 's':
+                poolSz = atoi(myoptarg);
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    if (burstSz < 1 || numBursts < 1 || idleMs < 0 || numThreads < 1 ||
+            poolSz < 1) {
+        Usage();
+        return 1;
+    }
+
+    wolfSSL_Init();
+
+    printf("TLS 1.3 %s: %d bursts of %d handshakes, %d ms apart\n",
+        gGroups[g].name, numBursts, burstSz, idleMs);
+    for (usePool = 0; ret == 0 && usePool <= 1; usePool++) {
+        if (usePool) {
+            ret = EphKeyPool_Init(numThreads, poolSz);
+            if (ret != 0) {
+                fprintf(stderr, "ERROR: failed to start key pool: %d\n", ret);
+                break;
+            }
+            EphKeyPool_WaitFull();
+        }
+
+        ret = CreateCtxs(&cctx, &sctx, usePool);
+        if (ret == 0) {
+            ret = RunBursts(usePool ? "pool" : "no pool", cctx, sctx,
+                gGroups[g].group, burstSz, numBursts, idleMs);
+        }
+        wolfSSL_CTX_free(sctx);
+        wolfSSL_CTX_free(cctx);
+        sctx = NULL;
+        cctx = NULL;
+
+        if (usePool) {
+            EphKeyPool_GetStats(&stats);
+            for (i = 0; i < EPHKEY_KINDS; i++) {
+                if (stats.taken[i] + stats.misses[i] == 0)
+                    continue;
+                printf("  %-10s : %lu taken from pool, %lu generated in "
+                       "handshake\n", gKindNames[i], stats.taken[i],
+                       stats.misses[i]);
+            }
+            EphKeyPool_Cleanup();
+        }
+    }
+
+    wolfSSL_Cleanup();
+
+    return (ret == 0) ? 0 : 1;
+}
+
+#else
+
+int main(void)
+{
+    printf("Please configure wolfSSL with --enable-cryptocb --enable-tls13 "
+           "and try again\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,488 @@
+/* bench-shmring.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * TLS 1.3 handshake latency and bulk throughput over the shared memory ring
+ * transport, between threads and between processes, and over a loopback TCP
+ * socket.
+ *
+ * The client does a number of full handshakes, each on a new connection, and
+ * then sends the bulk data on one more. The server replies with one byte
+ * when it has all of the data.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* socket includes */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+
+#include "shmring.h"
+
+#define CERT_FILE   "../certs/server-cert.pem"
+#define KEY_FILE    "../certs/server-key.pem"
+#define CA_FILE     "../certs/ca-cert.pem"
+
+/* Default number of handshakes. */
+#define NUM_HANDSHAKES      100
+/* Default megabytes of bulk data. */
+#define BULK_MB             64
+/* Size of each write of bulk data. */
+#define BULK_WRITE_SZ       (16 * 1024)
+
+/* The command line options. */
+#define OPTIONS "?n:b:r:"
+
+enum {
+    MODE_SHM_THREAD,
+    MODE_SHM_PROCESS,
+    MODE_TCP,
+    MODE_COUNT
+};
+
+/* What the client and server share. */
+typedef struct Bench {
+    int       mode;
+    int       numHs;
+    long      bulkSz;
+    /* One connection per handshake and one for the bulk data. */
+    ShmConn** conns;
+    int       listenFd;
+    int       port;
+} Bench;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static const char* gModeNames[MODE_COUNT] = {
+    "shm threads", "shm processes", "tcp loopback"
+};
+
+
+static double CurrentTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static WOLFSSL_CTX* NewCtx(int isServer)
+{
+    WOLFSSL_CTX* ctx;
+
+    if (isServer)
+        ctx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    else
+        ctx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    if (ctx == NULL) {
+        fprintf(stderr, "ERROR: failed to create WOLFSSL_CTX\n");
+        return NULL;
+    }
+
+    if (isServer) {
+        if (wolfSSL_CTX_use_certificate_file(ctx, CERT_FILE,
+                WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_use_PrivateKey_file(ctx, KEY_FILE,
+                WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "ERROR: failed to load %s or %s\n", CERT_FILE,
+                KEY_FILE);
+            wolfSSL_CTX_free(ctx);
+            return NULL;
+        }
+    #ifdef HAVE_SESSION_TICKET
+        /* The client does not wait to read a ticket before closing. */
+        wolfSSL_CTX_no_ticket_TLSv13(ctx);
+    #endif
+    }
+    else if (wolfSSL_CTX_load_verify_locations(ctx, CA_FILE, NULL)
+            != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s\n", CA_FILE);
+        wolfSSL_CTX_free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+/* Set up the transport of the i'th connection. Returns the socket or 0. */
+static int Connect(Bench* bench, WOLFSSL* ssl, int i, int isServer)
+{
+    int                sockfd;
+    int                on = 1;
+    struct sockaddr_in addr;
+
+    if (bench->mode != MODE_TCP)
+        return ShmConn_SetIO(ssl, bench->conns[i], isServer);
+
+    if (isServer) {
+        sockfd = accept(bench->listenFd, NULL, NULL);
+    }
+    else {
+        sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (sockfd >= 0) {
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(bench->port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+                close(sockfd);
+                sockfd = -1;
+            }
+        }
+    }
+    if (sockfd < 0) {
+        fprintf(stderr, "ERROR: failed to connect\n");
+        return -1;
+    }
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    wolfSSL_set_fd(ssl, sockfd);
+
+    return sockfd;
+}
+
+static void Disconnect(Bench* bench, WOLFSSL* ssl, int fd)
+{
+    wolfSSL_free(ssl);
+    if (bench->mode == MODE_TCP && fd > 0)
+        close(fd);
+}
+
+static int ServerRun(Bench* bench)
+{
+    int          ret = 0;
+    int          i;
+    int          fd;
+    long         total;
+    WOLFSSL_CTX* ctx;
+    WOLFSSL*     ssl;
+    static byte  buf[BULK_WRITE_SZ];
+
+    ctx = NewCtx(1);
+    if (ctx == NULL)
+        return -1;
+
+    for (i = 0; ret == 0 && i <= bench->numHs; i++) {
+        ssl = wolfSSL_new(ctx);
+        if (ssl == NULL) {
+            ret = -1;
+            break;
+        }
+        fd = Connect(bench, ssl, i, 1);
+        if (fd < 0 || wolfSSL_accept(ssl) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "ERROR: server handshake %d failed\n", i);
+            ret = -1;
+        }
+
+        /* The last connection carries the bulk data. */
+        for (total = 0; ret == 0 && i == bench->numHs &&
+                total < bench->bulkSz; ) {
+            ret = wolfSSL_read(ssl, buf, sizeof(buf));
+            if (ret <= 0) {
+                ret = -1;
+                break;
+            }
+            total += ret;
+            ret = 0;
+        }
+        if (ret == 0 && i == bench->numHs && wolfSSL_write(ssl, buf, 1) != 1)
+            ret = -1;
+
+        Disconnect(bench, ssl, fd);
+    }
+
+    if (ret != 0 && bench->mode != MODE_TCP) {
+        /* Wake the client from waiting on the server. */
+        for (i = 0; i <= bench->numHs; i++)
+            ShmConn_Shutdown(bench->conns[i]);
+    }
+
+    wolfSSL_CTX_free(ctx);
+    return ret;
+}
+
+static void* ServerThread(void* arg)
+{
+    ServerRun((Bench*)arg);
+    return NULL;
+}
+
+static int CompareDouble(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return (da > db) - (da < db);
+}
+
+static int ClientRun(Bench* bench)
+{
+    int          ret = 0;
+    int          i;
+    int          fd;
+    int          sz;
+    long         total;
+    double       start;
+    double       bulkTime = 0;
+    double       sum = 0;
+    double*      lat;
+    WOLFSSL_CTX* ctx;
+    WOLFSSL*     ssl;
+    static byte  buf[BULK_WRITE_SZ];
+
+    lat = (double*)malloc(sizeof(double) * bench->numHs);
+    ctx = NewCtx(0);
+    if (lat == NULL || ctx == NULL)
+        ret = -1;
+    memset(buf, 0x5a, sizeof(buf));
+
+    for (i = 0; ret == 0 && i <= bench->numHs; i++) {
+        ssl = wolfSSL_new(ctx);
+        if (ssl == NULL) {
+            ret = -1;
+            break;
+        }
+
+        start = CurrentTime();
+        fd = Connect(bench, ssl, i, 0);
+        if (fd < 0 || wolfSSL_connect(ssl) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "ERROR: client handshake %d failed\n", i);
+            ret = -1;
+        }
+        else if (i < bench->numHs) {
+            lat[i] = (CurrentTime() - start) * 1000;
+            sum += lat[i];
+        }
+        else {
+            start = CurrentTime();
+            for (total = 0; ret == 0 && total < bench->bulkSz; total += sz) {
+                sz = BULK_WRITE_SZ;
+                if (sz > bench->bulkSz - total)
+                    sz = (int)(bench->bulkSz - total);
+                if (wolfSSL_write(ssl, buf, sz) != sz)
+                    ret = -1;
+            }
+            if (ret == 0 && wolfSSL_read(ssl, buf, 1) != 1)
+                ret = -1;
+            bulkTime = CurrentTime() - start;
+        }
+
+        Disconnect(bench, ssl, fd);
+    }
+
+    if (ret == 0) {
+        qsort(lat, bench->numHs, sizeof(double), CompareDouble);
+        printf("%-14s %8.3f %8.3f %8.3f %10.1f\n", gModeNames[bench->mode],
+            sum / bench->numHs, lat[bench->numHs / 2],
+            lat[(bench->numHs * 99) / 100],
+            bench->bulkSz / bulkTime / (1024 * 1024));
+    }
+    else {
+        printf("%-14s failed\n", gModeNames[bench->mode]);
+        if (bench->mode != MODE_TCP) {
+            /* Wake the server from waiting on the client - it may be in
+             * another process. */
+            for (i = 0; i <= bench->numHs; i++)
+                ShmConn_Shutdown(bench->conns[i]);
+        }
+    }
+
+    free(lat);
+    wolfSSL_CTX_free(ctx);
+    return ret;
+}
+
+static int Listen(Bench* bench)
+{
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof(addr);
+    int                on = 1;
+
+    bench->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (bench->listenFd < 0)
+        return -1;
+    setsockopt(bench->listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(bench->listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(bench->listenFd, 128) != 0 ||
+            getsockname(bench->listenFd, (struct sockaddr*)&addr, &len) != 0) {
+        close(bench->listenFd);
+        return -1;
+    }
+    bench->port = ntohs(addr.sin_port);
+
+    return 0;
+}
+
+static int RunMode(Bench* bench, int mode, unsigned int ringSz)
+{
+    int       ret = 0;
+    int       i;
+    int       status;
+    pid_t     pid;
+    pthread_t tid;
+
+    bench->mode = mode;
+    if (mode == MODE_TCP) {
+        if (Listen(bench) != 0) {
+            fprintf(stderr, "ERROR: failed to listen on loopback\n");
+            return -1;
+        }
+    }
+    else {
+        /* Created before the server starts so that a child inherits them. */
+        for (i = 0; i <= bench->numHs; i++) {
+            bench->conns[i] = ShmConn_Create(NULL, ringSz);
+            if (bench->conns[i] == NULL) {
+                fprintf(stderr, "ERROR: failed to create shared memory\n");
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    if (ret == 0 && mode == MODE_SHM_PROCESS) {
+        pid = fork();
+        if (pid == 0)
+            _exit(ServerRun(bench) == 0 ? 0 : 1);
+        if (pid < 0) {
+            ret = -1;
+        }
+        else {
+            ret = ClientRun(bench);
+            waitpid(pid, &status, 0);
+        }
+    }
+    else if (ret == 0) {
+        if (pthread_create(&tid, NULL, ServerThread, bench) != 0) {
+            ret = -1;
+        }
+        else {
+            ret = ClientRun(bench);
+            if (ret != 0 && mode == MODE_TCP)
+                shutdown(bench->listenFd, SHUT_RDWR);
+            pthread_join(tid, NULL);
+        }
+    }
+
+    if (mode == MODE_TCP) {
+        close(bench->listenFd);
+    }
+    else {
+        for (i = 0; i <= bench->numHs; i++) {
+            ShmConn_Free(bench->conns[i]);
+            bench->conns[i] = NULL;
+        }
+    }
+
+    return ret;
+}
+
+static void Usage(void)
+{
+    printf("bench-shmring " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-n <num>    Number of handshakes, default %d\n", NUM_HANDSHAKES);
+    printf("-b <num>    Megabytes of bulk data, default %d\n", BULK_MB);
+    printf("-r <num>    Ring size in KB, a power of 2, default %d\n",
+        SHMRING_DEF_SZ / 1024);
+}
+
+int main(int argc, char* argv[])
+{
+    int          ret = 0;
+    int          ch;
+    int          mode;
+    unsigned int ringSz = SHMRING_DEF_SZ;
+    Bench        bench;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.numHs = NUM_HANDSHAKES;
+    bench.bulkSz = (long)BULK_MB * 1024 * 1024;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'n':
+                bench.numHs = atoi(myoptarg);
+                break;
+            case 'b':
+                bench.bulkSz = atol(myoptarg) * 1024 * 1024;
+                break;
+            case 'r':
+                ringSz = (unsigned int)atoi(myoptarg) * 1024;
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    if (bench.numHs < 1 || bench.bulkSz < 1 || ringSz < 1024 ||
+            (ringSz & (ringSz - 1)) != 0) {
+        Usage();
+        return 1;
+    }
+
+    bench.conns = (ShmConn**)calloc(bench.numHs + 1, sizeof(ShmConn*));
+    if (bench.conns == NULL)
+        return 1;
+
+    /* A peer closing a socket must not end the benchmark. */
+    signal(SIGPIPE, SIG_IGN);
+    wolfSSL_Init();
+
+    printf("%d handshakes, %ld MB bulk, %u KB rings\n", bench.numHs,
+        bench.bulkSz / (1024 * 1024), ringSz / 1024);
+    printf("%-14s %8s %8s %8s %10s\n", "transport", "hs ms", "p50 ms",
+        "p99 ms", "bulk MB/s");
+    for (mode = 0; ret == 0 && mode < MODE_COUNT; mode++)
+        ret = RunMode(&bench, mode, ringSz);
+
+    wolfSSL_Cleanup();
+    free(bench.conns);
+
+    return (ret == 0) ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+/* client-tls-resume-threaded.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * Session resumption benchmark. Each thread connects repeatedly, resuming the
+ * session of its previous connection, and the resume rate and handshake times
+ * are reported. Sessions can be saved to a file at exit and loaded at start to
+ * check that a server kept its sessions over a restart.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* socket includes */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+/* threads */
+#include <pthread.h>
+
+/* wolfSSL */
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+
+#define DEFAULT_PORT    11111
+/* Default number of client threads. */
+#define NUM_THREADS     16
+/* Default number of connections made by each thread. */
+#define NUM_CONNS       100
+/* Maximum number of client threads. */
+#define MAX_THREADS     1024
+/* Maximum size of a saved session. */
+#define MAX_SESS_SZ     4096
+
+#define CERT_FILE "../certs/ca-cert.pem"
+
+/* The command line options. */
+#define OPTIONS "?h:p:t:n:f:3"
+
+/* Data for each client thread. */
+typedef struct ClientThread {
+    pthread_t        tid;
+    WOLFSSL_SESSION* session;
+    int              conns;
+    int              resumed;
+    int              failed;
+    double           fullTime;
+    double           resumeTime;
+} ClientThread;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static WOLFSSL_CTX*       gCtx;
+static struct sockaddr_in gServAddr;
+static int                gNumConns = NUM_CONNS;
+static ClientThread       gThreads[MAX_THREADS];
+static int                gNumThreads = NUM_THREADS;
+
+
+/* Make one connection, resuming the thread's session when it has one.
+ *
+ * returns 0 on success, -1 on failure.
+ */
+static int ClientConnect(ClientThread* t)
+{
+    int         ret = -1;
+    int         sockfd;
+    WOLFSSL*    ssl = NULL;
+    char        buff[256];
+    const char* msg = "resume me\n";
+    double      start;
+
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd == -1)
+        return -1;
+    if (connect(sockfd, (struct sockaddr*)&gServAddr,
+            sizeof(gServAddr)) == -1) {
+        close(sockfd);
+        return -1;
+    }
+
+    ssl = wolfSSL_new(gCtx);
+    if (ssl == NULL)
+        goto exit;
+    wolfSSL_set_fd(ssl, sockfd);
+    if (t->session != NULL)
+        wolfSSL_set_session(ssl, t->session);
+
+    start = current_time(1);
+    if (wolfSSL_connect(ssl) != WOLFSSL_SUCCESS)
+        goto exit;
+    start = current_time(0) - start;
+    if (wolfSSL_session_reused(ssl)) {
+        t->resumed++;
+        t->resumeTime += start;
+    }
+    else {
+        t->fullTime += start;
+    }
+
+    /* TLS 1.3 tickets arrive after the handshake - read before saving. */
+    if (wolfSSL_write(ssl, msg, (int)XSTRLEN(msg)) <= 0 ||
+            wolfSSL_read(ssl, buff, sizeof(buff)) <= 0)
+        goto exit;
+
+    wolfSSL_SESSION_free(t->session);
+    t->session = wolfSSL_get1_session(ssl);
+    wolfSSL_shutdown(ssl);
+    ret = 0;
+
+exit:
+    wolfSSL_free(ssl);
+    close(sockfd);
+    return ret;
+}
+
+static void* ClientThreadMain(void* args)
+{
+    ClientThread* t = (ClientThread*)args;
+    int           i;
+
+    for (i = 0; i < gNumConns; i++) {
+        if (ClientConnect(t) == 0)
+            t->conns++;
+        else
+            t->failed++;
+    }
+
+    return NULL;
+}
+
+
+#ifdef HAVE_EXT_CACHE
+/* Load one session per thread from a file of length prefixed sessions. */
+static void LoadSessions(const char* file)
+{
+    FILE*       f;
+    byte        buf[MAX_SESS_SZ];
+    const byte* p;
+    word32      sz;
+    int         i;
+
+    f = fopen(file, "rb");
+    if (f == NULL)
+        return;
+    for (i = 0; i < gNumThreads; i++) {
+        if (fread(&sz, sizeof(sz), 1, f) != 1 || sz > sizeof(buf) ||
+                fread(buf, 1, sz, f) != sz)
+            break;
+        p = buf;
+        gThreads[i].session = wolfSSL_d2i_SSL_SESSION(NULL, &p, sz);
+    }
+    fclose(f);
+    printf("Loaded %d sessions from %s\n", i, file);
+}
+
+/* Save the last session of each thread to a file. */
+static void SaveSessions(const char* file)
+{
+    FILE*  f;
+    byte*  buf;
+    int    len;
+    word32 sz;
+    int    i;
+
+    f = fopen(file, "wb");
+    if (f == NULL)
+        return;
+    for (i = 0; i < gNumThreads; i++) {
+        if (gThreads[i].session == NULL)
+            continue;
+        buf = NULL;
+        len = wolfSSL_i2d_SSL_SESSION(gThreads[i].session, &buf);
+        if (len > 0 && buf != NULL) {
+            sz = (word32)len;
+            fwrite(&sz, sizeof(sz), 1, f);
+            fwrite(buf, 1, sz, f);
+        }
+        if (buf)
+            free(buf);
+    }
+    fclose(f);
+}
+#endif /* HAVE_EXT_CACHE */
+
+
+static void Usage(void)
+{
+    printf("client-tls-resume-threaded " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-h <addr>   Server address, default 127.0.0.1\n");
+    printf("-p <num>    Port of server, default %d\n", DEFAULT_PORT);
+    printf("-t <num>    Number of client threads, default %d\n", NUM_THREADS);
+    printf("-n <num>    Connections per thread, default %d\n", NUM_CONNS);
+#ifdef HAVE_EXT_CACHE
+    printf("-f <file>   Load sessions from and save sessions to file\n");
+#endif
+#ifdef WOLFSSL_TLS13
+    printf("-3          Use TLS 1.3 (resume with tickets)\n");
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    int          ret = 0;
+    int          ch;
+    int          i;
+    const char*  host = "127.0.0.1";
+    word16       port = DEFAULT_PORT;
+    const char*  sessFile = NULL;
+    int          tls13 = 0;
+    double       start;
+    long         conns = 0;
+    long         resumed = 0;
+    long         failed = 0;
+    double       fullTime = 0;
+    double       resumeTime = 0;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'h':
+                host = myoptarg;
+                break;
+            case 'p':
+                port = (word16)atoi(myoptarg);
+                break;
+            case 't':
+                gNumThreads = atoi(myoptarg);
+                if (gNumThreads < 1 || gNumThreads > MAX_THREADS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'n':
+                gNumConns = atoi(myoptarg);
+                break;
+            case 'f':
+                sessFile = myoptarg;
+                break;
+            case '3':
+                tls13 = 1;
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+
+    memset(&gServAddr, 0, sizeof(gServAddr));
+    gServAddr.sin_family = AF_INET;
+    gServAddr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host, &gServAddr.sin_addr) != 1) {
+        fprintf(stderr, "ERROR: invalid address\n");
+        return 1;
+    }
+
+    wolfSSL_Init();
+
+#ifdef WOLFSSL_TLS13
+    if (tls13)
+        gCtx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    else
+#endif
+        gCtx = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+    (void)tls13;
+    if (gCtx == NULL) {
+        fprintf(stderr, "ERROR: failed to create WOLFSSL_CTX\n");
+        ret = -1;
+        goto exit;
+    }
+    if (wolfSSL_CTX_load_verify_locations(gCtx, CERT_FILE, NULL)
+            != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                CERT_FILE);
+        ret = -1;
+        goto exit;
+    }
+
+#ifdef HAVE_EXT_CACHE
+    if (sessFile != NULL)
+        LoadSessions(sessFile);
+#endif
+
+    start = current_time(1);
+    for (i = 0; i < gNumThreads; i++) {
+        if (pthread_create(&gThreads[i].tid, NULL, ClientThreadMain,
+                &gThreads[i]) != 0) {
+            fprintf(stderr, "ERROR: failed to create thread\n");
+            gNumThreads = i;
+            break;
+        }
+    }
+    for (i = 0; i < gNumThreads; i++) {
+        pthread_join(gThreads[i].tid, NULL);
+        conns      += gThreads[i].conns;
+        resumed    += gThreads[i].resumed;
+        failed     += gThreads[i].failed;
+        fullTime   += gThreads[i].fullTime;
+        resumeTime += gThreads[i].resumeTime;
+    }
+    start = current_time(0) - start;
+
+    printf("Threads      : %d x %d connections\n", gNumThreads, gNumConns);
+    printf("Connections  : %ld (%ld failed) in %.3f s, %.1f conns/s\n",
+        conns, failed, start, conns / start);
+    printf("Resumed      : %ld (%.1f%%)\n", resumed,
+        conns ? resumed * 100.0 / conns : 0.0);
+    if (conns > resumed) {
+        printf("Full avg     : %.3f ms\n",
+            fullTime * 1000 / (conns - resumed));
+    }
+    if (resumed > 0) {
+        printf("Resume avg   : %.3f ms\n", resumeTime * 1000 / resumed);
+    }
+
+#ifdef HAVE_EXT_CACHE
+    if (sessFile != NULL)
+        SaveSessions(sessFile);
+#endif
+    (void)sessFile;
+
+exit:
+    for (i = 0; i < gNumThreads; i++)
+        wolfSSL_SESSION_free(gThreads[i].session);
+    if (gCtx)
+        wolfSSL_CTX_free(gCtx);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
@@ -23,13 +23,127 @@
 
 #ifdef WOLF_CRYPTO_CB
 
+#ifdef USE_OPENSSL
+#include <openssl/evp.h>
+#else
+#include <wolfssl/wolfcrypt/hash.h>
+#endif
+
+/* Running hash state kept in devCtx of the hash object.
+ * Each update is hashed immediately - no data is buffered. */
 typedef struct {
-    word32 bufSz;
+    enum wc_HashType type;
+    /* Hash object that made the state - a copy of it shares the state. */
+    void*            owner;
+#ifdef USE_OPENSSL
+    EVP_MD_CTX*      md;
+#else
+    wc_HashAlg       alg;
+#endif
 } hash_ctx_t;
 
+static int hash_ctx_init(hash_ctx_t* ctx, enum wc_HashType type)
+{
+    int ret = 0;
+#ifdef USE_OPENSSL
+    const EVP_MD* md;
+
+    switch (type) {
+        case WC_HASH_TYPE_SHA:    md = EVP_sha1();   break;
+        case WC_HASH_TYPE_SHA224: md = EVP_sha224(); break;
+        case WC_HASH_TYPE_SHA256: md = EVP_sha256(); break;
+        case WC_HASH_TYPE_SHA384: md = EVP_sha384(); break;
+        case WC_HASH_TYPE_SHA512: md = EVP_sha512(); break;
+        default:                  return NOT_COMPILED_IN;
+    }
+    ctx->md = EVP_MD_CTX_new();
+    if (ctx->md == NULL)
+        ret = MEMORY_E;
+    else if (EVP_DigestInit_ex(ctx->md, md, NULL) != 1) {
+        EVP_MD_CTX_free(ctx->md);
+        ret = WC_HW_E;
+    }
+#else
+    ret = wc_HashInit_ex(&ctx->alg, type, NULL, INVALID_DEVID);
+#endif
+    ctx->type = type;
+    return ret;
+}
+
+static int hash_ctx_update(hash_ctx_t* ctx, const byte* in, word32 inSz)
+{
+#ifdef USE_OPENSSL
+    return (EVP_DigestUpdate(ctx->md, in, inSz) == 1) ? 0 : WC_HW_E;
+#else
+    return wc_HashUpdate(&ctx->alg, ctx->type, in, inSz);
+#endif
+}
+
+static int hash_ctx_final(hash_ctx_t* ctx, byte* digest)
+{
+#ifdef USE_OPENSSL
+    return (EVP_DigestFinal_ex(ctx->md, digest, NULL) == 1) ? 0 : WC_HW_E;
+#else
+    return wc_HashFinal(&ctx->alg, ctx->type, digest);
+#endif
+}
+
+static void hash_ctx_free(hash_ctx_t* ctx)
+{
+#ifdef USE_OPENSSL
+    EVP_MD_CTX_free(ctx->md);
+#else
+    wc_HashFree(&ctx->alg, ctx->type);
+#endif
+}
+
+/* Duplicate the running state so that one can be finalized on its own. */
+static int hash_ctx_copy(hash_ctx_t* src, hash_ctx_t* dst)
+{
+    int ret;
+
+    ret = hash_ctx_init(dst, src->type);
+    if (ret != 0)
+        return ret;
 #ifdef USE_OPENSSL
-#include <openssl/sha.h>
+    if (EVP_MD_CTX_copy_ex(dst->md, src->md) != 1)
+        ret = WC_HW_E;
+#else
+    switch (src->type) {
+    #ifndef NO_SHA
+        case WC_HASH_TYPE_SHA:
+            ret = wc_ShaCopy(&src->alg.sha, &dst->alg.sha);
+            break;
+    #endif
+    #ifdef WOLFSSL_SHA224
+        case WC_HASH_TYPE_SHA224:
+            ret = wc_Sha224Copy(&src->alg.sha224, &dst->alg.sha224);
+            break;
+    #endif
+    #ifndef NO_SHA256
+        case WC_HASH_TYPE_SHA256:
+            ret = wc_Sha256Copy(&src->alg.sha256, &dst->alg.sha256);
+            break;
+    #endif
+    #ifdef WOLFSSL_SHA384
+        case WC_HASH_TYPE_SHA384:
+            ret = wc_Sha384Copy(&src->alg.sha384, &dst->alg.sha384);
+            break;
+    #endif
+    #ifdef WOLFSSL_SHA512
+        case WC_HASH_TYPE_SHA512:
+            ret = wc_Sha512Copy(&src->alg.sha512, &dst->alg.sha512);
+            break;
+    #endif
+        default:
+            ret = NOT_COMPILED_IN;
+            break;
+    }
 #endif
+    if (ret != 0)
+        hash_ctx_free(dst);
+    return ret;
+}
 
 /* type: WC_HASH_TYPE_SHA, WC_HASH_TYPE_SHA256, WC_HASH_TYPE_SHA384, etc */
 /* in: Update (when not NULL) / Final (when NULL) */
@@ -39,64 +153,66 @@ static int cb_hash(int type, const byte* in, word32 inSz, byte* digest,
     int ret = 0;
     enum wc_HashType hash_type = (enum wc_HashType)type;
     hash_ctx_t* ctx = (hash_ctx_t*)*devCtx;
-    byte*  hashBuf = NULL;
-    word32 hashBufSz = 0;
-
-    /* for updates alloc/realloc and copy */
-    if (in != NULL) {
+    hash_ctx_t* copy;
+    hash_ctx_t  tmp;
+    /* A copy of the hash object that still shares the original's state. */
+    int         shared = (ctx != NULL && (flags & WC_HASH_FLAG_ISCOPY) &&
+                          ctx->owner != shactx);
+
+    /* first update - start the running hash */
+    if (in != NULL && ctx == NULL) {
+        ctx = (hash_ctx_t*)malloc(sizeof(hash_ctx_t));
         if (ctx == NULL) {
-            ctx = (hash_ctx_t*)malloc(sizeof(hash_ctx_t) + hashBufSz + inSz);
+            return MEMORY_E;
         }
-        else {
-            hashBufSz = ctx->bufSz;
-            ctx = (hash_ctx_t*)realloc(ctx, sizeof(hash_ctx_t) + hashBufSz + inSz);
+        ret = hash_ctx_init(ctx, hash_type);
+        if (ret != 0) {
+            free(ctx);
+            return ret;
         }
-        if (ctx == NULL) {
+        ctx->owner = shactx;
+        *devCtx = ctx;
+    }
+    /* first update of a copy - give it its own state so that the original's
+     * isn't changed */
+    else if (in != NULL && shared) {
+        copy = (hash_ctx_t*)malloc(sizeof(hash_ctx_t));
+        if (copy == NULL) {
             return MEMORY_E;
         }
-        hashBuf = (byte*)ctx + sizeof(hash_ctx_t);
-        memcpy(&hashBuf[hashBufSz], in, inSz);
-        ctx->bufSz = hashBufSz + inSz;
-        *devCtx = ctx;
+        ret = hash_ctx_copy(ctx, copy);
+        if (ret != 0) {
+            free(copy);
+            return ret;
+        }
+        copy->owner = shactx;
+        *devCtx = ctx = copy;
+    }
+
+    if (in != NULL) {
+        ret = hash_ctx_update(ctx, in, inSz);
     }
     /* final */
     else if (digest != NULL) {
         if (ctx == NULL) {
             /* valid case of empty hash (0 len hash) */
+            ret = hash_ctx_init(&tmp, hash_type);
+            if (ret == 0) {
+                ret = hash_ctx_final(&tmp, digest);
+                hash_ctx_free(&tmp);
+            }
         }
-        else {
-            hashBuf = (byte*)ctx + sizeof(hash_ctx_t);
-            hashBufSz = ctx->bufSz;
-        }
-
-#ifdef USE_OPENSSL
-        switch (hash_type) {
-            case WC_HASH_TYPE_SHA:
-                SHA1(hashBuf, hashBufSz, digest);
-                break;
-            case WC_HASH_TYPE_SHA224:
-                SHA224(hashBuf, hashBufSz, digest);
-                break;
-            case WC_HASH_TYPE_SHA256:
-                SHA256(hashBuf, hashBufSz, digest);
-                break;
-            case WC_HASH_TYPE_SHA384:
-                SHA384(hashBuf, hashBufSz, digest);
-                break;
-            case WC_HASH_TYPE_SHA512:
-                SHA512(hashBuf, hashBufSz, digest);
-                break;
-            default:
-                ret = NOT_COMPILED_IN;
-                break;
+        else if (shared) {
+            /* state is shared with the original - finalize a duplicate */
+            ret = hash_ctx_copy(ctx, &tmp);
+            if (ret == 0) {
+                ret = hash_ctx_final(&tmp, digest);
+                hash_ctx_free(&tmp);
+            }
         }
-#else
-        ret = wc_Hash_ex(hash_type,
-            hashBuf, hashBufSz,
-            digest, wc_HashGetDigestSize(hash_type),
-            NULL, INVALID_DEVID);
-#endif
-        if (!(flags & WC_HASH_FLAG_ISCOPY)) {
+        else {
+            ret = hash_ctx_final(ctx, digest);
+            hash_ctx_free(ctx);
             free(ctx);
             *devCtx = NULL;
         }
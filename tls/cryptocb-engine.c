@@ -0,0 +1,168 @@
+/* cryptocb-engine.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "cryptocb-engine.h"
+
+#include <time.h>
+
+#ifdef WOLF_CRYPTO_CB
+
+/* Whether the operation is done by the engine. */
+static int Engine_Offloaded(wc_CryptoInfo* info)
+{
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+    /* TLS record protection */
+    if (info->algo_type == WC_ALGO_TYPE_CIPHER &&
+            info->cipher.type == WC_CIPHER_AES_GCM) {
+        return 1;
+    }
+#endif
+#ifdef HAVE_ECC
+    /* ECDHE */
+    if (info->algo_type == WC_ALGO_TYPE_PK &&
+            (info->pk.type == WC_PK_TYPE_EC_KEYGEN ||
+             info->pk.type == WC_PK_TYPE_ECDH)) {
+        return 1;
+    }
+#endif
+    (void)info;
+    return 0;
+}
+
+/* Take batches of requests off the queue and process them. */
+static void* Engine_Thread(void* arg)
+{
+    Engine*         engine = (Engine*)arg;
+    EngineReq*      batch;
+    EngineReq*      req;
+    EngineReq*      last;
+    int             cnt;
+    struct timespec ts;
+
+    pthread_mutex_lock(&engine->lock);
+    for (;;) {
+        while (engine->head == NULL && !engine->stop)
+            pthread_cond_wait(&engine->cond, &engine->lock);
+        if (engine->head == NULL)
+            break;
+
+        /* Take up to the maximum number of requests for this submission. */
+        batch = engine->head;
+        last = batch;
+        for (cnt = 1; cnt < engine->batchMax && last->next != NULL; cnt++)
+            last = last->next;
+        engine->head = last->next;
+        if (engine->head == NULL)
+            engine->tail = NULL;
+        last->next = NULL;
+        engine->submissions++;
+        engine->requests += cnt;
+        if (cnt > engine->maxBatch)
+            engine->maxBatch = cnt;
+        pthread_mutex_unlock(&engine->lock);
+
+        if (engine->submitUs > 0) {
+            ts.tv_sec = engine->submitUs / 1000000;
+            ts.tv_nsec = (long)(engine->submitUs % 1000000) * 1000;
+            nanosleep(&ts, NULL);
+        }
+        for (req = batch; req != NULL; req = req->next)
+            req->ret = myCryptoCb(req->devId, req->info, NULL);
+
+        pthread_mutex_lock(&engine->lock);
+        for (req = batch; req != NULL; req = req->next)
+            req->done = 1;
+        pthread_cond_broadcast(&engine->doneCond);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    return NULL;
+}
+
+int Engine_CryptoCb(int devId, wc_CryptoInfo* info, void* ctx)
+{
+    Engine*   engine = (Engine*)ctx;
+    EngineReq req;
+
+    if (info == NULL || engine == NULL)
+        return BAD_FUNC_ARG;
+    if (!Engine_Offloaded(info))
+        return myCryptoCb(devId, info, NULL);
+
+    req.info = info;
+    req.devId = devId;
+    req.ret = 0;
+    req.done = 0;
+    req.next = NULL;
+
+    /* Queue the request and wait for the engine to complete it. */
+    pthread_mutex_lock(&engine->lock);
+    if (engine->tail == NULL)
+        engine->head = &req;
+    else
+        engine->tail->next = &req;
+    engine->tail = &req;
+    pthread_cond_signal(&engine->cond);
+    while (!req.done)
+        pthread_cond_wait(&engine->doneCond, &engine->lock);
+    pthread_mutex_unlock(&engine->lock);
+
+    return req.ret;
+}
+
+int Engine_Init(Engine* engine, int batchMax, int submitUs)
+{
+    if (engine == NULL || batchMax <= 0 || submitUs < 0)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(engine, 0, sizeof(*engine));
+    engine->batchMax = batchMax;
+    engine->submitUs = submitUs;
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->cond, NULL);
+    pthread_cond_init(&engine->doneCond, NULL);
+    if (pthread_create(&engine->tid, NULL, Engine_Thread, engine) != 0) {
+        pthread_cond_destroy(&engine->doneCond);
+        pthread_cond_destroy(&engine->cond);
+        pthread_mutex_destroy(&engine->lock);
+        return MEMORY_E;
+    }
+
+    return 0;
+}
+
+void Engine_Free(Engine* engine)
+{
+    if (engine == NULL)
+        return;
+
+    pthread_mutex_lock(&engine->lock);
+    engine->stop = 1;
+    pthread_cond_signal(&engine->cond);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->tid, NULL);
+
+    pthread_cond_destroy(&engine->doneCond);
+    pthread_cond_destroy(&engine->cond);
+    pthread_mutex_destroy(&engine->lock);
+}
+
+#endif /* WOLF_CRYPTO_CB */
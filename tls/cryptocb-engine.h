@@ -0,0 +1,76 @@
+/* cryptocb-engine.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef _CRYPTOCB_ENGINE_H_
+#define _CRYPTOCB_ENGINE_H_
+
+#include <pthread.h>
+
+#include "cryptocb-common.h"
+
+#ifdef WOLF_CRYPTO_CB
+
+/* A request waiting in the engine's queue. */
+typedef struct EngineReq {
+    wc_CryptoInfo*    info;
+    int               devId;
+    int               ret;
+    int               done;
+    struct EngineReq* next;
+} EngineReq;
+
+/* Emulated offload engine.
+ *
+ * Requests are queued and the engine takes up to batchMax of them per
+ * submission. Each submission costs submitUs microseconds, as setting up
+ * DMA and ringing a doorbell would, and the requests are then processed by
+ * myCryptoCb.
+ */
+typedef struct Engine {
+    pthread_t       tid;
+    pthread_mutex_t lock;
+    /* Signaled when a request is queued. */
+    pthread_cond_t  cond;
+    /* Signaled when a batch is done. */
+    pthread_cond_t  doneCond;
+    EngineReq*      head;
+    EngineReq*      tail;
+    int             batchMax;
+    int             submitUs;
+    int             stop;
+    /* Statistics - changed under lock. */
+    long            submissions;
+    long            requests;
+    int             maxBatch;
+} Engine;
+
+/* Start the engine's thread. */
+int  Engine_Init(Engine* engine, int batchMax, int submitUs);
+/* Crypto callback to register with the engine as the context.
+ * AES-GCM, ECC key generation and ECDH are queued to the engine, all other
+ * operations are done by myCryptoCb in the calling thread. */
+int  Engine_CryptoCb(int devId, wc_CryptoInfo* info, void* ctx);
+/* Stop the engine's thread - no requests may be outstanding. */
+void Engine_Free(Engine* engine);
+
+#endif /* WOLF_CRYPTO_CB */
+
+#endif /* !_CRYPTOCB_ENGINE_H_ */
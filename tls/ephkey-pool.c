@@ -0,0 +1,463 @@
+/* ephkey-pool.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Pool of pre-generated ephemeral key pairs for TLS handshakes.
+ *
+ * Threads at idle priority generate P-256, X25519 and ML-KEM-768 key pairs
+ * into a pool for each kind. The pool is a crypto callback device: when a
+ * handshake of an attached context generates a key share, the callback
+ * imports a key pair taken from the pool instead. A key pair is removed from
+ * the pool when taken and zeroized after import - it is never used twice.
+ * When the pool is empty, the key pair is generated in software as usual.
+ * All other operations fall back to software.
+ */
+
+#define _GNU_SOURCE
+#include "ephkey-pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/curve25519.h>
+#ifdef WOLFSSL_HAVE_MLKEM
+    #include <wolfssl/wolfcrypt/mlkem.h>
+    #include <wolfssl/wolfcrypt/wc_mlkem.h>
+#endif
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/cryptocb.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#ifdef WOLF_CRYPTO_CB
+
+/* Most threads filling the pool. */
+#define EPHKEY_MAX_THREADS  64
+
+/* An encoded key pair - private part then public part. */
+typedef struct EphKey {
+    word32 privSz;
+    word32 pubSz;
+    byte*  data;
+} EphKey;
+
+/* Ring of key pairs of one kind. */
+typedef struct EphKeyRing {
+    EphKey** keys;
+    int      size;
+    int      head;
+    int      count;
+    /* Number of key pairs being generated for the ring. */
+    int      inProgress;
+    int      enabled;
+} EphKeyRing;
+
+/* The pool - changed under gLock. */
+static struct {
+    EphKeyRing      rings[EPHKEY_KINDS];
+    pthread_t       tids[EPHKEY_MAX_THREADS];
+    int             numThreads;
+    int             stop;
+    EphKeyPoolStats stats;
+} gPool;
+
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when a key pair is taken. */
+static pthread_cond_t  gNeedKey = PTHREAD_COND_INITIALIZER;
+/* Signaled when a key pair is added or a kind is given up on. */
+static pthread_cond_t  gHaveKey = PTHREAD_COND_INITIALIZER;
+
+
+static void EphKey_Free(EphKey* key)
+{
+    if (key != NULL) {
+        XMEMSET(key->data, 0, key->privSz + key->pubSz);
+        free(key);
+    }
+}
+
+static EphKey* EphKey_New(word32 privSz, word32 pubSz)
+{
+    EphKey* key;
+
+    /* One allocation holding the key pair after the header. */
+    key = (EphKey*)malloc(sizeof(EphKey) + privSz + pubSz);
+    if (key != NULL) {
+        key->privSz = privSz;
+        key->pubSz = pubSz;
+        key->data = (byte*)(key + 1);
+    }
+    return key;
+}
+
+/* Generate a key pair of the kind and encode it. */
+static int EphKey_Make(int kind, WC_RNG* rng, EphKey** out)
+{
+    int     ret = NOT_COMPILED_IN;
+    EphKey* key = NULL;
+
+    switch (kind) {
+#ifdef HAVE_ECC
+        case EPHKEY_P256: {
+            ecc_key ecc;
+
+            ret = wc_ecc_init_ex(&ecc, NULL, INVALID_DEVID);
+            if (ret != 0)
+                break;
+            ret = wc_ecc_make_key_ex(rng, 32, &ecc, ECC_SECP256R1);
+            if (ret == 0) {
+                key = EphKey_New(32, 1 + 2 * 32);
+                if (key == NULL)
+                    ret = MEMORY_E;
+            }
+            if (ret == 0) {
+                ret = wc_ecc_export_private_only(&ecc, key->data,
+                    &key->privSz);
+            }
+            if (ret == 0) {
+                ret = wc_ecc_export_x963(&ecc, key->data + key->privSz,
+                    &key->pubSz);
+            }
+            wc_ecc_free(&ecc);
+            break;
+        }
+#endif
+#ifdef HAVE_CURVE25519
+        case EPHKEY_X25519: {
+            curve25519_key x25519;
+
+            ret = wc_curve25519_init_ex(&x25519, NULL, INVALID_DEVID);
+            if (ret != 0)
+                break;
+            ret = wc_curve25519_make_key(rng, CURVE25519_KEYSIZE, &x25519);
+            if (ret == 0) {
+                key = EphKey_New(CURVE25519_KEYSIZE, CURVE25519_KEYSIZE);
+                if (key == NULL)
+                    ret = MEMORY_E;
+            }
+            if (ret == 0) {
+                ret = wc_curve25519_export_key_raw(&x25519, key->data,
+                    &key->privSz, key->data + CURVE25519_KEYSIZE,
+                    &key->pubSz);
+            }
+            wc_curve25519_free(&x25519);
+            break;
+        }
+#endif
+#ifdef WOLFSSL_HAVE_MLKEM
+        case EPHKEY_MLKEM768: {
+            MlKemKey mlkem;
+            word32   sz = 0;
+
+            ret = wc_MlKemKey_Init(&mlkem, WC_ML_KEM_768, NULL, INVALID_DEVID);
+            if (ret != 0)
+                break;
+            ret = wc_MlKemKey_MakeKey(&mlkem, rng);
+            if (ret == 0)
+                ret = wc_MlKemKey_PrivateKeySize(&mlkem, &sz);
+            if (ret == 0) {
+                /* Encoded private key holds the public key. */
+                key = EphKey_New(sz, 0);
+                if (key == NULL)
+                    ret = MEMORY_E;
+            }
+            if (ret == 0)
+                ret = wc_MlKemKey_EncodePrivateKey(&mlkem, key->data, sz);
+            wc_MlKemKey_Free(&mlkem);
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+
+    if (ret != 0) {
+        EphKey_Free(key);
+        key = NULL;
+    }
+    *out = key;
+    return ret;
+}
+
+/* Pick the ring with the fewest key pairs that isn't full - all rings are
+ * the same size. Call with lock held. */
+static int EphKeyPool_KindToFill(void)
+{
+    int         kind = -1;
+    int         i;
+    int         have;
+    int         least = 0;
+    EphKeyRing* ring;
+
+    for (i = 0; i < EPHKEY_KINDS; i++) {
+        ring = &gPool.rings[i];
+        have = ring->count + ring->inProgress;
+        if (ring->enabled && have < ring->size && (kind < 0 || have < least)) {
+            kind = i;
+            least = have;
+        }
+    }
+
+    return kind;
+}
+
+/* Fill the rings until stopped. */
+static void* EphKeyPool_Thread(void* arg)
+{
+    int     ret;
+    int     kind;
+    WC_RNG  rng;
+    EphKey* key;
+#ifdef SCHED_IDLE
+    struct sched_param sp;
+
+    /* Only use cores that have nothing else to do. */
+    XMEMSET(&sp, 0, sizeof(sp));
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp);
+#endif
+
+    (void)arg;
+
+    if (wc_InitRng(&rng) != 0) {
+        fprintf(stderr, "ERROR: ephemeral key pool failed to create RNG\n");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&gLock);
+    while (!gPool.stop) {
+        kind = EphKeyPool_KindToFill();
+        if (kind < 0) {
+            pthread_cond_wait(&gNeedKey, &gLock);
+            continue;
+        }
+        gPool.rings[kind].inProgress++;
+        pthread_mutex_unlock(&gLock);
+
+        ret = EphKey_Make(kind, &rng, &key);
+
+        pthread_mutex_lock(&gLock);
+        gPool.rings[kind].inProgress--;
+        if (ret != 0) {
+            fprintf(stderr, "ERROR: failed to make ephemeral key: %d\n", ret);
+            /* Don't keep trying - handshakes generate their own keys. */
+            gPool.rings[kind].enabled = 0;
+            pthread_cond_broadcast(&gHaveKey);
+            continue;
+        }
+        gPool.rings[kind].keys[(gPool.rings[kind].head +
+            gPool.rings[kind].count) % gPool.rings[kind].size] = key;
+        gPool.rings[kind].count++;
+        gPool.stats.made[kind]++;
+        pthread_cond_broadcast(&gHaveKey);
+    }
+    pthread_mutex_unlock(&gLock);
+
+    wc_FreeRng(&rng);
+    return NULL;
+}
+
+/* Take a key pair of the kind - NULL when the pool is empty. */
+static EphKey* EphKeyPool_Take(int kind)
+{
+    EphKey*     key = NULL;
+    EphKeyRing* ring = &gPool.rings[kind];
+
+    pthread_mutex_lock(&gLock);
+    if (ring->count > 0) {
+        key = ring->keys[ring->head];
+        ring->keys[ring->head] = NULL;
+        ring->head = (ring->head + 1) % ring->size;
+        ring->count--;
+        gPool.stats.taken[kind]++;
+        pthread_cond_signal(&gNeedKey);
+    }
+    else {
+        gPool.stats.misses[kind]++;
+    }
+    pthread_mutex_unlock(&gLock);
+
+    return key;
+}
+
+/* Import key pairs from the pool for key generation.
+ * Everything else is done in software. */
+static int EphKeyPool_CryptoCb(int devIdArg, wc_CryptoInfo* info, void* ctx)
+{
+    int     ret = CRYPTOCB_UNAVAILABLE;
+    EphKey* key = NULL;
+
+    (void)devIdArg;
+    (void)ctx;
+
+    if (info->algo_type != WC_ALGO_TYPE_PK)
+        return ret;
+
+#ifdef HAVE_ECC
+    if (info->pk.type == WC_PK_TYPE_EC_KEYGEN &&
+            (info->pk.eckg.curveId == ECC_SECP256R1 ||
+             (info->pk.eckg.curveId == ECC_CURVE_DEF &&
+              info->pk.eckg.size == 32))) {
+        key = EphKeyPool_Take(EPHKEY_P256);
+        if (key != NULL) {
+            ret = wc_ecc_import_private_key_ex(key->data, key->privSz,
+                key->data + key->privSz, key->pubSz, info->pk.eckg.key,
+                ECC_SECP256R1);
+        }
+    }
+#endif
+#ifdef HAVE_CURVE25519
+    if (info->pk.type == WC_PK_TYPE_CURVE25519_KEYGEN) {
+        key = EphKeyPool_Take(EPHKEY_X25519);
+        if (key != NULL) {
+            ret = wc_curve25519_import_private_raw(key->data, key->privSz,
+                key->data + key->privSz, key->pubSz,
+                info->pk.curve25519kg.key);
+        }
+    }
+#endif
+#ifdef WOLFSSL_HAVE_MLKEM
+    if (info->pk.type == WC_PK_TYPE_PQC_KEM_KEYGEN &&
+            info->pk.pqc_kem_kg.type == WC_PQC_KEM_TYPE_KYBER &&
+            ((MlKemKey*)info->pk.pqc_kem_kg.key)->type == WC_ML_KEM_768) {
+        key = EphKeyPool_Take(EPHKEY_MLKEM768);
+        if (key != NULL) {
+            ret = wc_MlKemKey_DecodePrivateKey(
+                (MlKemKey*)info->pk.pqc_kem_kg.key, key->data, key->privSz);
+        }
+    }
+#endif
+
+    /* Generate in software when the pooled key pair couldn't be used. */
+    if (key != NULL && ret != 0)
+        ret = CRYPTOCB_UNAVAILABLE;
+
+    /* Single use - gone from the pool and zeroized. */
+    EphKey_Free(key);
+
+    return ret;
+}
+
+int EphKeyPool_Init(int numThreads, int poolSz)
+{
+    int ret = 0;
+    int i;
+
+    if (numThreads < 1 || numThreads > EPHKEY_MAX_THREADS || poolSz < 1)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(gPool.rings, 0, sizeof(gPool.rings));
+    XMEMSET(&gPool.stats, 0, sizeof(gPool.stats));
+    gPool.stop = 0;
+    for (i = 0; ret == 0 && i < EPHKEY_KINDS; i++) {
+        gPool.rings[i].size = poolSz;
+        gPool.rings[i].keys = (EphKey**)calloc(poolSz, sizeof(EphKey*));
+        if (gPool.rings[i].keys == NULL)
+            ret = MEMORY_E;
+    }
+    if (ret != 0) {
+        EphKeyPool_Cleanup();
+        return ret;
+    }
+#ifdef HAVE_ECC
+    gPool.rings[EPHKEY_P256].enabled = 1;
+#endif
+#ifdef HAVE_CURVE25519
+    gPool.rings[EPHKEY_X25519].enabled = 1;
+#endif
+#ifdef WOLFSSL_HAVE_MLKEM
+    gPool.rings[EPHKEY_MLKEM768].enabled = 1;
+#endif
+
+    ret = wc_CryptoCb_RegisterDevice(EPHKEY_POOL_DEVID, EphKeyPool_CryptoCb,
+        NULL);
+    for (i = 0; ret == 0 && i < numThreads; i++) {
+        if (pthread_create(&gPool.tids[i], NULL, EphKeyPool_Thread,
+                NULL) != 0) {
+            break;
+        }
+        gPool.numThreads++;
+    }
+    if (ret == 0 && gPool.numThreads == 0)
+        ret = -1;
+    if (ret != 0)
+        EphKeyPool_Cleanup();
+
+    return ret;
+}
+
+int EphKeyPool_Attach(WOLFSSL_CTX* ctx)
+{
+    if (wolfSSL_CTX_SetDevId(ctx, EPHKEY_POOL_DEVID) != WOLFSSL_SUCCESS)
+        return -1;
+    return 0;
+}
+
+void EphKeyPool_WaitFull(void)
+{
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    for (i = 0; i < EPHKEY_KINDS; ) {
+        if (gPool.rings[i].enabled && gPool.rings[i].count < gPool.rings[i].size)
+            pthread_cond_wait(&gHaveKey, &gLock);
+        else
+            i++;
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+void EphKeyPool_GetStats(EphKeyPoolStats* stats)
+{
+    pthread_mutex_lock(&gLock);
+    *stats = gPool.stats;
+    pthread_mutex_unlock(&gLock);
+}
+
+void EphKeyPool_Cleanup(void)
+{
+    int i;
+    int j;
+
+    pthread_mutex_lock(&gLock);
+    gPool.stop = 1;
+    pthread_cond_broadcast(&gNeedKey);
+    pthread_mutex_unlock(&gLock);
+    for (i = 0; i < gPool.numThreads; i++)
+        pthread_join(gPool.tids[i], NULL);
+    gPool.numThreads = 0;
+
+    wc_CryptoCb_UnRegisterDevice(EPHKEY_POOL_DEVID);
+
+    for (i = 0; i < EPHKEY_KINDS; i++) {
+        if (gPool.rings[i].keys != NULL) {
+            for (j = 0; j < gPool.rings[i].size; j++)
+                EphKey_Free(gPool.rings[i].keys[j]);
+            free(gPool.rings[i].keys);
+        }
+        gPool.rings[i].keys = NULL;
+        gPool.rings[i].count = 0;
+        gPool.rings[i].enabled = 0;
+    }
+}
+
+#endif /* WOLF_CRYPTO_CB */
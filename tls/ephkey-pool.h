@@ -0,0 +1,67 @@
+/* ephkey-pool.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef _EPHKEY_POOL_H_
+#define _EPHKEY_POOL_H_
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+
+#ifdef WOLF_CRYPTO_CB
+
+/* Device identifier the pool's crypto callback is registered with. */
+#ifndef EPHKEY_POOL_DEVID
+    #define EPHKEY_POOL_DEVID   0x45504b50
+#endif
+
+/* Kinds of ephemeral key pair kept. */
+enum {
+    EPHKEY_P256,
+    EPHKEY_X25519,
+    EPHKEY_MLKEM768,
+    EPHKEY_KINDS
+};
+
+/* Counts for each kind of key pair. */
+typedef struct EphKeyPoolStats {
+    unsigned long made[EPHKEY_KINDS];
+    unsigned long taken[EPHKEY_KINDS];
+    /* Key pairs generated during a handshake as the pool was empty. */
+    unsigned long misses[EPHKEY_KINDS];
+} EphKeyPoolStats;
+
+/* Start numThreads threads that keep poolSz key pairs of each kind compiled
+ * in. The threads run at idle priority where supported. */
+int  EphKeyPool_Init(int numThreads, int poolSz);
+/* Take the ephemeral keys of handshakes of the context from the pool. */
+int  EphKeyPool_Attach(WOLFSSL_CTX* ctx);
+/* Wait until every kind of key pair has a full pool. */
+void EphKeyPool_WaitFull(void);
+void EphKeyPool_GetStats(EphKeyPoolStats* stats);
+/* Stop the threads and dispose of the key pairs not used. */
+void EphKeyPool_Cleanup(void);
+
+#endif /* WOLF_CRYPTO_CB */
+
+#endif /* !_EPHKEY_POOL_H_ */
@@ -0,0 +1,942 @@
+/* server-tls-pkcallback-async.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * Like server-tls-pkcallback, the private key operations are done in PK
+ * callbacks. Here the callbacks don't sign: they queue the operation for a
+ * pool of signer threads, standing in for a remote signer or HSM, and return
+ * WC_PENDING_E. One epoll event loop keeps many handshakes in flight and
+ * continues a handshake when its signature is ready. The signers add a
+ * configurable latency to each operation.
+ *
+ * Handshakes are counted and the rate printed at exit. Connections are
+ * handled as client-tls-perf expects: every message read is answered with a
+ * reply until the client closes.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+/* socket includes */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/* threads */
+#include <pthread.h>
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/rsa.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/test.h>
+
+#define DEFAULT_PORT        11111
+/* Default number of signer threads - operations the signer does at once. */
+#define NUM_SIGNERS         32
+/* Maximum number of signer threads. */
+#define MAX_SIGNERS         1024
+/* Default latency of the signer in microseconds. */
+#define SIGN_LATENCY_US     1000
+/* The number of epoll events to process at one time. */
+#define EPOLL_NUM_EVENTS    64
+/* Milliseconds to wait for events before checking for shutdown. */
+#define POLL_TIMEOUT_MS     100
+/* Default number of bytes to read from and write to the client. */
+#define NUM_READ_BYTES      16384
+#define NUM_WRITE_BYTES     16384
+/* Largest data to sign and signature - RSA 4096-bit. */
+#define MAX_SIGN_SZ         512
+
+#define ECC_CERT_FILE       "../certs/server-ecc.pem"
+#define ECC_KEY_FILE        "../certs/ecc-key.pem"
+#define ECC_KEYPUB_FILE     "../certs/ecc-keyPub.pem"
+#define RSA_CERT_FILE       "../certs/server-cert.pem"
+#define RSA_KEY_FILE        "../certs/server-key.pem"
+#define RSA_KEYPUB_FILE     "../certs/server-keyPub.pem"
+
+/* The command line options. */
+#define OPTIONS "?p:w:l:n:rR:W:"
+
+#if defined(HAVE_PK_CALLBACKS) && defined(WOLFSSL_ASYNC_CRYPT) && \
+    (defined(HAVE_ECC) || !defined(NO_RSA))
+
+/* Private key operation requested by a callback. */
+enum {
+    SIGN_ECC,
+    SIGN_RSA,
+    SIGN_RSA_PSS
+};
+
+/* State of the operation of a connection. */
+enum {
+    JOB_IDLE,
+    JOB_PENDING,
+    JOB_DONE
+};
+
+/* State of a connection. */
+enum {
+    CONN_ACCEPT,
+    CONN_READ,
+    CONN_WRITE
+};
+
+struct Conn;
+
+/* A private key operation. A connection has at most one outstanding. */
+typedef struct SignJob {
+    struct SignJob* next;
+    struct Conn*    conn;
+    int             type;
+    int             hash;
+    int             mgf;
+    int             state;
+    int             ret;
+    byte            in[MAX_SIGN_SZ];
+    word32          inSz;
+    byte            out[MAX_SIGN_SZ];
+    word32          outSz;
+    double          submitted;
+} SignJob;
+
+/* A connection handled by the event loop. */
+typedef struct Conn {
+    WOLFSSL* ssl;
+    int      fd;
+    int      state;
+    /* Events registered with epoll - 0 when not registered. */
+    uint32_t events;
+    SignJob  job;
+} Conn;
+
+/* Data of each signer thread. */
+typedef struct Signer {
+    pthread_t tid;
+    WC_RNG    rng;
+#ifdef HAVE_ECC
+    ecc_key   keyEcc;
+#endif
+#ifndef NO_RSA
+    RsaKey    keyRsa;
+#endif
+} Signer;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static WOLFSSL_CTX*          gCtx;
+static int                   gUseRsa;
+static byte*                 gKeyDer;
+static word32                gKeyDerSz;
+static int                   gLatency = SIGN_LATENCY_US;
+static int                   gReadLen = NUM_READ_BYTES;
+static int                   gReplyLen = NUM_WRITE_BYTES;
+static char*                 gReply;
+/* Operations waiting for a signer. */
+static pthread_mutex_t       gJobLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t        gJobCond = PTHREAD_COND_INITIALIZER;
+static SignJob*              gJobHead;
+static SignJob*              gJobTail;
+static int                   gSignersStop;
+/* Completed operations for the event loop. */
+static pthread_mutex_t       gDoneLock = PTHREAD_MUTEX_INITIALIZER;
+static SignJob*              gDoneHead;
+static int                   gDoneFd = -1;
+/* Statistics - only changed by the event loop. */
+static long                  gHandshakes;
+static long                  gResumed;
+static long                  gFailed;
+static long                  gSigns;
+static double                gSignTime;
+static long                  gPending;
+static long                  gPeakPending;
+static long                  gActive;
+static long                  gPeakActive;
+static double                gStart;
+/* Set on SIGINT or when the number of handshakes is reached. */
+static volatile sig_atomic_t gShutdown;
+
+
+static void SigIntHandler(int sig)
+{
+    (void)sig;
+    gShutdown = 1;
+}
+
+/* reads file size, allocates buffer, reads into buffer, returns buffer */
+static int load_file(const char* fname, byte** buf, size_t* bufLen)
+{
+    int ret;
+    long int fileSz;
+    XFILE lFile;
+
+    if (fname == NULL || buf == NULL || bufLen == NULL)
+        return BAD_FUNC_ARG;
+
+    /* set defaults */
+    *buf = NULL;
+    *bufLen = 0;
+
+    /* open file (read-only binary) */
+    lFile = XFOPEN(fname, "rb");
+    if (!lFile) {
+        printf("Error loading %s\n", fname);
+        return BAD_PATH_ERROR;
+    }
+
+    fseek(lFile, 0, SEEK_END);
+    fileSz = (int)ftell(lFile);
+    rewind(lFile);
+    if (fileSz  > 0) {
+        *bufLen = (size_t)fileSz;
+        *buf = (byte*)malloc(*bufLen);
+        if (*buf == NULL) {
+            ret = MEMORY_E;
+            printf("Error allocating %lu bytes\n", (unsigned long)*bufLen);
+        }
+        else {
+            size_t readLen = fread(*buf, *bufLen, 1, lFile);
+
+            /* check response code */
+            ret = (readLen > 0) ? 0 : -1;
+        }
+    }
+    else {
+        ret = BUFFER_E;
+    }
+    fclose(lFile);
+
+    return ret;
+}
+
+static int load_key_file(const char* fname, byte** derBuf, word32* derLen)
+{
+    int ret;
+    byte* buf = NULL;
+    size_t bufLen;
+
+    ret = load_file(fname, &buf, &bufLen);
+    if (ret != 0)
+        return ret;
+
+    *derBuf = (byte*)malloc(bufLen);
+    if (*derBuf == NULL) {
+        free(buf);
+        return MEMORY_E;
+    }
+
+    ret = wc_KeyPemToDer(buf, (word32)bufLen, *derBuf, (word32)bufLen, NULL);
+    if (ret < 0) {
+        free(buf);
+        free(*derBuf);
+        return ret;
+    }
+    *derLen = ret;
+    free(buf);
+
+    return 0;
+}
+
+
+#ifdef WC_RSA_PSS
+/* Convert the hash algorithm of TLS to a wolfCrypt hash type. */
+static enum wc_HashType HashType(int hash)
+{
+    switch (hash) {
+#ifndef NO_SHA256
+        case SHA256h:
+            return WC_HASH_TYPE_SHA256;
+#endif
+#ifdef WOLFSSL_SHA384
+        case SHA384h:
+            return WC_HASH_TYPE_SHA384;
+#endif
+#ifdef WOLFSSL_SHA512
+        case SHA512h:
+            return WC_HASH_TYPE_SHA512;
+#endif
+        default:
+            return WC_HASH_TYPE_NONE;
+    }
+}
+#endif
+
+/* Do the private key operation of a job with the signer's key. */
+static void Signer_Sign(Signer* s, SignJob* job)
+{
+    int ret = NOT_COMPILED_IN;
+
+    switch (job->type) {
+#ifdef HAVE_ECC
+        case SIGN_ECC:
+            ret = wc_ecc_sign_hash(job->in, job->inSz, job->out, &job->outSz,
+                &s->rng, &s->keyEcc);
+            break;
+#endif
+#ifndef NO_RSA
+        case SIGN_RSA:
+            ret = wc_RsaSSL_Sign(job->in, job->inSz, job->out, job->outSz,
+                &s->keyRsa, &s->rng);
+            break;
+    #ifdef WC_RSA_PSS
+        case SIGN_RSA_PSS:
+            ret = wc_RsaPSS_Sign(job->in, job->inSz, job->out, job->outSz,
+                HashType(job->hash), job->mgf, &s->keyRsa, &s->rng);
+            break;
+    #endif
+#endif
+        default:
+            break;
+    }
+    /* RSA returns the signature length - save and convert to 0 success */
+    if (ret > 0) {
+        job->outSz = (word32)ret;
+        ret = 0;
+    }
+    job->ret = ret;
+}
+
+/* Signer thread: wait for an operation, delay, sign and hand it back. */
+static void* SignerMain(void* args)
+{
+    Signer*  s = (Signer*)args;
+    SignJob* job;
+    uint64_t one = 1;
+
+    for (;;) {
+        pthread_mutex_lock(&gJobLock);
+        while (gJobHead == NULL && !gSignersStop)
+            pthread_cond_wait(&gJobCond, &gJobLock);
+        if (gSignersStop) {
+            pthread_mutex_unlock(&gJobLock);
+            break;
+        }
+        job = gJobHead;
+        gJobHead = job->next;
+        if (gJobHead == NULL)
+            gJobTail = NULL;
+        pthread_mutex_unlock(&gJobLock);
+
+        /* Time taken to reach the signer and for it to respond. */
+        if (gLatency > 0)
+            usleep(gLatency);
+        Signer_Sign(s, job);
+
+        pthread_mutex_lock(&gDoneLock);
+        job->next = gDoneHead;
+        gDoneHead = job;
+        pthread_mutex_unlock(&gDoneLock);
+        if (write(gDoneFd, &one, sizeof(one)) < 0)
+            fprintf(stderr, "ERROR: failed to signal completion\n");
+    }
+
+#if defined(HAVE_ECC) && defined(FP_ECC)
+    wc_ecc_fp_free();  /* free per thread cache */
+#endif
+    return NULL;
+}
+
+/* Load the signer's copy of the private key.
+ *
+ * returns 0 on success, otherwise failure.
+ */
+static int Signer_Init(Signer* s)
+{
+    int    ret;
+    word32 idx = 0;
+
+    ret = wc_InitRng(&s->rng);
+    if (ret != 0)
+        return ret;
+#ifndef NO_RSA
+    if (gUseRsa) {
+        ret = wc_InitRsaKey(&s->keyRsa, NULL);
+        if (ret == 0)
+            ret = wc_RsaPrivateKeyDecode(gKeyDer, &idx, &s->keyRsa, gKeyDerSz);
+        return ret;
+    }
+#endif
+#ifdef HAVE_ECC
+    ret = wc_ecc_init(&s->keyEcc);
+    if (ret == 0)
+        ret = wc_EccPrivateKeyDecode(gKeyDer, &idx, &s->keyEcc, gKeyDerSz);
+#endif
+    return ret;
+}
+
+static void Signer_Free(Signer* s)
+{
+#ifndef NO_RSA
+    if (gUseRsa)
+        wc_FreeRsaKey(&s->keyRsa);
+#endif
+#ifdef HAVE_ECC
+    if (!gUseRsa)
+        wc_ecc_free(&s->keyEcc);
+#endif
+    wc_FreeRng(&s->rng);
+}
+
+
+/* Common part of the sign callbacks. The first call queues the operation and
+ * returns WC_PENDING_E. wolfSSL calls again with the same data when the
+ * handshake is continued after the operation completes.
+ */
+static int Sign_Submit(Conn* conn, int type, const byte* in, word32 inSz,
+    byte* out, word32* outSz, int hash, int mgf)
+{
+    SignJob* job = &conn->job;
+
+    if (job->state == JOB_DONE) {
+        job->state = JOB_IDLE;
+        if (job->ret != 0)
+            return job->ret;
+        if (job->outSz > *outSz)
+            return BUFFER_E;
+        XMEMCPY(out, job->out, job->outSz);
+        *outSz = job->outSz;
+        return 0;
+    }
+    if (job->state == JOB_PENDING)
+        return WC_PENDING_E;
+    if (inSz > sizeof(job->in))
+        return BUFFER_E;
+
+    XMEMCPY(job->in, in, inSz);
+    job->inSz  = inSz;
+    job->outSz = *outSz < sizeof(job->out) ? *outSz : sizeof(job->out);
+    job->type  = type;
+    job->hash  = hash;
+    job->mgf   = mgf;
+    job->conn  = conn;
+    job->next  = NULL;
+    job->state = JOB_PENDING;
+    job->submitted = current_time(0);
+
+    pthread_mutex_lock(&gJobLock);
+    if (gJobTail != NULL)
+        gJobTail->next = job;
+    else
+        gJobHead = job;
+    gJobTail = job;
+    pthread_cond_signal(&gJobCond);
+    pthread_mutex_unlock(&gJobLock);
+
+    if (++gPending > gPeakPending)
+        gPeakPending = gPending;
+    return WC_PENDING_E;
+}
+
+#ifdef HAVE_ECC
+static int myEccSign(WOLFSSL* ssl, const byte* in, word32 inSz,
+        byte* out, word32* outSz, const byte* key, word32 keySz, void* ctx)
+{
+    (void)ssl;
+    (void)key;
+    (void)keySz;
+    return Sign_Submit((Conn*)ctx, SIGN_ECC, in, inSz, out, outSz, 0, 0);
+}
+#endif
+
+#ifndef NO_RSA
+static int myRsaSign(WOLFSSL* ssl, const byte* in, word32 inSz,
+        byte* out, word32* outSz, const byte* key, word32 keySz, void* ctx)
+{
+    (void)ssl;
+    (void)key;
+    (void)keySz;
+    return Sign_Submit((Conn*)ctx, SIGN_RSA, in, inSz, out, outSz, 0, 0);
+}
+
+#ifdef WC_RSA_PSS
+static int myRsaPssSign(WOLFSSL* ssl, const byte* in, word32 inSz,
+        byte* out, word32* outSz, int hash, int mgf, const byte* key,
+        word32 keySz, void* ctx)
+{
+    (void)ssl;
+    (void)key;
+    (void)keySz;
+    return Sign_Submit((Conn*)ctx, SIGN_RSA_PSS, in, inSz, out, outSz, hash,
+        mgf);
+}
+#endif
+#endif
+
+
+/* Close a connection and count it. */
+static void Conn_Free(int efd, Conn* conn, int failed)
+{
+    if (failed)
+        gFailed++;
+    if (conn->events != 0)
+        epoll_ctl(efd, EPOLL_CTL_DEL, conn->fd, NULL);
+    wolfSSL_free(conn->ssl);
+    close(conn->fd);
+    free(conn);
+    gActive--;
+}
+
+/* Register interest in reading or writing, or none while signing.
+ *
+ * returns 0 on success, -1 on failure.
+ */
+static int Conn_Want(int efd, Conn* conn, uint32_t events)
+{
+    struct epoll_event ev;
+    int                op;
+
+    if (conn->events == events)
+        return 0;
+    if (events == 0) {
+        /* Not even hang up is reported while the operation is outstanding. */
+        conn->events = 0;
+        return epoll_ctl(efd, EPOLL_CTL_DEL, conn->fd, NULL);
+    }
+    op = (conn->events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    XMEMSET(&ev, 0, sizeof(ev));
+    ev.events   = events;
+    ev.data.ptr = conn;
+    conn->events = events;
+    return epoll_ctl(efd, op, conn->fd, &ev);
+}
+
+/* Progress a connection until it would block or waits for a signature.
+ *
+ * buff  Scratch buffer to read into.
+ */
+static void Conn_Process(int efd, Conn* conn, char* buff)
+{
+    int ret;
+    int err;
+
+    for (;;) {
+        switch (conn->state) {
+            case CONN_ACCEPT:
+                ret = wolfSSL_accept(conn->ssl);
+                if (ret == WOLFSSL_SUCCESS) {
+                    gHandshakes++;
+                    gResumed += wolfSSL_session_reused(conn->ssl);
+                    conn->state = CONN_READ;
+                    continue;
+                }
+                break;
+            case CONN_READ:
+                ret = wolfSSL_read(conn->ssl, buff, gReadLen);
+                if (ret > 0) {
+                    conn->state = CONN_WRITE;
+                    continue;
+                }
+                break;
+            default:
+                /* A retried write must be given the same data. */
+                ret = wolfSSL_write(conn->ssl, gReply, gReplyLen);
+                if (ret > 0) {
+                    conn->state = CONN_READ;
+                    continue;
+                }
+                break;
+        }
+
+        err = wolfSSL_get_error(conn->ssl, ret);
+        if (err == WOLFSSL_ERROR_WANT_READ)
+            ret = Conn_Want(efd, conn, EPOLLIN);
+        else if (err == WOLFSSL_ERROR_WANT_WRITE)
+            ret = Conn_Want(efd, conn, EPOLLOUT);
+        else if (err == WC_PENDING_E) {
+            /* Can't be freed while a signer has the job - ignore failure. */
+            Conn_Want(efd, conn, 0);
+            return;
+        }
+        else {
+            /* Client closing after the handshake isn't a failure. */
+            Conn_Free(efd, conn, conn->state == CONN_ACCEPT);
+            return;
+        }
+        if (ret != 0)
+            Conn_Free(efd, conn, 1);
+        return;
+    }
+}
+
+/* Accept all waiting connections. */
+static void Conn_AcceptAll(int efd, int sockfd, char* buff)
+{
+    int   fd;
+    int   on = 1;
+    Conn* conn;
+
+    while ((fd = accept(sockfd, NULL, NULL)) != -1) {
+        if (gStart == 0)
+            gStart = current_time(1);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        conn = (Conn*)calloc(1, sizeof(*conn));
+        if (conn != NULL)
+            conn->ssl = wolfSSL_new(gCtx);
+        if (conn == NULL || conn->ssl == NULL) {
+            free(conn);
+            close(fd);
+            gFailed++;
+            continue;
+        }
+        conn->fd = fd;
+        conn->state = CONN_ACCEPT;
+        wolfSSL_set_fd(conn->ssl, fd);
+        /* The connection is the context of its sign callbacks. */
+    #ifdef HAVE_ECC
+        wolfSSL_SetEccSignCtx(conn->ssl, conn);
+    #endif
+    #ifndef NO_RSA
+        wolfSSL_SetRsaSignCtx(conn->ssl, conn);
+        #ifdef WC_RSA_PSS
+        wolfSSL_SetRsaPssSignCtx(conn->ssl, conn);
+        #endif
+    #endif
+
+        if (++gActive > gPeakActive)
+            gPeakActive = gActive;
+        /* The ClientHello may already be waiting. */
+        Conn_Process(efd, conn, buff);
+    }
+}
+
+/* Continue the handshakes whose operations have completed. */
+static void Conn_Completed(int efd, char* buff)
+{
+    SignJob* job;
+    SignJob* next;
+    uint64_t cnt;
+    double   now;
+
+    if (read(gDoneFd, &cnt, sizeof(cnt)) < 0)
+        return;
+    pthread_mutex_lock(&gDoneLock);
+    job = gDoneHead;
+    gDoneHead = NULL;
+    pthread_mutex_unlock(&gDoneLock);
+
+    now = current_time(0);
+    for (; job != NULL; job = next) {
+        next = job->next;
+        gPending--;
+        gSigns++;
+        gSignTime += now - job->submitted;
+        job->state = JOB_DONE;
+        Conn_Process(efd, job->conn, buff);
+    }
+}
+
+
+static void Usage(void)
+{
+    printf("server-tls-pkcallback-async " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-p <num>    Port to listen on, default %d\n", DEFAULT_PORT);
+    printf("-w <num>    Number of signer threads, default %d\n", NUM_SIGNERS);
+    printf("-l <num>    Signer latency in microseconds, default %d\n",
+        SIGN_LATENCY_US);
+    printf("-n <num>    Exit after <num> handshakes, default run until ^C\n");
+#if defined(HAVE_ECC) && !defined(NO_RSA)
+    printf("-r          Use RSA certificate and key instead of ECC\n");
+#endif
+    printf("-R <num>    Bytes to read from client at a time, default %d\n",
+        NUM_READ_BYTES);
+    printf("-W <num>    Bytes to reply with, default %d\n", NUM_WRITE_BYTES);
+}
+
+int main(int argc, char* argv[])
+{
+    int                ret = 0;
+    int                ch;
+    int                i;
+    int                n;
+    int                on = 1;
+    int                efd = -1;
+    int                sockfd = SOCKET_INVALID;
+    word16             port = DEFAULT_PORT;
+    int                numSigners = NUM_SIGNERS;
+    int                started = 0;
+    long               maxHandshakes = 0;
+    double             elapsed;
+    char*              buff = NULL;
+    Signer*            signers = NULL;
+    const char*        certFile;
+    const char*        keyFile;
+    const char*        keyPubFile;
+    struct sockaddr_in servAddr;
+    struct epoll_event ev;
+    struct epoll_event events[EPOLL_NUM_EVENTS];
+    struct sigaction   sa;
+
+#ifdef HAVE_ECC
+    gUseRsa = 0;
+#else
+    gUseRsa = 1;
+#endif
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'p':
+                port = (word16)atoi(myoptarg);
+                break;
+            case 'w':
+                numSigners = atoi(myoptarg);
+                if (numSigners < 1 || numSigners > MAX_SIGNERS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'l':
+                gLatency = atoi(myoptarg);
+                break;
+            case 'n':
+                maxHandshakes = atol(myoptarg);
+                break;
+        #if defined(HAVE_ECC) && !defined(NO_RSA)
+            case 'r':
+                gUseRsa = 1;
+                break;
+        #endif
+            case 'R':
+                gReadLen = atoi(myoptarg);
+                if (gReadLen <= 0) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'W':
+                gReplyLen = atoi(myoptarg);
+                if (gReplyLen <= 0) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    certFile   = gUseRsa ? RSA_CERT_FILE   : ECC_CERT_FILE;
+    keyFile    = gUseRsa ? RSA_KEY_FILE    : ECC_KEY_FILE;
+    keyPubFile = gUseRsa ? RSA_KEYPUB_FILE : ECC_KEYPUB_FILE;
+
+    /* Interrupt waiting so the statistics are printed. */
+    XMEMSET(&sa, 0, sizeof(sa));
+    sa.sa_handler = SigIntHandler;
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Initialize wolfSSL */
+    wolfSSL_Init();
+
+    buff = (char*)malloc(gReadLen);
+    gReply = (char*)malloc(gReplyLen);
+    signers = (Signer*)calloc(numSigners, sizeof(Signer));
+    if (buff == NULL || gReply == NULL || signers == NULL) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        ret = -1;
+        goto exit;
+    }
+    XMEMSET(gReply, 'A', gReplyLen);
+
+    /* Only the signers have the private key. */
+    if ((ret = load_key_file(keyFile, &gKeyDer, &gKeyDerSz)) != 0) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                keyFile);
+        goto exit;
+    }
+
+    gCtx = wolfSSL_CTX_new(wolfSSLv23_server_method());
+    if (gCtx == NULL) {
+        fprintf(stderr, "ERROR: failed to create WOLFSSL_CTX\n");
+        ret = -1;
+        goto exit;
+    }
+
+    /* register sign callbacks for the long term key */
+#ifdef HAVE_ECC
+    wolfSSL_CTX_SetEccSignCb(gCtx, myEccSign);
+#endif
+#ifndef NO_RSA
+    wolfSSL_CTX_SetRsaSignCb(gCtx, myRsaSign);
+    #ifdef WC_RSA_PSS
+    wolfSSL_CTX_SetRsaPssSignCb(gCtx, myRsaPssSign);
+    #endif
+#endif
+
+    if ((ret = wolfSSL_CTX_use_certificate_file(gCtx, certFile,
+            WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                certFile);
+        goto exit;
+    }
+    /* The public key is enough - signing is done by the signers. */
+    if ((ret = wolfSSL_CTX_use_PrivateKey_file(gCtx, keyPubFile,
+            WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                keyPubFile);
+        goto exit;
+    }
+
+    gDoneFd = eventfd(0, EFD_NONBLOCK);
+    if (gDoneFd == -1) {
+        fprintf(stderr, "ERROR: failed to create eventfd\n");
+        ret = -1;
+        goto exit;
+    }
+    for (started = 0; started < numSigners; started++) {
+        if (Signer_Init(&signers[started]) != 0) {
+            fprintf(stderr, "ERROR: failed to load key into signer\n");
+            Signer_Free(&signers[started]);
+            ret = -1;
+            goto exit;
+        }
+        if (pthread_create(&signers[started].tid, NULL, SignerMain,
+                &signers[started]) != 0) {
+            fprintf(stderr, "ERROR: failed to create thread\n");
+            Signer_Free(&signers[started]);
+            ret = -1;
+            goto exit;
+        }
+    }
+
+    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+        fprintf(stderr, "ERROR: failed to create the socket\n");
+        ret = -1;
+        goto exit;
+    }
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    memset(&servAddr, 0, sizeof(servAddr));
+    servAddr.sin_family      = AF_INET;
+    servAddr.sin_port        = htons(port);
+    servAddr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(sockfd, (struct sockaddr*)&servAddr, sizeof(servAddr)) == -1 ||
+            listen(sockfd, SOMAXCONN) == -1) {
+        fprintf(stderr, "ERROR: failed to listen on port %d\n", port);
+        ret = -1;
+        goto exit;
+    }
+    fcntl(sockfd, F_SETFL, O_NONBLOCK);
+
+    /* The listening socket and eventfd are told apart by their data. */
+    efd = epoll_create1(0);
+    XMEMSET(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = &sockfd;
+    if (efd == -1 || epoll_ctl(efd, EPOLL_CTL_ADD, sockfd, &ev) != 0) {
+        fprintf(stderr, "ERROR: failed to set up epoll\n");
+        ret = -1;
+        goto exit;
+    }
+    ev.data.ptr = &gDoneFd;
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, gDoneFd, &ev) != 0) {
+        fprintf(stderr, "ERROR: failed to set up epoll\n");
+        ret = -1;
+        goto exit;
+    }
+
+    printf("Waiting for connections on port %d (%s key, %d signers, "
+           "%d us latency)\n", port, gUseRsa ? "RSA" : "ECC", numSigners,
+           gLatency);
+    while (!gShutdown &&
+            (maxHandshakes == 0 || gHandshakes + gFailed < maxHandshakes)) {
+        n = epoll_wait(efd, events, EPOLL_NUM_EVENTS, POLL_TIMEOUT_MS);
+        for (i = 0; i < n; i++) {
+            if (events[i].data.ptr == &sockfd)
+                Conn_AcceptAll(efd, sockfd, buff);
+            else if (events[i].data.ptr == &gDoneFd)
+                Conn_Completed(efd, buff);
+            else
+                Conn_Process(efd, (Conn*)events[i].data.ptr, buff);
+        }
+    }
+    elapsed = gStart != 0 ? current_time(0) - gStart : 0;
+
+    printf("Handshakes   : %ld (%ld failed) in %.3f s, %.1f handshakes/s\n",
+        gHandshakes, gFailed, elapsed,
+        elapsed > 0 ? gHandshakes / elapsed : 0.0);
+    printf("Resumed      : %ld\n", gResumed);
+    printf("Signatures   : %ld, %.3f ms average from request to result\n",
+        gSigns, gSigns ? gSignTime * 1000 / gSigns : 0.0);
+    printf("Peak         : %ld connections, %ld signatures outstanding\n",
+        gPeakActive, gPeakPending);
+
+    ret = 0;
+
+exit:
+    /* Stop the signers - outstanding operations are dropped. */
+    pthread_mutex_lock(&gJobLock);
+    gSignersStop = 1;
+    pthread_cond_broadcast(&gJobCond);
+    pthread_mutex_unlock(&gJobLock);
+    for (i = 0; i < started; i++) {
+        pthread_join(signers[i].tid, NULL);
+        Signer_Free(&signers[i]);
+    }
+    /* Open connections are left for the process exit to clean up. */
+    if (efd != -1)
+        close(efd);
+    if (gDoneFd != -1)
+        close(gDoneFd);
+    if (sockfd != SOCKET_INVALID)
+        close(sockfd);
+    if (gCtx)
+        wolfSSL_CTX_free(gCtx);
+    free(gKeyDer);
+    free(signers);
+    free(gReply);
+    free(buff);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with --enable-pkcallbacks "
+           "--enable-asynccrypt\n");
+    return 0;
+}
+
+#endif /* HAVE_PK_CALLBACKS && WOLFSSL_ASYNC_CRYPT */
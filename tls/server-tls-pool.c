@@ -0,0 +1,834 @@
+/* server-tls-pool.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * TLS server with a fixed pool of worker threads. Each worker multiplexes many
+ * non-blocking WOLFSSL objects with epoll instead of a thread being created
+ * for each connection as in server-tls-threaded.c.
+ *
+ * Connections reach the workers in one of two ways:
+ *   reuseport - each worker listens on the port with SO_REUSEPORT and the
+ *               kernel spreads the connections.
+ *   queue     - the main thread accepts and hands each socket to a worker
+ *               through a lock-free single producer, single consumer ring
+ *               and wakes it with an eventfd.
+ * For comparison, mode thread creates a thread for each connection.
+ *
+ * Each connection is handled as client-tls-perf expects: every message read
+ * is answered with a reply until the client closes. The connection rate, peak
+ * number of threads and memory used are printed at exit.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+/* socket includes */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/* threads */
+#include <pthread.h>
+
+/* wolfSSL */
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+
+#define DEFAULT_PORT        11111
+/* Default number of worker threads. */
+#define NUM_WORKERS         4
+/* Maximum number of worker threads. */
+#define MAX_WORKERS         256
+/* Number of sockets a worker's queue holds - a power of 2. */
+#define QUEUE_SIZE          1024
+/* The number of epoll events to process at one time. */
+#define EPOLL_NUM_EVENTS    64
+/* Milliseconds to wait for events before checking for shutdown. */
+#define POLL_TIMEOUT_MS     100
+/* Size of a cache line - keeps the ends of a queue apart. */
+#define CACHE_LINE          64
+/* Default number of bytes to read from and write to the client. */
+#define NUM_READ_BYTES      16384
+#define NUM_WRITE_BYTES     16384
+
+#define CERT_FILE "../certs/server-cert.pem"
+#define KEY_FILE  "../certs/server-key.pem"
+
+/* The command line options. */
+#define OPTIONS "?p:m:t:n:R:W:"
+
+/* How connections reach the threads handling them. */
+enum {
+    MODE_REUSEPORT,
+    MODE_QUEUE,
+    MODE_THREAD
+};
+
+/* State of a connection. */
+enum {
+    CONN_ACCEPT,
+    CONN_READ,
+    CONN_WRITE
+};
+
+/* Ring of accepted sockets. Only the main thread pushes and only the owning
+ * worker pops, so no lock is needed. Each end is on its own cache line. */
+typedef struct ConnQueue {
+    atomic_uint head __attribute__((aligned(CACHE_LINE)));
+    atomic_uint tail __attribute__((aligned(CACHE_LINE)));
+    int         fds[QUEUE_SIZE] __attribute__((aligned(CACHE_LINE)));
+} ConnQueue;
+
+/* A connection handled by a worker. */
+typedef struct Conn {
+    WOLFSSL* ssl;
+    int      fd;
+    int      state;
+    /* Events currently registered with epoll. */
+    uint32_t events;
+} Conn;
+
+/* Data of each worker thread. */
+typedef struct Worker {
+    pthread_t tid;
+    /* Listening socket in reuseport mode. */
+    int       listenFd;
+    /* Woken when a socket is queued in queue mode. */
+    int       wakeFd;
+    ConnQueue queue;
+    /* Counts only changed by the worker. */
+    long      conns;
+    long      resumed;
+    long      failed;
+    long      active;
+    long      peakActive;
+} Worker;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+static WOLFSSL_CTX*          gCtx;
+static int                   gMode = MODE_REUSEPORT;
+static word16                gPort = DEFAULT_PORT;
+static int                   gNumWorkers = NUM_WORKERS;
+static Worker*               gWorkers;
+static int                   gReadLen = NUM_READ_BYTES;
+static int                   gReplyLen = NUM_WRITE_BYTES;
+static char*                 gReply;
+/* Stop after this many connections - 0 to run until ^C. */
+static long                  gMaxConns;
+/* Connections completed by all threads. */
+static atomic_long           gDone;
+/* Time of first connection. */
+static atomic_int            gStarted;
+static double                gStart;
+/* Counts of thread per connection mode. */
+static atomic_long           gThrConns;
+static atomic_long           gThrResumed;
+static atomic_long           gThrFailed;
+static atomic_long           gThrActive;
+static atomic_long           gThrPeak;
+/* Set on SIGINT or when the number of connections is reached - lock-free so
+ * safe to set in the signal handler and from any thread. */
+static atomic_int            gShutdown;
+
+
+static void SigIntHandler(int sig)
+{
+    (void)sig;
+    atomic_store(&gShutdown, 1);
+}
+
+/* Note a connection finished and stop when enough have been handled. */
+static void ConnDone(void)
+{
+    long done = atomic_fetch_add(&gDone, 1) + 1;
+
+    if (gMaxConns > 0 && done >= gMaxConns)
+        atomic_store(&gShutdown, 1);
+}
+
+/* Record the time of the first connection - the rate is measured from it. */
+static void ConnStarted(void)
+{
+    int expected = 0;
+
+    if (atomic_compare_exchange_strong(&gStarted, &expected, 1))
+        gStart = current_time(1);
+}
+
+/* Value of a field, in kB, from /proc/self/status - 0 when not found. */
+static long ProcStatus(const char* field)
+{
+    FILE* f;
+    char  line[128];
+    long  val = 0;
+    int   len = (int)XSTRLEN(field);
+
+    f = fopen("/proc/self/status", "r");
+    if (f == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (XSTRNCMP(line, field, len) == 0 && line[len] == ':') {
+            val = atol(line + len + 1);
+            break;
+        }
+    }
+    fclose(f);
+    return val;
+}
+
+/* Create a listening socket.
+ *
+ * reusePort  Set SO_REUSEPORT so each worker can listen on the port.
+ * returns the socket on success, SOCKET_INVALID on failure.
+ */
+static int CreateListen(int reusePort)
+{
+    int                sockfd;
+    int                on = 1;
+    struct sockaddr_in servAddr;
+
+    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+        return SOCKET_INVALID;
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (reusePort && setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &on,
+            sizeof(on)) != 0) {
+        close(sockfd);
+        return SOCKET_INVALID;
+    }
+
+    memset(&servAddr, 0, sizeof(servAddr));
+    servAddr.sin_family      = AF_INET;
+    servAddr.sin_port        = htons(gPort);
+    servAddr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(sockfd, (struct sockaddr*)&servAddr, sizeof(servAddr)) == -1 ||
+            listen(sockfd, SOMAXCONN) == -1) {
+        close(sockfd);
+        return SOCKET_INVALID;
+    }
+    return sockfd;
+}
+
+
+/* Add a socket to the ring - called by the main thread only.
+ *
+ * returns 0 on success, -1 when the ring is full.
+ */
+static int ConnQueue_Push(ConnQueue* q, int fd)
+{
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (tail - head == QUEUE_SIZE)
+        return -1;
+    q->fds[tail & (QUEUE_SIZE - 1)] = fd;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/* Take a socket from the ring - called by the owning worker only.
+ *
+ * returns the socket or -1 when the ring is empty.
+ */
+static int ConnQueue_Pop(ConnQueue* q)
+{
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    int          fd;
+
+    if (head == tail)
+        return -1;
+    fd = q->fds[head & (QUEUE_SIZE - 1)];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return fd;
+}
+
+
+/* Close a connection and count it. */
+static void Conn_Free(Worker* w, int efd, Conn* conn, int failed)
+{
+    if (failed) {
+        w->failed++;
+    }
+    else {
+        w->conns++;
+        w->resumed += wolfSSL_session_reused(conn->ssl);
+    }
+    epoll_ctl(efd, EPOLL_CTL_DEL, conn->fd, NULL);
+    wolfSSL_free(conn->ssl);
+    close(conn->fd);
+    free(conn);
+    w->active--;
+    ConnDone();
+}
+
+/* Register interest in reading or writing.
+ *
+ * returns 0 on success, -1 on failure.
+ */
+static int Conn_Want(int efd, Conn* conn, uint32_t events)
+{
+    struct epoll_event ev;
+
+    if (conn->events == events)
+        return 0;
+    XMEMSET(&ev, 0, sizeof(ev));
+    ev.events   = events;
+    ev.data.ptr = conn;
+    conn->events = events;
+    return epoll_ctl(efd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+/* Progress a connection until it would block.
+ *
+ * buff  Scratch buffer of worker to read into.
+ */
+static void Conn_Process(Worker* w, int efd, Conn* conn, char* buff)
+{
+    int ret;
+    int err;
+
+    for (;;) {
+        switch (conn->state) {
+            case CONN_ACCEPT:
+                ret = wolfSSL_accept(conn->ssl);
+                if (ret == WOLFSSL_SUCCESS) {
+                    conn->state = CONN_READ;
+                    continue;
+                }
+                break;
+            case CONN_READ:
+                ret = wolfSSL_read(conn->ssl, buff, gReadLen);
+                if (ret > 0) {
+                    conn->state = CONN_WRITE;
+                    continue;
+                }
+                break;
+            default:
+                /* A retried write must be given the same data. */
+                ret = wolfSSL_write(conn->ssl, gReply, gReplyLen);
+                if (ret > 0) {
+                    conn->state = CONN_READ;
+                    continue;
+                }
+                break;
+        }
+
+        err = wolfSSL_get_error(conn->ssl, ret);
+        if (err == WOLFSSL_ERROR_WANT_READ)
+            ret = Conn_Want(efd, conn, EPOLLIN);
+        else if (err == WOLFSSL_ERROR_WANT_WRITE)
+            ret = Conn_Want(efd, conn, EPOLLOUT);
+        else {
+            /* Client closing after the handshake is a completed connection. */
+            Conn_Free(w, efd, conn, conn->state == CONN_ACCEPT);
+            return;
+        }
+        if (ret != 0)
+            Conn_Free(w, efd, conn, 1);
+        return;
+    }
+}
+
+/* Start handling an accepted socket in a worker. */
+static void Conn_Add(Worker* w, int efd, int fd, char* buff)
+{
+    Conn*              conn;
+    struct epoll_event ev;
+    int                on = 1;
+
+    ConnStarted();
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    conn = (Conn*)malloc(sizeof(*conn));
+    if (conn == NULL) {
+        close(fd);
+        w->failed++;
+        ConnDone();
+        return;
+    }
+    conn->fd     = fd;
+    conn->state  = CONN_ACCEPT;
+    conn->events = EPOLLIN;
+    conn->ssl    = wolfSSL_new(gCtx);
+    if (conn->ssl == NULL) {
+        free(conn);
+        close(fd);
+        w->failed++;
+        ConnDone();
+        return;
+    }
+    wolfSSL_set_fd(conn->ssl, fd);
+
+    XMEMSET(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.ptr = conn;
+    w->active++;
+    if (w->active > w->peakActive)
+        w->peakActive = w->active;
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        /* Not in epoll - Conn_Free's delete fails harmlessly. */
+        Conn_Free(w, efd, conn, 1);
+        return;
+    }
+    /* The ClientHello may already be waiting. */
+    Conn_Process(w, efd, conn, buff);
+}
+
+/* Worker thread: multiplex connections with epoll until shutdown. */
+static void* WorkerMain(void* args)
+{
+    Worker*            w = (Worker*)args;
+    int                efd;
+    int                n;
+    int                i;
+    int                fd;
+    uint64_t           cnt;
+    char*              buff;
+    struct epoll_event ev;
+    struct epoll_event events[EPOLL_NUM_EVENTS];
+
+    buff = (char*)malloc(gReadLen);
+    efd = epoll_create1(0);
+    if (buff == NULL || efd == -1) {
+        fprintf(stderr, "ERROR: failed to start worker\n");
+        free(buff);
+        atomic_store(&gShutdown, 1);
+        return NULL;
+    }
+
+    /* The listening socket or eventfd is the event without a connection. */
+    XMEMSET(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(efd, EPOLL_CTL_ADD,
+        gMode == MODE_REUSEPORT ? w->listenFd : w->wakeFd, &ev);
+
+    while (!atomic_load(&gShutdown)) {
+        n = epoll_wait(efd, events, EPOLL_NUM_EVENTS, POLL_TIMEOUT_MS);
+        for (i = 0; i < n && !atomic_load(&gShutdown); i++) {
+            if (events[i].data.ptr != NULL) {
+                Conn_Process(w, efd, (Conn*)events[i].data.ptr, buff);
+            }
+            else if (gMode == MODE_REUSEPORT) {
+                while ((fd = accept(w->listenFd, NULL, NULL)) != -1)
+                    Conn_Add(w, efd, fd, buff);
+            }
+            else {
+                if (read(w->wakeFd, &cnt, sizeof(cnt)) < 0)
+                    continue;
+                while ((fd = ConnQueue_Pop(&w->queue)) != -1)
+                    Conn_Add(w, efd, fd, buff);
+            }
+        }
+    }
+
+    /* Connections still open at shutdown are not counted and are left for
+     * the process exit to clean up. */
+    while ((fd = ConnQueue_Pop(&w->queue)) != -1)
+        close(fd);
+    close(efd);
+    free(buff);
+#if defined(HAVE_ECC) && defined(FP_ECC)
+    wc_ecc_fp_free();  /* free per thread cache */
+#endif
+    return NULL;
+}
+
+
+/* Whether to retry a call on a connection thread's socket that timed out.
+ * Not retried after shutdown so that a stuck client doesn't stop the exit. */
+static int ConnThread_Retry(WOLFSSL* ssl, int ret)
+{
+    int err = wolfSSL_get_error(ssl, ret);
+
+    return (err == WOLFSSL_ERROR_WANT_READ ||
+            err == WOLFSSL_ERROR_WANT_WRITE) && !atomic_load(&gShutdown);
+}
+
+/* Handle a connection in its own thread - the model being compared. */
+static void* ConnThreadMain(void* args)
+{
+    int            fd = (int)(size_t)args;
+    WOLFSSL*       ssl;
+    char*          buff;
+    int            ret = -1;
+    int            accepted = 0;
+    int            resumed = 0;
+    struct timeval tv;
+
+    /* Blocking calls time out to check for shutdown. */
+    tv.tv_sec  = 0;
+    tv.tv_usec = POLL_TIMEOUT_MS * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    buff = (char*)malloc(gReadLen);
+    ssl = wolfSSL_new(gCtx);
+    if (ssl != NULL && buff != NULL) {
+        wolfSSL_set_fd(ssl, fd);
+        do {
+            ret = wolfSSL_accept(ssl);
+        } while (ret != WOLFSSL_SUCCESS && ConnThread_Retry(ssl, ret));
+        accepted = (ret == WOLFSSL_SUCCESS);
+        if (accepted) {
+            resumed = wolfSSL_session_reused(ssl);
+            for (;;) {
+                do {
+                    ret = wolfSSL_read(ssl, buff, gReadLen);
+                } while (ret <= 0 && ConnThread_Retry(ssl, ret));
+                if (ret <= 0)
+                    break;
+                /* A retried write must be given the same data. */
+                do {
+                    ret = wolfSSL_write(ssl, gReply, gReplyLen);
+                } while (ret <= 0 && ConnThread_Retry(ssl, ret));
+                if (ret <= 0)
+                    break;
+            }
+        }
+    }
+    wolfSSL_free(ssl);
+    free(buff);
+    close(fd);
+
+    if (accepted) {
+        atomic_fetch_add(&gThrConns, 1);
+        atomic_fetch_add(&gThrResumed, resumed);
+    }
+    else {
+        atomic_fetch_add(&gThrFailed, 1);
+    }
+    atomic_fetch_sub(&gThrActive, 1);
+    ConnDone();
+#if defined(HAVE_ECC) && defined(FP_ECC)
+    wc_ecc_fp_free();  /* free per thread cache */
+#endif
+    return NULL;
+}
+
+/* Accept on the main thread and give the socket to a worker or thread. */
+static void AcceptLoop(int sockfd)
+{
+    int           fd;
+    int           i;
+    int           next = 0;
+    long          active;
+    long          peak;
+    uint64_t      one = 1;
+    pthread_t     tid;
+    struct pollfd pfd;
+
+    pfd.fd     = sockfd;
+    pfd.events = POLLIN;
+    while (!atomic_load(&gShutdown)) {
+        /* Wake up to notice shutdown. */
+        if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0)
+            continue;
+        fd = accept(sockfd, NULL, NULL);
+        if (fd == -1)
+            continue;
+
+        if (gMode == MODE_THREAD) {
+            ConnStarted();
+            active = atomic_fetch_add(&gThrActive, 1) + 1;
+            peak = atomic_load(&gThrPeak);
+            while (active > peak &&
+                    !atomic_compare_exchange_weak(&gThrPeak, &peak, active)) {
+            }
+            if (pthread_create(&tid, NULL, ConnThreadMain,
+                    (void*)(size_t)fd) != 0) {
+                close(fd);
+                atomic_fetch_sub(&gThrActive, 1);
+                atomic_fetch_add(&gThrFailed, 1);
+                ConnDone();
+                continue;
+            }
+            pthread_detach(tid);
+            continue;
+        }
+
+        /* Round robin, skipping workers whose queue is full. */
+        for (i = 0; i < gNumWorkers; i++) {
+            if (ConnQueue_Push(&gWorkers[next].queue, fd) == 0)
+                break;
+            next = (next + 1) % gNumWorkers;
+        }
+        if (i == gNumWorkers) {
+            close(fd);
+            continue;
+        }
+        if (write(gWorkers[next].wakeFd, &one, sizeof(one)) < 0)
+            fprintf(stderr, "ERROR: failed to wake worker\n");
+        next = (next + 1) % gNumWorkers;
+    }
+}
+
+
+static void Usage(void)
+{
+    printf("server-tls-pool " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-p <num>    Port to listen on, default %d\n", DEFAULT_PORT);
+    printf("-m <mode>   How connections reach threads, default reuseport\n");
+    printf("            reuseport: each worker accepts with SO_REUSEPORT\n");
+    printf("            queue:     main thread accepts, lock-free queues\n");
+    printf("            thread:    a new thread per connection\n");
+    printf("-t <num>    Number of worker threads, default %d\n", NUM_WORKERS);
+    printf("-n <num>    Exit after <num> connections, default run until ^C\n");
+    printf("-R <num>    Bytes to read from client at a time, default %d\n",
+        NUM_READ_BYTES);
+    printf("-W <num>    Bytes to reply with, default %d\n", NUM_WRITE_BYTES);
+}
+
+int main(int argc, char* argv[])
+{
+    int              ret = 0;
+    int              ch;
+    int              i;
+    int              sockfd = SOCKET_INVALID;
+    int              started = 0;
+    double           elapsed;
+    long             conns = 0;
+    long             resumed = 0;
+    long             failed = 0;
+    long             peak = 0;
+    const char*      modeName = "reuseport";
+    struct sigaction sa;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'p':
+                gPort = (word16)atoi(myoptarg);
+                break;
+            case 'm':
+                modeName = myoptarg;
+                if (XSTRCMP(myoptarg, "reuseport") == 0)
+                    gMode = MODE_REUSEPORT;
+                else if (XSTRCMP(myoptarg, "queue") == 0)
+                    gMode = MODE_QUEUE;
+                else if (XSTRCMP(myoptarg, "thread") == 0)
+                    gMode = MODE_THREAD;
+                else {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 't':
+                gNumWorkers = atoi(myoptarg);
+                if (gNumWorkers < 1 || gNumWorkers > MAX_WORKERS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'n':
+                gMaxConns = atol(myoptarg);
+                break;
+            case 'R':
+                gReadLen = atoi(myoptarg);
+                if (gReadLen <= 0) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'W':
+                gReplyLen = atoi(myoptarg);
+                if (gReplyLen <= 0) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+
+    /* Interrupt waiting so the statistics are printed. */
+    XMEMSET(&sa, 0, sizeof(sa));
+    sa.sa_handler = SigIntHandler;
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Initialize wolfSSL */
+    wolfSSL_Init();
+
+    gReply = (char*)malloc(gReplyLen);
+    /* Aligned so the ends of each worker's queue are on separate lines. */
+    gWorkers = (Worker*)aligned_alloc(CACHE_LINE,
+        gNumWorkers * sizeof(Worker));
+    if (gReply == NULL || gWorkers == NULL) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        ret = -1;
+        goto exit;
+    }
+    XMEMSET(gReply, 'A', gReplyLen);
+    XMEMSET(gWorkers, 0, gNumWorkers * sizeof(Worker));
+    for (i = 0; i < gNumWorkers; i++) {
+        gWorkers[i].listenFd = SOCKET_INVALID;
+        gWorkers[i].wakeFd = -1;
+    }
+
+    gCtx = wolfSSL_CTX_new(wolfSSLv23_server_method());
+    if (gCtx == NULL) {
+        fprintf(stderr, "ERROR: failed to create WOLFSSL_CTX\n");
+        ret = -1;
+        goto exit;
+    }
+    if ((ret = wolfSSL_CTX_use_certificate_file(gCtx, CERT_FILE,
+            WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                CERT_FILE);
+        ret = -1;
+        goto exit;
+    }
+    if ((ret = wolfSSL_CTX_use_PrivateKey_file(gCtx, KEY_FILE,
+            WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                KEY_FILE);
+        ret = -1;
+        goto exit;
+    }
+    ret = 0;
+
+    if (gMode != MODE_REUSEPORT) {
+        if ((sockfd = CreateListen(0)) == SOCKET_INVALID) {
+            fprintf(stderr, "ERROR: failed to listen on port %d\n", gPort);
+            ret = -1;
+            goto exit;
+        }
+    }
+    if (gMode != MODE_THREAD) {
+        for (i = 0; i < gNumWorkers; i++) {
+            if (gMode == MODE_REUSEPORT) {
+                gWorkers[i].listenFd = CreateListen(1);
+                if (gWorkers[i].listenFd != SOCKET_INVALID)
+                    fcntl(gWorkers[i].listenFd, F_SETFL, O_NONBLOCK);
+            }
+            else {
+                gWorkers[i].wakeFd = eventfd(0, 0);
+            }
+            if ((gMode == MODE_REUSEPORT &&
+                    gWorkers[i].listenFd == SOCKET_INVALID) ||
+                (gMode == MODE_QUEUE && gWorkers[i].wakeFd == -1)) {
+                fprintf(stderr, "ERROR: failed to set up worker %d\n", i);
+                ret = -1;
+                goto exit;
+            }
+        }
+        for (started = 0; started < gNumWorkers; started++) {
+            if (pthread_create(&gWorkers[started].tid, NULL, WorkerMain,
+                    &gWorkers[started]) != 0) {
+                fprintf(stderr, "ERROR: failed to create thread\n");
+                atomic_store(&gShutdown, 1);
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    printf("Waiting for connections on port %d (%s mode", gPort, modeName);
+    if (gMode != MODE_THREAD)
+        printf(", %d workers", gNumWorkers);
+    printf(")\n");
+
+    if (gMode == MODE_REUSEPORT) {
+        while (!atomic_load(&gShutdown))
+            usleep(POLL_TIMEOUT_MS * 1000);
+    }
+    else {
+        AcceptLoop(sockfd);
+    }
+
+    for (i = 0; i < started; i++)
+        pthread_join(gWorkers[i].tid, NULL);
+    /* Wait for the connection threads to complete - idle ones give up within
+     * POLL_TIMEOUT_MS of shutdown. */
+    while (atomic_load(&gThrActive) > 0)
+        usleep(1000);
+    elapsed = atomic_load(&gStarted) ? current_time(0) - gStart : 0;
+
+    if (gMode == MODE_THREAD) {
+        conns   = atomic_load(&gThrConns);
+        resumed = atomic_load(&gThrResumed);
+        failed  = atomic_load(&gThrFailed);
+        peak    = atomic_load(&gThrPeak);
+    }
+    else {
+        for (i = 0; i < started; i++) {
+            conns   += gWorkers[i].conns;
+            resumed += gWorkers[i].resumed;
+            failed  += gWorkers[i].failed;
+            /* Sum of each worker's peak - an upper bound. */
+            peak    += gWorkers[i].peakActive;
+        }
+    }
+
+    printf("Connections  : %ld (%ld failed) in %.3f s, %.1f conns/s\n",
+        conns, failed, elapsed, elapsed > 0 ? conns / elapsed : 0.0);
+    printf("Resumed      : %ld (%.1f%%)\n", resumed,
+        conns ? resumed * 100.0 / conns : 0.0);
+    printf("Peak threads : %ld\n",
+        gMode == MODE_THREAD ? peak + 1 : (long)started + 1);
+    printf("Peak conns   : %ld\n", peak);
+    printf("Memory       : %ld kB peak RSS, %ld kB RSS\n",
+        ProcStatus("VmHWM"), ProcStatus("VmRSS"));
+
+exit:
+    if (sockfd != SOCKET_INVALID)
+        close(sockfd);
+    if (gWorkers != NULL) {
+        for (i = 0; i < gNumWorkers; i++) {
+            if (gWorkers[i].listenFd != SOCKET_INVALID)
+                close(gWorkers[i].listenFd);
+            if (gWorkers[i].wakeFd != -1)
+                close(gWorkers[i].wakeFd);
+        }
+        free(gWorkers);
+    }
+    free(gReply);
+    if (gCtx)
+        wolfSSL_CTX_free(gCtx);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
@@ -0,0 +1,358 @@
+/* server-tls-sesscache.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * Thread per connection TLS server, like server-tls-threaded, with the
+ * session cache in sesscache-common.c shared by all threads. Sessions can be
+ * kept in a file so that clients resume after the server restarts.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+/* socket includes */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+/* threads */
+#include <pthread.h>
+
+/* wolfSSL */
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+
+#include "sesscache-common.h"
+
+#define DEFAULT_PORT        11111
+/* Default number of connections handled at the same time. */
+#define MAX_THREADS         64
+/* Default number of sessions in the cache. */
+#define NUM_SESSIONS        20000
+
+#define CERT_FILE "../certs/server-cert.pem"
+#define KEY_FILE  "../certs/server-key.pem"
+
+/* The command line options. */
+#define OPTIONS "?p:t:s:f:n:"
+
+#if defined(HAVE_EXT_CACHE) && !defined(NO_SESSION_CACHE)
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+/* Shared state of the server threads. */
+static WOLFSSL_CTX*    gCtx;
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gCond = PTHREAD_COND_INITIALIZER;
+/* Number of threads handling a connection. */
+static int             gActive;
+/* Connections handled and how many were resumed. */
+static long            gConnections;
+static long            gResumed;
+static long            gFailed;
+/* Set on SIGINT. */
+static volatile sig_atomic_t gShutdown;
+
+
+static void SigIntHandler(int sig)
+{
+    (void)sig;
+    gShutdown = 1;
+}
+
+/* Handle one connection: handshake, read a message and reply. */
+static void* ClientHandler(void* args)
+{
+    int         connd = (int)(size_t)args;
+    WOLFSSL*    ssl;
+    char        buff[16384];
+    int         ret = -1;
+    int         resumed = 0;
+    const char* reply = "I hear ya fa shizzle!\n";
+
+    ssl = wolfSSL_new(gCtx);
+    if (ssl != NULL) {
+        wolfSSL_set_fd(ssl, connd);
+        ret = wolfSSL_accept(ssl);
+        if (ret == WOLFSSL_SUCCESS) {
+            resumed = wolfSSL_session_reused(ssl);
+            ret = wolfSSL_read(ssl, buff, sizeof(buff));
+            if (ret > 0)
+                ret = wolfSSL_write(ssl, reply, (int)XSTRLEN(reply));
+            if (ret > 0)
+                wolfSSL_shutdown(ssl);
+        }
+        else {
+            ret = wolfSSL_get_error(ssl, ret);
+            fprintf(stderr, "wolfSSL_accept error = %d, %s\n", ret,
+                wolfSSL_ERR_reason_error_string(ret));
+            ret = -1;
+        }
+        wolfSSL_free(ssl);
+    }
+    close(connd);
+
+    pthread_mutex_lock(&gLock);
+    if (ret > 0) {
+        gConnections++;
+        gResumed += resumed;
+    }
+    else {
+        gFailed++;
+    }
+    gActive--;
+    pthread_cond_signal(&gCond);
+    pthread_mutex_unlock(&gLock);
+
+#if defined(HAVE_ECC) && defined(FP_ECC)
+    wc_ecc_fp_free();  /* free per thread cache */
+#endif
+    return NULL;
+}
+
+
+static void Usage(void)
+{
+    printf("server-tls-sesscache " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-p <num>    Port to listen on, default %d\n", DEFAULT_PORT);
+    printf("-t <num>    Maximum concurrent connection threads, default %d\n",
+        MAX_THREADS);
+    printf("-s <num>    Number of sessions in the cache, default %d\n",
+        NUM_SESSIONS);
+    printf("-f <file>   Keep sessions in file across restarts\n");
+    printf("-n <num>    Exit after <num> connections, default run until ^C\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int                ret = 0;
+    int                ch;
+    int                sockfd = SOCKET_INVALID;
+    int                connd;
+    int                on = 1;
+    struct sockaddr_in servAddr;
+    struct sockaddr_in clientAddr;
+    socklen_t          size;
+    pthread_t          tid;
+    word16             port = DEFAULT_PORT;
+    int                maxThreads = MAX_THREADS;
+    unsigned int       numSessions = NUM_SESSIONS;
+    const char*        cacheFile = NULL;
+    long               maxConns = 0;
+    long               total;
+    long               conns;
+    long               resumed;
+    long               failed;
+    double             start;
+    SessCacheStats     stats;
+    struct sigaction   sa;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'p':
+                port = (word16)atoi(myoptarg);
+                break;
+            case 't':
+                maxThreads = atoi(myoptarg);
+                break;
+            case 's':
+                numSessions = (unsigned int)atoi(myoptarg);
+                break;
+            case 'f':
+                cacheFile = myoptarg;
+                break;
+            case 'n':
+                maxConns = atol(myoptarg);
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+    if (maxThreads <= 0)
+        maxThreads = 1;
+
+    /* Interrupt accept so the statistics are printed and the file synced. */
+    XMEMSET(&sa, 0, sizeof(sa));
+    sa.sa_handler = SigIntHandler;
+    sigaction(SIGINT, &sa, NULL);
+
+    /* Initialize wolfSSL */
+    wolfSSL_Init();
+
+    if ((ret = SessCache_Init(numSessions, cacheFile)) != 0) {
+        fprintf(stderr, "ERROR: failed to create session cache\n");
+        goto exit;
+    }
+    SessCache_GetStats(&stats);
+    if (cacheFile != NULL)
+        printf("Restored %lu sessions from %s\n", stats.restored, cacheFile);
+
+#ifdef USE_TLSV13
+    gCtx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+#else
+    gCtx = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+#endif
+    if (gCtx == NULL) {
+        fprintf(stderr, "ERROR: failed to create WOLFSSL_CTX\n");
+        ret = -1;
+        goto exit;
+    }
+
+    if ((ret = wolfSSL_CTX_use_certificate_file(gCtx, CERT_FILE,
+            WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                CERT_FILE);
+        ret = -1;
+        goto exit;
+    }
+    if ((ret = wolfSSL_CTX_use_PrivateKey_file(gCtx, KEY_FILE,
+            WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s, please check the file.\n",
+                KEY_FILE);
+        ret = -1;
+        goto exit;
+    }
+
+#if defined(HAVE_SESSION_TICKET) && !defined(USE_TLSV13)
+    /* Resume by session ID so that the cache is used. */
+    wolfSSL_CTX_NoTicketTLSv12(gCtx);
+#endif
+    if ((ret = SessCache_Attach(gCtx)) != 0) {
+        fprintf(stderr, "ERROR: failed to attach session cache\n");
+        goto exit;
+    }
+
+    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+        fprintf(stderr, "ERROR: failed to create the socket\n");
+        ret = -1;
+        goto exit;
+    }
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    memset(&servAddr, 0, sizeof(servAddr));
+    servAddr.sin_family      = AF_INET;
+    servAddr.sin_port        = htons(port);
+    servAddr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(sockfd, (struct sockaddr*)&servAddr, sizeof(servAddr)) == -1) {
+        fprintf(stderr, "ERROR: failed to bind\n");
+        ret = -1;
+        goto exit;
+    }
+    if (listen(sockfd, SOMAXCONN) == -1) {
+        fprintf(stderr, "ERROR: failed to listen\n");
+        ret = -1;
+        goto exit;
+    }
+
+    printf("Waiting for connections on port %d\n", port);
+#ifdef USE_TLSV13
+    printf("TLS 1.3 resumes with tickets, which bypass the session cache\n");
+#endif
+    start = current_time(1);
+    while (!gShutdown) {
+        /* Wait for a thread to become available. */
+        pthread_mutex_lock(&gLock);
+        while (gActive >= maxThreads)
+            pthread_cond_wait(&gCond, &gLock);
+        total = gConnections + gFailed + gActive;
+        pthread_mutex_unlock(&gLock);
+        if (maxConns > 0 && total >= maxConns)
+            break;
+
+        size = sizeof(clientAddr);
+        connd = accept(sockfd, (struct sockaddr*)&clientAddr, &size);
+        if (connd == -1) {
+            if (errno != EINTR)
+                fprintf(stderr, "ERROR: failed to accept\n");
+            continue;
+        }
+
+        pthread_mutex_lock(&gLock);
+        gActive++;
+        pthread_mutex_unlock(&gLock);
+        if (pthread_create(&tid, NULL, ClientHandler,
+                (void*)(size_t)connd) != 0) {
+            fprintf(stderr, "ERROR: failed to create thread\n");
+            close(connd);
+            pthread_mutex_lock(&gLock);
+            gActive--;
+            pthread_mutex_unlock(&gLock);
+            continue;
+        }
+        pthread_detach(tid);
+    }
+
+    /* Wait for all connections to complete. */
+    pthread_mutex_lock(&gLock);
+    while (gActive > 0)
+        pthread_cond_wait(&gCond, &gLock);
+    conns   = gConnections;
+    resumed = gResumed;
+    failed  = gFailed;
+    pthread_mutex_unlock(&gLock);
+    start = current_time(0) - start;
+
+    SessCache_GetStats(&stats);
+    printf("Connections  : %ld (%ld failed) in %.3f s, %.1f conns/s\n",
+        conns, failed, start, conns / start);
+    printf("Resumed      : %ld (%.1f%%)\n", resumed,
+        conns ? resumed * 100.0 / conns : 0.0);
+    printf("Cache        : %lu stores, %lu hits, %lu misses, %lu removes, "
+           "%lu evictions, %lu too big\n", stats.stores, stats.hits,
+           stats.misses, stats.removes, stats.evictions, stats.tooBig);
+
+    ret = 0;
+
+exit:
+    if (sockfd != SOCKET_INVALID)
+        close(sockfd);
+    if (gCtx)
+        wolfSSL_CTX_free(gCtx);
+    SessCache_Cleanup();
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with --enable-opensslextra "
+           "for the external session cache\n");
+    return 0;
+}
+
+#endif /* HAVE_EXT_CACHE && !NO_SESSION_CACHE */
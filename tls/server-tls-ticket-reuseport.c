@@ -0,0 +1,383 @@
+/* server-tls-ticket-reuseport.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *=============================================================================
+ *
+ * Multi-process TLS server. Worker processes each listen on the same port
+ * with SO_REUSEPORT and the kernel spreads the connections between them. The
+ * session ticket keys are shared through ticketkeys-common.c so a ticket
+ * issued by one process is accepted by all. The parent process rotates the
+ * keys and, on ^C, prints the connection and resumption counts of all workers.
+ *
+ * Use -k to give each worker its own ticket key instead. Clients then only
+ * resume when they reach the worker that issued their ticket.
+ */
+
+/* the usual suspects */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+/* socket includes */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+/* processes */
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* wolfSSL */
+#include <wolfssl/options.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/test.h>
+
+#include "ticketkeys-common.h"
+
+#define DEFAULT_PORT        11111
+/* Default number of worker processes. */
+#define NUM_WORKERS         4
+/* Maximum number of worker processes. */
+#define MAX_WORKERS         128
+/* Default number of seconds between ticket key rotations. */
+#define ROTATE_SECS         60
+/* Name of the shared memory segment holding the ticket keys. */
+#define TICKET_KEYS_SHM     "/wolfssl-ticket-keys"
+
+#define CERT_FILE "../certs/server-cert.pem"
+#define KEY_FILE  "../certs/server-key.pem"
+
+/* The command line options. */
+#define OPTIONS "?p:w:r:k"
+
+#if defined(HAVE_SESSION_TICKET) && defined(HAVE_CHACHA) && \
+    defined(HAVE_POLY1305) && defined(SO_REUSEPORT)
+
+/* Counts of a worker - in memory shared with the parent. */
+typedef struct WorkerStats {
+    long conns;
+    long resumed;
+    long failed;
+} WorkerStats;
+
+
+/* The index of the command line option. */
+int   myoptind = 0;
+/* The current command line option. */
+char* myoptarg = NULL;
+
+/* One entry per worker, mapped before forking. */
+static WorkerStats*          gStats;
+/* Set on SIGINT in the parent and SIGTERM in the workers. */
+static volatile sig_atomic_t gShutdown;
+
+
+static void SigHandler(int sig)
+{
+    (void)sig;
+    gShutdown = 1;
+}
+
+/* Install handler without SA_RESTART so blocking calls are interrupted. */
+static void SetSignal(int sig)
+{
+    struct sigaction sa;
+
+    XMEMSET(&sa, 0, sizeof(sa));
+    sa.sa_handler = SigHandler;
+    sigaction(sig, &sa, NULL);
+}
+
+/* Create a socket listening on the port shared with the other workers.
+ *
+ * returns the socket on success, SOCKET_INVALID on failure.
+ */
+static int Listen(word16 port)
+{
+    int                sockfd;
+    int                on = 1;
+    struct sockaddr_in servAddr;
+
+    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+        return SOCKET_INVALID;
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+        close(sockfd);
+        return SOCKET_INVALID;
+    }
+
+    memset(&servAddr, 0, sizeof(servAddr));
+    servAddr.sin_family      = AF_INET;
+    servAddr.sin_port        = htons(port);
+    servAddr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(sockfd, (struct sockaddr*)&servAddr, sizeof(servAddr)) == -1 ||
+            listen(sockfd, SOMAXCONN) == -1) {
+        close(sockfd);
+        return SOCKET_INVALID;
+    }
+    return sockfd;
+}
+
+/* Handle one connection: handshake, read a message and reply. */
+static void HandleConnection(WOLFSSL_CTX* ctx, int connd, WorkerStats* stats)
+{
+    WOLFSSL*    ssl;
+    char        buff[16384];
+    int         ret = -1;
+    int         resumed = 0;
+    const char* reply = "I hear ya fa shizzle!\n";
+
+    ssl = wolfSSL_new(ctx);
+    if (ssl != NULL) {
+        wolfSSL_set_fd(ssl, connd);
+        ret = wolfSSL_accept(ssl);
+        if (ret == WOLFSSL_SUCCESS) {
+            resumed = wolfSSL_session_reused(ssl);
+            ret = wolfSSL_read(ssl, buff, sizeof(buff));
+            if (ret > 0)
+                ret = wolfSSL_write(ssl, reply, (int)XSTRLEN(reply));
+            if (ret > 0)
+                wolfSSL_shutdown(ssl);
+        }
+        else {
+            ret = -1;
+        }
+        wolfSSL_free(ssl);
+    }
+    close(connd);
+
+    if (ret > 0) {
+        stats->conns++;
+        stats->resumed += resumed;
+    }
+    else {
+        stats->failed++;
+    }
+}
+
+/* Worker process: accept and handle connections until SIGTERM.
+ *
+ * returns the exit code of the process.
+ */
+static int Worker(word16 port, int shared, WorkerStats* stats)
+{
+    int                ret = 1;
+    int                sockfd;
+    int                connd;
+    struct sockaddr_in clientAddr;
+    socklen_t          size;
+    WOLFSSL_CTX*       ctx;
+
+    SetSignal(SIGTERM);
+    signal(SIGINT, SIG_IGN);
+
+    ctx = wolfSSL_CTX_new(wolfSSLv23_server_method());
+    if (ctx == NULL)
+        return 1;
+    if (wolfSSL_CTX_use_certificate_file(ctx, CERT_FILE,
+            WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_file(ctx, KEY_FILE,
+            WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "ERROR: failed to load %s or %s\n", CERT_FILE,
+            KEY_FILE);
+        goto exit;
+    }
+    /* Without a callback each context makes its own ticket key. */
+    if (shared && TicketKeys_Attach(ctx) != 0) {
+        fprintf(stderr, "ERROR: failed to use shared ticket keys\n");
+        goto exit;
+    }
+#ifndef NO_SESSION_CACHE
+    /* Only tickets carry sessions between workers - don't hide that. */
+    wolfSSL_CTX_set_session_cache_mode(ctx, WOLFSSL_SESS_CACHE_OFF);
+#endif
+
+    if ((sockfd = Listen(port)) == SOCKET_INVALID) {
+        fprintf(stderr, "ERROR: failed to listen on port %d\n", port);
+        goto exit;
+    }
+
+    while (!gShutdown) {
+        size = sizeof(clientAddr);
+        connd = accept(sockfd, (struct sockaddr*)&clientAddr, &size);
+        if (connd == -1) {
+            if (errno != EINTR)
+                fprintf(stderr, "ERROR: failed to accept\n");
+            continue;
+        }
+        HandleConnection(ctx, connd, stats);
+    }
+    close(sockfd);
+    ret = 0;
+
+exit:
+    wolfSSL_CTX_free(ctx);
+    TicketKeys_Close();
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+
+static void Usage(void)
+{
+    printf("server-tls-ticket-reuseport " LIBWOLFSSL_VERSION_STRING "\n");
+    printf("-?          Help, print this usage\n");
+    printf("-p <num>    Port to listen on, default %d\n", DEFAULT_PORT);
+    printf("-w <num>    Number of worker processes, default %d\n",
+        NUM_WORKERS);
+    printf("-r <num>    Seconds between ticket key rotations, default %d\n",
+        ROTATE_SECS);
+    printf("-k          Each worker uses its own ticket key\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int          ret = 0;
+    int          ch;
+    int          i;
+    word16       port = DEFAULT_PORT;
+    int          numWorkers = NUM_WORKERS;
+    unsigned int rotateSecs = ROTATE_SECS;
+    int          shared = 1;
+    pid_t        pids[MAX_WORKERS];
+    int          numPids = 0;
+    double       start;
+    WorkerStats  total;
+
+    while ((ch = mygetopt(argc, argv, OPTIONS)) != -1) {
+        switch (ch) {
+            case '?':
+                Usage();
+                return 0;
+            case 'p':
+                port = (word16)atoi(myoptarg);
+                break;
+            case 'w':
+                numWorkers = atoi(myoptarg);
+                if (numWorkers < 1 || numWorkers > MAX_WORKERS) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'r':
+                rotateSecs = (unsigned int)atoi(myoptarg);
+                if (rotateSecs == 0) {
+                    Usage();
+                    return 1;
+                }
+                break;
+            case 'k':
+                shared = 0;
+                break;
+            default:
+                Usage();
+                return 1;
+        }
+    }
+
+    SetSignal(SIGINT);
+
+    /* Initialize wolfSSL */
+    wolfSSL_Init();
+
+    gStats = (WorkerStats*)mmap(NULL, sizeof(WorkerStats) * numWorkers,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (gStats == MAP_FAILED) {
+        gStats = NULL;
+        fprintf(stderr, "ERROR: failed to map statistics\n");
+        ret = -1;
+        goto exit;
+    }
+    XMEMSET(gStats, 0, sizeof(WorkerStats) * numWorkers);
+
+    if (shared && TicketKeys_Create(TICKET_KEYS_SHM, rotateSecs) != 0) {
+        fprintf(stderr, "ERROR: failed to create ticket keys\n");
+        ret = -1;
+        goto exit;
+    }
+
+    start = current_time(1);
+    for (i = 0; i < numWorkers; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            /* Mapped memory and the ticket keys are inherited. */
+            exit(Worker(port, shared, &gStats[i]));
+        }
+        if (pids[i] < 0) {
+            fprintf(stderr, "ERROR: failed to fork worker\n");
+            break;
+        }
+        numPids++;
+    }
+    printf("Waiting for connections on port %d with %d workers (%s keys)\n",
+        port, numPids, shared ? "shared" : "per process");
+
+    /* Rotate keys until ^C - sleep returns early when interrupted. */
+    while (!gShutdown) {
+        if (sleep(rotateSecs) == 0 && shared &&
+                TicketKeys_Rotate() != 0) {
+            fprintf(stderr, "ERROR: failed to rotate ticket keys\n");
+        }
+    }
+
+    for (i = 0; i < numPids; i++)
+        kill(pids[i], SIGTERM);
+    for (i = 0; i < numPids; i++)
+        waitpid(pids[i], NULL, 0);
+    start = current_time(0) - start;
+
+    XMEMSET(&total, 0, sizeof(total));
+    for (i = 0; i < numPids; i++) {
+        printf("Worker %3d   : %ld conns, %ld resumed, %ld failed\n", i,
+            gStats[i].conns, gStats[i].resumed, gStats[i].failed);
+        total.conns   += gStats[i].conns;
+        total.resumed += gStats[i].resumed;
+        total.failed  += gStats[i].failed;
+    }
+    printf("Connections  : %ld (%ld failed) in %.3f s, %.1f conns/s\n",
+        total.conns, total.failed, start, total.conns / start);
+    printf("Resumed      : %ld (%.1f%%)\n", total.resumed,
+        total.conns ? total.resumed * 100.0 / total.conns : 0.0);
+    if (shared)
+        printf("Rotations    : %u\n", TicketKeys_Rotations());
+
+exit:
+    TicketKeys_Close();
+    if (gStats != NULL)
+        munmap(gStats, sizeof(WorkerStats) * numWorkers);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+
+#else
+
+int main(void)
+{
+    printf("Not compiled in: Configure wolfSSL with --enable-session-ticket "
+           "and ChaCha20-Poly1305 on a system with SO_REUSEPORT\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,399 @@
+/* sesscache-common.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* External session cache shared by all threads of a server.
+ *
+ * Sessions are serialized with wolfSSL_i2d_SSL_SESSION into fixed size slots.
+ * The session ID selects a shard, each with its own lock, and a bucket of
+ * SESS_CACHE_WAYS slots within the shard. When a bucket is full the session
+ * closest to expiry is replaced.
+ * The slots can be mapped from a file so that sessions survive a restart.
+ * The file holds session secrets - it is created readable by the owner only.
+ */
+
+#include "sesscache-common.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(HAVE_EXT_CACHE) && !defined(NO_SESSION_CACHE)
+
+/* Identifies a cache file and its layout version. */
+#define SESS_CACHE_MAGIC    0x57534331
+/* Maximum length of a session ID. */
+#define SESS_CACHE_ID_SZ    32
+
+/* Header at the start of the mapping. Must match for the file to be used. */
+typedef struct SessCacheHdr {
+    word32 magic;
+    word32 shards;
+    word32 buckets;
+    word32 ways;
+    word32 slotSz;
+} SessCacheHdr;
+
+/* A serialized session. */
+typedef struct SessCacheSlot {
+    /* Time when session expires - 0 when slot is empty. */
+    word32 expire;
+    /* Length of serialized session. */
+    word32 dataSz;
+    /* Length of session ID. */
+    word32 idSz;
+    byte   id[SESS_CACHE_ID_SZ];
+    byte   data[SESS_CACHE_DATA_SZ];
+} SessCacheSlot;
+
+/* A shard of the cache - lock and statistics for its slots. */
+typedef struct SessCacheShard {
+    pthread_mutex_t lock;
+    SessCacheStats  stats;
+} SessCacheShard;
+
+/* The cache. */
+static struct {
+    SessCacheHdr*  hdr;
+    SessCacheSlot* slots;
+    size_t         mapSz;
+    int            fd;
+    word32         buckets;
+    SessCacheShard shard[SESS_CACHE_SHARDS];
+} gCache;
+
+
+/* Hash a session ID to pick shard and bucket. FNV-1a. */
+static word32 SessCache_Hash(const byte* id, word32 idSz)
+{
+    word32 h = 2166136261U;
+    word32 i;
+
+    for (i = 0; i < idSz; i++) {
+        h ^= id[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/* Get the shard and first slot of the bucket for a session ID.
+ *
+ * id      Session ID.
+ * idSz    Length of session ID.
+ * bucket  First slot of bucket.
+ * returns the shard.
+ */
+static SessCacheShard* SessCache_Bucket(const byte* id, word32 idSz,
+    SessCacheSlot** bucket)
+{
+    word32 h = SessCache_Hash(id, idSz);
+    word32 s = h % SESS_CACHE_SHARDS;
+    word32 b = (h / SESS_CACHE_SHARDS) % gCache.buckets;
+
+    *bucket = &gCache.slots[(s * gCache.buckets + b) * SESS_CACHE_WAYS];
+    return &gCache.shard[s];
+}
+
+/* Find the slot of a session ID in a bucket - shard must be locked.
+ *
+ * returns slot or NULL when not found.
+ */
+static SessCacheSlot* SessCache_Find(SessCacheSlot* bucket, const byte* id,
+    word32 idSz)
+{
+    int i;
+
+    for (i = 0; i < SESS_CACHE_WAYS; i++) {
+        if (bucket[i].expire != 0 && bucket[i].idSz == idSz &&
+                XMEMCMP(bucket[i].id, id, idSz) == 0)
+            return &bucket[i];
+    }
+    return NULL;
+}
+
+
+/* Callback from wolfSSL when a new session is established.
+ *
+ * returns 0 as no reference to the session is kept.
+ */
+static int SessCache_NewCb(WOLFSSL* ssl, WOLFSSL_SESSION* session)
+{
+    const byte*     id;
+    unsigned int    idSz = 0;
+    int             dataSz;
+    byte            data[SESS_CACHE_DATA_SZ];
+    byte*           p = data;
+    word32          now = (word32)time(NULL);
+    SessCacheShard* shard;
+    SessCacheSlot*  bucket;
+    SessCacheSlot*  slot;
+    int             i;
+
+    (void)ssl;
+
+    id = wolfSSL_SESSION_get_id(session, &idSz);
+    if (id == NULL || idSz == 0 || idSz > SESS_CACHE_ID_SZ)
+        return 0;
+    shard = SessCache_Bucket(id, idSz, &bucket);
+
+    /* Serialize outside the lock. */
+    dataSz = wolfSSL_i2d_SSL_SESSION(session, NULL);
+    if (dataSz <= 0 || dataSz > SESS_CACHE_DATA_SZ) {
+        pthread_mutex_lock(&shard->lock);
+        shard->stats.tooBig++;
+        pthread_mutex_unlock(&shard->lock);
+        return 0;
+    }
+    if (wolfSSL_i2d_SSL_SESSION(session, &p) != dataSz)
+        return 0;
+
+    pthread_mutex_lock(&shard->lock);
+    slot = SessCache_Find(bucket, id, idSz);
+    if (slot == NULL) {
+        /* Empty or expired slot, otherwise the one that expires first. */
+        slot = &bucket[0];
+        for (i = 0; i < SESS_CACHE_WAYS; i++) {
+            if (bucket[i].expire <= now) {
+                slot = &bucket[i];
+                break;
+            }
+            if (bucket[i].expire < slot->expire)
+                slot = &bucket[i];
+        }
+        if (slot->expire > now)
+            shard->stats.evictions++;
+    }
+    /* Mark empty while writing so a torn write in the file is ignored. */
+    slot->expire = 0;
+    slot->idSz = idSz;
+    XMEMCPY(slot->id, id, idSz);
+    XMEMCPY(slot->data, data, dataSz);
+    slot->dataSz = dataSz;
+    slot->expire = (word32)wolfSSL_SESSION_get_time(session) +
+                   (word32)wolfSSL_SESSION_get_timeout(session);
+    shard->stats.stores++;
+    pthread_mutex_unlock(&shard->lock);
+
+    return 0;
+}
+
+/* Callback from wolfSSL to find a session to resume.
+ *
+ * returns a new session object, owned by wolfSSL, or NULL when not found.
+ */
+static WOLFSSL_SESSION* SessCache_GetCb(WOLFSSL* ssl, const byte* id, int idSz,
+    int* copy)
+{
+    byte            data[SESS_CACHE_DATA_SZ];
+    const byte*     p = data;
+    int             dataSz = 0;
+    word32          now = (word32)time(NULL);
+    SessCacheShard* shard;
+    SessCacheSlot*  bucket;
+    SessCacheSlot*  slot;
+
+    (void)ssl;
+
+    /* wolfSSL frees the session returned when copy is 0. */
+    *copy = 0;
+    if (idSz <= 0 || idSz > SESS_CACHE_ID_SZ)
+        return NULL;
+    shard = SessCache_Bucket(id, idSz, &bucket);
+
+    pthread_mutex_lock(&shard->lock);
+    slot = SessCache_Find(bucket, id, idSz);
+    if (slot != NULL && slot->expire > now) {
+        dataSz = slot->dataSz;
+        XMEMCPY(data, slot->data, dataSz);
+        shard->stats.hits++;
+    }
+    else {
+        shard->stats.misses++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    /* Deserialize outside the lock. */
+    if (dataSz == 0)
+        return NULL;
+    return wolfSSL_d2i_SSL_SESSION(NULL, &p, dataSz);
+}
+
+/* Callback from wolfSSL when a session is no longer to be resumed. */
+static void SessCache_RemoveCb(WOLFSSL_CTX* ctx, WOLFSSL_SESSION* session)
+{
+    const byte*     id;
+    unsigned int    idSz = 0;
+    SessCacheShard* shard;
+    SessCacheSlot*  bucket;
+    SessCacheSlot*  slot;
+
+    (void)ctx;
+
+    id = wolfSSL_SESSION_get_id(session, &idSz);
+    if (id == NULL || idSz == 0 || idSz > SESS_CACHE_ID_SZ)
+        return;
+    shard = SessCache_Bucket(id, idSz, &bucket);
+
+    pthread_mutex_lock(&shard->lock);
+    slot = SessCache_Find(bucket, id, idSz);
+    if (slot != NULL) {
+        slot->expire = 0;
+        shard->stats.removes++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+
+int SessCache_Init(unsigned int numSessions, const char* file)
+{
+    struct stat  st;
+    SessCacheHdr hdr;
+    word32       i;
+    word32       total;
+    word32       now = (word32)time(NULL);
+    void*        map;
+
+    if (numSessions == 0)
+        return BAD_FUNC_ARG;
+
+    hdr.magic   = SESS_CACHE_MAGIC;
+    hdr.shards  = SESS_CACHE_SHARDS;
+    hdr.ways    = SESS_CACHE_WAYS;
+    hdr.buckets = (numSessions + SESS_CACHE_SHARDS * SESS_CACHE_WAYS - 1) /
+                  (SESS_CACHE_SHARDS * SESS_CACHE_WAYS);
+    hdr.slotSz  = sizeof(SessCacheSlot);
+    total = hdr.shards * hdr.buckets * hdr.ways;
+
+    gCache.buckets = hdr.buckets;
+    gCache.mapSz = sizeof(SessCacheHdr) + (size_t)total * sizeof(SessCacheSlot);
+    gCache.fd = -1;
+
+    if (file != NULL) {
+        gCache.fd = open(file, O_RDWR | O_CREAT, 0600);
+        if (gCache.fd < 0) {
+            fprintf(stderr, "ERROR: failed to open session cache file %s\n",
+                file);
+            return -1;
+        }
+        /* Start again if the layout doesn't match. */
+        if (fstat(gCache.fd, &st) != 0 || (size_t)st.st_size != gCache.mapSz) {
+            if (ftruncate(gCache.fd, 0) != 0 ||
+                    ftruncate(gCache.fd, gCache.mapSz) != 0) {
+                close(gCache.fd);
+                gCache.fd = -1;
+                return -1;
+            }
+        }
+        map = mmap(NULL, gCache.mapSz, PROT_READ | PROT_WRITE, MAP_SHARED,
+            gCache.fd, 0);
+    }
+    else {
+        map = mmap(NULL, gCache.mapSz, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (map == MAP_FAILED) {
+        if (gCache.fd >= 0)
+            close(gCache.fd);
+        gCache.fd = -1;
+        return MEMORY_E;
+    }
+    gCache.hdr = (SessCacheHdr*)map;
+    gCache.slots = (SessCacheSlot*)((byte*)map + sizeof(SessCacheHdr));
+
+    XMEMSET(gCache.shard, 0, sizeof(gCache.shard));
+    if (XMEMCMP(gCache.hdr, &hdr, sizeof(hdr)) != 0) {
+        XMEMSET(map, 0, gCache.mapSz);
+        XMEMCPY(gCache.hdr, &hdr, sizeof(hdr));
+    }
+    else {
+        for (i = 0; i < total; i++) {
+            if (gCache.slots[i].expire > now)
+                gCache.shard[0].stats.restored++;
+            else
+                gCache.slots[i].expire = 0;
+        }
+    }
+
+    for (i = 0; i < SESS_CACHE_SHARDS; i++)
+        pthread_mutex_init(&gCache.shard[i].lock, NULL);
+
+    return 0;
+}
+
+int SessCache_Attach(WOLFSSL_CTX* ctx)
+{
+    if (ctx == NULL || gCache.slots == NULL)
+        return BAD_FUNC_ARG;
+
+    wolfSSL_CTX_sess_set_new_cb(ctx, SessCache_NewCb);
+    wolfSSL_CTX_sess_set_get_cb(ctx, SessCache_GetCb);
+    wolfSSL_CTX_sess_set_remove_cb(ctx, SessCache_RemoveCb);
+    /* All sessions stored and looked up in this cache only. */
+    wolfSSL_CTX_set_session_cache_mode(ctx, WOLFSSL_SESS_CACHE_NO_INTERNAL);
+
+    return 0;
+}
+
+void SessCache_GetStats(SessCacheStats* stats)
+{
+    int i;
+
+    XMEMSET(stats, 0, sizeof(*stats));
+    for (i = 0; i < SESS_CACHE_SHARDS; i++) {
+        SessCacheShard* shard = &gCache.shard[i];
+
+        pthread_mutex_lock(&shard->lock);
+        stats->stores    += shard->stats.stores;
+        stats->hits      += shard->stats.hits;
+        stats->misses    += shard->stats.misses;
+        stats->removes   += shard->stats.removes;
+        stats->evictions += shard->stats.evictions;
+        stats->tooBig    += shard->stats.tooBig;
+        stats->restored  += shard->stats.restored;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+void SessCache_Cleanup(void)
+{
+    int i;
+
+    if (gCache.hdr == NULL)
+        return;
+
+    if (gCache.fd >= 0) {
+        msync(gCache.hdr, gCache.mapSz, MS_SYNC);
+        close(gCache.fd);
+        gCache.fd = -1;
+    }
+    munmap(gCache.hdr, gCache.mapSz);
+    gCache.hdr = NULL;
+    gCache.slots = NULL;
+
+    for (i = 0; i < SESS_CACHE_SHARDS; i++)
+        pthread_mutex_destroy(&gCache.shard[i].lock);
+}
+
+#endif /* HAVE_EXT_CACHE && !NO_SESSION_CACHE */
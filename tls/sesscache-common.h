@@ -0,0 +1,70 @@
+/* sesscache-common.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef _SESSCACHE_COMMON_H_
+#define _SESSCACHE_COMMON_H_
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+
+#if defined(HAVE_EXT_CACHE) && !defined(NO_SESSION_CACHE)
+
+/* Number of independently locked shards of the cache. */
+#ifndef SESS_CACHE_SHARDS
+    #define SESS_CACHE_SHARDS   64
+#endif
+/* Number of slots a session ID can be stored in within a shard. */
+#ifndef SESS_CACHE_WAYS
+    #define SESS_CACHE_WAYS     4
+#endif
+/* Maximum size of a serialized session. Larger sessions are not cached. */
+#ifndef SESS_CACHE_DATA_SZ
+    #define SESS_CACHE_DATA_SZ  2048
+#endif
+
+/* Counts of cache operations. */
+typedef struct SessCacheStats {
+    unsigned long stores;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long removes;
+    unsigned long evictions;
+    /* Sessions not stored as serialization too big for slot. */
+    unsigned long tooBig;
+    /* Sessions found in the file when the cache was initialized. */
+    unsigned long restored;
+} SessCacheStats;
+
+/* Create the cache. When file is not NULL, the slots are mapped from the file
+ * and sessions stored by a previous run are used. */
+int  SessCache_Init(unsigned int numSessions, const char* file);
+/* Use the cache for sessions of the context instead of the internal one. */
+int  SessCache_Attach(WOLFSSL_CTX* ctx);
+void SessCache_GetStats(SessCacheStats* stats);
+/* Write sessions back to the file, if any, and dispose of the cache. */
+void SessCache_Cleanup(void);
+
+#endif /* HAVE_EXT_CACHE && !NO_SESSION_CACHE */
+
+#endif /* !_SESSCACHE_COMMON_H_ */
@@ -0,0 +1,307 @@
+/* shmring.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "shmring.h"
+
+/* Identifies memory holding a connection. */
+#define SHMRING_MAGIC   0x534d5247
+/* Times to check a ring before sleeping. */
+#define SHMRING_SPIN    200
+#define CACHE_LINE      64
+
+/* One direction of a connection.
+ *
+ * head and tail are free running counts of bytes written and read. Each is
+ * only changed by one party and has its own cache line. A party about to
+ * sleep sets its waiting flag and sleeps on its wake count, which the other
+ * party increments when it sees the flag set.
+ */
+typedef struct ShmRing {
+    /* Producer. */
+    unsigned int head __attribute__((aligned(CACHE_LINE)));
+    unsigned int writerWaiting;
+    unsigned int writerWake;
+    /* Consumer. */
+    unsigned int tail __attribute__((aligned(CACHE_LINE)));
+    unsigned int readerWaiting;
+    unsigned int readerWake;
+    /* Fixed at creation, except closed. */
+    unsigned int closed __attribute__((aligned(CACHE_LINE)));
+    unsigned int size;
+    /* Offset of data from the ring, the same in every process. */
+    size_t       dataOff;
+} ShmRing;
+
+struct ShmConn {
+    unsigned int magic;
+    unsigned int ringSz;
+    size_t       mapSz;
+    /* Client to server, then server to client. */
+    ShmRing      ring[2];
+};
+
+
+static long Futex(unsigned int* addr, int op, unsigned int val)
+{
+    /* Not private: the memory may be shared between processes. */
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static unsigned char* RingData(ShmRing* ring)
+{
+    return (unsigned char*)ring + ring->dataOff;
+}
+
+/* Sleep until woken, unless *word is no longer val or the ring is closed. */
+static void RingSleep(ShmRing* ring, unsigned int* waiting,
+    unsigned int* wake, unsigned int* word, unsigned int val)
+{
+    unsigned int seq = __atomic_load_n(wake, __ATOMIC_SEQ_CST);
+
+    __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(word, __ATOMIC_SEQ_CST) == val &&
+            !__atomic_load_n(&ring->closed, __ATOMIC_SEQ_CST)) {
+        /* Returns at once if woken since seq was read. */
+        Futex(wake, FUTEX_WAIT, seq);
+    }
+    __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+static void RingWake(unsigned int* waiting, unsigned int* wake)
+{
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        __atomic_add_fetch(wake, 1, __ATOMIC_SEQ_CST);
+        Futex(wake, FUTEX_WAKE, 1);
+    }
+}
+
+/* wolfSSL receive callback: read from the ring, waiting for data. */
+static int ShmRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    ShmRing*       ring = (ShmRing*)ctx;
+    unsigned int   tail = ring->tail;
+    unsigned int   mask = ring->size - 1;
+    unsigned int   head;
+    unsigned int   n;
+    unsigned int   first;
+    unsigned char* data = RingData(ring);
+    int            spin = 0;
+
+    (void)ssl;
+
+    for (;;) {
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head != tail)
+            break;
+        /* Data written before closing is read first. */
+        if (__atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE))
+            return WOLFSSL_CBIO_ERR_CONN_CLOSE;
+        if (++spin < SHMRING_SPIN)
+            continue;
+        RingSleep(ring, &ring->readerWaiting, &ring->readerWake, &ring->head,
+            tail);
+    }
+
+    n = head - tail;
+    if (n > (unsigned int)sz)
+        n = (unsigned int)sz;
+    first = ring->size - (tail & mask);
+    if (first > n)
+        first = n;
+    memcpy(buf, data + (tail & mask), first);
+    memcpy(buf + first, data, n - first);
+
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_SEQ_CST);
+    RingWake(&ring->writerWaiting, &ring->writerWake);
+
+    return (int)n;
+}
+
+/* wolfSSL send callback: write to the ring, waiting for space. */
+static int ShmSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    ShmRing*       ring = (ShmRing*)ctx;
+    unsigned int   head = ring->head;
+    unsigned int   mask = ring->size - 1;
+    unsigned int   tail;
+    unsigned int   n;
+    unsigned int   first;
+    unsigned char* data = RingData(ring);
+    int            spin = 0;
+
+    (void)ssl;
+
+    for (;;) {
+        if (__atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE))
+            return WOLFSSL_CBIO_ERR_CONN_CLOSE;
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (head - tail < ring->size)
+            break;
+        if (++spin < SHMRING_SPIN)
+            continue;
+        RingSleep(ring, &ring->writerWaiting, &ring->writerWake, &ring->tail,
+            tail);
+    }
+
+    n = ring->size - (head - tail);
+    if (n > (unsigned int)sz)
+        n = (unsigned int)sz;
+    first = ring->size - (head & mask);
+    if (first > n)
+        first = n;
+    memcpy(data + (head & mask), buf, first);
+    memcpy(data, buf + first, n - first);
+
+    __atomic_store_n(&ring->head, head + n, __ATOMIC_SEQ_CST);
+    RingWake(&ring->readerWaiting, &ring->readerWake);
+
+    return (int)n;
+}
+
+static ShmConn* ConnInit(void* mem, size_t mapSz, unsigned int ringSz)
+{
+    ShmConn* conn = (ShmConn*)mem;
+    int      i;
+
+    memset(conn, 0, sizeof(*conn));
+    conn->ringSz = ringSz;
+    conn->mapSz = mapSz;
+    for (i = 0; i < 2; i++) {
+        conn->ring[i].size = ringSz;
+        conn->ring[i].dataOff = sizeof(ShmConn) + (size_t)i * ringSz -
+            ((unsigned char*)&conn->ring[i] - (unsigned char*)conn);
+    }
+    __atomic_store_n(&conn->magic, SHMRING_MAGIC, __ATOMIC_RELEASE);
+
+    return conn;
+}
+
+ShmConn* ShmConn_Create(const char* name, unsigned int ringSz)
+{
+    size_t mapSz;
+    void*  mem;
+    int    fd = -1;
+
+    /* A power of 2 so that the counts wrap at a multiple of the size. */
+    if (ringSz < 1024 || (ringSz & (ringSz - 1)) != 0)
+        return NULL;
+    mapSz = sizeof(ShmConn) + 2 * (size_t)ringSz;
+
+    if (name == NULL) {
+        mem = mmap(NULL, mapSz, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    else {
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            return NULL;
+        if (ftruncate(fd, (off_t)mapSz) != 0) {
+            close(fd);
+            shm_unlink(name);
+            return NULL;
+        }
+        mem = mmap(NULL, mapSz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (mem == MAP_FAILED) {
+        if (name != NULL)
+            shm_unlink(name);
+        return NULL;
+    }
+
+    return ConnInit(mem, mapSz, ringSz);
+}
+
+ShmConn* ShmConn_Open(const char* name)
+{
+    struct stat st;
+    ShmConn*    conn;
+    void*       mem;
+    int         fd;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmConn)) {
+        close(fd);
+        return NULL;
+    }
+    mem = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return NULL;
+
+    conn = (ShmConn*)mem;
+    if (__atomic_load_n(&conn->magic, __ATOMIC_ACQUIRE) != SHMRING_MAGIC ||
+            conn->mapSz != (size_t)st.st_size) {
+        munmap(mem, (size_t)st.st_size);
+        return NULL;
+    }
+
+    return conn;
+}
+
+int ShmConn_SetIO(WOLFSSL* ssl, ShmConn* conn, int isServer)
+{
+    if (ssl == NULL || conn == NULL)
+        return BAD_FUNC_ARG;
+
+    wolfSSL_SSLSetIORecv(ssl, ShmRecv);
+    wolfSSL_SSLSetIOSend(ssl, ShmSend);
+    wolfSSL_SetIOReadCtx(ssl, &conn->ring[isServer ? 0 : 1]);
+    wolfSSL_SetIOWriteCtx(ssl, &conn->ring[isServer ? 1 : 0]);
+
+    return 0;
+}
+
+void ShmConn_Shutdown(ShmConn* conn)
+{
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        __atomic_store_n(&conn->ring[i].closed, 1, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&conn->ring[i].readerWake, 1, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&conn->ring[i].writerWake, 1, __ATOMIC_SEQ_CST);
+        Futex(&conn->ring[i].readerWake, FUTEX_WAKE, 1);
+        Futex(&conn->ring[i].writerWake, FUTEX_WAKE, 1);
+    }
+}
+
+void ShmConn_Free(ShmConn* conn)
+{
+    if (conn != NULL)
+        munmap(conn, conn->mapSz);
+}
+
+void ShmConn_Unlink(const char* name)
+{
+    shm_unlink(name);
+}
@@ -0,0 +1,63 @@
+/* shmring.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef _SHMRING_H_
+#define _SHMRING_H_
+
+#include <stddef.h>
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+
+/* Default bytes of data in each direction of a connection. */
+#define SHMRING_DEF_SZ      (64 * 1024)
+
+/* A TLS connection between two parties in shared memory.
+ *
+ * Each direction is a single-producer/single-consumer ring. Data is copied
+ * straight from wolfSSL's buffers into the ring and out again, without
+ * locks. A party that finds its ring empty (or full) sleeps on a futex and is
+ * woken by the other party, after a short spin. The memory may be shared by
+ * threads or processes.
+ */
+typedef struct ShmConn ShmConn;
+
+/* Create a connection with rings of ringSz bytes, a power of 2.
+ * With a name, the memory is a POSIX shared memory object that another
+ * process can open. Without one, it is an anonymous shared mapping that is
+ * inherited across fork(). */
+ShmConn* ShmConn_Create(const char* name, unsigned int ringSz);
+/* Open a connection created with a name by another process. */
+ShmConn* ShmConn_Open(const char* name);
+/* Set the I/O callbacks of ssl to use the connection, as client or server. */
+int      ShmConn_SetIO(WOLFSSL* ssl, ShmConn* conn, int isServer);
+/* Close both directions: the peer reads what is left and then sees the
+ * connection closed. */
+void     ShmConn_Shutdown(ShmConn* conn);
+/* Unmap the connection. */
+void     ShmConn_Free(ShmConn* conn);
+/* Remove the name of a connection created with one. */
+void     ShmConn_Unlink(const char* name);
+
+#endif /* !_SHMRING_H_ */
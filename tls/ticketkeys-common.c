@@ -0,0 +1,337 @@
+/* ticketkeys-common.c
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Session ticket keys shared by several server processes.
+ *
+ * The keys live in a POSIX shared memory segment. One process creates the
+ * segment and rotates the keys; the others only read them. Each key slot has
+ * a sequence number that is odd while the slot is being written (a seqlock),
+ * so the ticket callback copies a key without taking a lock and retries if a
+ * rotation overlapped. Rotation only ever writes the oldest slot, which no
+ * ticket is being issued with.
+ *
+ * Tickets are encrypted with ChaCha20-Poly1305 as in the wolfSSL test server.
+ * A ticket decrypted with a previous key is accepted and a new ticket issued.
+ */
+
+#include "ticketkeys-common.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/chacha20_poly1305.h>
+
+#if defined(HAVE_SESSION_TICKET) && defined(HAVE_CHACHA) && \
+    defined(HAVE_POLY1305)
+
+/* Identifies the segment and its layout version. */
+#define TICKET_KEYS_MAGIC   0x57544b31
+
+/* A ticket key - written only by the rotating process. */
+typedef struct TicketKey {
+    /* Odd while the slot is being written. */
+    atomic_uint seq;
+    /* Time key was created - 0 when slot not used. */
+    word32      created;
+    byte        name[WOLFSSL_TICKET_NAME_SZ];
+    byte        key[CHACHA20_POLY1305_AEAD_KEYSIZE];
+} TicketKey;
+
+/* The shared memory segment. */
+typedef struct TicketKeyRing {
+    word32      magic;
+    /* Seconds a key is used to encrypt tickets. */
+    word32      rotateSecs;
+    /* Slot of the key to encrypt new tickets with. */
+    atomic_uint current;
+    atomic_uint rotations;
+    TicketKey   keys[TICKET_KEYS_NUM];
+} TicketKeyRing;
+
+/* Copy of a key taken from the segment. */
+typedef struct TicketKeyCopy {
+    word32 created;
+    byte   name[WOLFSSL_TICKET_NAME_SZ];
+    byte   key[CHACHA20_POLY1305_AEAD_KEYSIZE];
+} TicketKeyCopy;
+
+
+static TicketKeyRing* gRing;
+static char           gName[64];
+/* Process that created the segment - forked children only read it. */
+static pid_t          gCreator;
+static WC_RNG         gRotateRng;
+/* Per thread random for IVs. Created on first use so that a process forked
+ * after creating the segment doesn't share the state of its parent. */
+static THREAD_LS_T WC_RNG* tIvRng;
+
+
+/* Copy a key out of its slot without locking.
+ *
+ * slot  Key slot in segment.
+ * copy  Copy of key.
+ */
+static void TicketKeys_Read(TicketKey* slot, TicketKeyCopy* copy)
+{
+    unsigned int s1;
+    unsigned int s2;
+
+    do {
+        s1 = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        copy->created = slot->created;
+        XMEMCPY(copy->name, slot->name, sizeof(copy->name));
+        XMEMCPY(copy->key, slot->key, sizeof(copy->key));
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    } while ((s1 & 1) != 0 || s1 != s2);
+}
+
+/* Build the additional authenticated data: key name, IV and length. */
+static void TicketKeys_Aad(byte* aad, const byte* name, const byte* iv,
+    int len)
+{
+    XMEMCPY(aad, name, WOLFSSL_TICKET_NAME_SZ);
+    XMEMCPY(aad + WOLFSSL_TICKET_NAME_SZ, iv, WOLFSSL_TICKET_IV_SZ);
+    aad[WOLFSSL_TICKET_NAME_SZ + WOLFSSL_TICKET_IV_SZ]     = (byte)(len >> 8);
+    aad[WOLFSSL_TICKET_NAME_SZ + WOLFSSL_TICKET_IV_SZ + 1] = (byte)len;
+}
+
+/* Ticket encryption callback. No locks are taken.
+ *
+ * returns WOLFSSL_TICKET_RET_OK on success, WOLFSSL_TICKET_RET_CREATE when
+ * decrypted with a previous key and WOLFSSL_TICKET_RET_REJECT when the ticket
+ * can't be used (full handshake).
+ */
+static int TicketKeys_EncCb(WOLFSSL* ssl, byte keyName[WOLFSSL_TICKET_NAME_SZ],
+    byte iv[WOLFSSL_TICKET_IV_SZ], byte mac[WOLFSSL_TICKET_MAC_SZ], int enc,
+    byte* ticket, int inLen, int* outLen, void* userCtx)
+{
+    int           ret = WOLFSSL_TICKET_RET_OK;
+    unsigned int  cur;
+    unsigned int  i;
+    word32        now;
+    TicketKeyCopy key;
+    byte          aad[WOLFSSL_TICKET_NAME_SZ + WOLFSSL_TICKET_IV_SZ + 2];
+
+    (void)ssl;
+    (void)userCtx;
+
+    cur = atomic_load_explicit(&gRing->current, memory_order_acquire);
+
+    if (enc) {
+        if (tIvRng == NULL) {
+            tIvRng = wc_rng_new(NULL, 0, NULL);
+            if (tIvRng == NULL)
+                return WOLFSSL_TICKET_RET_REJECT;
+        }
+        TicketKeys_Read(&gRing->keys[cur], &key);
+        if (wc_RNG_GenerateBlock(tIvRng, iv, WOLFSSL_TICKET_IV_SZ) != 0)
+            return WOLFSSL_TICKET_RET_REJECT;
+        XMEMCPY(keyName, key.name, WOLFSSL_TICKET_NAME_SZ);
+        TicketKeys_Aad(aad, keyName, iv, inLen);
+        if (wc_ChaCha20Poly1305_Encrypt(key.key, iv, aad, sizeof(aad),
+                ticket, inLen, ticket, mac) != 0)
+            ret = WOLFSSL_TICKET_RET_REJECT;
+    }
+    else {
+        now = (word32)time(NULL);
+        /* Start with the current key - most tickets were issued with it. */
+        for (i = 0; i < TICKET_KEYS_NUM; i++) {
+            TicketKeys_Read(&gRing->keys[(cur + TICKET_KEYS_NUM - i) %
+                TICKET_KEYS_NUM], &key);
+            if (key.created != 0 && XMEMCMP(keyName, key.name,
+                    WOLFSSL_TICKET_NAME_SZ) == 0)
+                break;
+        }
+        /* Unknown or too old - do a full handshake. */
+        if (i == TICKET_KEYS_NUM ||
+                now - key.created > TICKET_KEYS_NUM * gRing->rotateSecs)
+            return WOLFSSL_TICKET_RET_REJECT;
+
+        TicketKeys_Aad(aad, keyName, iv, inLen);
+        if (wc_ChaCha20Poly1305_Decrypt(key.key, iv, aad, sizeof(aad),
+                ticket, inLen, mac, ticket) != 0)
+            return WOLFSSL_TICKET_RET_REJECT;
+        /* Issue a ticket with the current key when an older one was used. */
+        if (i != 0)
+            ret = WOLFSSL_TICKET_RET_CREATE;
+    }
+
+    *outLen = inLen;
+    return ret;
+}
+
+
+/* Write a new key into a slot. Only called by the creator. */
+static int TicketKeys_Generate(unsigned int idx)
+{
+    int        ret;
+    TicketKey* slot = &gRing->keys[idx];
+
+    atomic_fetch_add_explicit(&slot->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    ret = wc_RNG_GenerateBlock(&gRotateRng, slot->name, sizeof(slot->name));
+    if (ret == 0)
+        ret = wc_RNG_GenerateBlock(&gRotateRng, slot->key, sizeof(slot->key));
+    slot->created = (ret == 0) ? (word32)time(NULL) : 0;
+    atomic_fetch_add_explicit(&slot->seq, 1, memory_order_release);
+
+    return ret;
+}
+
+int TicketKeys_Create(const char* name, unsigned int rotateSecs)
+{
+    int   ret;
+    int   fd;
+    void* map;
+
+    if (name == NULL || rotateSecs == 0)
+        return BAD_FUNC_ARG;
+
+    ret = wc_InitRng(&gRotateRng);
+    if (ret != 0)
+        return ret;
+
+    /* Readable by the owner only - the segment holds the ticket keys. */
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        wc_FreeRng(&gRotateRng);
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(TicketKeyRing)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        wc_FreeRng(&gRotateRng);
+        return -1;
+    }
+    map = mmap(NULL, sizeof(TicketKeyRing), PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(name);
+        wc_FreeRng(&gRotateRng);
+        return -1;
+    }
+
+    gRing = (TicketKeyRing*)map;
+    gCreator = getpid();
+    snprintf(gName, sizeof(gName), "%s", name);
+
+    gRing->rotateSecs = rotateSecs;
+    atomic_init(&gRing->current, 0);
+    atomic_init(&gRing->rotations, 0);
+    ret = TicketKeys_Generate(0);
+    /* Readers check the magic so set it last. */
+    atomic_thread_fence(memory_order_release);
+    gRing->magic = TICKET_KEYS_MAGIC;
+
+    return ret;
+}
+
+int TicketKeys_Open(const char* name)
+{
+    int   fd;
+    void* map;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return -1;
+    map = mmap(NULL, sizeof(TicketKeyRing), PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    gRing = (TicketKeyRing*)map;
+    if (gRing->magic != TICKET_KEYS_MAGIC) {
+        munmap(map, sizeof(TicketKeyRing));
+        gRing = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int TicketKeys_Rotate(void)
+{
+    int          ret;
+    unsigned int next;
+
+    if (gRing == NULL || gCreator != getpid())
+        return BAD_FUNC_ARG;
+
+    /* The oldest slot is the one after the current. */
+    next = (atomic_load(&gRing->current) + 1) % TICKET_KEYS_NUM;
+    ret = TicketKeys_Generate(next);
+    if (ret == 0) {
+        atomic_store_explicit(&gRing->current, next, memory_order_release);
+        atomic_fetch_add(&gRing->rotations, 1);
+    }
+
+    return ret;
+}
+
+int TicketKeys_Attach(WOLFSSL_CTX* ctx)
+{
+    if (ctx == NULL || gRing == NULL)
+        return BAD_FUNC_ARG;
+
+    if (wolfSSL_CTX_set_TicketEncCb(ctx, TicketKeys_EncCb) != WOLFSSL_SUCCESS)
+        return -1;
+    /* Client may use a ticket as long as a server can decrypt it. */
+    return wolfSSL_CTX_set_TicketHint(ctx,
+        (int)(gRing->rotateSecs * (TICKET_KEYS_NUM - 1))) == WOLFSSL_SUCCESS ?
+        0 : -1;
+}
+
+unsigned int TicketKeys_Rotations(void)
+{
+    if (gRing == NULL)
+        return 0;
+    return atomic_load(&gRing->rotations);
+}
+
+void TicketKeys_Close(void)
+{
+    if (gRing != NULL) {
+        munmap(gRing, sizeof(TicketKeyRing));
+        gRing = NULL;
+    }
+    if (tIvRng != NULL) {
+        wc_rng_free(tIvRng);
+        tIvRng = NULL;
+    }
+    if (gCreator == getpid()) {
+        shm_unlink(gName);
+        wc_FreeRng(&gRotateRng);
+    }
+    gCreator = 0;
+}
+
+#endif /* HAVE_SESSION_TICKET && HAVE_CHACHA && HAVE_POLY1305 */
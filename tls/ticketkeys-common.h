@@ -0,0 +1,56 @@
+/* ticketkeys-common.h
+ *
+ * Copyright (C) 2006-2025 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL. (formerly known as CyaSSL)
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef _TICKETKEYS_COMMON_H_
+#define _TICKETKEYS_COMMON_H_
+
+/* wolfSSL */
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/ssl.h>
+
+#if defined(HAVE_SESSION_TICKET) && defined(HAVE_CHACHA) && \
+    defined(HAVE_POLY1305)
+
+/* Number of keys kept: the current one plus the previous ones still accepted
+ * for decryption. */
+#ifndef TICKET_KEYS_NUM
+    #define TICKET_KEYS_NUM     4
+#endif
+
+/* Create the shared memory segment with a first key. Called by the process
+ * that rotates the keys. */
+int  TicketKeys_Create(const char* name, unsigned int rotateSecs);
+/* Map an existing segment. Called by each server process. */
+int  TicketKeys_Open(const char* name);
+/* Replace the oldest key with a new one and make it current. */
+int  TicketKeys_Rotate(void);
+/* Encrypt and decrypt the tickets of the context with the shared keys. */
+int  TicketKeys_Attach(WOLFSSL_CTX* ctx);
+/* Number of rotations done since the segment was created. */
+unsigned int TicketKeys_Rotations(void);
+/* Unmap the segment. The creator also removes it. */
+void TicketKeys_Close(void);
+
+#endif
+
+#endif /* !_TICKETKEYS_COMMON_H_ */